@@ -0,0 +1,231 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#include "lemon/pch.h"
+#include "lemon/compiler/CompilationCache.h"
+#include "lemon/program/Function.h"
+#include "lemon/program/GlobalsLookup.h"
+
+
+namespace lemon
+{
+	namespace
+	{
+		const uint32 SIGNATURE = *(uint32*)"LCC|";	// "Lemonscript Compilation Cache"
+		const uint16 VERSION = 0x01;
+	}
+
+
+	void CompilationCache::clear()
+	{
+		mFileEntries.clear();
+		mHasChanges = false;
+	}
+
+	bool CompilationCache::serialize(VectorBinarySerializer& serializer)
+	{
+		if (serializer.isReading())
+		{
+			clear();
+			if (serializer.getRemaining() < 6 || *(const uint32*)serializer.peek() != SIGNATURE)
+				return false;
+
+			serializer.skip(4);
+			if (serializer.read<uint16>() != VERSION)
+				return false;	// Just start with an empty cache then
+		}
+		else
+		{
+			serializer.write(SIGNATURE);
+			serializer.write(VERSION);
+		}
+
+		// Note that there's no compression, as decoding would take a good part of the time saved by the cache in the first place
+		size_t numberOfFiles = mFileEntries.size();
+		serializer.serializeAs<uint32>(numberOfFiles);
+		if (serializer.isReading())
+		{
+			mFileEntries.reserve(numberOfFiles);
+			for (size_t i = 0; i < numberOfFiles; ++i)
+			{
+				const uint64 pathHash = serializer.read<uint64>();
+				FileEntry& fileEntry = mFileEntries[pathHash];
+				serializer.serialize(fileEntry.mContentHash);
+				serializer.serialize(fileEntry.mDependencyHash);
+				fileEntry.mFunctions.resize((size_t)serializer.read<uint32>());
+				for (FunctionEntry& functionEntry : fileEntry.mFunctions)
+				{
+					serializer.serialize(functionEntry.mNameAndSignatureHash);
+					serializer.serializeData(functionEntry.mData);
+				}
+			}
+
+			if (serializer.hasError())
+			{
+				clear();
+				return false;
+			}
+		}
+		else
+		{
+			for (auto& [pathHash, fileEntry] : mFileEntries)
+			{
+				serializer.write(pathHash);
+				serializer.write(fileEntry.mContentHash);
+				serializer.write(fileEntry.mDependencyHash);
+				serializer.writeAs<uint32>(fileEntry.mFunctions.size());
+				for (FunctionEntry& functionEntry : fileEntry.mFunctions)
+				{
+					serializer.write(functionEntry.mNameAndSignatureHash);
+					serializer.serializeData(functionEntry.mData);
+				}
+			}
+		}
+
+
+		mHasChanges = false;
+		return true;
+	}
+
+	const CompilationCache::FileEntry* CompilationCache::getFileEntry(uint64 pathHash, uint64 contentHash, uint64 dependencyHash) const
+	{
+		const auto it = mFileEntries.find(pathHash);
+		if (it == mFileEntries.end())
+			return nullptr;
+		const FileEntry& fileEntry = it->second;
+		return (fileEntry.mContentHash == contentHash && fileEntry.mDependencyHash == dependencyHash) ? &fileEntry : nullptr;
+	}
+
+	CompilationCache::FileEntry& CompilationCache::setFileEntry(uint64 pathHash, uint64 contentHash, uint64 dependencyHash)
+	{
+		FileEntry& fileEntry = mFileEntries[pathHash];
+		fileEntry.mContentHash = contentHash;
+		fileEntry.mDependencyHash = dependencyHash;
+		fileEntry.mFunctions.clear();
+		mHasChanges = true;
+		return fileEntry;
+	}
+
+	void CompilationCache::removeFileEntry(uint64 pathHash)
+	{
+		if (mFileEntries.erase(pathHash) > 0)
+			mHasChanges = true;
+	}
+
+	bool CompilationCache::readFunctions(const std::vector<ScriptFunction*>& functions, const FileEntry& fileEntry, const GlobalsLookup& globalsLookup)
+	{
+		// Function signatures must be the same as when the entry was written
+		if (fileEntry.mFunctions.size() != functions.size())
+			return false;
+		for (size_t i = 0; i < functions.size(); ++i)
+		{
+			if (fileEntry.mFunctions[i].mNameAndSignatureHash != functions[i]->getNameAndSignatureHash())
+				return false;
+		}
+
+		// Read everything first, so that no function gets changed in case of invalid data
+		struct ReadFunction
+		{
+			std::vector<Opcode> mOpcodes;
+			std::vector<std::pair<FlyweightString, const DataTypeDefinition*>> mLocalVariables;
+			std::vector<ScriptFunction::Label> mLabels;
+		};
+		std::vector<ReadFunction> readFunctions(functions.size());
+
+		for (size_t i = 0; i < functions.size(); ++i)
+		{
+			const ScriptFunction& function = *functions[i];
+			ReadFunction& readFunction = readFunctions[i];
+			VectorBinarySerializer serializer(true, fileEntry.mFunctions[i].mData);
+
+			// Opcodes, using line numbers relative to the function start
+			readFunction.mOpcodes.resize((size_t)serializer.read<uint32>());
+			for (Opcode& opcode : readFunction.mOpcodes)
+			{
+				opcode.mType = (Opcode::Type)serializer.read<uint8>();
+				opcode.mDataType = (BaseType)serializer.read<uint8>();
+				opcode.mFlags = serializer.read<uint8>();
+				const uint32 lineOffset = serializer.read<uint32>();
+				opcode.mLineNumber = (lineOffset == 0) ? 0 : (function.mStartLineNumber + lineOffset - 1);
+				opcode.mParameter = serializer.read<int64>();
+			}
+
+			// Local variables, except for the parameters which are there already
+			const size_t numLocalVariables = (size_t)serializer.read<uint32>();
+			if (numLocalVariables < function.mLocalVariablesByID.size())
+				return false;
+			readFunction.mLocalVariables.resize(numLocalVariables - function.mLocalVariablesByID.size());
+			for (auto& [name, dataType] : readFunction.mLocalVariables)
+			{
+				name.serialize(serializer);
+				dataType = globalsLookup.readDataType(serializer);
+			}
+
+			// Labels
+			readFunction.mLabels.resize((size_t)serializer.read<uint32>());
+			for (ScriptFunction::Label& label : readFunction.mLabels)
+			{
+				label.mName.serialize(serializer);
+				label.mOffset = serializer.read<uint32>();
+			}
+
+			if (serializer.hasError() || serializer.getRemaining() != 0)
+				return false;
+		}
+
+		// Now apply it all
+		for (size_t i = 0; i < functions.size(); ++i)
+		{
+			ScriptFunction& function = *functions[i];
+			ReadFunction& readFunction = readFunctions[i];
+			function.mOpcodes.swap(readFunction.mOpcodes);
+			for (const auto& [name, dataType] : readFunction.mLocalVariables)
+			{
+				function.addLocalVariable(name, dataType, function.mStartLineNumber);
+			}
+			function.mLabels.swap(readFunction.mLabels);
+		}
+		return true;
+	}
+
+	void CompilationCache::writeFunction(FunctionEntry& functionEntry, const ScriptFunction& function)
+	{
+		functionEntry.mNameAndSignatureHash = function.getNameAndSignatureHash();
+		functionEntry.mData.clear();
+		VectorBinarySerializer serializer(false, functionEntry.mData);
+
+		// Opcodes
+		serializer.writeAs<uint32>(function.mOpcodes.size());
+		for (const Opcode& opcode : function.mOpcodes)
+		{
+			serializer.writeAs<uint8>(opcode.mType);
+			serializer.writeAs<uint8>(opcode.mDataType);
+			serializer.write(opcode.mFlags);
+			serializer.write((opcode.mLineNumber == 0) ? 0 : (opcode.mLineNumber - function.mStartLineNumber + 1));		// Line number 0 is used for generated opcodes without a line
+			serializer.write(opcode.mParameter);
+		}
+
+		// Local variables, where the parameters only get counted
+		serializer.writeAs<uint32>(function.mLocalVariablesByID.size());
+		for (size_t k = function.getParameters().size(); k < function.mLocalVariablesByID.size(); ++k)
+		{
+			const LocalVariable& variable = *function.mLocalVariablesByID[k];
+			variable.getName().write(serializer);
+			serializer.write(variable.getDataType()->getID());
+		}
+
+		// Labels
+		serializer.writeAs<uint32>(function.mLabels.size());
+		for (const ScriptFunction::Label& label : function.mLabels)
+		{
+			label.mName.write(serializer);
+			serializer.write(label.mOffset);
+		}
+	}
+
+}
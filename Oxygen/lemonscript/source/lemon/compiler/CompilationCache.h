@@ -0,0 +1,59 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#pragma once
+
+#include <rmxbase.h>
+
+
+namespace lemon
+{
+	class GlobalsLookup;
+	class ScriptFunction;
+
+	// Cache for compiled script functions, with one entry per source file
+	//  -> An entry gets reused only if both the file's preprocessed content and the dependency hash match, where the latter covers all global definitions visible to the file
+	//  -> Files still get parsed, but processing of function contents and opcode generation is skipped for all files found in the cache
+	class API_EXPORT CompilationCache
+	{
+	friend class Compiler;
+
+	public:
+		void clear();
+		bool serialize(VectorBinarySerializer& serializer);
+
+		inline bool hasChanges() const  { return mHasChanges; }
+
+	private:
+		struct FunctionEntry
+		{
+			uint64 mNameAndSignatureHash = 0;
+			std::vector<uint8> mData;
+		};
+
+		struct FileEntry
+		{
+			uint64 mContentHash = 0;
+			uint64 mDependencyHash = 0;
+			std::vector<FunctionEntry> mFunctions;
+		};
+
+	private:
+		const FileEntry* getFileEntry(uint64 pathHash, uint64 contentHash, uint64 dependencyHash) const;
+		FileEntry& setFileEntry(uint64 pathHash, uint64 contentHash, uint64 dependencyHash);
+		void removeFileEntry(uint64 pathHash);
+
+		static bool readFunctions(const std::vector<ScriptFunction*>& functions, const FileEntry& fileEntry, const GlobalsLookup& globalsLookup);
+		static void writeFunction(FunctionEntry& functionEntry, const ScriptFunction& function);
+
+	private:
+		std::unordered_map<uint64, FileEntry> mFileEntries;		// Using the hash of the source file path as key
+		bool mHasChanges = false;
+	};
+
+}
@@ -8,12 +8,16 @@
 
 #include "lemon/pch.h"
 #include "lemon/compiler/Compiler.h"
+#include "lemon/compiler/CompilationCache.h"
 #include "lemon/compiler/Utility.h"
 #include "lemon/compiler/backend/FunctionCompiler.h"
 #include "lemon/compiler/frontend/CompilerFrontend.h"
 #include "lemon/program/Module.h"
 #include "lemon/translator/Translator.h"
 
+#include <atomic>
+#include <thread>
+
 
 namespace lemon
 {
@@ -89,18 +93,35 @@ namespace lemon
 			BlockNode rootNode;
 			std::vector<FunctionNode*> functionNodes;
 
-			// Frontend part: Convert input text lines into a syntax tree like structure (built of nodes and tokens)
 			CompilerFrontend frontend(mModule, mGlobalsLookup, mCompileOptions, mLineNumberTranslation, functionNodes);
-			frontend.runCompilerFrontend(rootNode, lines);
-
-			// Optional translation
-			if (!mCompileOptions.mOutputTranslatedSource.empty())
+			if (mCompileOptions.mOutputTranslatedSource.empty())
 			{
-				Translator::translateToCppAndSave(mCompileOptions.mOutputTranslatedSource, rootNode);
+				// Process the global definitions first, then the function contents, which are independent of each other
+				frontend.runGlobalsStage(rootNode, lines);
+				if (nullptr != mCompileOptions.mCompilationCache)
+				{
+					// Compile only functions not found in the compilation cache
+					compileFunctionsWithCache(functionNodes);
+				}
+				else
+				{
+					compileFunctions(functionNodes);
+				}
 			}
+			else
+			{
+				// Frontend part: Convert input text lines into a syntax tree like structure (built of nodes and tokens)
+				frontend.runCompilerFrontend(rootNode, lines);
+
+				// Optional translation
+				if (!mCompileOptions.mOutputTranslatedSource.empty())
+				{
+					Translator::translateToCppAndSave(mCompileOptions.mOutputTranslatedSource, rootNode);
+				}
 
-			// Backend part: Compile functions' syntax tree structure into opcodes
-			runCompilerBackend(functionNodes);
+				// Backend part: Compile functions' syntax tree structure into opcodes
+				runCompilerBackend(functionNodes);
+			}
 
 			// Success
 			return true;
@@ -144,6 +165,7 @@ namespace lemon
 
 		// Register source file at module
 		const SourceFileInfo& sourceFileInfo = mModule.addSourceFileInfo(basepath, filename);
+		scriptFile.mSourceFileInfo = &sourceFileInfo;
 
 		// Update line number translation
 		mLineNumberTranslation.push((uint32)outLines.size() + 1, sourceFileInfo, 0);
@@ -179,6 +201,8 @@ namespace lemon
 		}
 
 		// Build output
+		const bool buildContentHash = (nullptr != mCompileOptions.mCompilationCache);
+		uint64 contentHash = rmx::startFNV1a_64();
 		for (uint32 fileLineIndex = 0; fileLineIndex < (uint32)fileLines.size(); ++fileLineIndex)
 		{
 			const std::string_view line = fileLines[fileLineIndex];
@@ -227,10 +251,17 @@ namespace lemon
 			}
 			else
 			{
+				if (buildContentHash)
+				{
+					// Include the line index as well, so that line breaks are part of the hash
+					contentHash = rmx::addToFNV1a_64(contentHash, (const uint8*)&fileLineIndex, sizeof(fileLineIndex));
+					contentHash = rmx::addToFNV1a_64(contentHash, (const uint8*)line.data(), line.length());
+				}
 				outLines.emplace_back(std::move(fileLines[fileLineIndex]));
 			}
 		}
 
+		scriptFile.mContentHash = contentHash;
 		return true;
 	}
 
@@ -297,4 +328,220 @@ namespace lemon
 	#endif
 	}
 
+	void Compiler::compileFunctions(std::vector<FunctionNode*>& functionNodes)
+	{
+		int numThreads = mCompileOptions.mNumThreads;
+		if (numThreads <= 0)
+		{
+			numThreads = (int)std::thread::hardware_concurrency();
+		}
+		numThreads = clamp(numThreads, 1, (int)genericmanager::ThreadSlots::MAX_SLOTS);
+		if (numThreads > 1 && functionNodes.size() >= 0x100)
+		{
+			compileFunctionsInParallel(functionNodes, numThreads);
+			return;
+		}
+
+		std::vector<FunctionNode*> dummyFunctionNodes;
+		CompilerFrontend frontend(mModule, mGlobalsLookup, mCompileOptions, mLineNumberTranslation, dummyFunctionNodes);
+		for (FunctionNode* node : functionNodes)
+		{
+			frontend.runFunctionStage(*node);
+		}
+		runCompilerBackend(functionNodes);
+	}
+
+	void Compiler::compileFunctionsInParallel(const std::vector<FunctionNode*>& functionNodes, int numThreads)
+	{
+		// Functions defining local constant arrays add these to the module, so they depend on the processing order
+		//  -> Compile them first, on this thread and in their original order
+		//  -> All other functions are independent of each other and can be compiled in any order
+		std::vector<size_t> orderedFunctionIndices;
+		std::vector<size_t> parallelFunctionIndices;
+		parallelFunctionIndices.reserve(functionNodes.size());
+		for (size_t k = 0; k < functionNodes.size(); ++k)
+		{
+			if (CompilerFrontend::hasLocalConstantArrays(*functionNodes[k]))
+				orderedFunctionIndices.push_back(k);
+			else
+				parallelFunctionIndices.push_back(k);
+		}
+
+		// Errors get collected per function, so that the first one in code order can be reported, like with single-threaded compilation
+		std::vector<std::exception_ptr> exceptions(functionNodes.size());
+		std::atomic<size_t> nextIndex = 0;
+		std::atomic<bool> anyError = false;
+
+		const auto compileFunctionNodes = [&](const std::vector<size_t>& functionIndices, uint8 threadSlot)
+		{
+			genericmanager::ThreadSlots::setCurrentSlot(threadSlot);
+			std::vector<FunctionNode*> dummyFunctionNodes;
+			CompilerFrontend frontend(mModule, mGlobalsLookup, mCompileOptions, mLineNumberTranslation, dummyFunctionNodes);
+			while (!anyError)
+			{
+				// Note that indices get handed out in ascending order, so all functions before one with an error still get compiled
+				const size_t index = nextIndex++;
+				if (index >= functionIndices.size())
+					break;
+
+				const size_t functionIndex = functionIndices[index];
+				FunctionNode& node = *functionNodes[functionIndex];
+				try
+				{
+					frontend.runFunctionStage(node);
+
+					FunctionCompiler functionCompiler(*node.mFunction, mCompileOptions, mGlobalsLookup);
+					functionCompiler.processParameters();
+					functionCompiler.buildOpcodesForFunction(*node.mContent);
+				}
+				catch (...)
+				{
+					exceptions[functionIndex] = std::current_exception();
+					anyError = true;
+				}
+			}
+			genericmanager::ThreadSlots::setCurrentSlot(0);
+		};
+
+		compileFunctionNodes(orderedFunctionIndices, 0);
+
+		// Data type names get created lazily, so make sure that does not happen in the worker threads
+		for (const DataTypeDefinition* dataType : mGlobalsLookup.getDataTypes())
+		{
+			dataType->getName();
+		}
+
+		// Compile all other functions in parallel, with this thread being one of the workers
+		nextIndex = 0;
+		anyError = false;
+		genericmanager::ThreadSlots::setMultiThreadingActive(true);
+		{
+			std::vector<std::thread> workerThreads;
+			workerThreads.reserve(numThreads - 1);
+			for (int k = 1; k < numThreads; ++k)
+			{
+				workerThreads.emplace_back(compileFunctionNodes, std::cref(parallelFunctionIndices), (uint8)k);
+			}
+			compileFunctionNodes(parallelFunctionIndices, 0);
+			for (std::thread& thread : workerThreads)
+			{
+				thread.join();
+			}
+		}
+		genericmanager::ThreadSlots::setMultiThreadingActive(false);
+
+		// Destroy nodes and tokens that could not be destroyed by the worker threads themselves
+		genericmanager::Manager<Node>::flushDeferredDestruction();
+		genericmanager::Manager<Token>::flushDeferredDestruction();
+
+		for (const std::exception_ptr& exception : exceptions)
+		{
+			if (exception)
+				std::rethrow_exception(exception);
+		}
+	}
+
+	void Compiler::compileFunctionsWithCache(std::vector<FunctionNode*>& functionNodes)
+	{
+		CompilationCache& compilationCache = *mCompileOptions.mCompilationCache;
+
+		// Cached functions can only be reused if none of the definitions they could depend on has changed
+		//  -> This is checked for all global definitions at once, so e.g. adding a new function anywhere invalidates all cache entries
+		uint64 dependencyHash = rmx::startFNV1a_64();
+		{
+			const uint64 values[] = { mCompileOptions.mExternalDependencyHash, mModule.buildDefinitionsHash(mGlobalsLookup), mCompileOptions.mScriptFeatureLevel, mCompileOptions.mExternalAddressType->getID() };
+			dependencyHash = rmx::addToFNV1a_64(dependencyHash, (const uint8*)values, sizeof(values));
+		}
+
+		// Group functions by the script file they are defined in
+		struct CachedScriptFile
+		{
+			const ScriptFile* mScriptFile = nullptr;
+			uint64 mPathHash = 0;
+			std::vector<ScriptFunction*> mFunctions;
+			bool mReused = false;
+			bool mCacheable = true;
+		};
+		std::vector<CachedScriptFile> cachedScriptFiles;
+		std::unordered_map<const SourceFileInfo*, size_t> cachedScriptFileIndices;
+		std::vector<size_t> cachedScriptFileIndexByNode;
+		{
+			cachedScriptFiles.reserve(mScriptFiles.size());
+			for (const ScriptFile* scriptFile : mScriptFiles)
+			{
+				CachedScriptFile& cachedScriptFile = vectorAdd(cachedScriptFiles);
+				cachedScriptFile.mScriptFile = scriptFile;
+				cachedScriptFile.mPathHash = rmx::getMurmur2_64(scriptFile->mSourceFileInfo->mFullPath);
+				cachedScriptFileIndices.emplace(scriptFile->mSourceFileInfo, cachedScriptFiles.size() - 1);
+			}
+
+			// Functions not coming from a loaded script file (e.g. when "compileLines" got called directly) get compiled each time
+			CachedScriptFile& uncachedFunctions = vectorAdd(cachedScriptFiles);
+			uncachedFunctions.mCacheable = false;
+
+			cachedScriptFileIndexByNode.reserve(functionNodes.size());
+			for (FunctionNode* node : functionNodes)
+			{
+				const auto it = cachedScriptFileIndices.find(node->mFunction->mSourceFileInfo);
+				const size_t index = (it == cachedScriptFileIndices.end()) ? (cachedScriptFiles.size() - 1) : it->second;
+				cachedScriptFiles[index].mFunctions.push_back(node->mFunction);
+				cachedScriptFileIndexByNode.push_back(index);
+
+				// This is what the frontend would do otherwise, and is needed for line numbers in cached opcodes
+				node->mFunction->mStartLineNumber = node->getLineNumber();
+			}
+		}
+
+		// Restore functions of unchanged files from the cache
+		for (CachedScriptFile& cachedScriptFile : cachedScriptFiles)
+		{
+			if (!cachedScriptFile.mCacheable || cachedScriptFile.mFunctions.empty())
+				continue;
+
+			const CompilationCache::FileEntry* fileEntry = compilationCache.getFileEntry(cachedScriptFile.mPathHash, cachedScriptFile.mScriptFile->mContentHash, dependencyHash);
+			if (nullptr != fileEntry)
+			{
+				cachedScriptFile.mReused = CompilationCache::readFunctions(cachedScriptFile.mFunctions, *fileEntry, mGlobalsLookup);
+			}
+		}
+
+		// Run frontend and backend for all other functions
+		//  -> Files defining local constant arrays are excluded from caching, as the arrays are part of the module and not the function itself
+		std::vector<FunctionNode*> compiledFunctionNodes;
+		compiledFunctionNodes.reserve(functionNodes.size());
+		for (size_t k = 0; k < functionNodes.size(); ++k)
+		{
+			CachedScriptFile& cachedScriptFile = cachedScriptFiles[cachedScriptFileIndexByNode[k]];
+			if (cachedScriptFile.mReused)
+				continue;
+
+			if (CompilerFrontend::hasLocalConstantArrays(*functionNodes[k]))
+				cachedScriptFile.mCacheable = false;
+
+			compiledFunctionNodes.push_back(functionNodes[k]);
+		}
+		compileFunctions(compiledFunctionNodes);
+
+		// Update the cache
+		for (const CachedScriptFile& cachedScriptFile : cachedScriptFiles)
+		{
+			if (cachedScriptFile.mReused || nullptr == cachedScriptFile.mScriptFile || cachedScriptFile.mFunctions.empty())
+				continue;
+
+			if (cachedScriptFile.mCacheable)
+			{
+				CompilationCache::FileEntry& fileEntry = compilationCache.setFileEntry(cachedScriptFile.mPathHash, cachedScriptFile.mScriptFile->mContentHash, dependencyHash);
+				fileEntry.mFunctions.resize(cachedScriptFile.mFunctions.size());
+				for (size_t i = 0; i < cachedScriptFile.mFunctions.size(); ++i)
+				{
+					CompilationCache::writeFunction(fileEntry.mFunctions[i], *cachedScriptFile.mFunctions[i]);
+				}
+			}
+			else
+			{
+				compilationCache.removeFileEntry(cachedScriptFile.mPathHash);
+			}
+		}
+	}
+
 }
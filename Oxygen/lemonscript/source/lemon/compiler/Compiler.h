@@ -20,6 +20,8 @@ namespace lemon
 	class Module;
 	class GlobalsLookup;
 	class FunctionNode;
+	class CompilerFrontend;
+	struct SourceFileInfo;
 
 	class API_EXPORT Compiler
 	{
@@ -45,6 +47,9 @@ namespace lemon
 	private:
 		bool loadScriptInternal(const std::wstring& basepath, const std::wstring& filename, std::vector<std::string_view>& outLines, std::unordered_set<uint64>& includedPathHashes);
 		void runCompilerBackend(std::vector<FunctionNode*>& functionNodes);
+		void compileFunctions(std::vector<FunctionNode*>& functionNodes);
+		void compileFunctionsInParallel(const std::vector<FunctionNode*>& functionNodes, int numThreads);
+		void compileFunctionsWithCache(std::vector<FunctionNode*>& functionNodes);
 
 	private:
 		Module& mModule;
@@ -61,6 +66,8 @@ namespace lemon
 			std::wstring mFilename;
 			String mContent;
 			size_t mFirstLine = 0;
+			const SourceFileInfo* mSourceFileInfo = nullptr;
+			uint64 mContentHash = 0;		// Hash of the preprocessed lines, without included files
 		};
 		std::vector<ScriptFile*> mScriptFiles;
 		ObjectPool<ScriptFile,64> mScriptFilesPool;
@@ -14,6 +14,7 @@
 namespace lemon
 {
 	struct DataTypeDefinition;
+	class CompilationCache;
 
 	struct CompileOptions
 	{
@@ -23,6 +24,9 @@ namespace lemon
 		std::wstring mOutputNativizedSource;
 		std::wstring mOutputTranslatedSource;
 		bool mConsumeProcessedPragmas = true;
+		CompilationCache* mCompilationCache = nullptr;	// Optional, to reuse compiled functions from unchanged script files
+		uint64 mExternalDependencyHash = 0;				// Hash of definitions from other modules the scripts can use, should be built with "Module::buildDefinitionsHash"
+		int mNumThreads = 1;							// Number of threads for compiling function contents, 0 for automatic choice based on the CPU core count
 
 		// Set during compilation
 		uint32 mScriptFeatureLevel = 1;
@@ -18,10 +18,34 @@ namespace genericmanager
 	template<class ELEMENT> struct GetElementFactoryLookupType;
 
 
+	// Thread slots for use of the managers by multiple threads at once
+	//  -> Each thread slot has its own element pools, so threads with different slots can create and destroy elements in parallel
+	//  -> While multi-threading is active, elements from a foreign slot don't get destroyed directly, but only when "flushDeferredDestruction" is called
+	//  -> Elements must not be shared between threads, as their reference counting is not thread-safe
+	class ThreadSlots
+	{
+	public:
+		static const constexpr size_t MAX_SLOTS = 16;
+
+	public:
+		inline static uint8 getCurrentSlot()  { return mCurrentSlot; }
+		inline static void setCurrentSlot(uint8 slot)  { mCurrentSlot = slot; }
+
+		inline static bool isMultiThreadingActive()  { return mMultiThreadingActive; }
+		inline static void setMultiThreadingActive(bool active)  { mMultiThreadingActive = active; }	// Must only be called while no other thread uses any manager
+
+	private:
+		inline static thread_local uint8 mCurrentSlot = 0;
+		inline static bool mMultiThreadingActive = false;
+	};
+
+
 	// Managed element base class
 	template<class ELEMENT>
 	class Element
 	{
+	friend class Manager<ELEMENT>;
+
 	public:
 		typedef uint32 Type;
 
@@ -32,6 +56,7 @@ namespace genericmanager
 		template<typename T> const T& as() const  { return static_cast<const T&>(*this); }
 
 		inline uint32 getReferenceCounter() const  { return mReferenceCounter; }
+		inline uint8 getThreadSlot() const  { return mThreadSlot; }
 
 		void addReference()
 		{
@@ -59,6 +84,7 @@ namespace genericmanager
 	private:
 		const Type mType;
 		uint32 mReferenceCounter = 0;
+		uint8 mThreadSlot = 0;		// Thread slot of the pool this element was created in
 	};
 
 
@@ -189,25 +215,58 @@ namespace genericmanager
 		template<typename TYPE>
 		static TYPE& create()
 		{
-			detail::ElementFactoryBase<ELEMENT>& factory = mFactoryMap.template getOrCreateElementFactory<TYPE>();
-			return static_cast<TYPE&>(factory.create());
+			const uint8 slot = ThreadSlots::getCurrentSlot();
+			detail::ElementFactoryBase<ELEMENT>& factory = mFactoryMaps[slot].template getOrCreateElementFactory<TYPE>();
+			TYPE& element = static_cast<TYPE&>(factory.create());
+			element.mThreadSlot = slot;
+			return element;
 		}
 
 		static void shrinkAllPools()
 		{
-			mFactoryMap.shrinkAllPools();
+			for (detail::ElementFactoryMap<ELEMENT>& factoryMap : mFactoryMaps)
+			{
+				factoryMap.shrinkAllPools();
+			}
+		}
+
+		static void flushDeferredDestruction()
+		{
+			// Must only be called after multi-threading ended
+			RMX_ASSERT(!ThreadSlots::isMultiThreadingActive(), "Deferred destruction must not be flushed while multi-threading is active");
+			for (std::vector<Element<ELEMENT>*>& deferredElements : mDeferredDestruction)
+			{
+				// Note that destroying elements can lead to more elements getting destroyed, but not to new entries in the list
+				for (Element<ELEMENT>* element : deferredElements)
+				{
+					destroy(*element);
+				}
+				deferredElements.clear();
+			}
 		}
 
 	private:
 		static void destroy(Element<ELEMENT>& element)
 		{
 			RMX_ASSERT(element.getReferenceCounter() == 0, "Element still has references");
-			detail::ElementFactoryBase<ELEMENT>& factory = mFactoryMap.getElementFactory(element.getType());
+			if (ThreadSlots::isMultiThreadingActive())
+			{
+				const uint8 slot = ThreadSlots::getCurrentSlot();
+				if (element.mThreadSlot != slot)
+				{
+					// The element's pool may be in use by another thread right now
+					mDeferredDestruction[slot].push_back(&element);
+					return;
+				}
+			}
+
+			detail::ElementFactoryBase<ELEMENT>& factory = mFactoryMaps[element.mThreadSlot].getElementFactory(element.getType());
 			factory.destroy(static_cast<ELEMENT&>(element));
 		}
 
 	private:
-		static inline detail::ElementFactoryMap<ELEMENT> mFactoryMap;
+		static inline detail::ElementFactoryMap<ELEMENT> mFactoryMaps[ThreadSlots::MAX_SLOTS];
+		static inline std::vector<Element<ELEMENT>*> mDeferredDestruction[ThreadSlots::MAX_SLOTS];
 	};
 
 
@@ -257,7 +257,7 @@ namespace lemon
 			return 0xffffffff;
 
 		const size_t size = original.size();
-		static std::vector<uint8> priorities;	// Not multi-threading safe
+		static thread_local std::vector<uint8> priorities;
 		priorities.resize(size);
 
 		for (size_t i = 0; i < size; ++i)
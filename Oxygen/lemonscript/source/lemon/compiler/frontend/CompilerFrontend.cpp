@@ -30,6 +30,27 @@ namespace lemon
 			node.setLineNumber(lineNumber);
 			return node;
 		}
+
+		bool containsConstantArrayDefinition(const BlockNode& blockNode)
+		{
+			static const uint64 ARRAY_NAME_HASH = rmx::getMurmur2_64(std::string_view("array"));
+			for (size_t i = 0; i < blockNode.mNodes.size(); ++i)
+			{
+				const Node& node = blockNode.mNodes[i];
+				if (node.getType() == Node::Type::BLOCK)
+				{
+					if (containsConstantArrayDefinition(node.as<BlockNode>()))
+						return true;
+				}
+				else if (node.getType() == Node::Type::UNDEFINED)
+				{
+					const TokenList& tokens = node.as<UndefinedNode>().mTokenList;
+					if (tokens.size() >= 2 && isKeyword(tokens[0], Keyword::CONSTANT) && isIdentifier(tokens[1], ARRAY_NAME_HASH))
+						return true;
+				}
+			}
+			return false;
+		}
 	}
 
 
@@ -75,18 +96,33 @@ namespace lemon
 	}
 
 	void CompilerFrontend::runCompilerFrontend(BlockNode& outRootNode, const std::vector<std::string_view>& lines)
+	{
+		runGlobalsStage(outRootNode, lines);
+
+		// Process function contents
+		for (FunctionNode* node : mFunctionNodes)
+		{
+			runFunctionStage(*node);
+		}
+	}
+
+	void CompilerFrontend::runGlobalsStage(BlockNode& outRootNode, const std::vector<std::string_view>& lines)
 	{
 		// Parse all lines and make nodes out of them that form a node hierarchy
 		buildNodesFromCodeLines(outRootNode, lines);
 
 		// Identify all globals definitions (functions, global variables, constants, defines)
 		processGlobalDefinitions(outRootNode);
+	}
 
-		// Process function contents
-		for (FunctionNode* node : mFunctionNodes)
-		{
-			processSingleFunction(*node);
-		}
+	void CompilerFrontend::runFunctionStage(FunctionNode& functionNode)
+	{
+		processSingleFunction(functionNode);
+	}
+
+	bool CompilerFrontend::hasLocalConstantArrays(const FunctionNode& functionNode)
+	{
+		return containsConstantArrayDefinition(*functionNode.mContent);
 	}
 
 	void CompilerFrontend::buildNodesFromCodeLines(BlockNode& rootNode, const std::vector<std::string_view>& lines)
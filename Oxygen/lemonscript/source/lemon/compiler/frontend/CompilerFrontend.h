@@ -33,6 +33,13 @@ namespace lemon
 
 		void runCompilerFrontend(BlockNode& outRootNode, const std::vector<std::string_view>& lines);
 
+		// The two stages of "runCompilerFrontend", for use when not all functions have to be processed
+		void runGlobalsStage(BlockNode& outRootNode, const std::vector<std::string_view>& lines);
+		void runFunctionStage(FunctionNode& functionNode);
+
+		// Check whether the function stage for this function would add constant arrays to the module, which makes it depend on processing order
+		static bool hasLocalConstantArrays(const FunctionNode& functionNode);
+
 	private:
 		struct ScopeContext
 		{
@@ -48,6 +48,65 @@ namespace lemon
 			return "Operator is not allowed here";
 		}
 
+		Token& createDefineContentTokenCopy(const Token& original)
+		{
+			// Define content tokens only ever get inserted as copies, as tokens may get modified later on during processing
+			//  -> This way, the define's content itself stays untouched, and can safely be used by multiple threads
+			//  -> Integer constants get their data type assigned for each use individually; when tokens were shared, the last use determined the type of all uses
+			//  -> Note that this type ends up in the PUSH_CONSTANT opcodes and is part of the nativized code lookup hash, see "Nativizer::getOpcodeSubtypeInfo"
+			switch (original.getType())
+			{
+				case Token::Type::KEYWORD:
+				{
+					KeywordToken& token = genericmanager::Manager<Token>::create<KeywordToken>();
+					token.mKeyword = original.as<KeywordToken>().mKeyword;
+					return token;
+				}
+
+				case Token::Type::VARTYPE:
+				{
+					VarTypeToken& token = genericmanager::Manager<Token>::create<VarTypeToken>();
+					token.mDataType = original.as<VarTypeToken>().mDataType;
+					return token;
+				}
+
+				case Token::Type::OPERATOR:
+				{
+					OperatorToken& token = genericmanager::Manager<Token>::create<OperatorToken>();
+					token.mOperator = original.as<OperatorToken>().mOperator;
+					return token;
+				}
+
+				case Token::Type::LABEL:
+				{
+					LabelToken& token = genericmanager::Manager<Token>::create<LabelToken>();
+					token.mName = original.as<LabelToken>().mName;
+					return token;
+				}
+
+				case Token::Type::CONSTANT:
+				{
+					ConstantToken& token = genericmanager::Manager<Token>::create<ConstantToken>();
+					token.mDataType = original.as<ConstantToken>().mDataType;
+					token.mValue = original.as<ConstantToken>().mValue;
+					return token;
+				}
+
+				case Token::Type::IDENTIFIER:
+				{
+					IdentifierToken& token = genericmanager::Manager<Token>::create<IdentifierToken>();
+					token.mDataType = original.as<IdentifierToken>().mDataType;
+					token.mName = original.as<IdentifierToken>().mName;
+					token.mResolved = original.as<IdentifierToken>().mResolved;
+					return token;
+				}
+
+				default:
+					RMX_ERROR("Unsupported token type in define content", RMX_REACT_THROW);
+					return genericmanager::Manager<Token>::create<KeywordToken>();
+			}
+		}
+
 		bool tryReplaceConstantsUnary(const ConstantToken& constRight, Operator op, int64& outValue)
 		{
 			// TODO: Support float/double as well here
@@ -316,7 +375,7 @@ namespace lemon
 					tokens.erase(i);
 					for (size_t k = 0; k < define.mContent.size(); ++k)
 					{
-						tokens.insert(define.mContent[k], i + k);
+						tokens.insert(createDefineContentTokenCopy(define.mContent[k]), i + k);
 					}
 
 					// TODO: Add implicit cast if necessary
@@ -367,7 +426,7 @@ namespace lemon
 
 	void TokenProcessing::processParentheses(TokenList& tokens)
 	{
-		static std::vector<std::pair<ParenthesisType, size_t>> parenthesisStack;	// Not multi-threading safe
+		static thread_local std::vector<std::pair<ParenthesisType, size_t>> parenthesisStack;
 		parenthesisStack.clear();
 		for (size_t i = 0; i < tokens.size(); ++i)
 		{
@@ -427,7 +486,7 @@ namespace lemon
 		}
 
 		// Find comma positions
-		static std::vector<size_t> commaPositions;	// Not multi-threading safe
+		static thread_local std::vector<size_t> commaPositions;
 		commaPositions.clear();
 		for (size_t i = 0; i < tokens.size(); ++i)
 		{
@@ -714,7 +773,7 @@ namespace lemon
 				tokens.erase(i+1);
 
 				// Assign types
-				static std::vector<const DataTypeDefinition*> parameterTypes;	// Not multi-threading safe
+				static thread_local std::vector<const DataTypeDefinition*> parameterTypes;
 				parameterTypes.resize(functionToken.mParameters.size());
 				for (size_t k = 0; k < functionToken.mParameters.size(); ++k)
 				{
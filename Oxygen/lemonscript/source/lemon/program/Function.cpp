@@ -11,6 +11,7 @@
 #include "lemon/program/Module.h"
 #include "lemon/compiler/Utility.h"
 #include "lemon/runtime/Runtime.h"
+#include "lemon/runtime/RuntimeProfiler.h"
 #include "lemon/utility/PragmaSplitter.h"
 #include "lemon/utility/QuickDataHasher.h"
 
@@ -208,11 +209,27 @@ namespace lemon
 	void NativeFunction::execute(const Context context) const
 	{
 		RuntimeDetailHandler* runtimeDetailHandler = context.mControlFlow.getRuntime().getRuntimeDetailHandler();
-		if (nullptr != runtimeDetailHandler)
+		RuntimeProfiler* runtimeProfiler = context.mControlFlow.getRuntime().getRuntimeProfiler();
+		if (nullptr != runtimeDetailHandler || nullptr != runtimeProfiler)
 		{
-			runtimeDetailHandler->preExecuteExternalFunction(*this, context.mControlFlow);
-			mFunctionWrapper->execute(context);
-			runtimeDetailHandler->postExecuteExternalFunction(*this, context.mControlFlow);
+			if (nullptr != runtimeDetailHandler)
+				runtimeDetailHandler->preExecuteExternalFunction(*this, context.mControlFlow);
+
+			if (nullptr != runtimeProfiler)
+			{
+				// Native functions count as one level deeper than the calling script function
+				const size_t callStackSize = context.mControlFlow.getCallStack().count;
+				runtimeProfiler->onFunctionCalled(*this, callStackSize + 1);
+				mFunctionWrapper->execute(context);
+				runtimeProfiler->onFunctionReturned(callStackSize);
+			}
+			else
+			{
+				mFunctionWrapper->execute(context);
+			}
+
+			if (nullptr != runtimeDetailHandler)
+				runtimeDetailHandler->postExecuteExternalFunction(*this, context.mControlFlow);
 		}
 		else
 		{
@@ -353,11 +353,13 @@ namespace lemon
 
 	LocalVariable& Module::createLocalVariable()
 	{
+		std::lock_guard<std::mutex> lock(mLocalVariablesMutex);
 		return mLocalVariablesPool.createObject();
 	}
 
 	void Module::destroyLocalVariable(LocalVariable& variable)
 	{
+		std::lock_guard<std::mutex> lock(mLocalVariablesMutex);
 		mLocalVariablesPool.destroyObject(variable);
 	}
 
@@ -421,6 +423,79 @@ namespace lemon
 		return (uint32)(mFunctions.size() + mGlobalVariables.size() + mConstants.size() + mConstantArrays.size() + mDefines.size() + mStringLiterals.size());
 	}
 
+	uint64 Module::buildDefinitionsHash(const GlobalsLookup& globalsLookup) const
+	{
+		// In contrast to "buildDependencyHash", this hash covers the contents of all definitions that can influence how code using them gets compiled
+		std::vector<uint8> buffer;
+		VectorBinarySerializer serializer(false, buffer);
+
+		// Functions
+		//  -> Note that function IDs are not included, as calls only refer to the name and signature hash
+		serializer.writeAs<uint32>(mFunctions.size());
+		for (const Function* function : mFunctions)
+		{
+			serializer.write(function->getNameAndSignatureHash());
+			serializer.write(function->getContext().getHash());
+			serializer.write(function->getReturnType()->getID());
+			serializer.writeAs<uint8>(function->getType());
+			serializer.write(function->hasFlag(Function::Flag::ALLOW_INLINE_EXECUTION));
+			serializer.write(function->hasFlag(Function::Flag::COMPILE_TIME_CONSTANT));
+			serializer.writeAs<uint8>(function->getAliasNames().size());
+			for (FlyweightString aliasName : function->getAliasNames())
+				serializer.write(aliasName.getHash());
+		}
+
+		// Global variables
+		serializer.writeAs<uint32>(mGlobalVariables.size());
+		for (const Variable* variable : mGlobalVariables)
+		{
+			serializer.write(variable->getName().getHash());
+			serializer.writeAs<uint8>(variable->getType());
+			serializer.write(variable->getDataType()->getID());
+			serializer.write(variable->getID());
+		}
+
+		// Constants
+		serializer.writeAs<uint32>(mConstants.size());
+		for (const Constant* constant : mConstants)
+		{
+			serializer.write(constant->getName().getHash());
+			serializer.write(constant->getDataType()->getID());
+			serializer.write(constant->getValue().get<uint64>());
+		}
+
+		// Global constant arrays; local ones get defined by the function code itself
+		serializer.writeAs<uint32>(mNumGlobalConstantArrays);
+		for (size_t k = 0; k < mNumGlobalConstantArrays; ++k)
+		{
+			const ConstantArray& constantArray = *mConstantArrays[k];
+			serializer.write(constantArray.getName().getHash());
+			serializer.write(constantArray.getElementDataType()->getID());
+			serializer.write(constantArray.getID());
+			serializer.writeAs<uint32>(constantArray.getSize());
+		}
+
+		// Defines, including their resolved contents
+		serializer.writeAs<uint32>(mDefines.size());
+		for (Define* define : mDefines)
+		{
+			serializer.write(define->getName().getHash());
+			serializer.write(define->getDataType()->getID());
+			TokenSerializer::serializeTokenList(serializer, define->mContent, globalsLookup);
+		}
+
+		// Data types
+		serializer.writeAs<uint32>(mDataTypes.size());
+		for (const CustomDataType* dataType : mDataTypes)
+		{
+			serializer.write(dataType->getName().getHash());
+			serializer.write(dataType->getID());
+			serializer.writeAs<uint8>(dataType->getBaseType());
+		}
+
+		return rmx::getMurmur2_64(buffer.data(), buffer.size());
+	}
+
 	bool Module::serialize(VectorBinarySerializer& outerSerializer, const GlobalsLookup& globalsLookup, uint32 dependencyHash, uint32 appVersion)
 	{
 		return ModuleSerializer::serialize(*this, outerSerializer, globalsLookup, dependencyHash, appVersion);
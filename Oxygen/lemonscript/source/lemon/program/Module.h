@@ -14,6 +14,7 @@
 #include "lemon/program/Function.h"
 #include "lemon/program/SourceFileInfo.h"
 #include "lemon/program/StringRef.h"
+#include <mutex>
 #include <unordered_map>
 
 
@@ -66,6 +67,7 @@ namespace lemon
 		Constant& addConstant(FlyweightString name, const DataTypeDefinition* dataType, AnyBaseValue value);
 
 		// Constant arrays
+		inline const std::vector<ConstantArray*>& getConstantArrays() const  { return mConstantArrays; }
 		ConstantArray& addConstantArray(FlyweightString name, const DataTypeDefinition* elementDataType, const uint64* values, size_t size, bool isGlobalDefinition);
 
 		// Defines
@@ -82,6 +84,7 @@ namespace lemon
 
 		// Serialization
 		uint32 buildDependencyHash() const;
+		uint64 buildDefinitionsHash(const GlobalsLookup& globalsLookup) const;
 		bool serialize(VectorBinarySerializer& serializer, const GlobalsLookup& globalsLookup, uint32 dependencyHash, uint32 appVersion);
 
 		inline uint64 getCompiledCodeHash() const     { return mCompiledCodeHash; }
@@ -111,6 +114,7 @@ namespace lemon
 		uint32 mFirstVariableID = 0;
 		std::vector<Variable*> mGlobalVariables;
 		ObjectPool<LocalVariable, 16> mLocalVariablesPool;
+		std::mutex mLocalVariablesMutex;					// Local variables get created by multiple threads when compiling in parallel
 
 		// Constants
 		std::vector<Constant*> mConstants;
@@ -94,10 +94,10 @@ namespace lemon
 		}
 	}
 
-	void Program::runNativization(const Module& module, const std::wstring& outputFilename, MemoryAccessHandler& memoryAccessHandler)
+	void Program::runNativization(const Module& module, const std::wstring& outputFilename, MemoryAccessHandler& memoryAccessHandler, Nativizer::OutputType outputType)
 	{
 		String output;
-		Nativizer().build(output, module, *this, memoryAccessHandler);
+		Nativizer().build(output, module, *this, memoryAccessHandler, outputType);
 
 		// Check if this is an actual change in the output file
 		{
@@ -133,11 +133,6 @@ namespace lemon
 		return (it == mFunctionsByName.end()) ? EMPTY_FUNCTIONS : it->second;
 	}
 
-	Variable& Program::getGlobalVariableByID(uint32 id) const
-	{
-		return *mGlobalVariables[id & 0x0fffffff];
-	}
-
 	Variable* Program::getGlobalVariableByName(uint64 nameHash) const
 	{
 		const auto it = mGlobalVariablesByName.find(nameHash);
@@ -11,6 +11,7 @@
 #include "lemon/program/ConstantArray.h"
 #include "lemon/program/Define.h"
 #include "lemon/program/Function.h"
+#include "lemon/translator/Nativizer.h"
 #include <unordered_map>
 
 
@@ -34,7 +35,7 @@ namespace lemon
 		void clear();
 		void addModule(const Module& module);
 
-		void runNativization(const Module& module, const std::wstring& outputFilename, MemoryAccessHandler& memoryAccessHandler);
+		void runNativization(const Module& module, const std::wstring& outputFilename, MemoryAccessHandler& memoryAccessHandler, Nativizer::OutputType outputType = Nativizer::OutputType::INCLUDE_FILE);
 
 		// Functions
 		inline const std::vector<Function*>& getFunctions() const  { return mFunctions; }
@@ -45,7 +46,7 @@ namespace lemon
 
 		// Variables
 		inline const std::vector<Variable*>& getGlobalVariables() const  { return mGlobalVariables; }
-		Variable& getGlobalVariableByID(uint32 id) const;
+		inline Variable& getGlobalVariableByID(uint32 id) const  { return *mGlobalVariables[id & 0x0fffffff]; }		// Inline, as nativized mod libraries use this and must not depend on symbols of the application
 		Variable* getGlobalVariableByName(uint64 nameHash) const;
 
 		// Constant arrays
@@ -27,6 +27,7 @@ namespace lemon
 	friend class Runtime;
 	friend class OpcodeExec;
 	friend class OptimizedOpcodeExec;
+	friend class SuperinstructionExec;
 	friend struct RuntimeOpcodeContext;
 
 	public:
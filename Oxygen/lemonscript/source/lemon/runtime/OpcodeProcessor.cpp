@@ -39,6 +39,18 @@ namespace lemon
 					++sequenceLength;
 			}
 			opcodeData[i].mRemainingSequenceLength = sequenceLength;
+			opcodeData[i].mIsJumpTarget = false;
+		}
+
+		// Mark jump targets
+		//  -> The original opcode flags for this are not available any more when the module was deserialized
+		for (size_t i = 0; i < numOpcodes; ++i)
+		{
+			if (opcodes[i].mType == Opcode::Type::JUMP || opcodes[i].mType == Opcode::Type::JUMP_CONDITIONAL)
+			{
+				const size_t jumpTarget = std::min((size_t)opcodes[i].mParameter, numOpcodes - 1);
+				opcodeData[jumpTarget].mIsJumpTarget = true;
+			}
 		}
 	}
 
@@ -21,6 +21,7 @@ namespace lemon
 		struct OpcodeData
 		{
 			uint8 mRemainingSequenceLength = 1;
+			bool mIsJumpTarget = false;
 		};
 
 	public:
@@ -10,6 +10,7 @@
 #include "lemon/runtime/Runtime.h"
 #include "lemon/runtime/RuntimeFunction.h"
 #include "lemon/runtime/RuntimeOpcodeContext.h"
+#include "lemon/runtime/RuntimeProfiler.h"
 #include "lemon/program/Program.h"
 #include "lemon/program/StringRef.h"
 
@@ -18,6 +19,14 @@ namespace lemon
 {
 	namespace
 	{
+		struct ProfilerExecutionScope
+		{
+			inline explicit ProfilerExecutionScope(RuntimeProfiler* profiler) : mProfiler(profiler)  { if (nullptr != mProfiler) mProfiler->beginExecution(); }
+			inline ~ProfilerExecutionScope()  { if (nullptr != mProfiler) mProfiler->endExecution(); }
+
+			RuntimeProfiler* mProfiler = nullptr;
+		};
+
 		int matchCallerProgramCounter(const Program& program, const ControlFlow::State& parentState, const ControlFlow::State& childLocation)
 		{
 			const std::vector<Opcode>& opcodes = parentState.mRuntimeFunction->mFunction->mOpcodes;
@@ -130,6 +139,12 @@ namespace lemon
 		mRuntimeOpcodesPool.clear();
 		mStrings.clear();
 
+		if (nullptr != mRuntimeProfiler)
+		{
+			// Collected data refers to the runtime functions that just got removed
+			mRuntimeProfiler->reset();
+		}
+
 		if (nullptr != mProgram)
 		{
 			// Setup runtime functions (all empty at first)
@@ -159,6 +174,9 @@ namespace lemon
 			controlFlow->reset();	// Existing control flows are only reset, not destroyed
 		}
 		mSelectedControlFlow = mControlFlows[0];	// Reset to main control flow
+
+		if (nullptr != mRuntimeProfiler)
+			mRuntimeProfiler->clearCallStack();
 	}
 
 	void Runtime::setProgram(const Program& program)
@@ -202,6 +220,11 @@ namespace lemon
 		mRuntimeDetailHandler = handler;
 	}
 
+	void Runtime::setRuntimeProfiler(RuntimeProfiler* profiler)
+	{
+		mRuntimeProfiler = profiler;
+	}
+
 	void Runtime::buildAllRuntimeFunctions()
 	{
 		for (Function* function : mProgram->getFunctions())
@@ -291,6 +314,9 @@ namespace lemon
 		state.mBaseCallIndex = baseCallIndex;
 		state.mProgramCounter = runtimeFunction.getFirstRuntimeOpcode();
 		state.mLocalVariablesStart = mSelectedControlFlow->mLocalVariablesSize;
+
+		if (nullptr != mRuntimeProfiler)
+			mRuntimeProfiler->onFunctionCalled(*runtimeFunction.mFunction, mSelectedControlFlow->mCallStack.count);
 	}
 
 	void Runtime::callFunction(const Function& function, size_t baseCallIndex)
@@ -371,6 +397,9 @@ namespace lemon
 
 		mSelectedControlFlow->mLocalVariablesSize = mSelectedControlFlow->mCallStack.back().mLocalVariablesStart;
 		mSelectedControlFlow->mCallStack.pop_back();
+
+		if (nullptr != mRuntimeProfiler)
+			mRuntimeProfiler->onFunctionReturned(mSelectedControlFlow->mCallStack.count);
 		return true;
 	}
 
@@ -389,6 +418,10 @@ namespace lemon
 		context.mControlFlow = mSelectedControlFlow;
 		mActiveControlFlow = mSelectedControlFlow;
 
+		// Profiling is only checked on control flow opcodes, so the common opcodes do not pay for it
+		RuntimeProfiler* const profiler = mRuntimeProfiler;
+		const ProfilerExecutionScope profilerExecutionScope(profiler);
+
 		// Outer loop
 		//  -> Gets restarted whenever the currently running function changes
 		//  -> Gets exited only by a stop signal or a return
@@ -458,8 +491,19 @@ namespace lemon
 					{
 						case Opcode::Type::JUMP_CONDITIONAL:
 						{
-							--mSelectedControlFlow->mValueStackPtr;
-							if (*mSelectedControlFlow->mValueStackPtr != 0)
+							bool conditionMet;
+							if (context.mOpcode->mFlags & RuntimeOpcode::FLAG_JUMP_FUSED_CONDITION)
+							{
+								// Superinstruction that evaluates the condition itself, without using the value stack
+								conditionMet = (*context.mOpcode->getParameter<ConditionFunc>(8))(context);
+							}
+							else
+							{
+								--mSelectedControlFlow->mValueStackPtr;
+								conditionMet = (*mSelectedControlFlow->mValueStackPtr != 0);
+							}
+
+							if (conditionMet)
 							{
 								context.mOpcode = context.mOpcode->mNext;
 								++result.mStepsExecuted;
@@ -476,6 +520,8 @@ namespace lemon
 							// Check if steps limit is reached (this usually means the limit was exceeded already, but that's okay)
 							//  -> This is needed to prevent endless loops
 							++result.mStepsExecuted;
+							if (nullptr != profiler)
+								profiler->onStepsExecuted(*state.mRuntimeFunction, context.mOpcode, result.mStepsExecuted);
 							if (result.mStepsExecuted >= stepsLimit)
 							{
 								mActiveControlFlow = nullptr;
@@ -491,6 +537,8 @@ namespace lemon
 							state.mProgramCounter = (uint8*)context.mOpcode->mNext;
 							const uint64 callTarget = context.mOpcode->getParameter<uint64>();
 							++result.mStepsExecuted;
+							if (nullptr != profiler)
+								profiler->onStepsExecuted(*state.mRuntimeFunction, context.mOpcode, result.mStepsExecuted);
 
 							const Function* func = handleResultCall(*context.mOpcode);
 							if (result.handleCall(func, callTarget))
@@ -509,9 +557,15 @@ namespace lemon
 
 						case Opcode::Type::RETURN:
 						{
+							++result.mStepsExecuted;
+							if (nullptr != profiler)
+							{
+								profiler->onStepsExecuted(*state.mRuntimeFunction, context.mOpcode, result.mStepsExecuted);
+								profiler->onFunctionReturned(mSelectedControlFlow->mCallStack.count - 1);
+							}
+
 							mSelectedControlFlow->mLocalVariablesSize = mSelectedControlFlow->mCallStack.back().mLocalVariablesStart;
 							mSelectedControlFlow->mCallStack.pop_back();
-							++result.mStepsExecuted;
 
 							if (result.handleReturn())
 							{
@@ -657,6 +711,9 @@ namespace lemon
 			{
 				controlFlow->reset();
 			}
+
+			if (nullptr != mRuntimeProfiler)
+				mRuntimeProfiler->clearCallStack();
 		}
 
 		// Signature and version number
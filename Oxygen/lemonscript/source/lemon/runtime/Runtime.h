@@ -17,6 +17,7 @@ namespace lemon
 	class Function;
 	class Program;
 	class NativeFunction;
+	class RuntimeProfiler;
 	class Variable;
 	struct RuntimeOpcode;
 
@@ -128,6 +129,9 @@ namespace lemon
 		inline RuntimeDetailHandler* getRuntimeDetailHandler() const  { return mRuntimeDetailHandler; }
 		void setRuntimeDetailHandler(RuntimeDetailHandler* handler);
 
+		inline RuntimeProfiler* getRuntimeProfiler() const  { return mRuntimeProfiler; }
+		void setRuntimeProfiler(RuntimeProfiler* profiler);
+
 		void buildAllRuntimeFunctions();
 
 		RuntimeFunction* getRuntimeFunction(const ScriptFunction& scriptFunction);
@@ -165,6 +169,7 @@ namespace lemon
 		const Program* mProgram = nullptr;
 		MemoryAccessHandler* mMemoryAccessHandler = nullptr;
 		RuntimeDetailHandler* mRuntimeDetailHandler = nullptr;
+		RuntimeProfiler* mRuntimeProfiler = nullptr;
 
 		std::vector<RuntimeFunction> mRuntimeFunctions;
 		std::unordered_map<const ScriptFunction*, RuntimeFunction*> mRuntimeFunctionsMapped;
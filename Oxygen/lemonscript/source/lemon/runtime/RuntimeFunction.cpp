@@ -13,6 +13,7 @@
 #include "lemon/runtime/OpcodeProcessor.h"
 #include "lemon/runtime/provider/DefaultOpcodeProvider.h"
 #include "lemon/runtime/provider/OptimizedOpcodeProvider.h"
+#include "lemon/runtime/provider/SuperinstructionOpcodeProvider.h"
 #include "lemon/runtime/provider/NativizedOpcodeProvider.h"
 #include "lemon/program/Program.h"
 
@@ -117,7 +118,7 @@ namespace lemon
 				const size_t start = tempBuffer.size();
 
 				int numOpcodesConsumed = 1;
-				createRuntimeOpcode(tempBuffer, &opcodes[i], opcodeData[i].mRemainingSequenceLength, numOpcodesConsumed, runtime);
+				createRuntimeOpcode(tempBuffer, &opcodes[i], &opcodeData[i], opcodeData[i].mRemainingSequenceLength, numOpcodesConsumed, runtime);
 				for (int k = 0; k < numOpcodesConsumed; ++k)
 				{
 					mProgramCounterByOpcodeIndex[k + i] = start;
@@ -230,7 +231,7 @@ namespace lemon
 		return &mRuntimeOpcodeBuffer[index];
 	}
 
-	void RuntimeFunction::createRuntimeOpcode(RuntimeOpcodeBuffer& buffer, const Opcode* opcodes, int numOpcodesAvailable, int& outNumOpcodesConsumed, const Runtime& runtime)
+	void RuntimeFunction::createRuntimeOpcode(RuntimeOpcodeBuffer& buffer, const Opcode* opcodes, const OpcodeProcessor::OpcodeData* opcodeData, int numOpcodesAvailable, int& outNumOpcodesConsumed, const Runtime& runtime)
 	{
 		const Program& program = runtime.getProgram();
 		if (program.getOptimizationLevel() >= 2 && nullptr != program.mNativizedOpcodeProvider)
@@ -240,6 +241,14 @@ namespace lemon
 				return;
 		}
 
+		// Superinstructions for longer opcode sequences, including compare-and-branch
+		if (program.getOptimizationLevel() >= 3)
+		{
+			const bool success = SuperinstructionOpcodeProvider::buildRuntimeOpcodeStatic(buffer, opcodes, opcodeData, numOpcodesAvailable, outNumOpcodesConsumed, runtime);
+			if (success)
+				return;
+		}
+
 		// Runtime opcode generation by merging multiple opcodes where possible
 		if (program.getOptimizationLevel() >= 1)
 		{
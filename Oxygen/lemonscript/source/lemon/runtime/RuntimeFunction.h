@@ -9,6 +9,7 @@
 #pragma once
 
 #include "lemon/runtime/RuntimeOpcode.h"
+#include "lemon/runtime/OpcodeProcessor.h"
 
 
 namespace lemon
@@ -58,7 +59,7 @@ namespace lemon
 		const uint8* translateToRuntimeProgramCounter(size_t originalProgramCounter) const;
 
 	private:
-		void createRuntimeOpcode(RuntimeOpcodeBuffer& buffer, const Opcode* opcodes, int numOpcodesAvailable, int& outNumOpcodesConsumed, const Runtime& runtime);
+		void createRuntimeOpcode(RuntimeOpcodeBuffer& buffer, const Opcode* opcodes, const OpcodeProcessor::OpcodeData* opcodeData, int numOpcodesAvailable, int& outNumOpcodesConsumed, const Runtime& runtime);
 
 	public:
 		const ScriptFunction* mFunction = nullptr;
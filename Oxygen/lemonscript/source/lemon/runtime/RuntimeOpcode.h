@@ -21,6 +21,7 @@ namespace lemon
 
 
 	typedef void(*ExecFunc)(const RuntimeOpcodeContext context);
+	typedef bool(*ConditionFunc)(const RuntimeOpcodeContext context);
 
 	class API_EXPORT RuntimeOpcodeProvider
 	{
@@ -34,6 +35,7 @@ namespace lemon
 	public:
 		enum Flags
 		{
+			FLAG_JUMP_FUSED_CONDITION		= 0x10,		// For JUMP_CONDITIONAL opcodes only: Condition gets evaluated by a ConditionFunc in the parameters, instead of being popped from the value stack
 			FLAG_CALL_IS_BASE_CALL			= 0x20,		// For CALL opcodes only: It is a base call
 			FLAG_CALL_TARGET_RESOLVED		= 0x40,		// For CALL opcodes only: Call target is already resolved and can be found in the parameter (as pointer)
 			FLAG_CALL_TARGET_RUNTIME_FUNC	= 0x80		// For CALL opcodes only: Call target is resolved and is a RuntimeFunction, not a Function
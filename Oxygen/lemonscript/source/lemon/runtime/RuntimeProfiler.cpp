@@ -0,0 +1,242 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#include "lemon/pch.h"
+#include "lemon/runtime/RuntimeProfiler.h"
+#include "lemon/runtime/RuntimeFunction.h"
+#include "lemon/program/Function.h"
+
+#include <chrono>
+
+
+namespace lemon
+{
+	namespace
+	{
+		inline uint64 getClockTime()
+		{
+			return (uint64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		void appendFunctionName(std::string& output, const Function& function)
+		{
+			if (!function.getContext().isEmpty())
+			{
+				output += function.getContext().getString();
+				output += '.';
+			}
+			output += function.getName().getString();
+		}
+	}
+
+
+	RuntimeProfiler::RuntimeProfiler()
+	{
+		reset();
+	}
+
+	void RuntimeProfiler::reset()
+	{
+		mFunctionData.clear();
+		mCallTree.clear();
+		mCallTree.emplace_back();
+		mCallTreeLookup.clear();
+		mFrames.clear();
+		mSamples.clear();
+
+		mNumFrames = 0;
+		mTime = 0;
+		mLastClockTime = getClockTime();
+		mLastSampleSteps = 0;
+	}
+
+	void RuntimeProfiler::clearCallStack()
+	{
+		advanceTime();
+		while (!mFrames.empty())
+		{
+			popFrame();
+		}
+	}
+
+	void RuntimeProfiler::getFunctionStats(std::vector<FunctionStats>& output) const
+	{
+		output.clear();
+		output.reserve(mFunctionData.size());
+		for (const auto& [function, data] : mFunctionData)
+		{
+			FunctionStats& stats = vectorAdd(output);
+			stats.mFunction = function;
+			stats.mCallCount = data.mCallCount;
+			stats.mInclusiveTime = data.mInclusiveTime;
+			stats.mExclusiveTime = data.mExclusiveTime;
+		}
+
+		// Functions still on the call stack did not add their inclusive time yet
+		for (const Frame& frame : mFrames)
+		{
+			if (frame.mOutermost)
+			{
+				for (FunctionStats& stats : output)
+				{
+					if (stats.mFunction == frame.mFunction)
+					{
+						stats.mInclusiveTime += mTime - frame.mStartTime;
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	void RuntimeProfiler::getLocationSamples(std::vector<LocationSample>& output) const
+	{
+		output.clear();
+		output.reserve(mSamples.size());
+		for (const auto& [runtimeOpcode, sample] : mSamples)
+		{
+			LocationSample& locationSample = vectorAdd(output);
+			locationSample.mFunction = sample.mRuntimeFunction->mFunction;
+			locationSample.mProgramCounter = sample.mRuntimeFunction->translateFromRuntimeProgramCounter((const uint8*)runtimeOpcode);
+			locationSample.mSteps = sample.mSteps;
+		}
+	}
+
+	void RuntimeProfiler::writeFoldedStacks(std::string& output) const
+	{
+		std::vector<uint32> path;
+		for (size_t index = 1; index < mCallTree.size(); ++index)
+		{
+			const uint64 microseconds = mCallTree[index].mExclusiveTime / 1000;
+			if (microseconds == 0)
+				continue;
+
+			path.clear();
+			for (uint32 nodeIndex = (uint32)index; nodeIndex != 0; nodeIndex = mCallTree[nodeIndex].mParentIndex)
+			{
+				path.push_back(nodeIndex);
+			}
+
+			for (auto it = path.rbegin(); it != path.rend(); ++it)
+			{
+				if (it != path.rbegin())
+					output += ';';
+				appendFunctionName(output, *mCallTree[*it].mFunction);
+			}
+			output += ' ';
+			output += std::to_string(microseconds);
+			output += '\n';
+		}
+	}
+
+	bool RuntimeProfiler::exportFoldedStacks(const std::wstring& filename) const
+	{
+		std::string output;
+		writeFoldedStacks(output);
+		return FTX::FileSystem->saveFile(filename, output.data(), output.length());
+	}
+
+	void RuntimeProfiler::beginExecution()
+	{
+		if (mExecutionDepth == 0)
+		{
+			mLastClockTime = getClockTime();
+			mLastSampleSteps = 0;
+		}
+		++mExecutionDepth;
+	}
+
+	void RuntimeProfiler::endExecution()
+	{
+		advanceTime();
+		--mExecutionDepth;
+	}
+
+	void RuntimeProfiler::onFunctionCalled(const Function& function, size_t callStackSize)
+	{
+		const uint64 time = advanceTime();
+
+		// Remove frames that were left without a profiler notification, e.g. by exceptions
+		while (!mFrames.empty() && mFrames.back().mDepth >= callStackSize)
+		{
+			popFrame();
+		}
+
+		// Find or create the call tree node
+		const uint32 parentIndex = mFrames.empty() ? 0 : mFrames.back().mNodeIndex;
+		const uint64 key = ((uint64)parentIndex << 32) + function.getID();
+		const auto [it, inserted] = mCallTreeLookup.emplace(key, (uint32)mCallTree.size());
+		if (inserted)
+		{
+			CallTreeNode& node = vectorAdd(mCallTree);
+			node.mFunction = &function;
+			node.mParentIndex = parentIndex;
+		}
+
+		FunctionData& data = mFunctionData[&function];
+		++data.mCallCount;
+
+		Frame& frame = vectorAdd(mFrames);
+		frame.mFunction = &function;
+		frame.mFunctionData = &data;
+		frame.mNodeIndex = it->second;
+		frame.mDepth = callStackSize;
+		frame.mStartTime = time;
+		frame.mOutermost = (data.mActiveCount == 0);
+		++data.mActiveCount;
+	}
+
+	void RuntimeProfiler::onFunctionReturned(size_t callStackSize)
+	{
+		advanceTime();
+		while (!mFrames.empty() && mFrames.back().mDepth > callStackSize)
+		{
+			popFrame();
+		}
+	}
+
+	uint64 RuntimeProfiler::advanceTime()
+	{
+		if (mExecutionDepth > 0)
+		{
+			const uint64 clockTime = getClockTime();
+			const uint64 delta = clockTime - mLastClockTime;
+			mLastClockTime = clockTime;
+			mTime += delta;
+
+			// Attribute the time since the last event to the function on top of the call stack
+			if (!mFrames.empty())
+			{
+				const Frame& frame = mFrames.back();
+				frame.mFunctionData->mExclusiveTime += delta;
+				mCallTree[frame.mNodeIndex].mExclusiveTime += delta;
+			}
+		}
+		return mTime;
+	}
+
+	void RuntimeProfiler::popFrame()
+	{
+		const Frame& frame = mFrames.back();
+		--frame.mFunctionData->mActiveCount;
+		if (frame.mOutermost)
+		{
+			frame.mFunctionData->mInclusiveTime += mTime - frame.mStartTime;
+		}
+		mFrames.pop_back();
+	}
+
+	void RuntimeProfiler::addSample(const RuntimeFunction& runtimeFunction, const void* runtimeOpcode, size_t stepsExecuted)
+	{
+		Sample& sample = mSamples[runtimeOpcode];
+		sample.mRuntimeFunction = &runtimeFunction;
+		sample.mSteps += stepsExecuted - mLastSampleSteps;
+		mLastSampleSteps = stepsExecuted;
+	}
+
+}
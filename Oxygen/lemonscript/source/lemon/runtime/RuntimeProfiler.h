@@ -0,0 +1,126 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#pragma once
+
+#include "lemon/compiler/Definitions.h"
+
+
+namespace lemon
+{
+	class Function;
+	class RuntimeFunction;
+	class ScriptFunction;
+
+
+	// Collects per-function timings and opcode location samples while the runtime executes script code
+	//  -> Timings only advance while inside "Runtime::executeSteps", so time spent outside of scripts is not attributed to functions still on the call stack
+	//  -> Location samples are taken at control flow opcodes (jumps, calls, returns) once a certain number of steps was executed since the last sample
+	class API_EXPORT RuntimeProfiler
+	{
+	public:
+		struct FunctionStats
+		{
+			const Function* mFunction = nullptr;
+			uint64 mCallCount = 0;
+			uint64 mInclusiveTime = 0;		// In nanoseconds, including time spent in called functions
+			uint64 mExclusiveTime = 0;		// In nanoseconds, only time spent in this function itself
+		};
+
+		struct LocationSample
+		{
+			const ScriptFunction* mFunction = nullptr;
+			size_t mProgramCounter = 0;		// Original opcode index inside the function
+			uint64 mSteps = 0;				// Number of executed opcode steps attributed to this location
+		};
+
+	public:
+		RuntimeProfiler();
+
+		void reset();
+		void clearCallStack();
+
+		inline uint32 getSampleInterval() const  { return mSampleInterval; }
+		inline void setSampleInterval(uint32 steps)  { mSampleInterval = std::max<uint32>(steps, 1); }
+
+		inline void nextFrame()  { ++mNumFrames; }
+		inline uint32 getNumFrames() const  { return mNumFrames; }
+		inline uint64 getTotalTime() const  { return mTime; }
+
+		void getFunctionStats(std::vector<FunctionStats>& output) const;
+		void getLocationSamples(std::vector<LocationSample>& output) const;
+
+		// Output in the "folded stacks" format used by flame graph tools, one line per call path with its exclusive time in microseconds
+		void writeFoldedStacks(std::string& output) const;
+		bool exportFoldedStacks(const std::wstring& filename) const;
+
+		// Called by the runtime
+		void beginExecution();
+		void endExecution();
+		void onFunctionCalled(const Function& function, size_t callStackSize);
+		void onFunctionReturned(size_t callStackSize);
+
+		inline void onStepsExecuted(const RuntimeFunction& runtimeFunction, const void* runtimeOpcode, size_t stepsExecuted)
+		{
+			if (stepsExecuted >= mLastSampleSteps + mSampleInterval)
+				addSample(runtimeFunction, runtimeOpcode, stepsExecuted);
+		}
+
+	private:
+		struct FunctionData
+		{
+			uint64 mCallCount = 0;
+			uint64 mInclusiveTime = 0;
+			uint64 mExclusiveTime = 0;
+			uint32 mActiveCount = 0;		// Number of frames of this function currently on the call stack, for correct inclusive times of recursive calls
+		};
+
+		struct CallTreeNode
+		{
+			const Function* mFunction = nullptr;
+			uint32 mParentIndex = 0;
+			uint64 mExclusiveTime = 0;
+		};
+
+		struct Frame
+		{
+			const Function* mFunction = nullptr;
+			FunctionData* mFunctionData = nullptr;
+			uint32 mNodeIndex = 0;
+			size_t mDepth = 0;				// Call stack size of the control flow while this frame is active
+			uint64 mStartTime = 0;
+			bool mOutermost = false;
+		};
+
+		struct Sample
+		{
+			const RuntimeFunction* mRuntimeFunction = nullptr;
+			uint64 mSteps = 0;
+		};
+
+	private:
+		uint64 advanceTime();
+		void popFrame();
+		void addSample(const RuntimeFunction& runtimeFunction, const void* runtimeOpcode, size_t stepsExecuted);
+
+	private:
+		std::unordered_map<const Function*, FunctionData> mFunctionData;
+		std::vector<CallTreeNode> mCallTree;				// Node at index 0 is the root, which does not represent a function
+		std::unordered_map<uint64, uint32> mCallTreeLookup;	// Key is parent node index in the upper 32 bits and function ID in the lower 32 bits
+		std::vector<Frame> mFrames;
+		std::unordered_map<const void*, Sample> mSamples;	// Key is the runtime opcode where the sample was taken
+
+		uint32 mSampleInterval = 64;
+		uint32 mNumFrames = 0;
+		uint64 mTime = 0;				// Accumulated execution time in nanoseconds
+		uint64 mLastClockTime = 0;
+		uint32 mExecutionDepth = 0;
+		size_t mLastSampleSteps = 0;
+	};
+
+}
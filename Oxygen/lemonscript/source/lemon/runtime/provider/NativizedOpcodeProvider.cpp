@@ -22,35 +22,62 @@ namespace lemon
 		(*buildFunction)(mLookupDictionary);
 	}
 
+	bool NativizedOpcodeProvider::isValid() const
+	{
+		if (!mLookupDictionary.mEntries.empty())
+			return true;
+		for (const Nativizer::LookupDictionary& dictionary : mLibraryLookupDictionaries)
+		{
+			if (!dictionary.mEntries.empty())
+				return true;
+		}
+		return false;
+	}
+
+	bool NativizedOpcodeProvider::addLibraryLookup(const Nativizer::LibraryData& libraryData)
+	{
+		Nativizer::LookupDictionary& dictionary = mLibraryLookupDictionaries.emplace_back();
+		if (!dictionary.loadLibraryData(libraryData))
+		{
+			mLibraryLookupDictionaries.pop_back();
+			return false;
+		}
+		return true;
+	}
+
+	void NativizedOpcodeProvider::clearLibraryLookups()
+	{
+		mLibraryLookupDictionaries.clear();
+	}
+
 	bool NativizedOpcodeProvider::buildRuntimeOpcode(RuntimeOpcodeBuffer& buffer, const Opcode* opcodes, int numOpcodesAvailable, int& outNumOpcodesConsumed, const Runtime& runtime)
 	{
-		if (mLookupDictionary.mEntries.empty() || numOpcodesAvailable < (int)Nativizer::MIN_OPCODES)
+		if (numOpcodesAvailable < (int)Nativizer::MIN_OPCODES)
 			return false;
 
-		Nativizer::LookupEntry* bestEntry = nullptr;
-		uint64 bestEntryHash = 0;		// Variable exists only for debugging
+		// Search all dictionaries and use the one with the longest match
+		const Nativizer::LookupDictionary* bestDictionary = nullptr;
+		const Nativizer::LookupEntry* bestEntry = nullptr;
+		outNumOpcodesConsumed = 0;
 		{
-			uint64 hash = Nativizer::getStartHash();
-			for (size_t index = 0; index < (size_t)numOpcodesAvailable; )
+			int numOpcodesConsumed = 0;
+			const Nativizer::LookupEntry* entry = findBestEntry(mLookupDictionary, opcodes, numOpcodesAvailable, numOpcodesConsumed, runtime);
+			if (nullptr != entry)
 			{
-				Nativizer::OpcodeSubtypeInfo info;
-				Nativizer::getOpcodeSubtypeInfo(info, &opcodes[index], numOpcodesAvailable, *runtime.getMemoryAccessHandler());
-				hash = Nativizer::addOpcodeSubtypeInfoToHash(hash, info);
-				index += info.mConsumedOpcodes;
-
-				if (index >= Nativizer::MIN_OPCODES)
-				{
-					const auto it = mLookupDictionary.mEntries.find(hash);
-					if (it == mLookupDictionary.mEntries.end())
-						return false;
-
-					if (nullptr != it->second.mExecFunc)
-					{
-						bestEntry = &it->second;
-						bestEntryHash = hash;
-						outNumOpcodesConsumed = (int)index;
-					}
-				}
+				bestDictionary = &mLookupDictionary;
+				bestEntry = entry;
+				outNumOpcodesConsumed = numOpcodesConsumed;
+			}
+		}
+		for (const Nativizer::LookupDictionary& dictionary : mLibraryLookupDictionaries)
+		{
+			int numOpcodesConsumed = 0;
+			const Nativizer::LookupEntry* entry = findBestEntry(dictionary, opcodes, numOpcodesAvailable, numOpcodesConsumed, runtime);
+			if (nullptr != entry && numOpcodesConsumed > outNumOpcodesConsumed)
+			{
+				bestDictionary = &dictionary;
+				bestEntry = entry;
+				outNumOpcodesConsumed = numOpcodesConsumed;
 			}
 		}
 
@@ -61,7 +88,7 @@ namespace lemon
 			int numParameters = 0;
 			size_t parameterSize = 0;
 			{
-				const Nativizer::LookupEntry::ParameterInfo* parameterPtr = &mLookupDictionary.mParameterData[entry.mParameterStart];
+				const Nativizer::LookupEntry::ParameterInfo* parameterPtr = &bestDictionary->mParameterData[entry.mParameterStart];
 				while (parameterPtr->mOpcodeIndex != 0xff)
 				{
 					++parameterPtr;
@@ -75,7 +102,7 @@ namespace lemon
 			runtimeOpcode.mExecFunc = entry.mExecFunc;
 			{
 				// Go through all parameters (again), now adding them to the runtime opcode
-				const Nativizer::LookupEntry::ParameterInfo* parameterPtr = &mLookupDictionary.mParameterData[entry.mParameterStart];
+				const Nativizer::LookupEntry::ParameterInfo* parameterPtr = &bestDictionary->mParameterData[entry.mParameterStart];
 				for (int k = 0; k < numParameters; ++k)
 				{
 					const Nativizer::LookupEntry::ParameterInfo& parameter = parameterPtr[k];
@@ -123,4 +150,35 @@ namespace lemon
 		return false;
 	}
 
+
+	const Nativizer::LookupEntry* NativizedOpcodeProvider::findBestEntry(const Nativizer::LookupDictionary& dictionary, const Opcode* opcodes, int numOpcodesAvailable, int& outNumOpcodesConsumed, const Runtime& runtime) const
+	{
+		if (dictionary.mEntries.empty())
+			return nullptr;
+
+		const Nativizer::LookupEntry* bestEntry = nullptr;
+		uint64 hash = Nativizer::getStartHash();
+		for (size_t index = 0; index < (size_t)numOpcodesAvailable; )
+		{
+			Nativizer::OpcodeSubtypeInfo info;
+			Nativizer::getOpcodeSubtypeInfo(info, &opcodes[index], numOpcodesAvailable, *runtime.getMemoryAccessHandler());
+			hash = Nativizer::addOpcodeSubtypeInfoToHash(hash, info);
+			index += info.mConsumedOpcodes;
+
+			if (index >= Nativizer::MIN_OPCODES)
+			{
+				const auto it = dictionary.mEntries.find(hash);
+				if (it == dictionary.mEntries.end())
+					return nullptr;
+
+				if (nullptr != it->second.mExecFunc)
+				{
+					bestEntry = &it->second;
+					outNumOpcodesConsumed = (int)index;
+				}
+			}
+		}
+		return bestEntry;
+	}
+
 }
@@ -22,12 +22,22 @@ namespace lemon
 		inline NativizedOpcodeProvider() {}
 		inline NativizedOpcodeProvider(BuildFunction buildFunction) { buildLookup(buildFunction); }
 
-		inline bool isValid() const  { return !mLookupDictionary.mEntries.empty(); }
+		bool isValid() const;
 		void buildLookup(BuildFunction buildFunction);
 
+		// Add nativized code loaded from a shared library, e.g. for a mod's scripts
+		//  -> Returns false if the library data is not compatible
+		//  -> Note that the library must stay loaded for as long as this provider is in use
+		bool addLibraryLookup(const Nativizer::LibraryData& libraryData);
+		void clearLibraryLookups();
+
 		bool buildRuntimeOpcode(RuntimeOpcodeBuffer& buffer, const Opcode* opcodes, int numOpcodesAvailable, int& outNumOpcodesConsumed, const Runtime& runtime) override;
 
+	private:
+		const Nativizer::LookupEntry* findBestEntry(const Nativizer::LookupDictionary& dictionary, const Opcode* opcodes, int numOpcodesAvailable, int& outNumOpcodesConsumed, const Runtime& runtime) const;
+
 	protected:
 		Nativizer::LookupDictionary mLookupDictionary;	// This needs to be filled by either a sub-class implementation or a call to the buildLookup method
+		std::vector<Nativizer::LookupDictionary> mLibraryLookupDictionaries;
 	};
 }
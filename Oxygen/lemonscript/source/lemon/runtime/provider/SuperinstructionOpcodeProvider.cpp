@@ -0,0 +1,446 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#include "lemon/pch.h"
+#include "lemon/runtime/provider/SuperinstructionOpcodeProvider.h"
+#include "lemon/runtime/RuntimeFunction.h"
+#include "lemon/runtime/RuntimeOpcodeContext.h"
+#include "lemon/runtime/OpcodeExecUtils.h"
+#include "lemon/program/Program.h"
+
+
+namespace lemon
+{
+
+	#define SELECT_FUNC_BY_DATATYPE_INT(_target_, _function_, _operation_, _datatype_) \
+	{ \
+		switch (_datatype_) \
+		{ \
+			case BaseType::INT_8:		_target_ = &_function_<int8, _operation_>;		break; \
+			case BaseType::INT_16:		_target_ = &_function_<int16, _operation_>;		break; \
+			case BaseType::INT_32:		_target_ = &_function_<int32, _operation_>;		break; \
+			case BaseType::INT_64:		_target_ = &_function_<int64, _operation_>;		break; \
+			case BaseType::UINT_8:		_target_ = &_function_<uint8, _operation_>;		break; \
+			case BaseType::UINT_16:		_target_ = &_function_<uint16, _operation_>;	break; \
+			case BaseType::UINT_32:		_target_ = &_function_<uint32, _operation_>;	break; \
+			case BaseType::UINT_64:		_target_ = &_function_<uint64, _operation_>;	break; \
+			case BaseType::INT_CONST:	_target_ = &_function_<uint64, _operation_>;	break; \
+			default:					_target_ = nullptr;								break; \
+		} \
+	}
+
+	#define SELECT_FUNC_BY_ARITHM_OPERATION(_target_, _function_, _opcodetype_, _datatype_) \
+	{ \
+		switch (_opcodetype_) \
+		{ \
+			case Opcode::Type::ARITHM_ADD:	SELECT_FUNC_BY_DATATYPE_INT(_target_, _function_, SuperinstructionExec::OperationAdd, _datatype_);	break; \
+			case Opcode::Type::ARITHM_SUB:	SELECT_FUNC_BY_DATATYPE_INT(_target_, _function_, SuperinstructionExec::OperationSub, _datatype_);	break; \
+			case Opcode::Type::ARITHM_MUL:	SELECT_FUNC_BY_DATATYPE_INT(_target_, _function_, SuperinstructionExec::OperationMul, _datatype_);	break; \
+			case Opcode::Type::ARITHM_DIV:	SELECT_FUNC_BY_DATATYPE_INT(_target_, _function_, SuperinstructionExec::OperationDiv, _datatype_);	break; \
+			case Opcode::Type::ARITHM_MOD:	SELECT_FUNC_BY_DATATYPE_INT(_target_, _function_, SuperinstructionExec::OperationMod, _datatype_);	break; \
+			case Opcode::Type::ARITHM_AND:	SELECT_FUNC_BY_DATATYPE_INT(_target_, _function_, SuperinstructionExec::OperationAnd, _datatype_);	break; \
+			case Opcode::Type::ARITHM_OR:	SELECT_FUNC_BY_DATATYPE_INT(_target_, _function_, SuperinstructionExec::OperationOr,  _datatype_);	break; \
+			case Opcode::Type::ARITHM_XOR:	SELECT_FUNC_BY_DATATYPE_INT(_target_, _function_, SuperinstructionExec::OperationXor, _datatype_);	break; \
+			case Opcode::Type::ARITHM_SHL:	SELECT_FUNC_BY_DATATYPE_INT(_target_, _function_, SuperinstructionExec::OperationShl, _datatype_);	break; \
+			case Opcode::Type::ARITHM_SHR:	SELECT_FUNC_BY_DATATYPE_INT(_target_, _function_, SuperinstructionExec::OperationShr, _datatype_);	break; \
+			default:						_target_ = nullptr;	break; \
+		} \
+	}
+
+	#define SELECT_FUNC_BY_COMPARE_OPERATION(_target_, _function_, _opcodetype_, _datatype_) \
+	{ \
+		switch (_opcodetype_) \
+		{ \
+			case Opcode::Type::COMPARE_EQ:	SELECT_FUNC_BY_DATATYPE_INT(_target_, _function_, SuperinstructionExec::CompareEQ,  _datatype_);	break; \
+			case Opcode::Type::COMPARE_NEQ:	SELECT_FUNC_BY_DATATYPE_INT(_target_, _function_, SuperinstructionExec::CompareNEQ, _datatype_);	break; \
+			case Opcode::Type::COMPARE_LT:	SELECT_FUNC_BY_DATATYPE_INT(_target_, _function_, SuperinstructionExec::CompareLT,  _datatype_);	break; \
+			case Opcode::Type::COMPARE_LE:	SELECT_FUNC_BY_DATATYPE_INT(_target_, _function_, SuperinstructionExec::CompareLE,  _datatype_);	break; \
+			case Opcode::Type::COMPARE_GT:	SELECT_FUNC_BY_DATATYPE_INT(_target_, _function_, SuperinstructionExec::CompareGT,  _datatype_);	break; \
+			case Opcode::Type::COMPARE_GE:	SELECT_FUNC_BY_DATATYPE_INT(_target_, _function_, SuperinstructionExec::CompareGE,  _datatype_);	break; \
+			default:						_target_ = nullptr;	break; \
+		} \
+	}
+
+
+	class SuperinstructionExec
+	{
+	public:
+		struct OperationAdd { template<typename T> FORCE_INLINE static T apply(T a, T b)  { return a + b; } };
+		struct OperationSub { template<typename T> FORCE_INLINE static T apply(T a, T b)  { return a - b; } };
+		struct OperationMul { template<typename T> FORCE_INLINE static T apply(T a, T b)  { return a * b; } };
+		struct OperationDiv { template<typename T> FORCE_INLINE static T apply(T a, T b)  { return OpcodeExecUtils::safeDivide(a, b); } };
+		struct OperationMod { template<typename T> FORCE_INLINE static T apply(T a, T b)  { return OpcodeExecUtils::safeModulo(a, b); } };
+		struct OperationAnd { template<typename T> FORCE_INLINE static T apply(T a, T b)  { return a & b; } };
+		struct OperationOr  { template<typename T> FORCE_INLINE static T apply(T a, T b)  { return a | b; } };
+		struct OperationXor { template<typename T> FORCE_INLINE static T apply(T a, T b)  { return a ^ b; } };
+		struct OperationShl { template<typename T> FORCE_INLINE static T apply(T a, T b)  { return a << (b & (sizeof(T) * 8 - 1)); } };
+		struct OperationShr { template<typename T> FORCE_INLINE static T apply(T a, T b)  { return a >> (b & (sizeof(T) * 8 - 1)); } };
+
+		struct CompareEQ  { template<typename T> FORCE_INLINE static bool apply(T a, T b)  { return a == b; } };
+		struct CompareNEQ { template<typename T> FORCE_INLINE static bool apply(T a, T b)  { return a != b; } };
+		struct CompareLT  { template<typename T> FORCE_INLINE static bool apply(T a, T b)  { return a < b; } };
+		struct CompareLE  { template<typename T> FORCE_INLINE static bool apply(T a, T b)  { return a <= b; } };
+		struct CompareGT  { template<typename T> FORCE_INLINE static bool apply(T a, T b)  { return a > b; } };
+		struct CompareGE  { template<typename T> FORCE_INLINE static bool apply(T a, T b)  { return a >= b; } };
+
+		// Parameters: uint32 source variable ID, uint32 target variable ID, constant value
+		template<typename T, typename OPERATION>
+		static void exec_SI_LOCAL_OPERATION_CONSTANT_STORE(const RuntimeOpcodeContext context)
+		{
+			const T value = OPERATION::apply(context.readLocalVariable<T>(context.getParameter<uint32>()), context.getParameter<T>(8));
+			context.writeLocalVariable<T>(context.getParameter<uint32>(4), value);
+		}
+
+		// Parameters: uint32 source variable ID, constant value at offset 8
+		template<typename T, typename OPERATION>
+		static void exec_SI_LOCAL_OPERATION_CONSTANT(const RuntimeOpcodeContext context)
+		{
+			context.writeValueStack<T>(0, OPERATION::apply(context.readLocalVariable<T>(context.getParameter<uint32>()), context.getParameter<T>(8)));
+			++context.mControlFlow->mValueStackPtr;
+		}
+
+		// Parameters: direct access pointer, constant value
+		template<typename T, typename OPERATION>
+		static void exec_SI_MODIFY_MEMORY_FIXED_ADDR_DIRECT(const RuntimeOpcodeContext context)
+		{
+			T* pointer = context.getParameter<T*>();
+			*pointer = OPERATION::apply(*pointer, context.getParameter<T>(8));
+		}
+
+		// Parameters: direct access pointer, constant value
+		template<typename T, typename OPERATION>
+		static void exec_SI_MODIFY_MEMORY_FIXED_ADDR_DIRECT_SWAP(const RuntimeOpcodeContext context)
+		{
+			T* pointer = context.getParameter<T*>();
+			*pointer = rmx::swapBytes(OPERATION::apply(rmx::swapBytes(*pointer), context.getParameter<T>(8)));
+		}
+
+		// Parameters: address, constant value
+		template<typename T, typename OPERATION>
+		static void exec_SI_MODIFY_MEMORY_FIXED_ADDR(const RuntimeOpcodeContext context)
+		{
+			const uint64 address = context.getParameter<uint64>();
+			const T value = OpcodeExecUtils::readMemory<T>(*context.mControlFlow, address);
+			OpcodeExecUtils::writeMemory<T>(*context.mControlFlow, address, OPERATION::apply(value, context.getParameter<T>(8)));
+		}
+
+		// Parameters: pointer to external variable, offset constant
+		template<typename T>
+		static void exec_SI_READ_MEMORY_EXTERNAL_OFFSET(const RuntimeOpcodeContext context)
+		{
+			const uint32 address = *context.getParameter<uint32*>() + context.getParameter<uint32>(8);
+			*context.mControlFlow->mValueStackPtr = OpcodeExecUtils::readMemory<T>(*context.mControlFlow, address);
+			++context.mControlFlow->mValueStackPtr;
+		}
+
+		// Condition functions for fused conditional jumps
+		//  -> Parameters always start with the jump target and the condition function pointer itself, so own parameters start at offset 16
+
+		template<typename T, typename COMPARE>
+		static bool cond_SI_COMPARE(const RuntimeOpcodeContext context)
+		{
+			context.mControlFlow->mValueStackPtr -= 2;
+			return COMPARE::apply(context.readValueStack<T>(0), context.readValueStack<T>(1));
+		}
+
+		template<typename T, typename COMPARE>
+		static bool cond_SI_COMPARE_CONSTANT(const RuntimeOpcodeContext context)
+		{
+			--context.mControlFlow->mValueStackPtr;
+			return COMPARE::apply(context.readValueStack<T>(0), context.getParameter<T>(16));
+		}
+
+		template<typename T, typename COMPARE>
+		static bool cond_SI_COMPARE_LOCAL_CONSTANT(const RuntimeOpcodeContext context)
+		{
+			return COMPARE::apply(context.readLocalVariable<T>(context.getParameter<uint32>(24)), context.getParameter<T>(16));
+		}
+
+		template<typename T, typename COMPARE>
+		static bool cond_SI_COMPARE_MEMORY_FIXED_ADDR_DIRECT_CONSTANT(const RuntimeOpcodeContext context)
+		{
+			return COMPARE::apply(*context.getParameter<T*>(24), context.getParameter<T>(16));
+		}
+
+		template<typename T, typename COMPARE>
+		static bool cond_SI_COMPARE_MEMORY_FIXED_ADDR_DIRECT_SWAP_CONSTANT(const RuntimeOpcodeContext context)
+		{
+			return COMPARE::apply(rmx::swapBytes(*context.getParameter<T*>(24)), context.getParameter<T>(16));
+		}
+
+		template<typename T, typename COMPARE>
+		static bool cond_SI_COMPARE_MEMORY_FIXED_ADDR_CONSTANT(const RuntimeOpcodeContext context)
+		{
+			return COMPARE::apply(OpcodeExecUtils::readMemory<T>(*context.mControlFlow, context.getParameter<uint64>(24)), context.getParameter<T>(16));
+		}
+	};
+
+
+	namespace
+	{
+		FORCE_INLINE bool isLocalVariable(const Opcode& opcode)
+		{
+			return (Variable::Type)((uint32)(opcode.mParameter) >> 28) == Variable::Type::LOCAL;
+		}
+
+		FORCE_INLINE bool isDiscardingMoveStack(const Opcode& opcode)
+		{
+			return (opcode.mType == Opcode::Type::MOVE_STACK && opcode.mParameter == -1);
+		}
+
+		FORCE_INLINE bool isBinaryArithmetic(const Opcode& opcode)
+		{
+			return (opcode.mType >= Opcode::Type::ARITHM_ADD && opcode.mType <= Opcode::Type::ARITHM_SHR);
+		}
+
+		FORCE_INLINE bool isComparison(const Opcode& opcode)
+		{
+			return (opcode.mType >= Opcode::Type::COMPARE_EQ && opcode.mType <= Opcode::Type::COMPARE_GE);
+		}
+
+		bool canFuseConditionalJump(const Opcode* opcodes, const OpcodeProcessor::OpcodeData* opcodeData, int numOpcodesAvailable, int jumpIndex)
+		{
+			// The conditional jump must directly follow the sequence, and must not be a jump target itself
+			//  -> Otherwise the jump translation in "RuntimeFunction::build" would lead into the middle of the merged runtime opcode
+			return (nullptr != opcodeData && numOpcodesAvailable == jumpIndex && opcodes[jumpIndex].mType == Opcode::Type::JUMP_CONDITIONAL && !opcodeData[jumpIndex].mIsJumpTarget);
+		}
+
+		void addFusedConditionalJump(RuntimeOpcodeBuffer& buffer, const Opcode& jumpOpcode, ConditionFunc conditionFunc, uint64 constant, uint64 extraParameter)
+		{
+			RuntimeOpcode& runtimeOpcode = buffer.addOpcode(32);
+			runtimeOpcode.mOpcodeType = Opcode::Type::JUMP_CONDITIONAL;
+			runtimeOpcode.mFlags |= RuntimeOpcode::FLAG_JUMP_FUSED_CONDITION;
+			runtimeOpcode.mSuccessiveHandledOpcodes = 0;
+			runtimeOpcode.setParameter<uint64>((uint64)jumpOpcode.mParameter);		// Gets translated to the actual target later on
+			runtimeOpcode.setParameter(conditionFunc, 8);
+			runtimeOpcode.setParameter(constant, 16);
+			runtimeOpcode.setParameter(extraParameter, 24);
+		}
+	}
+
+
+	bool SuperinstructionOpcodeProvider::buildRuntimeOpcodeStatic(RuntimeOpcodeBuffer& buffer, const Opcode* opcodes, const OpcodeProcessor::OpcodeData* opcodeData, int numOpcodesAvailable, int& outNumOpcodesConsumed, const Runtime& runtime)
+	{
+		// Compare-and-branch: Fixed address memory read compared to a constant
+		//  -> PUSH_CONSTANT, READ_MEMORY, PUSH_CONSTANT, COMPARE_*, JUMP_CONDITIONAL
+		if (numOpcodesAvailable >= 4 && opcodes[0].mType == Opcode::Type::PUSH_CONSTANT && opcodes[1].mType == Opcode::Type::READ_MEMORY && opcodes[1].mParameter == 0 &&
+			opcodes[2].mType == Opcode::Type::PUSH_CONSTANT && isComparison(opcodes[3]) && canFuseConditionalJump(opcodes, opcodeData, numOpcodesAvailable, 4))
+		{
+			// Comparison must use a data type of the same size as the memory read, so the read value does not need any conversion
+			const size_t size = DataTypeHelper::getSizeOfBaseType(opcodes[1].mDataType);
+			if (size == DataTypeHelper::getSizeOfBaseType(opcodes[3].mDataType))
+			{
+				const uint64 address = opcodes[0].mParameter;
+				MemoryAccessHandler::SpecializationResult result;
+				runtime.getMemoryAccessHandler()->getDirectAccessSpecialization(result, address, size, false);
+
+				ConditionFunc conditionFunc = nullptr;
+				uint64 extraParameter = address;
+				if (result.mResult == MemoryAccessHandler::SpecializationResult::HAS_SPECIALIZATION)
+				{
+					if (result.mSwapBytes)
+					{
+						SELECT_FUNC_BY_COMPARE_OPERATION(conditionFunc, SuperinstructionExec::cond_SI_COMPARE_MEMORY_FIXED_ADDR_DIRECT_SWAP_CONSTANT, opcodes[3].mType, opcodes[3].mDataType);
+					}
+					else
+					{
+						SELECT_FUNC_BY_COMPARE_OPERATION(conditionFunc, SuperinstructionExec::cond_SI_COMPARE_MEMORY_FIXED_ADDR_DIRECT_CONSTANT, opcodes[3].mType, opcodes[3].mDataType);
+					}
+					extraParameter = reinterpret_cast<uint64>(result.mDirectAccessPointer);
+				}
+				else
+				{
+					SELECT_FUNC_BY_COMPARE_OPERATION(conditionFunc, SuperinstructionExec::cond_SI_COMPARE_MEMORY_FIXED_ADDR_CONSTANT, opcodes[3].mType, opcodes[3].mDataType);
+				}
+
+				if (nullptr != conditionFunc)
+				{
+					addFusedConditionalJump(buffer, opcodes[4], conditionFunc, opcodes[2].mParameter, extraParameter);
+					outNumOpcodesConsumed = 5;
+					return true;
+				}
+			}
+		}
+
+		// Compare-and-branch: Local variable compared to a constant
+		//  -> GET_VARIABLE_VALUE, PUSH_CONSTANT, COMPARE_*, JUMP_CONDITIONAL
+		if (numOpcodesAvailable >= 3 && opcodes[0].mType == Opcode::Type::GET_VARIABLE_VALUE && isLocalVariable(opcodes[0]) &&
+			opcodes[1].mType == Opcode::Type::PUSH_CONSTANT && isComparison(opcodes[2]) && canFuseConditionalJump(opcodes, opcodeData, numOpcodesAvailable, 3))
+		{
+			ConditionFunc conditionFunc = nullptr;
+			SELECT_FUNC_BY_COMPARE_OPERATION(conditionFunc, SuperinstructionExec::cond_SI_COMPARE_LOCAL_CONSTANT, opcodes[2].mType, opcodes[2].mDataType);
+			if (nullptr != conditionFunc)
+			{
+				addFusedConditionalJump(buffer, opcodes[3], conditionFunc, opcodes[1].mParameter, (uint32)opcodes[0].mParameter);
+				outNumOpcodesConsumed = 4;
+				return true;
+			}
+		}
+
+		// Compare-and-branch: Value on the stack compared to a constant
+		//  -> PUSH_CONSTANT, COMPARE_*, JUMP_CONDITIONAL
+		if (numOpcodesAvailable >= 2 && opcodes[0].mType == Opcode::Type::PUSH_CONSTANT && isComparison(opcodes[1]) && canFuseConditionalJump(opcodes, opcodeData, numOpcodesAvailable, 2))
+		{
+			ConditionFunc conditionFunc = nullptr;
+			SELECT_FUNC_BY_COMPARE_OPERATION(conditionFunc, SuperinstructionExec::cond_SI_COMPARE_CONSTANT, opcodes[1].mType, opcodes[1].mDataType);
+			if (nullptr != conditionFunc)
+			{
+				addFusedConditionalJump(buffer, opcodes[2], conditionFunc, opcodes[0].mParameter, 0);
+				outNumOpcodesConsumed = 3;
+				return true;
+			}
+		}
+
+		// Compare-and-branch: Two values on the stack compared to each other
+		//  -> COMPARE_*, JUMP_CONDITIONAL
+		if (numOpcodesAvailable >= 1 && isComparison(opcodes[0]) && canFuseConditionalJump(opcodes, opcodeData, numOpcodesAvailable, 1))
+		{
+			ConditionFunc conditionFunc = nullptr;
+			SELECT_FUNC_BY_COMPARE_OPERATION(conditionFunc, SuperinstructionExec::cond_SI_COMPARE, opcodes[0].mType, opcodes[0].mDataType);
+			if (nullptr != conditionFunc)
+			{
+				addFusedConditionalJump(buffer, opcodes[1], conditionFunc, 0, 0);
+				outNumOpcodesConsumed = 2;
+				return true;
+			}
+		}
+
+		// Read-modify-write on a fixed memory address, with the result discarded
+		//  -> PUSH_CONSTANT, READ_MEMORY (no consume), PUSH_CONSTANT, ARITHM_*, WRITE_MEMORY (exchanged), MOVE_STACK
+		if (numOpcodesAvailable >= 6 && opcodes[0].mType == Opcode::Type::PUSH_CONSTANT && opcodes[1].mType == Opcode::Type::READ_MEMORY && opcodes[1].mParameter == 1 &&
+			opcodes[2].mType == Opcode::Type::PUSH_CONSTANT && isBinaryArithmetic(opcodes[3]) && opcodes[4].mType == Opcode::Type::WRITE_MEMORY && opcodes[4].mParameter == 1 &&
+			isDiscardingMoveStack(opcodes[5]))
+		{
+			// Operation must use a data type of the same size as the memory access, so read and written values do not need any conversion
+			const size_t size = DataTypeHelper::getSizeOfBaseType(opcodes[1].mDataType);
+			if (size == DataTypeHelper::getSizeOfBaseType(opcodes[4].mDataType) && size == DataTypeHelper::getSizeOfBaseType(opcodes[3].mDataType))
+			{
+				const uint64 address = opcodes[0].mParameter;
+				MemoryAccessHandler::SpecializationResult readResult;
+				MemoryAccessHandler::SpecializationResult writeResult;
+				runtime.getMemoryAccessHandler()->getDirectAccessSpecialization(readResult, address, size, false);
+				runtime.getMemoryAccessHandler()->getDirectAccessSpecialization(writeResult, address, size, true);
+
+				ExecFunc execFunc = nullptr;
+				uint64 parameter = address;
+				if (readResult.mResult == MemoryAccessHandler::SpecializationResult::HAS_SPECIALIZATION && writeResult.mResult == MemoryAccessHandler::SpecializationResult::HAS_SPECIALIZATION &&
+					readResult.mDirectAccessPointer == writeResult.mDirectAccessPointer && readResult.mSwapBytes == writeResult.mSwapBytes)
+				{
+					if (readResult.mSwapBytes)
+					{
+						SELECT_FUNC_BY_ARITHM_OPERATION(execFunc, SuperinstructionExec::exec_SI_MODIFY_MEMORY_FIXED_ADDR_DIRECT_SWAP, opcodes[3].mType, opcodes[3].mDataType);
+					}
+					else
+					{
+						SELECT_FUNC_BY_ARITHM_OPERATION(execFunc, SuperinstructionExec::exec_SI_MODIFY_MEMORY_FIXED_ADDR_DIRECT, opcodes[3].mType, opcodes[3].mDataType);
+					}
+					parameter = reinterpret_cast<uint64>(readResult.mDirectAccessPointer);
+				}
+				else
+				{
+					SELECT_FUNC_BY_ARITHM_OPERATION(execFunc, SuperinstructionExec::exec_SI_MODIFY_MEMORY_FIXED_ADDR, opcodes[3].mType, opcodes[3].mDataType);
+				}
+
+				if (nullptr != execFunc)
+				{
+					RuntimeOpcode& runtimeOpcode = buffer.addOpcode(16);
+					runtimeOpcode.mExecFunc = execFunc;
+					runtimeOpcode.setParameter(parameter);
+					runtimeOpcode.setParameter(opcodes[2].mParameter, 8);
+					outNumOpcodesConsumed = 6;
+					return true;
+				}
+			}
+		}
+
+		// Load-op-store on local variables, with the result discarded
+		//  -> GET_VARIABLE_VALUE, PUSH_CONSTANT, ARITHM_*, SET_VARIABLE_VALUE, MOVE_STACK
+		if (numOpcodesAvailable >= 5 && opcodes[0].mType == Opcode::Type::GET_VARIABLE_VALUE && isLocalVariable(opcodes[0]) &&
+			opcodes[1].mType == Opcode::Type::PUSH_CONSTANT && isBinaryArithmetic(opcodes[2]) &&
+			opcodes[3].mType == Opcode::Type::SET_VARIABLE_VALUE && isLocalVariable(opcodes[3]) && isDiscardingMoveStack(opcodes[4]))
+		{
+			ExecFunc execFunc = nullptr;
+			SELECT_FUNC_BY_ARITHM_OPERATION(execFunc, SuperinstructionExec::exec_SI_LOCAL_OPERATION_CONSTANT_STORE, opcodes[2].mType, opcodes[2].mDataType);
+			if (nullptr != execFunc)
+			{
+				RuntimeOpcode& runtimeOpcode = buffer.addOpcode(16);
+				runtimeOpcode.mExecFunc = execFunc;
+				runtimeOpcode.setParameter((uint32)opcodes[0].mParameter);
+				runtimeOpcode.setParameter((uint32)opcodes[3].mParameter, 4);
+				runtimeOpcode.setParameter(opcodes[1].mParameter, 8);
+				outNumOpcodesConsumed = 5;
+				return true;
+			}
+		}
+
+		// Memory read relative to an external variable, like an address register
+		//  -> GET_VARIABLE_VALUE, PUSH_CONSTANT, ARITHM_ADD, READ_MEMORY
+		if (numOpcodesAvailable >= 4 && opcodes[0].mType == Opcode::Type::GET_VARIABLE_VALUE && (Variable::Type)((uint32)(opcodes[0].mParameter) >> 28) == Variable::Type::EXTERNAL &&
+			opcodes[1].mType == Opcode::Type::PUSH_CONSTANT && opcodes[2].mType == Opcode::Type::ARITHM_ADD && opcodes[2].mDataType == BaseType::UINT_32 &&
+			opcodes[3].mType == Opcode::Type::READ_MEMORY && opcodes[3].mParameter == 0)
+		{
+			const ExternalVariable& variable = static_cast<ExternalVariable&>(runtime.getProgram().getGlobalVariableByID((uint32)opcodes[0].mParameter));
+			if (variable.getDataType()->getBytes() == 4)
+			{
+				ExecFunc execFunc = nullptr;
+				switch (opcodes[3].mDataType)
+				{
+					case BaseType::INT_8:	execFunc = &SuperinstructionExec::exec_SI_READ_MEMORY_EXTERNAL_OFFSET<int8>;	break;
+					case BaseType::INT_16:	execFunc = &SuperinstructionExec::exec_SI_READ_MEMORY_EXTERNAL_OFFSET<int16>;	break;
+					case BaseType::INT_32:	execFunc = &SuperinstructionExec::exec_SI_READ_MEMORY_EXTERNAL_OFFSET<int32>;	break;
+					case BaseType::INT_64:	execFunc = &SuperinstructionExec::exec_SI_READ_MEMORY_EXTERNAL_OFFSET<int64>;	break;
+					case BaseType::UINT_8:	execFunc = &SuperinstructionExec::exec_SI_READ_MEMORY_EXTERNAL_OFFSET<uint8>;	break;
+					case BaseType::UINT_16:	execFunc = &SuperinstructionExec::exec_SI_READ_MEMORY_EXTERNAL_OFFSET<uint16>;	break;
+					case BaseType::UINT_32:	execFunc = &SuperinstructionExec::exec_SI_READ_MEMORY_EXTERNAL_OFFSET<uint32>;	break;
+					case BaseType::UINT_64:	execFunc = &SuperinstructionExec::exec_SI_READ_MEMORY_EXTERNAL_OFFSET<uint64>;	break;
+					default:				break;
+				}
+
+				if (nullptr != execFunc)
+				{
+					RuntimeOpcode& runtimeOpcode = buffer.addOpcode(16);
+					runtimeOpcode.mExecFunc = execFunc;
+					runtimeOpcode.setParameter(variable.mAccessor());
+					runtimeOpcode.setParameter(opcodes[1].mParameter, 8);
+					outNumOpcodesConsumed = 4;
+					return true;
+				}
+			}
+		}
+
+		// Load-op on a local variable, with the result pushed to the stack
+		//  -> GET_VARIABLE_VALUE, PUSH_CONSTANT, ARITHM_*
+		if (numOpcodesAvailable >= 3 && opcodes[0].mType == Opcode::Type::GET_VARIABLE_VALUE && isLocalVariable(opcodes[0]) &&
+			opcodes[1].mType == Opcode::Type::PUSH_CONSTANT && isBinaryArithmetic(opcodes[2]))
+		{
+			ExecFunc execFunc = nullptr;
+			SELECT_FUNC_BY_ARITHM_OPERATION(execFunc, SuperinstructionExec::exec_SI_LOCAL_OPERATION_CONSTANT, opcodes[2].mType, opcodes[2].mDataType);
+			if (nullptr != execFunc)
+			{
+				RuntimeOpcode& runtimeOpcode = buffer.addOpcode(16);
+				runtimeOpcode.mExecFunc = execFunc;
+				runtimeOpcode.setParameter((uint32)opcodes[0].mParameter);
+				runtimeOpcode.setParameter(opcodes[1].mParameter, 8);
+				outNumOpcodesConsumed = 3;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool SuperinstructionOpcodeProvider::buildRuntimeOpcode(RuntimeOpcodeBuffer& buffer, const Opcode* opcodes, int numOpcodesAvailable, int& outNumOpcodesConsumed, const Runtime& runtime)
+	{
+		// Without opcode data, compare-and-branch superinstructions can't be used, as it's unknown whether conditional jumps are jump targets
+		return buildRuntimeOpcodeStatic(buffer, opcodes, nullptr, numOpcodesAvailable, outNumOpcodesConsumed, runtime);
+	}
+
+	#undef SELECT_FUNC_BY_DATATYPE_INT
+	#undef SELECT_FUNC_BY_ARITHM_OPERATION
+	#undef SELECT_FUNC_BY_COMPARE_OPERATION
+}
@@ -0,0 +1,30 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#pragma once
+
+#include "lemon/runtime/RuntimeOpcode.h"
+#include "lemon/runtime/OpcodeProcessor.h"
+
+
+namespace lemon
+{
+	// Merges longer opcode sequences into single runtime opcodes that work without the value stack, like:
+	//  - Load-op-store on local variables, e.g. "x += 4"
+	//  - Read-modify-write on fixed memory addresses, e.g. "u8[0xfffffe10] += 1"
+	//  - Memory reads relative to an external variable, e.g. "u16[A0 + 0x10]"
+	//  - Compare-and-branch, e.g. "if (x < 5)", with the condition evaluated inside the conditional jump
+	class SuperinstructionOpcodeProvider final : public RuntimeOpcodeProvider
+	{
+	public:
+		static bool buildRuntimeOpcodeStatic(RuntimeOpcodeBuffer& buffer, const Opcode* opcodes, const OpcodeProcessor::OpcodeData* opcodeData, int numOpcodesAvailable, int& outNumOpcodesConsumed, const Runtime& runtime);
+
+	public:
+		bool buildRuntimeOpcode(RuntimeOpcodeBuffer& buffer, const Opcode* opcodes, int numOpcodesAvailable, int& outNumOpcodesConsumed, const Runtime& runtime) override;
+	};
+}
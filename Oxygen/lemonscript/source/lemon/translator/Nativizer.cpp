@@ -86,6 +86,21 @@ namespace lemon
 	}
 
 
+	bool Nativizer::LookupDictionary::loadLibraryData(const LibraryData& libraryData)
+	{
+		if (libraryData.mVersion != LIBRARY_DATA_VERSION)
+			return false;
+
+		if (libraryData.mNumFunctions > 0)
+		{
+			addEmptyEntries(libraryData.mEmptyEntries, libraryData.mNumEmptyEntries);
+			loadParameterInfo(libraryData.mCompressedParameterData, libraryData.mCompressedParameterDataSize);
+			loadFunctions(libraryData.mFunctions, libraryData.mNumFunctions);
+		}
+		return true;
+	}
+
+
 	void Nativizer::getOpcodeSubtypeInfo(OpcodeSubtypeInfo& outInfo, const Opcode* opcodes, size_t numOpcodesAvailable, MemoryAccessHandler& memoryAccessHandler)
 	{
 		const Opcode& firstOpcode = opcodes[0];
@@ -206,7 +221,7 @@ namespace lemon
 		return hash;
 	}
 
-	void Nativizer::build(String& output, const Module& module, const Program& program, MemoryAccessHandler& memoryAccessHandler)
+	void Nativizer::build(String& output, const Module& module, const Program& program, MemoryAccessHandler& memoryAccessHandler, OutputType outputType)
 	{
 		mModule = &module;
 		mProgram = &program;
@@ -223,8 +238,30 @@ namespace lemon
 
 		// Start writing
 		CppWriter writer(output);
-		writer.writeLine("#define NATIVIZED_CODE_AVAILABLE");
-		writer.writeEmptyLine();
+		if (outputType == OutputType::SHARED_LIBRARY_SOURCE)
+		{
+			writer.writeLine("// Generated by the lemonscript nativizer for module '" + module.getModuleName() + "', to be built as a shared library");
+			writer.writeEmptyLine();
+			writer.writeLine("#include <lemon/pch.h>");
+			writer.writeLine("#include <lemon/runtime/OpcodeExecUtils.h>");
+			writer.writeLine("#include <lemon/runtime/RuntimeOpcodeContext.h>");
+			writer.writeLine("#include <lemon/translator/Nativizer.h>");
+			writer.writeEmptyLine();
+			writer.writeLine("#if defined(_MSC_VER)");
+			writer.writeLine("\t#define NATIVIZED_LIBRARY_EXPORT extern \"C\" __declspec(dllexport)");
+			writer.writeLine("#else");
+			writer.writeLine("\t#define NATIVIZED_LIBRARY_EXPORT extern \"C\" __attribute__((visibility(\"default\")))");
+			writer.writeLine("#endif");
+			writer.writeEmptyLine();
+			writer.writeEmptyLine();
+			writer.writeLine("namespace lemon");
+			writer.beginBlock();
+		}
+		else
+		{
+			writer.writeLine("#define NATIVIZED_CODE_AVAILABLE");
+			writer.writeEmptyLine();
+		}
 
 		// Go through all compiled opcodes
 		for (const ScriptFunction* func : module.getScriptFunctions())
@@ -233,80 +270,144 @@ namespace lemon
 		}
 
 		// Write reflection lookup
-		if (!mBuiltDictionary.mEntries.empty())
+		writeLookupData(writer, outputType);
+
+		if (outputType == OutputType::SHARED_LIBRARY_SOURCE)
 		{
-			writer.writeEmptyLine();
-			writer.writeLine("void createNativizedCodeLookup(Nativizer::LookupDictionary& dict)");
-			writer.beginBlock();
+			writer.endBlock();
+		}
+	}
+
+	void Nativizer::writeLookupData(CppWriter& writer, OutputType outputType)
+	{
+		if (mBuiltDictionary.mEntries.empty())
+		{
+			if (outputType == OutputType::SHARED_LIBRARY_SOURCE)
 			{
-				std::vector<uint64> entriesToWrite;
-				entriesToWrite.reserve(mBuiltDictionary.mEntries.size());	// Certainly overestimated, but who cares
-				for (const std::pair<uint64, LookupEntry>& pair : mBuiltDictionary.mEntries)
-				{
-					if (nullptr == pair.second.mExecFunc)
-					{
-						entriesToWrite.push_back(pair.first);
-					}
-				}
-				const uint8* data = (const uint8*)&entriesToWrite[0];
-				const size_t bytes = entriesToWrite.size() * 8;
-				const size_t chunks = (bytes + 0x7fff) / 0x8000;
-				for (size_t i = 0; i < chunks; ++i)
-				{
-					const std::string identifier = "emptyEntries" + std::to_string(i);
-					const size_t restBytes = std::min<size_t>(bytes - i * 0x8000, 0x8000);
-					writeBinaryBlob(writer, identifier, &data[i * 0x8000], restBytes);
-					writer.writeLine("dict.addEmptyEntries(reinterpret_cast<const uint64*>(" + identifier + "), " + rmx::hexString(restBytes / 8, 2) + ");");
-					writer.writeEmptyLine();
-				}
+				// Export empty data, so that the library is still valid and does not get rebuilt over and over again
+				writer.writeEmptyLine();
+				writer.writeLine("NATIVIZED_LIBRARY_EXPORT const Nativizer::LibraryData* getNativizedLibraryData()");
+				writer.beginBlock();
+				writer.writeLine("static Nativizer::LibraryData data;");
+				writer.writeLine("data.mVersion = " + std::to_string(LIBRARY_DATA_VERSION) + ";");
+				writer.writeLine("return &data;");
+				writer.endBlock();
 			}
+			return;
+		}
 
-			// Collect the data to actually write
-			std::vector<std::pair<uint64, size_t>> functionList;	// First = hash of the generated function, second = start index of function's parameter data
-			std::vector<uint8> parameterData;
+		std::vector<uint64> emptyEntries;
+		emptyEntries.reserve(mBuiltDictionary.mEntries.size());	// Certainly overestimated, but who cares
+		for (const std::pair<uint64, LookupEntry>& pair : mBuiltDictionary.mEntries)
+		{
+			if (nullptr == pair.second.mExecFunc)
 			{
-				functionList.reserve(mBuiltDictionary.mEntries.size());
-				for (const std::pair<uint64, LookupEntry>& pair : mBuiltDictionary.mEntries)
-				{
-					const LookupEntry& lookupEntry = pair.second;
-					if (nullptr != lookupEntry.mExecFunc)
-					{
-						functionList.emplace_back(pair.first, pair.second.mParameterStart);
-					}
-				}
+				emptyEntries.push_back(pair.first);
+			}
+		}
 
-				parameterData.resize(mBuiltDictionary.mParameterData.size() * 4);
-				uint8* outPtr = &parameterData[0];
-				for (const LookupEntry::ParameterInfo& parameterInfo : mBuiltDictionary.mParameterData)
+		// Collect the data to actually write
+		std::vector<std::pair<uint64, size_t>> functionList;	// First = hash of the generated function, second = start index of function's parameter data
+		std::vector<uint8> parameterData;
+		{
+			functionList.reserve(mBuiltDictionary.mEntries.size());
+			for (const std::pair<uint64, LookupEntry>& pair : mBuiltDictionary.mEntries)
+			{
+				const LookupEntry& lookupEntry = pair.second;
+				if (nullptr != lookupEntry.mExecFunc)
 				{
-					*(uint16*)(&outPtr[0]) = (uint16)parameterInfo.mOffset;
-					outPtr[2] = (uint8)parameterInfo.mOpcodeIndex;
-					outPtr[3] = (uint8)parameterInfo.mSemantics;
-					outPtr += 4;
+					functionList.emplace_back(pair.first, pair.second.mParameterStart);
 				}
 			}
 
-			// Now write all that data
-			//  -> This gets output as a string (and also using compression), as that proved to allow for MUCH faster compilation by the Microsoft compiler for some reason
+			parameterData.resize(mBuiltDictionary.mParameterData.size() * 4);
+			uint8* outPtr = &parameterData[0];
+			for (const LookupEntry::ParameterInfo& parameterInfo : mBuiltDictionary.mParameterData)
+			{
+				*(uint16*)(&outPtr[0]) = (uint16)parameterInfo.mOffset;
+				outPtr[2] = (uint8)parameterInfo.mOpcodeIndex;
+				outPtr[3] = (uint8)parameterInfo.mSemantics;
+				outPtr += 4;
+			}
+		}
+		std::vector<uint8> compressedParameterData;
+		ZlibDeflate::encode(compressedParameterData, &parameterData[0], parameterData.size(), 9);
+
+		writer.writeEmptyLine();
+		if (outputType == OutputType::SHARED_LIBRARY_SOURCE)
+		{
+			// Write the data as static arrays, and export a single function giving access to them
+			//  -> The generated code only calls back into the application through inline functions and virtual calls (like "Program::getGlobalVariableByID" and "Variable::setValue"),
+			//     as the library must not depend on the application's exported symbols; so adding the data to the lookup dictionary is left to "LookupDictionary::loadLibraryData"
+			writer.writeLine("const uint64 emptyEntries[] =");
+			writer.beginBlock();
+			for (size_t k = 0; k < emptyEntries.size(); ++k)
 			{
-				std::vector<uint8> compressedData;
-				ZlibDeflate::encode(compressedData, &parameterData[0], parameterData.size(), 9);
-				writeBinaryBlob(writer, "parameterData", &compressedData[0], compressedData.size());
-				writer.writeLine("dict.loadParameterInfo(reinterpret_cast<const uint8*>(parameterData), " + rmx::hexString(compressedData.size(), 4) + ");");
+				writer.writeLine("0x" + rmx::hexString(emptyEntries[k], 16, "") + "ull" + (k+1 < emptyEntries.size() ? "," : ""));
+			}
+			if (emptyEntries.empty())
+				writer.writeLine("0");
+			writer.endBlock("};");
+			writer.writeEmptyLine();
+
+			writeBinaryBlob(writer, "parameterData", &compressedParameterData[0], compressedParameterData.size());
+			writer.writeEmptyLine();
+		}
+		else
+		{
+			writer.writeLine("void createNativizedCodeLookup(Nativizer::LookupDictionary& dict)");
+			writer.beginBlock();
+
+			const uint8* data = (const uint8*)&emptyEntries[0];
+			const size_t bytes = emptyEntries.size() * 8;
+			const size_t chunks = (bytes + 0x7fff) / 0x8000;
+			for (size_t i = 0; i < chunks; ++i)
+			{
+				const std::string identifier = "emptyEntries" + std::to_string(i);
+				const size_t restBytes = std::min<size_t>(bytes - i * 0x8000, 0x8000);
+				writeBinaryBlob(writer, identifier, &data[i * 0x8000], restBytes);
+				writer.writeLine("dict.addEmptyEntries(reinterpret_cast<const uint64*>(" + identifier + "), " + rmx::hexString(restBytes / 8, 2) + ");");
 				writer.writeEmptyLine();
 			}
+
+			// Now write all that data
+			//  -> This gets output as a string (and also using compression), as that proved to allow for MUCH faster compilation by the Microsoft compiler for some reason
+			writeBinaryBlob(writer, "parameterData", &compressedParameterData[0], compressedParameterData.size());
+			writer.writeLine("dict.loadParameterInfo(reinterpret_cast<const uint8*>(parameterData), " + rmx::hexString(compressedParameterData.size(), 4) + ");");
+			writer.writeEmptyLine();
+		}
+
+		{
+			writer.writeLine("const Nativizer::CompactFunctionEntry functionList[] =");
+			writer.beginBlock();
+			for (size_t k = 0; k < functionList.size(); ++k)
 			{
-				writer.writeLine("const Nativizer::CompactFunctionEntry functionList[] =");
-				writer.beginBlock();
-				for (size_t k = 0; k < functionList.size(); ++k)
-				{
-					const auto& pair = functionList[k];
-					const std::string hashString = rmx::hexString(pair.first, 16, "");
-					writer.writeLine("{ 0x" + hashString + ", &exec_" + hashString + ", " + rmx::hexString(pair.second, 8) + " }" + (k+1 < functionList.size() ? "," : ""));
-				}
-				writer.endBlock("};");
-				writer.writeLine("dict.loadFunctions(functionList, " + rmx::hexString(functionList.size(), 4) + ");");
+				const auto& pair = functionList[k];
+				const std::string hashString = rmx::hexString(pair.first, 16, "");
+				writer.writeLine("{ 0x" + hashString + ", &exec_" + hashString + ", " + rmx::hexString(pair.second, 8) + " }" + (k+1 < functionList.size() ? "," : ""));
 			}
+			writer.endBlock("};");
+		}
+
+		if (outputType == OutputType::SHARED_LIBRARY_SOURCE)
+		{
+			writer.writeEmptyLine();
+			writer.writeLine("NATIVIZED_LIBRARY_EXPORT const Nativizer::LibraryData* getNativizedLibraryData()");
+			writer.beginBlock();
+			writer.writeLine("static Nativizer::LibraryData data;");
+			writer.writeLine("data.mVersion = " + std::to_string(LIBRARY_DATA_VERSION) + ";");
+			writer.writeLine("data.mEmptyEntries = emptyEntries;");
+			writer.writeLine("data.mNumEmptyEntries = " + rmx::hexString(emptyEntries.size(), 4) + ";");
+			writer.writeLine("data.mCompressedParameterData = reinterpret_cast<const uint8*>(parameterData);");
+			writer.writeLine("data.mCompressedParameterDataSize = " + rmx::hexString(compressedParameterData.size(), 4) + ";");
+			writer.writeLine("data.mFunctions = functionList;");
+			writer.writeLine("data.mNumFunctions = " + rmx::hexString(functionList.size(), 4) + ";");
+			writer.writeLine("return &data;");
+			writer.endBlock();
+		}
+		else
+		{
+			writer.writeLine("dict.loadFunctions(functionList, " + rmx::hexString(functionList.size(), 4) + ");");
 			writer.endBlock();
 		}
 	}
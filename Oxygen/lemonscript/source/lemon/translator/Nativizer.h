@@ -26,6 +26,13 @@ namespace lemon
 	public:
 		static const constexpr size_t MIN_OPCODES = 2;
 		static const constexpr size_t MAX_OPCODES = 32;
+		static const constexpr uint32 LIBRARY_DATA_VERSION = 1;
+
+		enum class OutputType
+		{
+			INCLUDE_FILE,			// Code to be included in the application's build, defining "createNativizedCodeLookup"
+			SHARED_LIBRARY_SOURCE	// Standalone source file to be built as a shared library, exporting "getNativizedLibraryData"
+		};
 
 		struct OpcodeSubtypeInfo
 		{
@@ -73,11 +80,23 @@ namespace lemon
 			size_t mParameterStart;
 		};
 
+		struct LibraryData
+		{
+			uint32 mVersion = 0;
+			const uint64* mEmptyEntries = nullptr;
+			size_t mNumEmptyEntries = 0;
+			const uint8* mCompressedParameterData = nullptr;
+			size_t mCompressedParameterDataSize = 0;
+			const CompactFunctionEntry* mFunctions = nullptr;
+			size_t mNumFunctions = 0;
+		};
+
 		struct LookupDictionary
 		{
 			void addEmptyEntries(const uint64* hashes, size_t numHashes);
 			void loadFunctions(const CompactFunctionEntry* entries, size_t numEntries);
 			void loadParameterInfo(const uint8* data, size_t count);
+			bool loadLibraryData(const LibraryData& libraryData);
 
 			std::unordered_map<uint64, LookupEntry> mEntries;
 			std::vector<LookupEntry::ParameterInfo> mParameterData;
@@ -89,9 +108,10 @@ namespace lemon
 		static uint64 addOpcodeSubtypeInfoToHash(uint64 hash, const OpcodeSubtypeInfo& info);
 
 	public:
-		void build(String& output, const Module& module, const Program& program, MemoryAccessHandler& memoryAccessHandler);
+		void build(String& output, const Module& module, const Program& program, MemoryAccessHandler& memoryAccessHandler, OutputType outputType = OutputType::INCLUDE_FILE);
 
 	private:
+		void writeLookupData(CppWriter& writer, OutputType outputType);
 		void buildFunction(CppWriter& writer, const ScriptFunction& function);
 		size_t processOpcodes(CppWriter& writer, const Opcode* opcodes, size_t numOpcodes, const ScriptFunction& function);
 		size_t collectNativizableOpcodes(const Opcode* opcodes, size_t numOpcodes);
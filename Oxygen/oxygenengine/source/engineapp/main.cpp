@@ -10,6 +10,7 @@
 #include "engineapp/pch.h"
 #include "engineapp/EngineDelegate.h"
 
+#include "oxygen/helper/EngineTests.h"
 #include "oxygen/platform/PlatformFunctions.h"
 
 
@@ -34,6 +35,13 @@ int main(int argc, char** argv)
 		PlatformFunctions::changeWorkingDirectory(wstr.toStdWString());
 	}
 
+	if (argc >= 2 && std::string(argv[1]) == "-enginetests")
+	{
+		// Only run the tests, with output to the console
+		rmx::Logging::addLogger(*new rmx::StdCoutLogger());
+		return EngineTests::runAllTests() ? 0 : 1;
+	}
+
 	// Create engine delegate and angine main instance
 	{
 		EngineDelegate myDelegate;
@@ -31,9 +31,13 @@
 #include "oxygen/helper/Logging.h"
 #include "oxygen/helper/Profiling.h"
 #include "oxygen/platform/PlatformFunctions.h"
+#include "oxygen/simulation/CodeExec.h"
+#include "oxygen/simulation/LemonScriptRuntime.h"
 #include "oxygen/simulation/LogDisplay.h"
 #include "oxygen/simulation/Simulation.h"
 
+#include <lemon/runtime/RuntimeProfiler.h>
+
 
 static const float MOUSE_HIDE_TIME = 1.0f;	// Seconds until mouse cursor gets hidden after last movement
 
@@ -230,7 +234,30 @@ void Application::keyboard(const rmx::KeyboardEvent& ev)
 
 					case 'p':
 					{
-						Configuration::instance().mPerformanceDisplay = (Configuration::instance().mPerformanceDisplay + 1) % 3;
+						if (FTX::keyState(SDLK_LSHIFT) && EngineMain::getDelegate().useDeveloperFeatures())
+						{
+							// Toggle the script profiler, its results get exported when it is turned off
+							LemonScriptRuntime& lemonScriptRuntime = mSimulation->getCodeExec().getLemonScriptRuntime();
+							if (!lemonScriptRuntime.isProfilingEnabled())
+							{
+								lemonScriptRuntime.setProfilingEnabled(true);
+								Configuration::instance().mPerformanceDisplay = 2;
+								LogDisplay::instance().setLogDisplay("Perfilador de scripts ativado");
+							}
+							else
+							{
+								lemonScriptRuntime.setProfilingEnabled(false);
+								const std::wstring filename = Configuration::instance().mAppDataPath + L"script_profile.folded";
+								if (lemonScriptRuntime.getRuntimeProfiler().exportFoldedStacks(filename))
+									LogDisplay::instance().setLogDisplay("Perfilador de scripts desativado, resultados salvos em 'script_profile.folded'");
+								else
+									LogDisplay::instance().setLogDisplay("Perfilador de scripts desativado, falha ao salvar os resultados");
+							}
+						}
+						else
+						{
+							Configuration::instance().mPerformanceDisplay = (Configuration::instance().mPerformanceDisplay + 1) % 3;
+						}
 						break;
 					}
 
@@ -615,6 +642,62 @@ void Application::render()
 	}
 }
 
+void Application::runHeadless()
+{
+	Configuration& config = Configuration::instance();
+	RMX_LOG_INFO("Starting headless simulation");
+
+	// Load everything synchronously; if loading can't be completed in one go (e.g. waiting for user input), it won't ever be
+	if (!config.mGameRecorder.mIsPlayback && config.mHeadlessFrameLimit == 0)
+	{
+		// Without either, the simulation would never stop
+		RMX_LOG_INFO("Headless simulation needs a game recording playback or a frame limit, use \"-playback=<file>\" or \"-frames=<count>\"");
+	}
+	else if (updateLoading() && !mGameLoader->isLoading())
+	{
+		HighResolutionTimer timer;
+		timer.start();
+
+		// Simulate as fast as possible, without any rendering or frame sync in between
+		mSimulation->setRunning(true);
+		const bool isPlayback = config.mGameRecorder.mIsPlayback;
+		while (config.mHeadlessFrameLimit == 0 || mSimulation->getFrameNumber() < config.mHeadlessFrameLimit)
+		{
+			if (isPlayback && !mSimulation->isPlayingGameRecording())
+				break;
+
+			if (!mSimulation->generateFrame())
+			{
+				// Interrupted frames just get continued, but there's no way to recover if code execution failed
+				if (!mSimulation->getCodeExec().isCodeExecutionPossible())
+				{
+					RMX_LOG_INFO("Headless simulation stopped as code execution is not possible any more");
+					break;
+				}
+			}
+		}
+
+		const double seconds = timer.getSecondsSinceStart();
+		const uint32 frames = mSimulation->getFrameNumber();
+		const double realtimeSeconds = (double)frames / (double)mSimulation->getSimulationFrequency();
+		RMX_LOG_INFO("Headless simulation of " << frames << " frames took " << seconds << " seconds (" << (realtimeSeconds / std::max(seconds, 0.001)) << "x real-time)");
+
+		if (!config.mHeadlessOutputState.empty())
+		{
+			RMX_LOG_INFO("Saving final state to '" << WString(config.mHeadlessOutputState).toStdString() << "'");
+			mSimulation->saveState(config.mHeadlessOutputState, false);
+		}
+	}
+	else
+	{
+		RMX_LOG_INFO("Headless simulation could not be started, as game loading failed");
+	}
+
+	EngineMain::getDelegate().shutdownGame();
+	EngineMain::instance().getAudioOut().getAudioPlayer().clearPlayback();
+	mSimulation->shutdown();
+}
+
 void Application::childClosed(GuiBase& child)
 {
 	if (mSimulation->isRunning())
@@ -826,9 +909,13 @@ bool Application::updateLoading()
 				// Startup game
 				EngineMain::getDelegate().startupGame(mSimulation->getEmulatorInterface());
 
-				RMX_LOG_INFO("Adding game app instance");
-				mGameApp = &EngineMain::getDelegate().createGameApp();
-				addChild(mGameApp);
+				// Headless mode has no use for the game app, as that's all about menus and GUI
+				if (!Configuration::instance().mHeadlessMode)
+				{
+					RMX_LOG_INFO("Adding game app instance");
+					mGameApp = &EngineMain::getDelegate().createGameApp();
+					addChild(mGameApp);
+				}
 				break;
 			}
 
@@ -42,6 +42,8 @@ public:
 	virtual void update(float timeElapsed) override;
 	virtual void render() override;
 
+	void runHeadless();
+
 	void childClosed(GuiBase& child);
 
 	inline Simulation& getSimulation()		   { return *mSimulation; }
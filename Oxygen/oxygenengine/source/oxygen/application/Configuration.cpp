@@ -226,6 +226,8 @@ Configuration::Configuration()
 #if defined(PLATFORM_WEB)
 	// Threading in general is not (afaik) supported by emscripten
 	mUseAudioThreading = false;
+	mSoftwareRenderingThreads = 1;
+	mScriptCompilerThreads = 1;
 #endif
 
 }
@@ -312,7 +314,10 @@ bool Configuration::loadSettings(const std::wstring& filename, SettingsType sett
 		if (rootHelper.tryReadBool("FailSafeMode", mFailSafeMode))
 		{
 			if (mFailSafeMode)
+			{
 				mUseAudioThreading = false;
+				mSoftwareRenderingThreads = 1;
+			}
 		}
 
 		// Graphics
@@ -327,6 +332,10 @@ bool Configuration::loadSettings(const std::wstring& filename, SettingsType sett
 		rootHelper.tryReadInt("Scanlines", mScanlines);
 		rootHelper.tryReadInt("BackgroundBlur", mBackgroundBlur);
 		rootHelper.tryReadInt("PerformanceDisplay", mPerformanceDisplay);
+		#if !defined(PLATFORM_WEB)
+		if (!mFailSafeMode)
+			rootHelper.tryReadInt("SoftwareRenderingThreads", mSoftwareRenderingThreads);
+		#endif
 
 		// Audio
 		rootHelper.tryReadFloat("Volume", mAudioVolume);
@@ -519,7 +528,7 @@ void Configuration::saveSettings()
 
 void Configuration::evaluateGameRecording()
 {
-	if (mGameRecorder.mRecordingMode == 0 || mGameRecorder.mIsPlayback)
+	if (mGameRecorder.mRecordingMode == 0 || mGameRecorder.mIsPlayback || mHeadlessMode)
 	{
 		mGameRecorder.mIsRecording = false;
 	}
@@ -620,6 +629,8 @@ void Configuration::loadConfigurationProperties(JsonHelper& rootHelper)
 
 	// Audio
 	rootHelper.tryReadInt("AudioSampleRate", mAudioSampleRate);
+	rootHelper.tryReadBool("EmulatedAudioCache", mUseEmulatedAudioCache);
+	rootHelper.tryReadBool("FMBlockProcessing", mUseFMBlockProcessing);
 
 	// Input recorder
 	if (mDevMode.mEnabled)
@@ -633,6 +644,24 @@ void Configuration::loadConfigurationProperties(JsonHelper& rootHelper)
 	// Script
 	rootHelper.tryReadBool("CompileScripts", mForceCompileScripts);
 #endif
+
+	// Script compilation cache
+	rootHelper.tryReadBool("ScriptCompilationCache", mUseScriptCompilationCache);
+#if !defined(PLATFORM_WEB)
+	rootHelper.tryReadInt("ScriptCompilerThreads", mScriptCompilerThreads);
+#endif
+
+	// Sprite decoding cache
+	rootHelper.tryReadBool("SpriteDecodingCache", mUseSpriteDecodingCache);
+
+	// Mod script nativization
+	Json::Value modNativizationJson = rootHelper.mJson["ModNativization"];
+	if (modNativizationJson.isObject())
+	{
+		JsonHelper modNativizationHelper(modNativizationJson);
+		modNativizationHelper.tryReadBool("Enabled", mModNativization.mEnabled);
+		modNativizationHelper.tryReadString("CompileCommand", mModNativization.mCompileCommand);
+	}
 }
 
 void Configuration::saveSettingsInput(const std::wstring& filename) const
@@ -54,6 +54,13 @@ public:
 		bool mIsPlayback = false;
 		int mPlaybackStartFrame = 0;
 		bool mPlaybackIgnoreKeys = false;
+		std::wstring mPlaybackFilename;	// If empty, "gamerecording.bin" or "gamerec.bin" is used
+	};
+
+	struct ModNativization
+	{
+		bool mEnabled = false;			// Load nativized mod scripts from the cache, and write nativized sources for mods not in the cache yet
+		std::string mCompileCommand;	// Command line to build a nativized source as shared library linked against lemonscript and rmxbase, using "$(SOURCE)" and "$(OUTPUT)" as placeholders
 	};
 
 	struct VirtualGamepad
@@ -161,11 +168,14 @@ public:
 	int   mBackgroundBlur = 0;
 	bool  mFullEmulationRendering = true;
 	int   mPerformanceDisplay = 0;
+	int   mSoftwareRenderingThreads = 0;	// Number of threads for the software renderer, 0 for automatic choice based on the CPU core count
 
 	// Audio
 	int   mAudioSampleRate = 48000;
 	float mAudioVolume = 1.0f;
 	bool  mUseAudioThreading = true;		// Disabled in constructor for platforms that don't support it
+	bool  mUseEmulatedAudioCache = false;	// Store rendered emulated sound effects and jingles in the app data folder, so they don't have to be emulated again later
+	bool  mUseFMBlockProcessing = false;	// Emulate the YM2612 in blocks of samples instead of sample by sample, with the same output; only faster with few channels playing and without feedback, so it's off by default
 
 	// Input
 	std::vector<InputConfig::DeviceDefinition> mInputDeviceDefinitions;
@@ -183,14 +193,23 @@ public:
 
 	// Internal
 	bool mForceCompileScripts = false;
+	bool mUseScriptCompilationCache = true;
+	bool mUseSpriteDecodingCache = false;	// Store decoded sprite sheets in the app data folder, so they don't have to be decoded again later
+	int mScriptCompilerThreads = 0;			// Number of threads for compiling script functions, 0 for automatic choice based on the CPU core count
 	int mScriptOptimizationLevel = -1;		// -1: Auto, 0: No optimization at all, up to 3: Full optimization
 	std::wstring mCompiledScriptSavePath;
 	bool mEnableROMDataAnalyser = false;
 	bool mExitAfterScriptLoading = false;
 	int mRunScriptNativization = 0;			// 0: Disabled, 1: Run nativization, 2: Nativization done
 	std::wstring mScriptNativizationOutput;
+	ModNativization mModNativization;
 	std::wstring mDumpCppDefinitionsOutput;
 
+	// Headless mode
+	bool mHeadlessMode = false;				// Simulation only, without window, input devices or audio output
+	uint32 mHeadlessFrameLimit = 0;			// 0: No limit, i.e. run until game recording playback is finished
+	std::wstring mHeadlessOutputState;		// Optional save state file written at the end of a headless run
+
 	// Mod settings
 	std::map<uint64, Mod> mModSettings;
 
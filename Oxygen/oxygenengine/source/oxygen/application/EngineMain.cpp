@@ -224,14 +224,35 @@ bool EngineMain::startupEngine()
 	if (!mDelegate.onEnginePreStartup())
 		return false;
 
+	const EngineDelegateInterface::AppMetaData& appMetaData = mDelegate.getAppMetaData();
+	Configuration& config = Configuration::instance();
+
 	std::wstring argumentProjectPath;
+	std::wstring argumentPlaybackFilename;
 #ifndef PLATFORM_ANDROID
 	// Parse arguments
 	for (size_t i = 1; i < mArguments.size(); ++i)
 	{
 		if (mArguments[i][0] == '-')
 		{
-			// TODO: Add handling for options
+			const std::string& option = mArguments[i];
+			if (option == "-headless")
+			{
+				config.mHeadlessMode = true;
+			}
+			else if (rmx::startsWith(option, "-frames="))
+			{
+				config.mHeadlessFrameLimit = (uint32)std::max(0, atoi(option.c_str() + 8));
+			}
+			else if (rmx::startsWith(option, "-playback="))
+			{
+				// This gets applied only after loading the configuration, which would overwrite it otherwise
+				argumentPlaybackFilename = String(option.substr(10)).toStdWString();
+			}
+			else if (rmx::startsWith(option, "-outputstate="))
+			{
+				config.mHeadlessOutputState = String(option.substr(13)).toStdWString();
+			}
 		}
 		else
 		{
@@ -247,9 +268,6 @@ bool EngineMain::startupEngine()
 	}
 #endif
 
-	const EngineDelegateInterface::AppMetaData& appMetaData = mDelegate.getAppMetaData();
-	Configuration& config = Configuration::instance();
-
 	// Don't use the accelerometer as a joystick on mobile devices, that's just confusing
 	SDL_SetHint(SDL_HINT_ACCELEROMETER_AS_JOYSTICK, "0");
 
@@ -308,7 +326,7 @@ bool EngineMain::startupEngine()
 	}
 
 	// Load configuration and settings
-	if (!initConfigAndSettings(argumentProjectPath))
+	if (!initConfigAndSettings(argumentProjectPath, argumentPlaybackFilename))
 		return false;
 
 	// Setup file system
@@ -316,6 +334,22 @@ bool EngineMain::startupEngine()
 	if (!initFileSystem())
 		return false;
 
+	if (config.mHeadlessMode)
+	{
+		// Headless mode only sets up what the simulation really needs
+		//  -> No SDL video, window, input devices or audio device; the software drawer works fine without a window
+		RMX_LOG_INFO("Headless mode initialization...");
+		mDrawer.createDrawer<SoftwareDrawer>();
+		mInternal.mVideoOut.startup();
+		mInternal.mControlsIn.startup();
+
+		mAudioOut = &EngineMain::getDelegate().createAudioOut();
+		mAudioOut->startup();
+
+		RMX_LOG_INFO("Engine startup in headless mode successful");
+		return true;
+	}
+
 	// System
 	RMX_LOG_INFO("System initialization...");
 	if (!FTX::System->initialize())
@@ -363,7 +397,14 @@ void EngineMain::run()
 	RMX_LOG_INFO("Starting main application loop");
 
 	Application application;
-	FTX::System->run(application);
+	if (Configuration::instance().mHeadlessMode)
+	{
+		application.runHeadless();
+	}
+	else
+	{
+		FTX::System->run(application);
+	}
 }
 
 void EngineMain::shutdown()
@@ -393,7 +434,7 @@ void EngineMain::shutdown()
 	oxygen::Logging::shutdown();
 }
 
-bool EngineMain::initConfigAndSettings(const std::wstring& argumentProjectPath)
+bool EngineMain::initConfigAndSettings(const std::wstring& argumentProjectPath, const std::wstring& argumentPlaybackFilename)
 {
 	RMX_LOG_INFO("Initializing configuration");
 	Configuration& config = Configuration::instance();
@@ -406,6 +447,14 @@ bool EngineMain::initConfigAndSettings(const std::wstring& argumentProjectPath)
 	config.loadConfiguration(L"config.json");
 #endif
 
+	if (!argumentPlaybackFilename.empty())
+	{
+		// Overwrite game recording playback from config
+		config.mGameRecorder.mIsPlayback = true;
+		config.mGameRecorder.mPlaybackFilename = argumentPlaybackFilename;
+		config.mStartPhase = 3;		// Like for playback enabled in the config, see "Configuration::loadConfiguration"
+	}
+
 	// Setup a custom game profile (like S3AIR does) or load the "oxygenproject.json"
 	const bool hasCustomGameProfile = mDelegate.setupCustomGameProfile();
 	if (!hasCustomGameProfile)
@@ -433,8 +482,14 @@ bool EngineMain::initConfigAndSettings(const std::wstring& argumentProjectPath)
 		config.saveSettings();
 	}
 
-	// Evaluate fail-safe mode
-	if (config.mFailSafeMode)
+	// Evaluate headless and fail-safe mode
+	if (config.mHeadlessMode)
+	{
+		RMX_LOG_INFO("Using headless mode");
+		config.mRenderMethod = Configuration::RenderMethod::SOFTWARE;
+		config.setSettingsReadOnly(true);	// Batch runs must not overwrite the user's settings
+	}
+	else if (config.mFailSafeMode)
 	{
 		RMX_LOG_INFO("Using fail-safe mode");
 		config.mRenderMethod = Configuration::RenderMethod::SOFTWARE;	// Should already be set actually, but why not play it safe
@@ -102,7 +102,7 @@ private:
 	void run();
 	void shutdown();
 
-	bool initConfigAndSettings(const std::wstring& argumentProjectPath);
+	bool initConfigAndSettings(const std::wstring& argumentProjectPath, const std::wstring& argumentPlaybackFilename);
 	bool initFileSystem();
 	bool loadFilePackages(bool forceReload);
 	bool loadFilePackageByIndex(size_t index, bool forceReload);
@@ -622,6 +622,11 @@ AudioPlayer::PlayingSound* AudioPlayer::startOrContinuePlayback(SourceRegistrati
 
 AudioPlayer::PlayingSound* AudioPlayer::startPlaybackInternal(SourceRegistration& sourceReg, AudioSourceBase& audioSource, float volume, float time, int contextId, int channelId)
 {
+	// In headless mode, there's no audio device that would ever play (and thus finish) any sound
+	//  -> So don't start any playback at all, otherwise sounds started by scripts would pile up in both the playing sounds and the audio mixer
+	if (Configuration::instance().mHeadlessMode)
+		return nullptr;
+
 	// Startup audio source and get the audio buffer
 	AudioBuffer* audioBuffer = audioSource.startup(0.1f);
 	if (nullptr == audioBuffer)
@@ -10,6 +10,9 @@
 #include "oxygen/application/audio/AudioSourceManager.h"
 #include "oxygen/application/audio/EmulationAudioSource.h"
 #include "oxygen/application/audio/OggAudioSource.h"
+#include "oxygen/application/Configuration.h"
+#include "oxygen/application/EngineMain.h"
+#include "oxygen/simulation/EmulatorInterface.h"
 
 
 void AudioSourceManager::clear()
@@ -24,6 +27,7 @@ void AudioSourceManager::clear()
 	}
 	mAudioSources.clear();
 	mMappedAudioSourcesByHash.clear();
+	mRomHash = 0;
 }
 
 AudioSourceBase* AudioSourceManager::getAudioSourceForPlayback(SourceRegistration& sourceRegistration)
@@ -131,6 +135,27 @@ AudioSourceBase* AudioSourceManager::addEmulationAudioSource(uint8 soundId, Audi
 	{
 		audioSource->initWithSfxId(soundId);
 	}
+
+	// Static sources can be stored on disk once rendered
+	const Configuration& config = Configuration::instance();
+	if (cachingType == AudioSourceBase::CachingType::STREAMING_STATIC && config.mUseEmulatedAudioCache && !config.mAppDataPath.empty())
+	{
+		if (mRomHash == 0)
+		{
+			EmulatorInterface& emulatorInterface = EmulatorInterface::instance();
+			mRomHash = rmx::getMurmur2_64(emulatorInterface.getRom(), emulatorInterface.getRomSize());
+
+			// Each build uses a directory of its own, as rendered output depends on the build's sound emulation and sound driver
+			//  -> Anything else in the audio cache is left over from other builds and gets removed, so it does not pile up with each update
+			const std::wstring basePath = config.mAppDataPath + L"audiocache/";
+			const std::wstring buildDirectoryName = String(rmx::hexString(EngineMain::getDelegate().getAppMetaData().mBuildVersionNumber, 8, "")).toStdWString();
+			removeOutdatedPersistentCaches(basePath, buildDirectoryName);
+
+			mPersistentCachePath = basePath + buildDirectoryName + L"/";
+			FTX::FileSystem->createDirectory(mPersistentCachePath);
+		}
+		audioSource->enablePersistentCache(mRomHash, mPersistentCachePath);
+	}
 	return audioSource;
 }
 
@@ -144,3 +169,31 @@ AudioSourceBase* AudioSourceManager::addOggAudioSource(const std::wstring& filen
 	audioSource->load(filename);
 	return audioSource;
 }
+
+void AudioSourceManager::removeOutdatedPersistentCaches(const std::wstring& basePath, const std::wstring& buildDirectoryName)
+{
+	// Files directly in the base path were written by older builds that did not use a directory per build yet
+	std::vector<rmx::FileIO::FileEntry> fileEntries;
+	FTX::FileSystem->listFiles(basePath, false, fileEntries);
+	for (const rmx::FileIO::FileEntry& fileEntry : fileEntries)
+	{
+		FTX::FileSystem->removeFile(fileEntry.mPath + fileEntry.mFilename);
+	}
+
+	std::vector<std::wstring> directories;
+	FTX::FileSystem->listDirectories(basePath, directories);
+	for (const std::wstring& directory : directories)
+	{
+		if (directory == buildDirectoryName)
+			continue;
+
+		RMX_LOG_INFO("Removing outdated audio cache directory: " << WString(directory).toUTF8().toStdString());
+		fileEntries.clear();
+		FTX::FileSystem->listFiles(basePath + directory, false, fileEntries);
+		for (const rmx::FileIO::FileEntry& fileEntry : fileEntries)
+		{
+			FTX::FileSystem->removeFile(fileEntry.mPath + fileEntry.mFilename);
+		}
+		FTX::FileSystem->removeFile(basePath + directory);	// Works for empty directories as well, and cache directories have no subdirectories
+	}
+}
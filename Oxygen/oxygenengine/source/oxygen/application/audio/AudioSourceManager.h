@@ -29,8 +29,11 @@ public:
 private:
 	AudioSourceBase* addEmulationAudioSource(uint8 soundId, AudioSourceBase::CachingType cachingType, const std::wstring& filename = L"", uint32 sourceAddress = 0, uint32 contentOffset = 0);
 	AudioSourceBase* addOggAudioSource(const std::wstring& filename, bool useCaching = true, bool isLooping = false, int loopStart = -1);
+	void removeOutdatedPersistentCaches(const std::wstring& basePath, const std::wstring& buildDirectoryName);
 
 private:
 	std::vector<AudioSourceBase*> mAudioSources;
 	std::map<uint64, AudioSourceBase*> mMappedAudioSourcesByHash;
+	uint64 mRomHash = 0;		// Only calculated if needed for the emulated audio cache
+	std::wstring mPersistentCachePath;	// Directory of the emulated audio cache for this build, set together with the ROM hash
 };
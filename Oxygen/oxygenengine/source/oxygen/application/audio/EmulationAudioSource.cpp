@@ -9,6 +9,16 @@
 #include "oxygen/pch.h"
 #include "oxygen/application/audio/EmulationAudioSource.h"
 #include "oxygen/application/Configuration.h"
+#include "oxygen/application/EngineMain.h"
+
+
+namespace
+{
+	// Persistent cache files contain the rendered output as interleaved stereo samples
+	//  -> Each sample is stored as difference to the previous one in the same channel, which makes the zlib compression a lot more effective
+	static const uint32 PERSISTENT_CACHE_SIGNATURE = 0x43414d45;	// "EMAC"
+	static const uint16 PERSISTENT_CACHE_FORMAT_VERSION = 1;
+}
 
 
 EmulationAudioSource::EmulationAudioSource(CachingType cachingType) :
@@ -56,10 +66,35 @@ bool EmulationAudioSource::initWithCustomContent(uint8 soundId, const std::wstri
 			return false;
 		}
 		mSoundDriver.setFixedContent(&mCompressedContent[0], (uint32)mCompressedContent.size(), contentOffset);
+		mContentHash = rmx::getMurmur2_64(&mCompressedContent[0], mCompressedContent.size()) ^ contentOffset;
 	}
 	return true;
 }
 
+void EmulationAudioSource::enablePersistentCache(uint64 romHash, const std::wstring& cachePath)
+{
+	if (isDynamic())
+		return;
+
+	// Build a key from everything that has an influence on the rendered output
+	//  -> The sound driver may read from ROM even when using custom content, so the ROM hash is always included
+	//  -> The build version is included as well, so that changes in the sound emulation or driver of a new build never lead to outdated output getting loaded
+	const EngineDelegateInterface::AppMetaData& appMetaData = EngineMain::getDelegate().getAppMetaData();
+	std::vector<uint8> keyData;
+	VectorBinarySerializer serializer(false, keyData);
+	serializer.write(PERSISTENT_CACHE_FORMAT_VERSION);
+	serializer.write(appMetaData.mBuildVersionNumber);
+	serializer.write(appMetaData.mBuildVersionString);
+	serializer.write(romHash);
+	serializer.write(mContentHash);
+	serializer.write(mSoundId);
+	serializer.write(mSourceAddress);
+	serializer.writeAs<uint32>(Configuration::instance().mAudioSampleRate);
+
+	const uint64 key = rmx::getMurmur2_64(&keyData[0], keyData.size());
+	mPersistentCacheFilename = cachePath + *String(rmx::hexString(key, 16, "")).toWString() + L".bin";
+}
+
 void EmulationAudioSource::resetContent()
 {
 	if (isJobRegistered())
@@ -83,6 +118,8 @@ void EmulationAudioSource::injectTempoSpeedup(uint8 tempoSpeedup)
 {
 	SDL_LockMutex(mMutex);
 	mSoundDriver.setTempoSpeedup(tempoSpeedup);
+	if (tempoSpeedup != 0)
+		mTempoModified = true;
 	SDL_UnlockMutex(mMutex);
 }
 
@@ -145,6 +182,8 @@ AudioSourceBase::State EmulationAudioSource::startupInternal()
 	mSoundEmulation.init(Configuration::instance().mAudioSampleRate, 60.0);
 	mSoundDriver.reset();
 	mSoundDriver.playSound(mSoundId);
+	mCheckPersistentCache = !mPersistentCacheFilename.empty();
+	mTempoModified = false;
 	SDL_UnlockMutex(mMutex);
 
 	return State::STREAMING;
@@ -180,6 +219,19 @@ bool EmulationAudioSource::jobFunc()
 	// This method is executed by a worker thread
 	SDL_LockMutex(mMutex);
 
+	// Try loading the whole output from disk on the first update, so there's no need to emulate anything
+	if (mCheckPersistentCache)
+	{
+		mCheckPersistentCache = false;
+		if (loadFromPersistentCache())
+		{
+			mAudioBuffer.setCompleted();
+			mState = State::COMPLETED;
+			SDL_UnlockMutex(mMutex);
+			return true;
+		}
+	}
+
 	// Update in increments of around 2 ms per "jobFunc" call, but at least 25 ms for the first update
 	//  -> The worker threads should update all audio sources in parallel (using relatively small increments), instead of updating one completely, then the next, etc.
 	//  -> On the other hand, the very first update should at least cover one complete sample buffer size (usually 1024 samples, which is around 23 ms, at 44.1 kHz)
@@ -190,7 +242,8 @@ bool EmulationAudioSource::jobFunc()
 		const std::vector<SoundChipWrite>& writes = mSoundDriver.getSoundChipWrites();
 		bool isPlaying = (updateResult == SoundDriver::UpdateResult::CONTINUE);
 
-		static int16 soundBuffer[0x10000];
+		// Buffers are per thread, as multiple worker threads may update different audio sources in parallel
+		static thread_local int16 soundBuffer[0x10000];
 		const uint32 length = mSoundEmulation.update(soundBuffer, writes);	// Returns length in samples
 
 		if (updateResult == SoundDriver::UpdateResult::FINISHED)
@@ -208,7 +261,7 @@ bool EmulationAudioSource::jobFunc()
 
 		if (isPlaying)
 		{
-			static int16 pcm[2][0x10000];
+			static thread_local int16 pcm[2][0x10000];
 			int16* pcmPtr[2] = { pcm[0], pcm[1] };
 
 			for (uint32 i = 0; i < length; ++i)
@@ -224,8 +277,14 @@ bool EmulationAudioSource::jobFunc()
 		{
 			mAudioBuffer.setCompleted();
 			mState = State::COMPLETED;
+			const bool storeOutput = (!mPersistentCacheFilename.empty() && !mTempoModified);
 			SDL_UnlockMutex(mMutex);
 
+			if (storeOutput)
+			{
+				saveToPersistentCache();
+			}
+
 			// Job completed
 			return true;
 		}
@@ -238,3 +297,88 @@ bool EmulationAudioSource::jobFunc()
 	// Keep going with this job, i.e. this method will get called again
 	return false;
 }
+
+bool EmulationAudioSource::loadFromPersistentCache()
+{
+	std::vector<uint8> buffer;
+	if (!FTX::FileSystem->readFile(mPersistentCacheFilename, buffer))
+		return false;
+
+	VectorBinarySerializer serializer(true, buffer);
+	const uint32 signature = serializer.read<uint32>();
+	const uint16 formatVersion = serializer.read<uint16>();
+	const uint32 sampleRate = serializer.read<uint32>();
+	const uint32 numSamples = serializer.read<uint32>();
+	if (serializer.hasError() || signature != PERSISTENT_CACHE_SIGNATURE || formatVersion != PERSISTENT_CACHE_FORMAT_VERSION || sampleRate != (uint32)Configuration::instance().mAudioSampleRate)
+		return false;
+
+	std::vector<uint8> uncompressed;
+	if (!ZlibDeflate::decode(uncompressed, serializer.peek(), serializer.getRemaining()) || uncompressed.size() != (size_t)numSamples * 4)
+		return false;
+
+	// Undo the delta encoding and split into channels
+	std::vector<int16> pcm[2];
+	pcm[0].resize(numSamples);
+	pcm[1].resize(numSamples);
+	const int16* deltas = reinterpret_cast<const int16*>(&uncompressed[0]);
+	int16 last[2] = { 0, 0 };
+	for (uint32 i = 0; i < numSamples; ++i)
+	{
+		last[0] += deltas[i*2];
+		last[1] += deltas[i*2+1];
+		pcm[0][i] = last[0];
+		pcm[1][i] = last[1];
+	}
+
+	int16* pcmPtr[2] = { &pcm[0][0], &pcm[1][0] };
+	mAudioBuffer.lock();
+	mAudioBuffer.addData(pcmPtr, (int)numSamples);
+	mAudioBuffer.unlock();
+	return true;
+}
+
+void EmulationAudioSource::saveToPersistentCache()
+{
+	// Collect all rendered samples as deltas
+	std::vector<int16> deltas;
+	{
+		mAudioBuffer.lock();
+		const int length = mAudioBuffer.getLength();
+		deltas.reserve((size_t)length * 2);
+		int16 last[2] = { 0, 0 };
+		int position = 0;
+		while (position < length)
+		{
+			short* data[2];
+			const int available = mAudioBuffer.getData(data, position);
+			if (available <= 0)
+				break;
+
+			for (int i = 0; i < available; ++i)
+			{
+				deltas.push_back(data[0][i] - last[0]);
+				deltas.push_back(data[1][i] - last[1]);
+				last[0] = data[0][i];
+				last[1] = data[1][i];
+			}
+			position += available;
+		}
+		mAudioBuffer.unlock();
+	}
+	if (deltas.empty())
+		return;
+
+	std::vector<uint8> compressed;
+	if (!ZlibDeflate::encode(compressed, &deltas[0], deltas.size() * sizeof(int16), 9))
+		return;
+
+	std::vector<uint8> buffer;
+	buffer.reserve(compressed.size() + 0x10);
+	VectorBinarySerializer serializer(false, buffer);
+	serializer.write(PERSISTENT_CACHE_SIGNATURE);
+	serializer.write(PERSISTENT_CACHE_FORMAT_VERSION);
+	serializer.writeAs<uint32>(Configuration::instance().mAudioSampleRate);
+	serializer.writeAs<uint32>(deltas.size() / 2);
+	serializer.write(&compressed[0], compressed.size());
+	FTX::FileSystem->saveFile(mPersistentCacheFilename, buffer);
+}
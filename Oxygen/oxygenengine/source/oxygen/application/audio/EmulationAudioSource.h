@@ -25,6 +25,9 @@ public:
 	bool initWithCustomAddress(uint8 soundId, uint32 sourceAddress);
 	bool initWithCustomContent(uint8 soundId, const std::wstring& filename, uint32 contentOffset);
 
+	// Store the rendered output on disk, so it can be loaded from there instead of being emulated again; only supported for static sounds
+	void enablePersistentCache(uint64 romHash, const std::wstring& cachePath);
+
 	void resetContent();
 	void injectPlaySound(uint8 soundId);
 	void injectTempoSpeedup(uint8 tempoSpeedup);
@@ -38,11 +41,20 @@ protected:
 protected:
 	virtual bool jobFunc() override;
 
+private:
+	bool loadFromPersistentCache();
+	void saveToPersistentCache();
+
 private:
 	uint8 mSoundId = 0;
 	uint32 mSourceAddress = 0;				// Usually not used (i.e. stays zero), except if a different address should be used than the one associated with the sound ID
 	std::wstring mFilename;					// Empty if using original ROM data
 	std::vector<uint8> mCompressedContent;	// Empty if using original ROM data
+	uint64 mContentHash = 0;				// Hash of the content and content offset, if not using original ROM data
+
+	std::wstring mPersistentCacheFilename;	// Empty if the rendered output does not get stored on disk
+	bool mCheckPersistentCache = false;		// Set on startup, so that the first job update tries loading the rendered output from disk
+	bool mTempoModified = false;			// Set if the tempo got changed while rendering, in which case the output must not get stored
 
 	SoundEmulation mSoundEmulation;
 	SoundDriver mSoundDriver;
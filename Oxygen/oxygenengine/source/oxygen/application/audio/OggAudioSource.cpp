@@ -273,11 +273,14 @@ bool OggAudioSource::jobFunc()
 
 void OggAudioSource::updateStreaming(float targetTime)
 {
-	mAudioBuffer.lock();
-	while (mAudioBuffer.getLengthInSec() < targetTime)
+	// Lock the audio buffer only for each single chunk, so that the audio mixer never has to wait for the whole update
+	//  -> Also stop early if the job got removed in the meantime
+	while (mAudioBuffer.getLengthInSec() < targetTime && shouldJobBeRunning())
 	{
-		if (!mOggLoader->updateStreaming())
+		mAudioBuffer.lock();
+		const bool success = mOggLoader->updateStreaming();
+		mAudioBuffer.unlock();
+		if (!success)
 			break;
 	}
-	mAudioBuffer.unlock();
 }
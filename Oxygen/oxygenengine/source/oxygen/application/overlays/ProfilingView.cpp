@@ -10,9 +10,17 @@
 #include "oxygen/application/overlays/ProfilingView.h"
 #include "oxygen/application/audio/AudioOutBase.h"
 #include "oxygen/application/audio/AudioPlayer.h"
+#include "oxygen/application/Application.h"
 #include "oxygen/application/Configuration.h"
 #include "oxygen/application/EngineMain.h"
 #include "oxygen/helper/Profiling.h"
+#include "oxygen/simulation/CodeExec.h"
+#include "oxygen/simulation/LemonScriptProgram.h"
+#include "oxygen/simulation/LemonScriptRuntime.h"
+#include "oxygen/simulation/Simulation.h"
+
+#include <lemon/program/Function.h>
+#include <lemon/runtime/RuntimeProfiler.h>
 
 
 namespace
@@ -57,6 +65,7 @@ void ProfilingView::deinitialize()
 
 void ProfilingView::update(float timeElapsed)
 {
+	mScriptProfileRefreshTimeout -= timeElapsed;
 }
 
 void ProfilingView::render()
@@ -157,5 +166,125 @@ void ProfilingView::render()
 	drawer.printText(font, Recti(FTX::screenWidth() - 200, 10, 0, 0), String(0, "Audio Memory: %.2f MB", (float)EngineMain::instance().getAudioOut().getAudioPlayer().getMemoryUsage() / 1048576.0f));
 	drawer.printText(font, Recti(FTX::screenWidth() - 200, 25, 0, 0), String(0, "%d sounds playing", EngineMain::instance().getAudioOut().getAudioPlayer().getNumPlayingSounds()));
 
+	// Script profiler results
+	renderScriptProfile(drawer, font);
+
 	drawer.performRendering();
 }
+
+void ProfilingView::refreshScriptProfile()
+{
+	mScriptFunctionRows.clear();
+	mScriptLineRows.clear();
+
+	const lemon::RuntimeProfiler& profiler = Application::instance().getSimulation().getCodeExec().getLemonScriptRuntime().getRuntimeProfiler();
+	mScriptProfileFrames = profiler.getNumFrames();
+	if (mScriptProfileFrames == 0)
+		return;
+
+	const float nanosecondsToMillisecondsPerFrame = 1.0e-6f / (float)mScriptProfileFrames;
+	mScriptTimePerFrame = (float)profiler.getTotalTime() * nanosecondsToMillisecondsPerFrame;
+
+	// Functions with the highest exclusive time
+	{
+		static std::vector<lemon::RuntimeProfiler::FunctionStats> functionStats;	// This is static to avoid reallocations
+		profiler.getFunctionStats(functionStats);
+
+		const size_t count = std::min<size_t>(functionStats.size(), 15);
+		std::partial_sort(functionStats.begin(), functionStats.begin() + count, functionStats.end(),
+						  [](const lemon::RuntimeProfiler::FunctionStats& a, const lemon::RuntimeProfiler::FunctionStats& b) { return a.mExclusiveTime > b.mExclusiveTime; });
+
+		for (size_t index = 0; index < count; ++index)
+		{
+			const lemon::RuntimeProfiler::FunctionStats& stats = functionStats[index];
+			ScriptFunctionRow& row = vectorAdd(mScriptFunctionRows);
+			row.mName = stats.mFunction->getName().getString();
+			row.mExclusiveTime = (float)stats.mExclusiveTime * nanosecondsToMillisecondsPerFrame;
+			row.mInclusiveTime = (float)stats.mInclusiveTime * nanosecondsToMillisecondsPerFrame;
+			row.mCalls = (float)stats.mCallCount / (float)mScriptProfileFrames;
+		}
+	}
+
+	// Source lines with the most sampled opcode steps
+	{
+		static std::vector<lemon::RuntimeProfiler::LocationSample> samples;		// This is static to avoid reallocations
+		profiler.getLocationSamples(samples);
+
+		// Multiple samples can refer to the same line, so merge them first
+		std::map<std::pair<std::string, uint32>, uint64> stepsByLine;
+		uint64 totalSteps = 0;
+		for (const lemon::RuntimeProfiler::LocationSample& sample : samples)
+		{
+			std::string filename;
+			uint32 lineNumber = 0;
+			LemonScriptProgram::resolveLocation(*sample.mFunction, (uint32)sample.mProgramCounter, filename, lineNumber);
+			stepsByLine[std::make_pair(filename, lineNumber)] += sample.mSteps;
+			totalSteps += sample.mSteps;
+		}
+
+		std::vector<std::pair<uint64, const std::pair<std::string, uint32>*>> sortedLines;
+		sortedLines.reserve(stepsByLine.size());
+		for (const auto& pair : stepsByLine)
+		{
+			sortedLines.emplace_back(pair.second, &pair.first);
+		}
+
+		const size_t count = std::min<size_t>(sortedLines.size(), 8);
+		std::partial_sort(sortedLines.begin(), sortedLines.begin() + count, sortedLines.end(),
+						  [](const auto& a, const auto& b) { return a.first > b.first; });
+
+		for (size_t index = 0; index < count; ++index)
+		{
+			ScriptLineRow& row = vectorAdd(mScriptLineRows);
+			row.mLocation = sortedLines[index].second->first + ":" + std::to_string(sortedLines[index].second->second);
+			row.mPercentage = (float)sortedLines[index].first * 100.0f / (float)totalSteps;
+		}
+	}
+}
+
+void ProfilingView::renderScriptProfile(Drawer& drawer, Font& font)
+{
+	// Refresh only a few times per second, as collecting the data is not exactly cheap
+	if (mScriptProfileRefreshTimeout <= 0.0f)
+	{
+		refreshScriptProfile();
+		mScriptProfileRefreshTimeout = 0.5f;
+	}
+	if (mScriptProfileFrames == 0)
+		return;
+
+	const bool isActive = Application::instance().getSimulation().getCodeExec().getLemonScriptRuntime().isProfilingEnabled();
+	const Color headerColor(1.0f, 1.0f, 0.6f);
+	int py = 40;
+
+	drawer.printText(font, Recti(10, py, 0, 0), String(0, "Script profile: %d frames, %0.2f ms per frame%s", mScriptProfileFrames, mScriptTimePerFrame, isActive ? "" : " (stopped)"), 1, headerColor);
+	py += 18;
+	drawer.printText(font, Recti(10, py, 0, 0), "Function", 1, headerColor);
+	drawer.printText(font, Recti(290, py, 0, 0), "Excl.", 3, headerColor);
+	drawer.printText(font, Recti(350, py, 0, 0), "Incl.", 3, headerColor);
+	drawer.printText(font, Recti(410, py, 0, 0), "Calls", 3, headerColor);
+	py += 15;
+
+	for (const ScriptFunctionRow& row : mScriptFunctionRows)
+	{
+		drawer.printText(font, Recti(10, py, 0, 0), row.mName, 1);
+		drawer.printText(font, Recti(290, py, 0, 0), String(0, "%0.3f", row.mExclusiveTime), 3);
+		drawer.printText(font, Recti(350, py, 0, 0), String(0, "%0.3f", row.mInclusiveTime), 3);
+		drawer.printText(font, Recti(410, py, 0, 0), String(0, "%0.1f", row.mCalls), 3);
+		py += 15;
+	}
+
+	if (!mScriptLineRows.empty())
+	{
+		py += 8;
+		drawer.printText(font, Recti(10, py, 0, 0), "Hottest lines (sampled opcode steps)", 1, headerColor);
+		py += 15;
+
+		for (const ScriptLineRow& row : mScriptLineRows)
+		{
+			drawer.printText(font, Recti(10, py, 0, 0), row.mLocation, 1);
+			drawer.printText(font, Recti(410, py, 0, 0), String(0, "%0.1f%%", row.mPercentage), 3);
+			py += 15;
+		}
+	}
+}
@@ -11,6 +11,8 @@
 
 #include <rmxmedia.h>
 
+class Drawer;
+
 
 class ProfilingView : public GuiBase
 {
@@ -22,4 +24,30 @@ public:
 	virtual void deinitialize() override;
 	virtual void update(float timeElapsed) override;
 	virtual void render() override;
+
+private:
+	struct ScriptFunctionRow
+	{
+		std::string mName;
+		float mExclusiveTime = 0.0f;	// In milliseconds per frame
+		float mInclusiveTime = 0.0f;	// In milliseconds per frame
+		float mCalls = 0.0f;			// Per frame
+	};
+
+	struct ScriptLineRow
+	{
+		std::string mLocation;
+		float mPercentage = 0.0f;		// Share of all sampled opcode steps
+	};
+
+private:
+	void refreshScriptProfile();
+	void renderScriptProfile(Drawer& drawer, Font& font);
+
+private:
+	std::vector<ScriptFunctionRow> mScriptFunctionRows;
+	std::vector<ScriptLineRow> mScriptLineRows;
+	uint32 mScriptProfileFrames = 0;
+	float mScriptTimePerFrame = 0.0f;
+	float mScriptProfileRefreshTimeout = 0.0f;
 };
@@ -50,19 +50,29 @@ void Downloader::setupDownload(std::string_view url, std::wstring_view outputFil
 void Downloader::startDownload()
 {
 	mState = State::RUNNING;
-	mThread = new std::thread(&Downloader::performDownloadStatic, this);
+	mPlatformDownloadStarted = false;
+	mJobType = "Downloader";
+	mJobIsLongRunning = true;	// The job function blocks until the whole download is done
+	FTX::JobManager->insertJob(*this);
 }
 
 void Downloader::stopDownload()
 {
-	// Stop the thread if it's running
-	if (nullptr != mThread)
+	// Stop the job if it's still running
+	//  -> This waits until the job function returned, which happens soon after the write callback signals an abort
+	if (isJobRegistered())
 	{
-		mThreadRunning = false;
-		mThread->join();
-		delete mThread;
-		mThread = nullptr;
+		FTX::JobManager->removeJob(*this);
 	}
+
+#if defined(PLATFORM_ANDROID)
+	// Android runs the actual download in its own thread, which needs to be stopped separately
+	if (mPlatformDownloadStarted && mState == State::RUNNING)
+	{
+		AndroidJavaInterface::instance().stopFileDownload(mPlatformDownloadId);
+	}
+#endif
+	mPlatformDownloadStarted = false;
 	mState = State::NONE;
 }
 
@@ -71,15 +81,10 @@ size_t Downloader::writeDataStatic(void* data, size_t size, size_t nmemb, Downlo
 	return downloader->writeData(data, size, nmemb);
 }
 
-void Downloader::performDownloadStatic(Downloader* downloader)
-{
-	downloader->performDownload();
-}
-
 size_t Downloader::writeData(void* data, size_t size, size_t nmemb)
 {
 	// Check for a signal to stop the download
-	if (!mThreadRunning)
+	if (!shouldJobBeRunning())
 		return 0;
 
 	// Write data to the output file
@@ -89,19 +94,19 @@ size_t Downloader::writeData(void* data, size_t size, size_t nmemb)
 	return written;
 }
 
-void Downloader::performDownload()
+bool Downloader::jobFunc()
 {
+	// This method is executed by a worker thread
 #if defined(USING_CURL)
 
 	CURL* curl = curl_easy_init();
 	if (nullptr == curl)
 	{
 		mState = State::FAILED;
-		return;
+		return true;
 	}
 
 	mOutputFile.open(Configuration::instance().mAppDataPath + mOutputFilename, FILE_ACCESS_WRITE);
-	mThreadRunning = true;
 
 	curl_easy_setopt(curl, CURLOPT_URL, mURL.c_str());
 	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &Downloader::writeDataStatic);
@@ -112,9 +117,8 @@ void Downloader::performDownload()
 	mOutputFile.close();
 
 	// Check if aborted
-	if (mThreadRunning)
+	if (shouldJobBeRunning())
 	{
-		mThreadRunning = false;
 		mState = State::DONE;
 	}
 	else
@@ -122,51 +126,50 @@ void Downloader::performDownload()
 		// TODO: Delete the output file
 		mState = State::FAILED;
 	}
+	return true;
 
 #elif defined(PLATFORM_ANDROID)
 
 	AndroidJavaInterface& javaInterface = AndroidJavaInterface::instance();
-	const uint64 downloadId = javaInterface.startFileDownload(mURL.c_str(), *WString(mOutputFilename).toUTF8());
+	if (!mPlatformDownloadStarted)
+	{
+		mPlatformDownloadId = javaInterface.startFileDownload(mURL.c_str(), *WString(mOutputFilename).toUTF8());
+		mPlatformDownloadStarted = true;
+	}
 
-	// The download runs in its own thread, so we just have to wait here...
-	mThreadRunning = true;
-	while (true)
+	// States:
+	//  0x00 = Invalid download request
+	//  0x01 = Pending download
+	//  0x02 = Running
+	//  0x04 = Paused
+	//  0x08 = Finished successfully
+	//  0x10 = Failed
+	int state;
+	uint64 bytesDownloaded;
+	uint64 bytesTotal;
+	javaInterface.getDownloadStatus(mPlatformDownloadId, state, bytesDownloaded, bytesTotal);
+	mBytesDownloaded = bytesDownloaded;
+
+	if (state == 0x00 || state == 0x10)
 	{
-		if (!mThreadRunning)
-		{
-			// Download was stopped by the user
-			javaInterface.stopFileDownload(downloadId);
-			mState = State::FAILED;
-			return;
-		}
-
-		// States:
-		//  0x00 = Invalid download request
-		//  0x01 = Pending download
-		//  0x02 = Running
-		//  0x04 = Paused
-		//  0x08 = Finished successfully
-		//  0x10 = Failed
-		int state;
-		uint64 bytesDownloaded;
-		uint64 bytesTotal;
-		javaInterface.getDownloadStatus(downloadId, state, bytesDownloaded, bytesTotal);
-		mBytesDownloaded = bytesDownloaded;
-
-		if (state == 0x00 || state == 0x10)
-		{
-			mState = State::FAILED;
-			return;
-		}
-		else if (state == 0x08)
-		{
-			mThreadRunning = false;
-			mState = State::DONE;
-			return;
-		}
-
-		std::this_thread::sleep_for(std::chrono::milliseconds(250));
+		mState = State::FAILED;
+		return true;
 	}
+	else if (state == 0x08)
+	{
+		mState = State::DONE;
+		return true;
+	}
+
+	// The download runs in its own thread, so there's no need to block the worker thread while waiting
+	//  -> Instead, check again after a short delay
+	setJobDelayUntilTicks(SDL_GetTicks() + 250);
+	return false;
+
+#else
+
+	mState = State::FAILED;
+	return true;
 
 #endif
 }
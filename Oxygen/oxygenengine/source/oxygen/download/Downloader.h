@@ -8,12 +8,12 @@
 
 #pragma once
 
-#include <rmxbase.h>
+#include <rmxmedia.h>
 #include <atomic>
-#include <thread>
 
 
-class Downloader
+// Downloads run as a job in the job manager, so that they never block the main thread
+class Downloader : public rmx::JobBase
 {
 public:
 	enum class State
@@ -38,19 +38,20 @@ public:
 	void startDownload();
 	void stopDownload();
 
+protected:
+	virtual bool jobFunc() override;
+
 private:
 	static size_t writeDataStatic(void* data, size_t size, size_t nmemb, Downloader* downloader);
-	static void performDownloadStatic(Downloader* downloader);
 
 	size_t writeData(void* data, size_t size, size_t nmemb);
-	void performDownload();
 
 private:
 	std::string mURL;
-	std::thread* mThread = nullptr;
-	State mState = State::NONE;
+	std::atomic<State> mState = State::NONE;
 	std::wstring mOutputFilename;
 	FileHandle mOutputFile;
 	std::atomic<uint64> mBytesDownloaded = 0;
-	std::atomic<bool> mThreadRunning = false;
+	bool mPlatformDownloadStarted = false;
+	uint64 mPlatformDownloadId = 0;
 };
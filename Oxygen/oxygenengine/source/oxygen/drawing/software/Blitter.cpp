@@ -9,6 +9,7 @@
 #include "oxygen/pch.h"
 #include "oxygen/drawing/software/Blitter.h"
 #include "oxygen/drawing/software/BlitterHelper.h"
+#include "oxygen/drawing/software/BlitterKernels.h"
 
 
 void Blitter::blitColor(const OutputWrapper& output, const Color& color, BlendMode blendMode)
@@ -36,7 +37,13 @@ void Blitter::blitSprite(const OutputWrapper& output, const SpriteWrapper& sprit
 	if (outputBoundingBox.isEmpty())
 		return;
 
-	if (nullptr == options.mTransform)
+	if (mUseKernels && BlitterKernels::supportsOptions(options))
+	{
+		// Fast path: Process and merge directly into the output, line by line
+		const Vec2i innerIndent = outputBoundingBox.getPos() - position + sprite.mPivot;
+		BlitterKernels::blitSprite(output, outputBoundingBox, BitmapView<uint32>(sprite.mBitmapView, Recti(innerIndent, outputBoundingBox.getSize())), options);
+	}
+	else if (nullptr == options.mTransform)
 	{
 		const Vec2i innerIndent = outputBoundingBox.getPos() - position + sprite.mPivot;
 
@@ -80,7 +87,13 @@ void Blitter::blitIndexed(const OutputWrapper& output, const IndexedSpriteWrappe
 	if (outputBoundingBox.isEmpty())
 		return;
 
-	if (nullptr == options.mTransform)
+	if (mUseKernels && BlitterKernels::supportsOptions(options))
+	{
+		// Fast path: Palette lookup, processing and merge directly into the output, line by line
+		const Vec2i innerIndent = outputBoundingBox.getPos() - position + sprite.mPivot;
+		BlitterKernels::blitIndexed(output, outputBoundingBox, BitmapView<uint8>(sprite.mBitmapView, Recti(innerIndent, outputBoundingBox.getSize())), palette, options);
+	}
+	else if (nullptr == options.mTransform)
 	{
 		const Vec2i innerIndent = outputBoundingBox.getPos() - position + sprite.mPivot;
 
@@ -71,6 +71,9 @@ public:
 	};
 
 public:
+	// Line kernels get used for untransformed sprites by default, this switches to the generic intermediate bitmap path instead, e.g. for comparison in tests
+	inline void setUseKernels(bool enable)  { mUseKernels = enable; }
+
 	void blitColor(const OutputWrapper& output, const Color& color, BlendMode blendMode);
 	void blitSprite(const OutputWrapper& output, const SpriteWrapper& sprite, Vec2i position, const Options& options);
 	void blitIndexed(const OutputWrapper& output, const IndexedSpriteWrapper& sprite, const PaletteWrapper& palette, Vec2i position, const Options& options);
@@ -90,4 +93,5 @@ private:
 
 private:
 	std::vector<uint32> mTempBitmapData;		// Defined here so its reserved memory can be reused for multiple blitting calls
+	bool mUseKernels = true;
 };
@@ -0,0 +1,423 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#include "oxygen/pch.h"
+#include "oxygen/drawing/software/BlitterKernels.h"
+#include "oxygen/drawing/software/BlitterHelper.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__)) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define BLITTER_SSE2
+	#include <emmintrin.h>
+#endif
+
+
+namespace
+{
+	static constexpr int CHUNK_SIZE = 128;		// Number of pixels processed at once using a line buffer on the stack
+
+	struct ColorProcessing
+	{
+		// Tint color factors in 8.8 fixed point, and added color split into its positive and negative parts
+		//  -> Alpha channel uses a tint factor only, no added color
+		uint16 mMultiply[4] = { 0x100, 0x100, 0x100, 0x100 };
+		uint16 mAddPositive[4] = { 0 };
+		uint16 mAddNegative[4] = { 0 };
+	};
+
+	struct BlitContext
+	{
+		BitmapViewMutable<uint32> mOutput;
+		BitmapViewMutable<uint8> mDepthBuffer;
+		BitmapView<uint32> mInputRGBA;
+		BitmapView<uint8> mInputIndexed;
+		Blitter::PaletteWrapper mPalette;
+		ColorProcessing mColorProcessing;
+		uint8 mDepthTestValue = 0;
+	};
+
+	typedef void(*BlitFunction)(const BlitContext& context);
+
+
+	int getTintFactor(float value)
+	{
+		// Same as in "Blitter::processIntermediateBitmap"
+		return clamp(roundToInt(value * 0x100), -0x10000, 0x10000);
+	}
+
+	bool getColorProcessing(ColorProcessing& outProcessing, const Blitter::Options& options)
+	{
+		if (nullptr != options.mTintColor)
+		{
+			const int mult[4] = { getTintFactor(options.mTintColor->r), getTintFactor(options.mTintColor->g), getTintFactor(options.mTintColor->b), getTintFactor(options.mTintColor->a) };
+			for (int k = 0; k < 4; ++k)
+			{
+				// Negative tint factors and 0x10000 don't fit into unsigned 16-bit multiplications
+				if (mult[k] < 0 || mult[k] > 0xffff)
+					return false;
+				outProcessing.mMultiply[k] = (uint16)mult[k];
+			}
+		}
+		if (nullptr != options.mAddedColor)
+		{
+			const int add[3] = { roundToInt(options.mAddedColor->r * 0xff), roundToInt(options.mAddedColor->g * 0xff), roundToInt(options.mAddedColor->b * 0xff) };
+			for (int k = 0; k < 3; ++k)
+			{
+				// Limiting the added value to this range does not change the clamped result
+				outProcessing.mAddPositive[k] = (uint16)clamp(add[k], 0, 0xff);
+				outProcessing.mAddNegative[k] = (uint16)clamp(-add[k], 0, 0xffff);
+			}
+		}
+		return true;
+	}
+
+
+	// Scalar code
+	//  -> Used for the last pixels of each line that don't fill a whole SIMD block, and on platforms without SIMD support
+
+	template<bool USE_TINT, bool USE_ADD>
+	void processColorsScalar(uint32* dst_, const uint32* src_, int numPixels, const ColorProcessing& processing)
+	{
+		// This produces the same results as "Blitter::processIntermediateBitmap"
+		uint8* dst = (uint8*)dst_;
+		const uint8* src = (const uint8*)src_;
+		for (int x = 0; x < numPixels; ++x)
+		{
+			for (int k = 0; k < 4; ++k)
+			{
+				int value = src[k];
+				if constexpr (USE_TINT)
+					value = (value * processing.mMultiply[k]) >> 8;
+				if constexpr (USE_ADD)
+					value = value + processing.mAddPositive[k] - processing.mAddNegative[k];
+				dst[k] = (uint8)clamp(value, 0, 0xff);
+			}
+			dst += 4;
+			src += 4;
+		}
+	}
+
+	template<BlendMode BLEND_MODE, bool DEPTH_TEST>
+	void blendLineScalar(uint32* dst, const uint32* src, int numPixels, uint8* depth, uint8 depthTestValue)
+	{
+		if constexpr (DEPTH_TEST)
+		{
+			switch (BLEND_MODE)
+			{
+				case BlendMode::ALPHA:			 BlitterHelper::blendLineAlphaWithDepth(dst, src, numPixels, depth, depthTestValue);			break;
+				case BlendMode::ONE_BIT:		 BlitterHelper::blendLineOneBitWithDepth(dst, src, numPixels, depth, depthTestValue);			break;
+				case BlendMode::ADDITIVE:		 BlitterHelper::blendLineAdditiveWithDepth(dst, src, numPixels, depth, depthTestValue);			break;
+				case BlendMode::SUBTRACTIVE:	 BlitterHelper::blendLineSubtractiveWithDepth(dst, src, numPixels, depth, depthTestValue);		break;
+				case BlendMode::MULTIPLICATIVE:	 BlitterHelper::blendLineMultiplicativeWithDepth(dst, src, numPixels, depth, depthTestValue);	break;
+				case BlendMode::MINIMUM:		 BlitterHelper::blendLineMinimumWithDepth(dst, src, numPixels, depth, depthTestValue);			break;
+				case BlendMode::MAXIMUM:		 BlitterHelper::blendLineMaximumWithDepth(dst, src, numPixels, depth, depthTestValue);			break;
+				default:						 BlitterHelper::blendLineOpaqueWithDepth(dst, src, numPixels, depth, depthTestValue);			break;
+			}
+		}
+		else
+		{
+			switch (BLEND_MODE)
+			{
+				case BlendMode::ALPHA:			 BlitterHelper::blendLineAlpha(dst, src, numPixels);			break;
+				case BlendMode::ONE_BIT:		 BlitterHelper::blendLineOneBit(dst, src, numPixels);			break;
+				case BlendMode::ADDITIVE:		 BlitterHelper::blendLineAdditive(dst, src, numPixels);			break;
+				case BlendMode::SUBTRACTIVE:	 BlitterHelper::blendLineSubtractive(dst, src, numPixels);		break;
+				case BlendMode::MULTIPLICATIVE:	 BlitterHelper::blendLineMultiplicative(dst, src, numPixels);	break;
+				case BlendMode::MINIMUM:		 BlitterHelper::blendLineMinimum(dst, src, numPixels);			break;
+				case BlendMode::MAXIMUM:		 BlitterHelper::blendLineMaximum(dst, src, numPixels);			break;
+				default:						 BlitterHelper::blendLineOpaque(dst, src, numPixels);			break;
+			}
+		}
+	}
+
+
+#if defined(BLITTER_SSE2)
+
+	// SSE2 code
+	//  -> Handles 4 pixels at once, with color channels expanded to 16 bits where multiplications are needed
+
+	FORCE_INLINE __m128i divideBy255_SSE2(__m128i value)
+	{
+		// Exact integer division by 255 for all 16-bit values up to 255 * 255
+		return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(value, _mm_set1_epi16(1)), _mm_srli_epi16(value, 8)), 8);
+	}
+
+	FORCE_INLINE __m128i multiplyFixed8_SSE2(__m128i value, __m128i factor)
+	{
+		// Calculates (value * factor) >> 8 for unsigned 16-bit values, where the result is known to fit into 16 bits
+		const __m128i low = _mm_mullo_epi16(value, factor);
+		const __m128i high = _mm_mulhi_epu16(value, factor);
+		return _mm_or_si128(_mm_slli_epi16(high, 8), _mm_srli_epi16(low, 8));
+	}
+
+	template<bool USE_TINT, bool USE_ADD>
+	FORCE_INLINE __m128i processChannels_SSE2(__m128i value, __m128i multiply, __m128i addPositive, __m128i addNegative)
+	{
+		if constexpr (USE_TINT)
+			value = multiplyFixed8_SSE2(value, multiply);
+		if constexpr (USE_ADD)
+			value = _mm_subs_epu16(_mm_adds_epu16(value, addPositive), addNegative);
+
+		// Clamp to 0xff; there's no unsigned 16-bit minimum in SSE2, so use saturated subtraction instead
+		return _mm_sub_epi16(value, _mm_subs_epu16(value, _mm_set1_epi16(0xff)));
+	}
+
+	template<bool USE_TINT, bool USE_ADD>
+	void processColors(uint32* dst, const uint32* src, int numPixels, const ColorProcessing& processing)
+	{
+		// Factors for two pixels, matching the channel layout after unpacking to 16 bits
+		const __m128i multiply = _mm_set_epi16(processing.mMultiply[3], processing.mMultiply[2], processing.mMultiply[1], processing.mMultiply[0], processing.mMultiply[3], processing.mMultiply[2], processing.mMultiply[1], processing.mMultiply[0]);
+		const __m128i addPositive = _mm_set_epi16(0, processing.mAddPositive[2], processing.mAddPositive[1], processing.mAddPositive[0], 0, processing.mAddPositive[2], processing.mAddPositive[1], processing.mAddPositive[0]);
+		const __m128i addNegative = _mm_set_epi16(0, processing.mAddNegative[2], processing.mAddNegative[1], processing.mAddNegative[0], 0, processing.mAddNegative[2], processing.mAddNegative[1], processing.mAddNegative[0]);
+		const __m128i zero = _mm_setzero_si128();
+
+		int x = 0;
+		for (; x + 4 <= numPixels; x += 4)
+		{
+			const __m128i colors = _mm_loadu_si128((const __m128i*)&src[x]);
+			const __m128i low  = processChannels_SSE2<USE_TINT, USE_ADD>(_mm_unpacklo_epi8(colors, zero), multiply, addPositive, addNegative);
+			const __m128i high = processChannels_SSE2<USE_TINT, USE_ADD>(_mm_unpackhi_epi8(colors, zero), multiply, addPositive, addNegative);
+			_mm_storeu_si128((__m128i*)&dst[x], _mm_packus_epi16(low, high));
+		}
+		processColorsScalar<USE_TINT, USE_ADD>(&dst[x], &src[x], numPixels - x, processing);
+	}
+
+	template<BlendMode BLEND_MODE>
+	FORCE_INLINE __m128i blendChannels_SSE2(__m128i dst, __m128i src)
+	{
+		// Blend 2 pixels with channels expanded to 16 bits
+		if constexpr (BLEND_MODE == BlendMode::ALPHA)
+		{
+			const __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(src, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			const __m128i oneMinusAlpha = _mm_sub_epi16(_mm_set1_epi16(0xff), alpha);
+			return divideBy255_SSE2(_mm_add_epi16(_mm_mullo_epi16(src, alpha), _mm_mullo_epi16(dst, oneMinusAlpha)));
+		}
+		else
+		{
+			static_assert(BLEND_MODE == BlendMode::MULTIPLICATIVE, "Unsupported blend mode");
+			return divideBy255_SSE2(_mm_mullo_epi16(src, dst));
+		}
+	}
+
+	template<BlendMode BLEND_MODE, bool DEPTH_TEST>
+	void blendLine(uint32* dst, const uint32* src, int numPixels, uint8* depth, uint8 depthTestValue)
+	{
+		if constexpr (BLEND_MODE == BlendMode::OPAQUE && !DEPTH_TEST)
+		{
+			// Nothing to gain here, it's a simple copy anyways
+			BlitterHelper::blendLineOpaque(dst, src, numPixels);
+			return;
+		}
+
+		const __m128i alphaMask = _mm_set1_epi32(0xff000000);
+		const __m128i depthTestValue32 = _mm_set1_epi32(depthTestValue);
+		const __m128i zero = _mm_setzero_si128();
+
+		int x = 0;
+		for (; x + 4 <= numPixels; x += 4)
+		{
+			const __m128i srcColors = _mm_loadu_si128((const __m128i*)&src[x]);
+			const __m128i dstColors = _mm_loadu_si128((const __m128i*)&dst[x]);
+
+			// Mask of pixels where the output stays unchanged
+			__m128i keepMask = zero;
+			if constexpr (DEPTH_TEST)
+			{
+				int32 depthValues;
+				memcpy(&depthValues, &depth[x], 4);
+				const __m128i depth32 = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(depthValues), zero), zero);
+				keepMask = _mm_cmpgt_epi32(depth32, depthTestValue32);
+			}
+			if constexpr (BLEND_MODE != BlendMode::OPAQUE && BLEND_MODE != BlendMode::ALPHA && BLEND_MODE != BlendMode::ONE_BIT)
+			{
+				// Fully transparent source pixels get ignored
+				keepMask = _mm_or_si128(keepMask, _mm_cmpeq_epi32(_mm_and_si128(srcColors, alphaMask), zero));
+			}
+
+			__m128i result;
+			if constexpr (BLEND_MODE == BlendMode::OPAQUE)
+			{
+				result = srcColors;
+			}
+			else if constexpr (BLEND_MODE == BlendMode::ONE_BIT)
+			{
+				const __m128i isOpaque = _mm_srai_epi32(srcColors, 31);
+				result = _mm_or_si128(_mm_and_si128(isOpaque, _mm_or_si128(srcColors, alphaMask)), _mm_andnot_si128(isOpaque, dstColors));
+			}
+			else
+			{
+				if constexpr (BLEND_MODE == BlendMode::ALPHA || BLEND_MODE == BlendMode::MULTIPLICATIVE)
+				{
+					const __m128i low  = blendChannels_SSE2<BLEND_MODE>(_mm_unpacklo_epi8(dstColors, zero), _mm_unpacklo_epi8(srcColors, zero));
+					const __m128i high = blendChannels_SSE2<BLEND_MODE>(_mm_unpackhi_epi8(dstColors, zero), _mm_unpackhi_epi8(srcColors, zero));
+					result = _mm_packus_epi16(low, high);
+				}
+				else if constexpr (BLEND_MODE == BlendMode::ADDITIVE)
+				{
+					result = _mm_adds_epu8(dstColors, srcColors);
+				}
+				else if constexpr (BLEND_MODE == BlendMode::SUBTRACTIVE)
+				{
+					result = _mm_subs_epu8(dstColors, srcColors);
+				}
+				else if constexpr (BLEND_MODE == BlendMode::MINIMUM)
+				{
+					result = _mm_min_epu8(dstColors, srcColors);
+				}
+				else
+				{
+					result = _mm_max_epu8(dstColors, srcColors);
+				}
+
+				// These blend modes all leave the output alpha untouched
+				result = _mm_or_si128(_mm_andnot_si128(alphaMask, result), _mm_and_si128(alphaMask, dstColors));
+			}
+
+			_mm_storeu_si128((__m128i*)&dst[x], _mm_or_si128(_mm_and_si128(keepMask, dstColors), _mm_andnot_si128(keepMask, result)));
+		}
+		blendLineScalar<BLEND_MODE, DEPTH_TEST>(&dst[x], &src[x], numPixels - x, DEPTH_TEST ? &depth[x] : nullptr, depthTestValue);
+	}
+
+#else
+
+	template<bool USE_TINT, bool USE_ADD>
+	void processColors(uint32* dst, const uint32* src, int numPixels, const ColorProcessing& processing)
+	{
+		processColorsScalar<USE_TINT, USE_ADD>(dst, src, numPixels, processing);
+	}
+
+	template<BlendMode BLEND_MODE, bool DEPTH_TEST>
+	void blendLine(uint32* dst, const uint32* src, int numPixels, uint8* depth, uint8 depthTestValue)
+	{
+		blendLineScalar<BLEND_MODE, DEPTH_TEST>(dst, src, numPixels, depth, depthTestValue);
+	}
+
+#endif
+
+
+	void lookupPalette(uint32* dst, const uint8* src, int numPixels, const Blitter::PaletteWrapper& palette)
+	{
+		// Same as in "Blitter::makeTempBitmapAsCopy"
+		for (int x = 0; x < numPixels; ++x)
+		{
+			const uint8 index = src[x];
+			dst[x] = (index < palette.mNumEntries) ? palette.mPalette[index] : 0;
+		}
+	}
+
+	template<bool INDEXED, BlendMode BLEND_MODE, bool USE_TINT, bool USE_ADD, bool DEPTH_TEST>
+	void blitLines(const BlitContext& context)
+	{
+		const int width = context.mOutput.getSize().x;
+		for (int y = 0; y < context.mOutput.getSize().y; ++y)
+		{
+			uint32* dst = context.mOutput.getLinePointer(y);
+			uint8* depth = DEPTH_TEST ? context.mDepthBuffer.getLinePointer(y) : nullptr;
+
+			if constexpr (!INDEXED && !USE_TINT && !USE_ADD)
+			{
+				// Blend the input data directly, no need for a line buffer
+				blendLine<BLEND_MODE, DEPTH_TEST>(dst, context.mInputRGBA.getLinePointer(y), width, depth, context.mDepthTestValue);
+			}
+			else
+			{
+				uint32 buffer[CHUNK_SIZE];
+				for (int x = 0; x < width; x += CHUNK_SIZE)
+				{
+					const int numPixels = std::min(width - x, CHUNK_SIZE);
+					const uint32* colors = buffer;
+					if constexpr (INDEXED)
+					{
+						lookupPalette(buffer, context.mInputIndexed.getLinePointer(y) + x, numPixels, context.mPalette);
+						if constexpr (USE_TINT || USE_ADD)
+							processColors<USE_TINT, USE_ADD>(buffer, buffer, numPixels, context.mColorProcessing);
+					}
+					else
+					{
+						processColors<USE_TINT, USE_ADD>(buffer, context.mInputRGBA.getLinePointer(y) + x, numPixels, context.mColorProcessing);
+					}
+					blendLine<BLEND_MODE, DEPTH_TEST>(dst + x, colors, numPixels, DEPTH_TEST ? depth + x : nullptr, context.mDepthTestValue);
+				}
+			}
+		}
+	}
+
+
+	// Selection of the template specialization for the given options
+
+	template<bool INDEXED, BlendMode BLEND_MODE, bool USE_TINT, bool USE_ADD>
+	BlitFunction selectBlitFunction(bool depthTest)
+	{
+		return depthTest ? &blitLines<INDEXED, BLEND_MODE, USE_TINT, USE_ADD, true> : &blitLines<INDEXED, BLEND_MODE, USE_TINT, USE_ADD, false>;
+	}
+
+	template<bool INDEXED, BlendMode BLEND_MODE>
+	BlitFunction selectBlitFunction(bool useTint, bool useAdd, bool depthTest)
+	{
+		if (useTint)
+			return useAdd ? selectBlitFunction<INDEXED, BLEND_MODE, true, true>(depthTest) : selectBlitFunction<INDEXED, BLEND_MODE, true, false>(depthTest);
+		else
+			return useAdd ? selectBlitFunction<INDEXED, BLEND_MODE, false, true>(depthTest) : selectBlitFunction<INDEXED, BLEND_MODE, false, false>(depthTest);
+	}
+
+	template<bool INDEXED>
+	BlitFunction selectBlitFunction(const Blitter::Options& options)
+	{
+		const bool useTint = (nullptr != options.mTintColor);
+		const bool useAdd = (nullptr != options.mAddedColor);
+		const bool depthTest = (nullptr != options.mDepthBuffer);
+		switch (options.mBlendMode)
+		{
+			case BlendMode::ALPHA:			 return selectBlitFunction<INDEXED, BlendMode::ALPHA>(useTint, useAdd, depthTest);
+			case BlendMode::ONE_BIT:		 return selectBlitFunction<INDEXED, BlendMode::ONE_BIT>(useTint, useAdd, depthTest);
+			case BlendMode::ADDITIVE:		 return selectBlitFunction<INDEXED, BlendMode::ADDITIVE>(useTint, useAdd, depthTest);
+			case BlendMode::SUBTRACTIVE:	 return selectBlitFunction<INDEXED, BlendMode::SUBTRACTIVE>(useTint, useAdd, depthTest);
+			case BlendMode::MULTIPLICATIVE:	 return selectBlitFunction<INDEXED, BlendMode::MULTIPLICATIVE>(useTint, useAdd, depthTest);
+			case BlendMode::MINIMUM:		 return selectBlitFunction<INDEXED, BlendMode::MINIMUM>(useTint, useAdd, depthTest);
+			case BlendMode::MAXIMUM:		 return selectBlitFunction<INDEXED, BlendMode::MAXIMUM>(useTint, useAdd, depthTest);
+			default:						 return selectBlitFunction<INDEXED, BlendMode::OPAQUE>(useTint, useAdd, depthTest);
+		}
+	}
+
+	void setupContext(BlitContext& context, const Blitter::OutputWrapper& output, const Recti& outputBoundingBox, const Blitter::Options& options)
+	{
+		context.mOutput = BitmapViewMutable<uint32>(output.mBitmapView, outputBoundingBox);
+		if (nullptr != options.mDepthBuffer)
+		{
+			context.mDepthBuffer = BitmapViewMutable<uint8>(*options.mDepthBuffer, outputBoundingBox);
+			context.mDepthTestValue = options.mDepthTestValue;
+		}
+		getColorProcessing(context.mColorProcessing, options);
+	}
+}
+
+
+bool BlitterKernels::supportsOptions(const Blitter::Options& options)
+{
+	if (nullptr != options.mTransform || options.mSwapRedBlueChannels)
+		return false;
+
+	ColorProcessing processing;
+	return getColorProcessing(processing, options);
+}
+
+void BlitterKernels::blitSprite(const Blitter::OutputWrapper& output, const Recti& outputBoundingBox, const BitmapView<uint32>& input, const Blitter::Options& options)
+{
+	BlitContext context;
+	setupContext(context, output, outputBoundingBox, options);
+	context.mInputRGBA = input;
+	selectBlitFunction<false>(options)(context);
+}
+
+void BlitterKernels::blitIndexed(const Blitter::OutputWrapper& output, const Recti& outputBoundingBox, const BitmapView<uint8>& input, const Blitter::PaletteWrapper& palette, const Blitter::Options& options)
+{
+	BlitContext context;
+	setupContext(context, output, outputBoundingBox, options);
+	context.mInputIndexed = input;
+	context.mPalette = palette;
+	selectBlitFunction<true>(options)(context);
+}
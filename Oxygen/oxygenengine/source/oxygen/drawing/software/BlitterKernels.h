@@ -0,0 +1,27 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#pragma once
+
+#include "oxygen/drawing/software/Blitter.h"
+
+
+// Line kernels for untransformed sprite blitting
+//  -> Tint color, added color, blending and depth test are applied in one pass over each line, without copying the sprite into an intermediate bitmap
+//  -> There's one specialization per combination of blend mode, tint color, added color and depth test, selected via templates at compile time
+//  -> Uses SSE2 on x86 builds for blocks of 4 pixels, and BlitterHelper's scalar code otherwise and for the remaining pixels
+//  -> Output must be exactly the same as for Blitter's generic path, see "EngineTests::testBlitterKernels"
+class BlitterKernels
+{
+public:
+	// Check whether the given options are supported, otherwise the caller has to use the generic intermediate bitmap path
+	static bool supportsOptions(const Blitter::Options& options);
+
+	static void blitSprite(const Blitter::OutputWrapper& output, const Recti& outputBoundingBox, const BitmapView<uint32>& input, const Blitter::Options& options);
+	static void blitIndexed(const Blitter::OutputWrapper& output, const Recti& outputBoundingBox, const BitmapView<uint8>& input, const Blitter::PaletteWrapper& palette, const Blitter::Options& options);
+};
@@ -24,6 +24,12 @@ uint32 Bitstream::getSize() const
 
 bool Bitstream::read()
 {
+	if (mBytePosition >= mData.size())
+	{
+		mHasError = true;
+		return false;
+	}
+
 	const bool result = (mData[mBytePosition] & mNextBitValue) != 0;
 	advance();
 	return result;
@@ -45,6 +51,25 @@ void Bitstream::write(bool bit)
 	advance();
 }
 
+uint32 Bitstream::readBits(uint32 numBits)
+{
+	uint32 value = 0;
+	for (uint32 bitIndex = 0; bitIndex < numBits; ++bitIndex)
+	{
+		if (read())
+			value |= (1u << bitIndex);
+	}
+	return value;
+}
+
+void Bitstream::writeBits(uint32 value, uint32 numBits)
+{
+	for (uint32 bitIndex = 0; bitIndex < numBits; ++bitIndex)
+	{
+		write((value & (1u << bitIndex)) != 0);
+	}
+}
+
 void Bitstream::advance()
 {
 	if (mNextBitValue >= 0x80)
@@ -21,6 +21,13 @@ public:
 	bool read();
 	void write(bool bit);
 
+	// Multiple bits at once, least significant bit first
+	uint32 readBits(uint32 numBits);
+	void writeBits(uint32 value, uint32 numBits);
+
+	// Set when reading past the end of the data
+	inline bool hasError() const  { return mHasError; }
+
 private:
 	void advance();
 
@@ -28,4 +35,5 @@ private:
 	std::vector<uint8>& mData;
 	uint32 mBytePosition;		// Position inside mData
 	uint32 mNextBitValue;		// Always a power of two between 1 and 128
+	bool mHasError = false;
 };
@@ -0,0 +1,428 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#include "oxygen/pch.h"
+#include "oxygen/helper/EngineTests.h"
+#include "oxygen/drawing/software/Blitter.h"
+#include "oxygen/rendering/software/SoftwareRendererKernels.h"
+#include "oxygen/simulation/GameRecorder.h"
+#include "oxygen/simulation/LogDisplay.h"
+#include "oxygen/simulation/sound/ym2612.h"
+
+#include <random>
+
+
+bool EngineTests::runAllTests()
+{
+	struct Test
+	{
+		const char* mName;
+		bool(*mFunction)();
+	};
+	const Test TESTS[] =
+	{
+		{ "Software renderer kernels", &testSoftwareRendererKernels },
+		{ "Blitter kernels", &testBlitterKernels },
+		{ "YM2612 block processing", &testYM2612BlockProcessing },
+		{ "Game recorder", &testGameRecorder },
+	};
+
+	int numFailed = 0;
+	for (const Test& test : TESTS)
+	{
+		const bool passed = test.mFunction();
+		RMX_LOG_INFO((passed ? "Passed: " : "FAILED: ") << test.mName);
+		if (!passed)
+			++numFailed;
+	}
+
+	RMX_LOG_INFO(numFailed << " of " << sizeof(TESTS) / sizeof(TESTS[0]) << " engine tests failed");
+	return (numFailed == 0);
+}
+
+bool EngineTests::testSoftwareRendererKernels()
+{
+	// Compare all supported SIMD variants against the scalar kernels, for all pixel counts up to a few SIMD blocks plus remainder
+	typedef SoftwareRendererKernels::Variant Variant;
+	constexpr int MAX_PIXELS = 72;
+
+	SoftwareRendererKernels::Functions reference;
+	SoftwareRendererKernels::getVariantFunctions(Variant::SCALAR, reference);
+
+	bool success = true;
+	for (Variant variant : { Variant::SSE2, Variant::AVX2, Variant::NEON })
+	{
+		SoftwareRendererKernels::Functions functions;
+		if (!SoftwareRendererKernels::getVariantFunctions(variant, functions))
+			continue;
+
+		std::mt19937 random(0x12345678);
+		uint32 palette[0x140];		// Including room for a palette offset
+		uint8 src[MAX_PIXELS];
+		uint8 depth[MAX_PIXELS];
+		uint32 outputRGBA[2][MAX_PIXELS];
+		uint8 outputDepth[2][MAX_PIXELS];
+		for (uint32& color : palette)
+			color = random();
+
+		for (int numPixels = 0; numPixels <= MAX_PIXELS; ++numPixels)
+		{
+			for (int i = 0; i < MAX_PIXELS; ++i)
+			{
+				// Include transparent pixels, i.e. palette indices with the lower 4 bits all zero
+				src[i] = (random() % 3 == 0) ? (uint8)(random() & 0xf0) : (uint8)random();
+				depth[i] = (random() & 1) ? 0x80 : 0;
+				outputRGBA[0][i] = outputRGBA[1][i] = random();
+				outputDepth[0][i] = outputDepth[1][i] = depth[i];
+			}
+
+			const char* mismatch = nullptr;
+			reference.mWritePixelsOpaque(outputRGBA[0], src, palette, numPixels);
+			functions.mWritePixelsOpaque(outputRGBA[1], src, palette, numPixels);
+			if (memcmp(outputRGBA[0], outputRGBA[1], sizeof(outputRGBA[0])) != 0)
+				mismatch = "writePixelsOpaque";
+
+			reference.mWritePixels(outputRGBA[0], src, palette + 0x40, numPixels);
+			functions.mWritePixels(outputRGBA[1], src, palette + 0x40, numPixels);
+			if (nullptr == mismatch && memcmp(outputRGBA[0], outputRGBA[1], sizeof(outputRGBA[0])) != 0)
+				mismatch = "writePixels";
+
+			for (uint8 depthValue : { (uint8)0, (uint8)0x40, (uint8)0x80 })
+			{
+				reference.mWritePixelsDepthTested(outputRGBA[0], depth, depthValue, src, palette, numPixels);
+				functions.mWritePixelsDepthTested(outputRGBA[1], depth, depthValue, src, palette, numPixels);
+				if (nullptr == mismatch && memcmp(outputRGBA[0], outputRGBA[1], sizeof(outputRGBA[0])) != 0)
+					mismatch = "writePixelsDepthTested";
+			}
+
+			reference.mWritePixelsWithDepth(outputRGBA[0], outputDepth[0], src, palette, numPixels);
+			functions.mWritePixelsWithDepth(outputRGBA[1], outputDepth[1], src, palette, numPixels);
+			if (nullptr == mismatch && (memcmp(outputRGBA[0], outputRGBA[1], sizeof(outputRGBA[0])) != 0 || memcmp(outputDepth[0], outputDepth[1], sizeof(outputDepth[0])) != 0))
+				mismatch = "writePixelsWithDepth";
+
+			if (nullptr != mismatch)
+			{
+				RMX_LOG_INFO("Software renderer kernel " << mismatch << " of variant " << SoftwareRendererKernels::getVariantName(variant) << " differs from scalar reference for " << numPixels << " pixels");
+				success = false;
+				break;
+			}
+		}
+	}
+	return success;
+}
+
+bool EngineTests::testBlitterKernels()
+{
+	// Compare blitting with line kernels against the generic intermediate bitmap path, for all blend modes and color processing options
+	//  -> Sprites are partially outside of the output, and have all widths up to a few SIMD blocks plus remainder
+	constexpr int MAX_WIDTH = 20;
+	constexpr int HEIGHT = 3;
+	constexpr int OUTPUT_WIDTH = MAX_WIDTH + 4;
+	constexpr int PALETTE_SIZE = 16;
+	const BlendMode BLEND_MODES[] = { BlendMode::OPAQUE, BlendMode::ALPHA, BlendMode::ONE_BIT, BlendMode::ADDITIVE, BlendMode::SUBTRACTIVE, BlendMode::MULTIPLICATIVE, BlendMode::MINIMUM, BlendMode::MAXIMUM };
+	const uint32 ALPHA_VALUES[] = { 0x00, 0x01, 0x7f, 0x80, 0xfe, 0xff };
+
+	std::mt19937 random(0x12345678);
+	auto randomColor = [&]() { return (random() & 0x00ffffff) | (ALPHA_VALUES[random() % 6] << 24); };
+
+	Blitter blitters[2];
+	blitters[1].setUseKernels(false);
+
+	uint32 sprite[MAX_WIDTH * HEIGHT];
+	uint8 indices[MAX_WIDTH * HEIGHT];
+	uint32 palette[PALETTE_SIZE];
+	uint32 output[2][OUTPUT_WIDTH * HEIGHT];
+	uint8 depth[2][OUTPUT_WIDTH * HEIGHT];
+	const Blitter::PaletteWrapper paletteWrapper(palette, PALETTE_SIZE - 4);	// Some indices are outside the palette, these must result in transparent pixels
+
+	for (int width = 1; width <= MAX_WIDTH; ++width)
+	{
+		for (BlendMode blendMode : BLEND_MODES)
+		{
+			for (bool indexed : { false, true })
+			{
+				for (int colorMode = 0; colorMode < 4; ++colorMode)		// No color processing, tint only, added color only, tint and added color
+				{
+					for (bool depthTest : { false, true })
+					{
+						for (int i = 0; i < MAX_WIDTH * HEIGHT; ++i)
+						{
+							sprite[i] = randomColor();
+							indices[i] = (uint8)(random() % PALETTE_SIZE);
+						}
+						for (uint32& color : palette)
+							color = randomColor();
+						for (int i = 0; i < OUTPUT_WIDTH * HEIGHT; ++i)
+						{
+							output[0][i] = output[1][i] = random();
+							depth[0][i] = depth[1][i] = (random() & 1) ? 0x80 : 0;
+						}
+
+						// Tint factors are multiples of 1/256 like the kernels use, some of them too large for the kernels, which must then fall back to the generic path
+						const Color tintColor((float)(random() % 0x140) / 256.0f, (float)(random() % 0x140) / 256.0f, (float)(random() % 0x140) / 256.0f, (float)(random() % 0x120) / 256.0f);
+						const Color addedColor((float)((int)(random() % 0x200) - 0x100) / 255.0f, (float)((int)(random() % 0x200) - 0x100) / 255.0f, (float)((int)(random() % 0x200) - 0x100) / 255.0f, 0.0f);
+						const Vec2i position((int)(random() % 8) - 4, (int)(random() % 3) - 1);
+
+						for (int k = 0; k < 2; ++k)
+						{
+							const BitmapViewMutable<uint8> depthBuffer(depth[k], Vec2i(OUTPUT_WIDTH, HEIGHT));
+							Blitter::Options options;
+							options.mBlendMode = blendMode;
+							options.mTintColor = (colorMode == 1 || colorMode == 3) ? &tintColor : nullptr;
+							options.mAddedColor = (colorMode >= 2) ? &addedColor : nullptr;
+							options.mDepthBuffer = depthTest ? &depthBuffer : nullptr;
+							options.mDepthTestValue = 0x40;
+
+							const Blitter::OutputWrapper outputWrapper(output[k], Vec2i(OUTPUT_WIDTH, HEIGHT));
+							if (indexed)
+								blitters[k].blitIndexed(outputWrapper, Blitter::IndexedSpriteWrapper(indices, Vec2i(width, HEIGHT), Vec2i()), paletteWrapper, position, options);
+							else
+								blitters[k].blitSprite(outputWrapper, Blitter::SpriteWrapper(sprite, Vec2i(width, HEIGHT), Vec2i()), position, options);
+						}
+
+						if (memcmp(output[0], output[1], sizeof(output[0])) != 0 || memcmp(depth[0], depth[1], sizeof(depth[0])) != 0)
+						{
+							RMX_LOG_INFO("Blitter kernels differ from generic blitting for blend mode " << (int)blendMode << ", " << (indexed ? "indexed" : "RGBA") << " sprite of width " << width
+										 << ", color mode " << colorMode << (depthTest ? " with depth test" : ""));
+							return false;
+						}
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+bool EngineTests::testYM2612BlockProcessing()
+{
+	// Compare block processing of the FM chip against sample by sample processing, which is the reference implementation
+	//  -> First with random register writes between updates of random length, then with sound driver like timing
+	//     (a burst of register writes every few samples during each frame), including feedback, LFO and amplitude modulation
+	constexpr int SAMPLES_PER_FRAME = 888;		// Samples per frame at 53267 Hz and 60 frames per second
+	constexpr int MAX_LENGTH = 300;
+
+	std::mt19937 random(0x12345678);
+	std::unique_ptr<soundemulation::YM2612> chips[2] = { std::make_unique<soundemulation::YM2612>(), std::make_unique<soundemulation::YM2612>() };
+	for (int k = 0; k < 2; ++k)
+	{
+		chips[k]->init();
+		chips[k]->config(14);
+		chips[k]->resetChip();
+		chips[k]->setBlockProcessing(k == 1);
+	}
+
+	auto writeRegister = [&](uint32 address, uint32 value)
+	{
+		for (auto& chip : chips)
+		{
+			chip->write((address >= 0x100) ? 2 : 0, address & 0xff);
+			chip->write(1, value);
+		}
+	};
+
+	int output[2][MAX_LENGTH * 2];
+	auto updateAndCompare = [&](int length, const char* context)
+	{
+		for (int k = 0; k < 2; ++k)
+			chips[k]->update(output[k], length);
+		if (memcmp(output[0], output[1], length * 2 * sizeof(int)) != 0)
+		{
+			RMX_LOG_INFO("YM2612 block processing differs from sample by sample processing for " << context << ", update length " << length);
+			return false;
+		}
+		return true;
+	};
+
+	// Random register writes, excluding the DAC and timer registers
+	for (int iteration = 0; iteration < 2000; ++iteration)
+	{
+		const int numWrites = random() % 8;
+		for (int i = 0; i < numWrites; ++i)
+		{
+			const uint32 address = ((random() & 1) ? 0x100 : 0) + 0x30 + random() % 0x88;
+			writeRegister(address, random() & 0xff);
+		}
+		if (random() % 4 == 0)
+		{
+			const uint32 channel = random() % 6;
+			writeRegister(0x28, ((channel >= 3) ? channel + 1 : channel) | ((random() & 1) ? 0xf0 : 0));
+		}
+		if (!updateAndCompare(1 + random() % ((random() & 7) ? 40 : MAX_LENGTH), "random register writes"))
+			return false;
+	}
+
+	// Sound driver like timing, with moderate and heavy use of modulation
+	for (bool heavy : { false, true })
+	{
+		writeRegister(0x22, heavy ? 0x0f : 0x00);		// LFO
+		for (int channel = 0; channel < 6; ++channel)
+		{
+			const uint32 part = (channel >= 3) ? 0x100 : 0;
+			const uint32 offset = part + channel % 3;
+			writeRegister(offset + 0xb0, heavy ? (0x38 | (channel % 8)) : (random() % 8));		// Feedback and algorithm
+			writeRegister(offset + 0xb4, heavy ? 0xf7 : 0xc0);									// Panning, AMS and FMS
+			for (int op = 0; op < 4; ++op)
+			{
+				writeRegister(offset + op * 4 + 0x30, random() & 0x7f);							// Detune and multiple
+				writeRegister(offset + op * 4 + 0x40, random() % 0x30);							// Total level
+				writeRegister(offset + op * 4 + 0x50, 0xc0 | (random() & 0x1f));				// Key scale and attack rate
+				writeRegister(offset + op * 4 + 0x60, (heavy ? 0x80 : 0) | (random() & 0x1f));	// AM enable and decay rate
+				writeRegister(offset + op * 4 + 0x70, random() & 0x1f);							// Sustain rate
+				writeRegister(offset + op * 4 + 0x80, random() & 0xff);							// Sustain level and release rate
+			}
+		}
+
+		for (int frame = 0; frame < 60; ++frame)
+		{
+			int remaining = SAMPLES_PER_FRAME;
+			while (remaining > 0)
+			{
+				const uint32 channel = random() % 6;
+				const uint32 offset = ((channel >= 3) ? 0x100 : 0) + channel % 3;
+				writeRegister(offset + 0xa4, random() & 0x3f);
+				writeRegister(offset + 0xa0, random() & 0xff);
+				if (random() % 4 == 0)
+					writeRegister(0x28, ((channel >= 3) ? channel + 1 : channel) | ((random() & 1) ? 0xf0 : 0));
+
+				// Writes of one burst are only a few samples apart, with longer gaps in between
+				const int length = std::min(remaining, (int)((random() & 3) ? (random() % 4) : (random() % MAX_LENGTH)));
+				if (length > 0 && !updateAndCompare(length, heavy ? "heavy modulation" : "driver like timing"))
+					return false;
+				remaining -= length;
+			}
+		}
+	}
+	return true;
+}
+
+bool EngineTests::testGameRecorder()
+{
+	// Record frames with full and differential keyframes, save the recording and load it again, and check that playback restores all inputs and keyframe data
+	//  -> Also checks loading of the older GRC1 format, which has no differential keyframes
+	constexpr int NUM_FRAMES = 600;
+	constexpr int KEYFRAME_INTERVAL = 5;
+	constexpr uint32 MIN_KEEP_FRAMES = 300;
+
+	// Playback updates the mode display
+	std::unique_ptr<LogDisplay> logDisplay;
+	if (!LogDisplay::hasInstance())
+		logDisplay = std::make_unique<LogDisplay>();
+
+	std::mt19937 random(0x12345678);
+
+	// Generate inputs and save states, the latter with only a few changes from one keyframe to the next, and changing size now and then
+	std::vector<std::array<uint16, 2>> inputs(NUM_FRAMES);
+	std::vector<std::vector<uint8>> states(NUM_FRAMES);
+	std::vector<uint8> state(0x3000);
+	for (uint8& value : state)
+		value = (uint8)random();
+	for (int frameNumber = 0; frameNumber < NUM_FRAMES; ++frameNumber)
+	{
+		inputs[frameNumber] = { (uint16)random(), (uint16)random() };
+		if (frameNumber % KEYFRAME_INTERVAL == 0)
+		{
+			for (int k = 0; k < 50; ++k)
+				state[random() % state.size()] = (uint8)random();
+			if (random() % 8 == 0)
+				state.resize(state.size() + (random() % 0x200) - 0x100, (uint8)random());
+			states[frameNumber] = state;
+		}
+	}
+
+	// Check playback of a loaded recording against the generated frames, starting at the given frame number
+	auto checkPlayback = [&](GameRecorder& gameRecorder, int firstFrameNumber, const char* context)
+	{
+		for (int frameNumber = firstFrameNumber; frameNumber < NUM_FRAMES; ++frameNumber)
+		{
+			GameRecorder::PlaybackResult result;
+			if (!gameRecorder.updatePlayback(result))
+			{
+				RMX_LOG_INFO("Game recorder playback of " << context << " ended early at frame " << frameNumber);
+				return false;
+			}
+			const bool isKeyframe = !states[frameNumber].empty();
+			if (result.mInputs[0] != inputs[frameNumber][0] || result.mInputs[1] != inputs[frameNumber][1] || (nullptr != result.mData) != isKeyframe || (isKeyframe && *result.mData != states[frameNumber]))
+			{
+				RMX_LOG_INFO("Game recorder playback of " << context << " differs from recorded data at frame " << frameNumber);
+				return false;
+			}
+		}
+		return true;
+	};
+
+	// Recording, with old frames getting discarded like in the simulation
+	{
+		GameRecorder gameRecorder;
+		for (int frameNumber = 0; frameNumber < NUM_FRAMES; ++frameNumber)
+		{
+			if (states[frameNumber].empty())
+			{
+				gameRecorder.addFrame(&inputs[frameNumber][0]);
+			}
+			else
+			{
+				gameRecorder.addKeyFrame(&inputs[frameNumber][0], states[frameNumber]);
+				gameRecorder.discardOldFrames(MIN_KEEP_FRAMES);
+			}
+		}
+
+		const std::vector<uint8> header = { 0x01, 0x02, 0x03 };
+		std::vector<uint8> dump;
+		gameRecorder.saveRecordingData(dump, "23.09.01.0", header);
+
+		GameRecorder loadedRecorder;
+		std::string buildString;
+		std::vector<uint8> loadedHeader;
+		if (!loadedRecorder.loadRecordingData(dump, buildString, loadedHeader) || buildString != "23.09.01.0" || loadedHeader != header)
+		{
+			RMX_LOG_INFO("Failed to load saved game recording");
+			return false;
+		}
+		if (!checkPlayback(loadedRecorder, (int)gameRecorder.getRangeStart(), "GRC2 recording"))
+			return false;
+	}
+
+	// Recording in format GRC1, with only full keyframes
+	{
+		std::vector<uint8> dump;
+		VectorBinarySerializer serializer(false, dump);
+		serializer.write("GRC1", 4);
+		serializer.write("23.09.01.0", 10);
+		serializer.write((uint32)0);		// No game-specific header
+		serializer.write((uint32)NUM_FRAMES);
+
+		std::vector<uint8> compressed;
+		for (int frameNumber = 0; frameNumber < NUM_FRAMES; ++frameNumber)
+		{
+			const bool isKeyframe = !states[frameNumber].empty();
+			serializer.writeAs<uint8>(isKeyframe ? 1 : 0);		// Frame type, input only or keyframe
+			serializer.write(inputs[frameNumber][0]);
+			serializer.write(inputs[frameNumber][1]);
+			if (isKeyframe)
+			{
+				compressed.clear();
+				ZlibDeflate::encode(compressed, &states[frameNumber][0], states[frameNumber].size());
+				serializer.write((uint32)compressed.size());
+				serializer.write(&compressed[0], compressed.size());
+			}
+		}
+
+		GameRecorder loadedRecorder;
+		std::string buildString;
+		std::vector<uint8> loadedHeader;
+		if (!loadedRecorder.loadRecordingData(dump, buildString, loadedHeader))
+		{
+			RMX_LOG_INFO("Failed to load GRC1 game recording");
+			return false;
+		}
+		if (!checkPlayback(loadedRecorder, 0, "GRC1 recording"))
+			return false;
+	}
+	return true;
+}
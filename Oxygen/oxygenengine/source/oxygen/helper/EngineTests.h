@@ -0,0 +1,26 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#pragma once
+
+
+// Tests comparing optimized engine code against its reference implementation
+//  -> Run with the "-enginetests" command line argument, in any build configuration, as release builds are where the optimized code gets used
+//  -> Each test logs details on what differs
+class EngineTests
+{
+public:
+	// Run all tests and log their results; returns false if any test failed
+	static bool runAllTests();
+
+private:
+	static bool testSoftwareRendererKernels();
+	static bool testBlitterKernels();
+	static bool testYM2612BlockProcessing();
+	static bool testGameRecorder();
+};
@@ -97,13 +97,7 @@ bool FileHelper::loadPaletteBitmap(PaletteBitmap& bitmap, const std::wstring& fi
 		RMX_CHECK(!showError, "Failed to load image file '" << *WString(filename).toString() << "': File not found", );
 		return false;
 	}
-
-	if (!bitmap.loadBMP(content))
-	{
-		RMX_CHECK(!showError, "Failed to load image file '" << *WString(filename).toString() << "': Format not supported", );
-		return false;
-	}
-	return true;
+	return decodePaletteBitmap(bitmap, content, filename, showError);
 }
 
 bool FileHelper::loadBitmap(Bitmap& bitmap, const std::wstring& filename, bool showError)
@@ -114,7 +108,21 @@ bool FileHelper::loadBitmap(Bitmap& bitmap, const std::wstring& filename, bool s
 		RMX_CHECK(!showError, "Failed to load image file '" << *WString(filename).toString() << "': File not found", );
 		return false;
 	}
+	return decodeBitmap(bitmap, content, filename, showError);
+}
+
+bool FileHelper::decodePaletteBitmap(PaletteBitmap& bitmap, const std::vector<uint8>& content, const std::wstring& filename, bool showError)
+{
+	if (!bitmap.loadBMP(content))
+	{
+		RMX_CHECK(!showError, "Failed to load image file '" << *WString(filename).toString() << "': Format not supported", );
+		return false;
+	}
+	return true;
+}
 
+bool FileHelper::decodeBitmap(Bitmap& bitmap, const std::vector<uint8>& content, const std::wstring& filename, bool showError)
+{
 	// Get file type
 	String format;
 	WString fname = filename;
@@ -20,6 +20,8 @@ class FileHelper
 public:
 	static bool loadPaletteBitmap(PaletteBitmap& bitmap, const std::wstring& filename, bool showError = true);
 	static bool loadBitmap(Bitmap& bitmap, const std::wstring& filename, bool showError = true);
+	static bool decodePaletteBitmap(PaletteBitmap& bitmap, const std::vector<uint8>& content, const std::wstring& filename, bool showError = true);
+	static bool decodeBitmap(Bitmap& bitmap, const std::vector<uint8>& content, const std::wstring& filename, bool showError = true);
 	static bool loadTexture(DrawerTexture& texture, const std::wstring& filename, bool showError = true);
 
 #ifdef RMX_WITH_OPENGL_SUPPORT
@@ -8,6 +8,7 @@
 
 #include "oxygen/pch.h"
 #include "oxygen/rendering/software/SoftwareRenderer.h"
+#include "oxygen/rendering/software/SoftwareRendererKernels.h"
 #include "oxygen/rendering/Geometry.h"
 #include "oxygen/rendering/parts/RenderParts.h"
 #include "oxygen/application/Configuration.h"
@@ -23,7 +24,7 @@ namespace detail
 	public:
 		PixelBlockWriter(SoftwareRenderer::BufferedPlaneData& data, const PatternManager::CacheItem* patternCache) :
 			mBufferedPlaneData(&data),
-			mContent(&data.mContent[0]),
+			mContent(data.mContent.data()),
 			mPatternCache(patternCache)
 		{}
 
@@ -31,6 +32,7 @@ namespace detail
 		{
 			mLineNumber = lineNumber;
 			mPosition = position;
+			mContentPosition = position - mBufferedPlaneData->mContentOffset;
 			mPaletteIndex = paletteIndex;
 			mLastPatternBits = 0xffff;
 		}
@@ -38,7 +40,7 @@ namespace detail
 		FORCE_INLINE void addPixels(int x, uint16 patternIndex, int pixels)
 		{
 			const PatternManager::CacheItem::Pattern& pattern = mPatternCache[patternIndex & 0x07ff].mFlipVariation[(patternIndex >> 11) & 3];
-			uint8* dst = &mContent[mPosition + x];
+			uint8* dst = &mContent[mContentPosition + x];
 			const uint8* srcPatternPixels = &pattern.mPixels[mPatternPixelOffset];
 			memcpy(dst, srcPatternPixels, pixels);
 
@@ -64,7 +66,7 @@ namespace detail
 		{
 			// Same as above, but with hardcoded "pixels == 8"
 			const PatternManager::CacheItem::Pattern& pattern = mPatternCache[patternIndex & 0x07ff].mFlipVariation[(patternIndex >> 11) & 3];
-			uint64* dst = (uint64*)&mContent[mPosition + x];
+			uint64* dst = (uint64*)&mContent[mContentPosition + x];
 			const uint64* srcPatternPixels = (uint64*)&pattern.mPixels[mPatternPixelOffset];
 			*dst = *srcPatternPixels;
 
@@ -96,6 +98,7 @@ namespace detail
 
 		int mLineNumber = 0;
 		int mPosition = 0;
+		int mContentPosition = 0;
 		int mDepthPosition = 0;
 		int mPaletteIndex = 0;
 
@@ -110,10 +113,27 @@ SoftwareRenderer::SoftwareRenderer(RenderParts& renderParts, DrawerTexture& outp
 {
 }
 
+SoftwareRenderer::~SoftwareRenderer()
+{
+	stopWorkerThreads();
+}
+
 void SoftwareRenderer::initialize()
 {
 	mGameResolution = Configuration::instance().mGameScreen;
 	mGameScreenTexture.accessBitmap().create(mGameResolution.x, mGameResolution.y);
+
+	SoftwareRendererKernels::initialize();
+
+	// Setup render bands, one per thread
+	int numThreads = Configuration::instance().mSoftwareRenderingThreads;
+	if (numThreads <= 0)
+	{
+		// Automatic choice, note that this can return 0 if the number of cores is not known
+		numThreads = (int)std::thread::hardware_concurrency();
+	}
+	mNumRenderBands = clamp(numThreads, 1, MAX_RENDER_BANDS);
+	startWorkerThreads();
 }
 
 void SoftwareRenderer::reset()
@@ -142,49 +162,61 @@ void SoftwareRenderer::renderGameScreen(const std::vector<Geometry*>& geometries
 
 	// Clear depth buffer
 	memset(mDepthBuffer, 0, sizeof(mDepthBuffer));
-	mEmptyDepthBuffer = true;
 
 	if (mRenderParts.getEnforceClearScreen())
 	{
 		gameScreenBitmap.clear(0);
 	}
 
-	mCurrentViewport.set(0, 0, mGameResolution.x, mGameResolution.y);
-	mFullViewport = true;
-
-	for (int i = 0; i < MAX_BUFFER_PLANE_DATA; ++i)
-	{
-		mBufferedPlaneData[i].mValid = false;
-	}
+	setupRenderBands();
 
 	// Do some analysis on what's to render
-	bool usingSpriteMask = false;
+	mUsingSpriteMask = false;
 	{
 		for (const Geometry* geometry : geometries)
 		{
-			if (geometry->getType() == Geometry::Type::SPRITE && geometry->as<SpriteGeometry>().mSpriteInfo.getType() == SpriteManager::SpriteInfo::Type::MASK)
+			if (geometry->getType() == Geometry::Type::SPRITE)
 			{
-				usingSpriteMask = true;
-				break;
+				const SpriteManager::SpriteInfo& spriteInfo = geometry->as<SpriteGeometry>().mSpriteInfo;
+				if (spriteInfo.getType() == SpriteManager::SpriteInfo::Type::MASK)
+				{
+					mUsingSpriteMask = true;
+				}
+				else if (spriteInfo.getType() == SpriteManager::SpriteInfo::Type::PALETTE)
+				{
+					// Upscaled sprites get created lazily, which must not happen inside the render bands
+					const SpriteManager::PaletteSpriteInfo& paletteSpriteInfo = static_cast<const SpriteManager::PaletteSpriteInfo&>(spriteInfo);
+					if (paletteSpriteInfo.mUseUpscaledSprite)
+						static_cast<PaletteSprite*>(paletteSpriteInfo.mCacheItem->mSprite)->getUpscaledBitmap();
+				}
 			}
 		}
 	}
 
+	if (mUsingSpriteMask)
+	{
+		// Make sure the copy has the right size already, each render band only copies its own lines into it
+		mGameScreenCopy.create(gameScreenBitmap.getWidth(), gameScreenBitmap.getHeight());
+	}
+
 	// Render geometries
+	//  -> Blur effects read lines of neighboring render bands, so they are rendered in between on the main thread
 	{
-		uint16 lastRenderQueue = 0xffff;
+		size_t firstIndex = 0;
 		for (size_t i = 0; i < geometries.size(); ++i)
 		{
-			const uint16 renderQueue = geometries[i]->mRenderQueue;
-			if (usingSpriteMask && lastRenderQueue < 0x8000 && renderQueue >= 0x8000)
+			if (geometries[i]->getType() == Geometry::Type::EFFECT_BLUR)
 			{
-				// Copy planes (needed for sprite masking)
-				mGameScreenCopy = gameScreenBitmap;
+				renderGeometriesInBands(geometries, firstIndex, i);
+				for (int k = 0; k < mNumRenderBands; ++k)
+				{
+					updateRenderQueue(mRenderBands[k], geometries[i]->mRenderQueue);
+				}
+				renderBlurEffect(static_cast<const EffectBlurGeometry&>(*geometries[i]));
+				firstIndex = i + 1;
 			}
-
-			renderGeometry(*geometries[i]);
-			lastRenderQueue = renderQueue;
 		}
+		renderGeometriesInBands(geometries, firstIndex, geometries.size());
 	}
 
 	// Set alpha channel to 0xff to make sure nothing gets lost due to alpha test
@@ -220,9 +252,6 @@ void SoftwareRenderer::renderDebugDraw(int debugDrawMode, const Recti& rect)
 	mGameScreenTexture.setupAsRenderTarget(bitmapSize.x, bitmapSize.y);
 	gameScreenBitmap.create(bitmapSize.x, bitmapSize.y, 0);
 
-	mCurrentViewport.set(0, 0, bitmapSize.x, bitmapSize.y);
-	mFullViewport = true;
-
 	// Render to bitmap
 	{
 		const PlaneManager& planeManager = mRenderParts.getPlaneManager();
@@ -275,7 +304,146 @@ void SoftwareRenderer::renderDebugDraw(int debugDrawMode, const Recti& rect)
 	gameScreenBitmap.create(oldSize.x, oldSize.y);
 }
 
-void SoftwareRenderer::renderGeometry(const Geometry& geometry)
+void SoftwareRenderer::setupRenderBands()
+{
+	// Split into bands of equal height, rounded up to full patterns
+	const int linesPerBand = ((mGameResolution.y + mNumRenderBands - 1) / mNumRenderBands + 7) & ~7;
+	for (int k = 0; k < mNumRenderBands; ++k)
+	{
+		RenderBand& band = mRenderBands[k];
+		band.mMinY = std::min(k * linesPerBand, mGameResolution.y);
+		band.mMaxY = std::min((k + 1) * linesPerBand, mGameResolution.y);
+		band.mBandRect.set(0, band.mMinY, mGameResolution.x, band.mMaxY - band.mMinY);
+		band.mCurrentViewport = band.mBandRect;
+		band.mEmptyDepthBuffer = true;
+		band.mLastRenderQueue = 0xffff;
+
+		for (int i = 0; i < MAX_BUFFER_PLANE_DATA; ++i)
+		{
+			band.mBufferedPlaneData[i].mValid = false;
+		}
+	}
+}
+
+void SoftwareRenderer::startWorkerThreads()
+{
+	stopWorkerThreads();
+
+	mWorkerJobCounter = 0;
+	mWorkersRunning = 0;
+	for (int k = 1; k < mNumRenderBands; ++k)
+	{
+		mWorkerThreads.emplace_back(&SoftwareRenderer::workerThreadFunc, this, k);
+	}
+}
+
+void SoftwareRenderer::stopWorkerThreads()
+{
+	if (mWorkerThreads.empty())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(mWorkerMutex);
+		mStopWorkers = true;
+	}
+	mWorkerStartCondition.notify_all();
+
+	for (std::thread& thread : mWorkerThreads)
+	{
+		thread.join();
+	}
+	mWorkerThreads.clear();
+	mStopWorkers = false;
+}
+
+void SoftwareRenderer::workerThreadFunc(int bandIndex)
+{
+	uint32 lastJobCounter = 0;
+	while (true)
+	{
+		const std::vector<Geometry*>* geometries = nullptr;
+		size_t firstIndex = 0;
+		size_t endIndex = 0;
+		{
+			std::unique_lock<std::mutex> lock(mWorkerMutex);
+			mWorkerStartCondition.wait(lock, [&] { return mStopWorkers || mWorkerJobCounter != lastJobCounter; });
+			if (mStopWorkers)
+				return;
+
+			lastJobCounter = mWorkerJobCounter;
+			geometries = mJobGeometries;
+			firstIndex = mJobFirstIndex;
+			endIndex = mJobEndIndex;
+		}
+
+		renderGeometriesInBand(mRenderBands[bandIndex], *geometries, firstIndex, endIndex);
+
+		{
+			std::lock_guard<std::mutex> lock(mWorkerMutex);
+			--mWorkersRunning;
+			if (mWorkersRunning == 0)
+				mWorkerFinishedCondition.notify_one();
+		}
+	}
+}
+
+void SoftwareRenderer::renderGeometriesInBands(const std::vector<Geometry*>& geometries, size_t firstIndex, size_t endIndex)
+{
+	if (firstIndex >= endIndex)
+		return;
+
+	if (mWorkerThreads.empty())
+	{
+		renderGeometriesInBand(mRenderBands[0], geometries, firstIndex, endIndex);
+		return;
+	}
+
+	// Start the worker threads, and render the first band in the meantime
+	{
+		std::lock_guard<std::mutex> lock(mWorkerMutex);
+		mJobGeometries = &geometries;
+		mJobFirstIndex = firstIndex;
+		mJobEndIndex = endIndex;
+		mWorkersRunning = (int)mWorkerThreads.size();
+		++mWorkerJobCounter;
+	}
+	mWorkerStartCondition.notify_all();
+
+	renderGeometriesInBand(mRenderBands[0], geometries, firstIndex, endIndex);
+
+	// Wait for all other bands to be finished as well
+	{
+		std::unique_lock<std::mutex> lock(mWorkerMutex);
+		mWorkerFinishedCondition.wait(lock, [&] { return mWorkersRunning == 0; });
+	}
+}
+
+void SoftwareRenderer::renderGeometriesInBand(RenderBand& band, const std::vector<Geometry*>& geometries, size_t firstIndex, size_t endIndex)
+{
+	if (band.mMinY >= band.mMaxY)
+		return;
+
+	for (size_t i = firstIndex; i < endIndex; ++i)
+	{
+		updateRenderQueue(band, geometries[i]->mRenderQueue);
+		renderGeometry(band, *geometries[i]);
+	}
+}
+
+void SoftwareRenderer::updateRenderQueue(RenderBand& band, uint16 renderQueue)
+{
+	if (mUsingSpriteMask && band.mLastRenderQueue < 0x8000 && renderQueue >= 0x8000)
+	{
+		// Copy planes (needed for sprite masking), but only the lines of this band
+		const Bitmap& gameScreenBitmap = mGameScreenTexture.accessBitmap();
+		const int offset = band.mMinY * gameScreenBitmap.getWidth();
+		const int pixels = (band.mMaxY - band.mMinY) * gameScreenBitmap.getWidth();
+		memcpy(&mGameScreenCopy.getData()[offset], &gameScreenBitmap.getData()[offset], pixels * sizeof(uint32));
+	}
+	band.mLastRenderQueue = renderQueue;
+}
+
+void SoftwareRenderer::renderGeometry(RenderBand& band, const Geometry& geometry)
 {
 	switch (geometry.getType())
 	{
@@ -284,87 +452,84 @@ void SoftwareRenderer::renderGeometry(const Geometry& geometry)
 
 		case Geometry::Type::PLANE:
 		{
-			renderPlane(static_cast<const PlaneGeometry&>(geometry));
+			renderPlane(band, static_cast<const PlaneGeometry&>(geometry));
 			break;
 		}
 
 		case Geometry::Type::SPRITE:
 		{
-			renderSprite(static_cast<const SpriteGeometry&>(geometry));
+			renderSprite(band, static_cast<const SpriteGeometry&>(geometry));
 			break;
 		}
 
 		case Geometry::Type::RECT:
 		{
 			const RectGeometry& rg = static_cast<const RectGeometry&>(geometry);
-			mBlitter.blitColor(Blitter::OutputWrapper(mGameScreenTexture.accessBitmap(), rg.mRect), rg.mColor, BlendMode::ALPHA);
+			band.mBlitter.blitColor(Blitter::OutputWrapper(mGameScreenTexture.accessBitmap(), Recti::getIntersection(rg.mRect, band.mBandRect)), rg.mColor, BlendMode::ALPHA);
 			break;
 		}
 
 		case Geometry::Type::TEXTURED_RECT:
 		{
 			const TexturedRectGeometry& tg = static_cast<const TexturedRectGeometry&>(geometry);
-			Bitmap& gameScreenBitmap = mGameScreenTexture.accessBitmap();
 
 			Blitter::Options blitterOptions;
 			blitterOptions.mBlendMode = BlendMode::ALPHA;
 			blitterOptions.mTintColor = &tg.mColor;
 
-			mBlitter.blitSprite(Blitter::OutputWrapper(mGameScreenTexture.accessBitmap()), Blitter::SpriteWrapper(tg.mDrawerTexture.accessBitmap(), Vec2i()), tg.mRect.getPos(), blitterOptions);
+			band.mBlitter.blitSprite(Blitter::OutputWrapper(mGameScreenTexture.accessBitmap(), band.mBandRect), Blitter::SpriteWrapper(tg.mDrawerTexture.accessBitmap(), Vec2i()), tg.mRect.getPos(), blitterOptions);
 			break;
 		}
 
 		case Geometry::Type::EFFECT_BLUR:
+			break;	// Gets handled outside of the render bands, see "renderBlurEffect"
+
+		case Geometry::Type::VIEWPORT:
 		{
-			const EffectBlurGeometry& ebg = static_cast<const EffectBlurGeometry&>(geometry);
-			Bitmap& gameScreenBitmap = mGameScreenTexture.accessBitmap();
+			const ViewportGeometry& vg = static_cast<const ViewportGeometry&>(geometry);
+			band.mCurrentViewport = Recti::getIntersection(band.mBandRect, vg.mRect);
+			break;
+		}
+	}
+}
 
-			// Blur x-direction
-			if (ebg.mBlurValue >= 1)
-			{
-				for (int y = 0; y < gameScreenBitmap.getHeight(); ++y)
-				{
-					uint32* data = gameScreenBitmap.getPixelPointer(0, y);
-					for (int x = gameScreenBitmap.getWidth() - 1; x >= 1; --x)
-					{
-						data[x] = (data[x] & 0xff000000) + (((data[x] & 0xfefefe) + (data[x-1] & 0xfefefe)) >> 1);
-					}
-				}
-			}
+void SoftwareRenderer::renderBlurEffect(const EffectBlurGeometry& geometry)
+{
+	Bitmap& gameScreenBitmap = mGameScreenTexture.accessBitmap();
 
-			// Blur y-direction
-			if (ebg.mBlurValue >= 3)
+	// Blur x-direction
+	if (geometry.mBlurValue >= 1)
+	{
+		for (int y = 0; y < gameScreenBitmap.getHeight(); ++y)
+		{
+			uint32* data = gameScreenBitmap.getPixelPointer(0, y);
+			for (int x = gameScreenBitmap.getWidth() - 1; x >= 1; --x)
 			{
-				const int stride = gameScreenBitmap.getWidth();
-				for (int y = 0; y < gameScreenBitmap.getHeight()-1; ++y)
-				{
-					uint32* data = gameScreenBitmap.getPixelPointer(0, y);
-					for (int x = 0; x < gameScreenBitmap.getWidth(); ++x)
-					{
-						data[x] = (data[x] & 0xff000000) + (((data[x] & 0xfefefe) + (data[x+stride] & 0xfefefe)) >> 1);
-					}
-				}
+				data[x] = (data[x] & 0xff000000) + (((data[x] & 0xfefefe) + (data[x-1] & 0xfefefe)) >> 1);
 			}
-			break;
 		}
+	}
 
-		case Geometry::Type::VIEWPORT:
+	// Blur y-direction
+	if (geometry.mBlurValue >= 3)
+	{
+		const int stride = gameScreenBitmap.getWidth();
+		for (int y = 0; y < gameScreenBitmap.getHeight()-1; ++y)
 		{
-			const ViewportGeometry& vg = static_cast<const ViewportGeometry&>(geometry);
-			const Recti fullViewport(0, 0, mGameResolution.x, mGameResolution.y);
-			mCurrentViewport = fullViewport;
-			mCurrentViewport.intersect(vg.mRect);
-			mFullViewport = (mCurrentViewport == fullViewport);
-			break;
+			uint32* data = gameScreenBitmap.getPixelPointer(0, y);
+			for (int x = 0; x < gameScreenBitmap.getWidth(); ++x)
+			{
+				data[x] = (data[x] & 0xff000000) + (((data[x] & 0xfefefe) + (data[x+stride] & 0xfefefe)) >> 1);
+			}
 		}
 	}
 }
 
-void SoftwareRenderer::renderPlane(const PlaneGeometry& geometry)
+void SoftwareRenderer::renderPlane(RenderBand& band, const PlaneGeometry& geometry)
 {
 	Bitmap& gameScreenBitmap = mGameScreenTexture.accessBitmap();
 
-	Recti rect(0, 0, mGameResolution.x, mGameResolution.y);
+	Recti rect = band.mBandRect;
 	rect.intersect(geometry.mActiveRect);
 	const int minX = rect.x;
 	const int maxX = rect.x + rect.width;
@@ -379,7 +544,7 @@ void SoftwareRenderer::renderPlane(const PlaneGeometry& geometry)
 	int foundFittingBufferedPlaneDataIndex = -1;
 	for (int i = 0; i < MAX_BUFFER_PLANE_DATA; ++i)
 	{
-		const BufferedPlaneData& bufferedPlaneData = mBufferedPlaneData[i];
+		const BufferedPlaneData& bufferedPlaneData = band.mBufferedPlaneData[i];
 		if (bufferedPlaneData.mValid &&
 			bufferedPlaneData.mPlaneIndex == geometry.mPlaneIndex &&
 			bufferedPlaneData.mScrollOffsets == geometry.mScrollOffsets &&
@@ -395,7 +560,7 @@ void SoftwareRenderer::renderPlane(const PlaneGeometry& geometry)
 		// Find a free index
 		for (int i = 0; i < MAX_BUFFER_PLANE_DATA; ++i)
 		{
-			if (!mBufferedPlaneData[i].mValid)
+			if (!band.mBufferedPlaneData[i].mValid)
 			{
 				foundFittingBufferedPlaneDataIndex = i;
 				break;
@@ -403,11 +568,12 @@ void SoftwareRenderer::renderPlane(const PlaneGeometry& geometry)
 		}
 		RMX_CHECK(foundFittingBufferedPlaneDataIndex != -1, "No free buffered plane data structure found", return);
 
-		BufferedPlaneData& bufferedPlaneData = mBufferedPlaneData[foundFittingBufferedPlaneDataIndex];
+		BufferedPlaneData& bufferedPlaneData = band.mBufferedPlaneData[foundFittingBufferedPlaneDataIndex];
 		bufferedPlaneData.mPlaneIndex = geometry.mPlaneIndex;
 		bufferedPlaneData.mScrollOffsets = geometry.mScrollOffsets;
 		bufferedPlaneData.mActiveRect = geometry.mActiveRect;
-		bufferedPlaneData.mContent.resize(gameScreenBitmap.getPixelCount());
+		bufferedPlaneData.mContent.resize((band.mMaxY - band.mMinY) * gameScreenBitmap.getWidth());
+		bufferedPlaneData.mContentOffset = band.mMinY * gameScreenBitmap.getWidth();
 		bufferedPlaneData.mPrioBlocks.clear();
 		bufferedPlaneData.mPrioBlocks.reserve(0x800);
 		bufferedPlaneData.mNonPrioBlocks.clear();
@@ -418,12 +584,12 @@ void SoftwareRenderer::renderPlane(const PlaneGeometry& geometry)
 		const uint16* scrollOffsetsH = nullptr;
 		const uint16* scrollOffsetsV = nullptr;
 		uint16 scrollMaskH = 0xff;
+		uint16 wScrollOffsetX = 0;
 		uint16 scrollMaskV = 0;
 		bool scrollNoRepeat = false;
 
 		if (geometry.mPlaneIndex == PlaneManager::PLANE_W)
 		{
-			static uint16 wScrollOffsetX;
 			wScrollOffsetX = (uint16)scrollOffsetsManager.getPlaneWScrollOffset().x;
 			scrollOffsetsH = &wScrollOffsetX;
 			scrollMaskH = 0;
@@ -552,55 +718,40 @@ void SoftwareRenderer::renderPlane(const PlaneGeometry& geometry)
 
 	// Write plane data to output
 	{
-		BufferedPlaneData& bufferedPlaneData = mBufferedPlaneData[foundFittingBufferedPlaneDataIndex];
+		BufferedPlaneData& bufferedPlaneData = band.mBufferedPlaneData[foundFittingBufferedPlaneDataIndex];
 
 		const uint32* palettes[2] = { paletteManager.getPalette(0).getData(), paletteManager.getPalette(1).getData() };
 		const bool isBackground = (geometry.mPlaneIndex == PlaneManager::PLANE_B && !geometry.mPriorityFlag);
+		const SoftwareRendererKernels::Functions& kernels = SoftwareRendererKernels::getFunctions();
 
 		const std::vector<BufferedPlaneData::PixelBlock>& blocks = geometry.mPriorityFlag ? bufferedPlaneData.mPrioBlocks : bufferedPlaneData.mNonPrioBlocks;
 		for (const BufferedPlaneData::PixelBlock& block : blocks)
 		{
-			const uint8* RESTRICT src = &bufferedPlaneData.mContent[block.mLinearPosition];
+			const uint8* RESTRICT src = &bufferedPlaneData.mContent[block.mLinearPosition - bufferedPlaneData.mContentOffset];
 			uint32* RESTRICT dstRGBA = &gameScreenBitmap.getData()[block.mLinearPosition];
 			const uint32* RESTRICT paletteWithAtex = &palettes[block.mPaletteIndex][block.mAtex];
 
 			if (isBackground)
 			{
-				for (int i = 0; i < block.mNumPixels; ++i)
-				{
-					dstRGBA[i] = paletteWithAtex[src[i]];
-				}
+				kernels.mWritePixelsOpaque(dstRGBA, src, paletteWithAtex, block.mNumPixels);
 			}
 			else if (geometry.mPriorityFlag)
 			{
 				uint8* RESTRICT dstDepth = &mDepthBuffer[block.mStartCoords.x + block.mStartCoords.y * 0x200];
-				for (int i = 0; i < block.mNumPixels; ++i)
-				{
-					if (src[i] & 0x0f)
-					{
-						dstRGBA[i] = paletteWithAtex[src[i]];
-						dstDepth[i] = 0x80;
-					}
-				}
+				kernels.mWritePixelsWithDepth(dstRGBA, dstDepth, src, paletteWithAtex, block.mNumPixels);
 			}
 			else
 			{
-				for (int i = 0; i < block.mNumPixels; ++i)
-				{
-					if (src[i] & 0x0f)
-					{
-						dstRGBA[i] = paletteWithAtex[src[i]];
-					}
-				}
+				kernels.mWritePixels(dstRGBA, src, paletteWithAtex, block.mNumPixels);
 			}
 		}
 
 		if (!blocks.empty() && geometry.mPriorityFlag)
-			mEmptyDepthBuffer = false;
+			band.mEmptyDepthBuffer = false;
 	}
 }
 
-void SoftwareRenderer::renderSprite(const SpriteGeometry& geometry)
+void SoftwareRenderer::renderSprite(RenderBand& band, const SpriteGeometry& geometry)
 {
 	Bitmap& gameScreenBitmap = mGameScreenTexture.accessBitmap();
 
@@ -616,9 +767,10 @@ void SoftwareRenderer::renderSprite(const SpriteGeometry& geometry)
 
 			const uint8 depthValue = (sprite.mPriorityFlag) ? 0x80 : 0;
 			const bool useTintColor = (sprite.mTintColor != Color::WHITE || sprite.mAddedColor != Color::TRANSPARENT);
+			const SoftwareRendererKernels::Functions& kernels = SoftwareRendererKernels::getFunctions();
 
 			Recti rect(sprite.mInterpolatedPosition.x, sprite.mInterpolatedPosition.y, sprite.mSize.x * 8, sprite.mSize.y * 8);
-			rect.intersect(mCurrentViewport);
+			rect.intersect(band.mCurrentViewport);
 
 			const int minX = rect.x;
 			const int maxX = rect.x + rect.width;
@@ -628,52 +780,60 @@ void SoftwareRenderer::renderSprite(const SpriteGeometry& geometry)
 			for (int y = minY; y < maxY; ++y)
 			{
 				const uint32* palette = (y < paletteManager.mSplitPositionY) ? palettes[0] : palettes[1];
+				const int vy = y - sprite.mInterpolatedPosition.y;
+				int patternY = vy / 8;
+				if (sprite.mFirstPattern & 0x1000)
+					patternY = sprite.mSize.y - patternY - 1;
 
-				for (int x = minX; x < maxX; ++x)
+				// Go through the pattern rows in this line, each up to 8 pixels
+				for (int x = minX; x < maxX; )
 				{
-					// Depth test
-					if (depthValue < mDepthBuffer[x + y * 0x200])
-						continue;
-
-					int vx = x - sprite.mInterpolatedPosition.x;
-					int vy = y - sprite.mInterpolatedPosition.y;
+					const int vx = x - sprite.mInterpolatedPosition.x;
+					const int pixels = std::min(8 - (vx % 8), maxX - x);
 
 					int patternX = vx / 8;
-					int patternY = vy / 8;
 					if (sprite.mFirstPattern & 0x0800)
 						patternX = sprite.mSize.x - patternX - 1;
-					if (sprite.mFirstPattern & 0x1000)
-						patternY = sprite.mSize.y - patternY - 1;
 
 					const uint16 patternIndex = sprite.mFirstPattern + patternY + patternX * sprite.mSize.y;
 					const PatternManager::CacheItem::Pattern& pattern = patternCache[patternIndex & 0x07ff].mFlipVariation[(patternIndex >> 11) & 3];
+					const uint8* srcPatternPixels = &pattern.mPixels[(vx % 8) + (vy % 8) * 8];
+					const uint32* paletteWithAtex = &palette[(patternIndex >> 9) & 0x30];
+					uint32* dstRGBA = gameScreenBitmap.getPixelPointer(x, y);
+					const uint8* depth = &mDepthBuffer[x + y * 0x200];
 
-					uint8 colorIndex = pattern.mPixels[(vx%8) + (vy%8) * 8];
-					colorIndex += (patternIndex >> 9) & 0x30;
-					if (colorIndex & 0x0f)
+					if (useTintColor)
 					{
-						uint32& dst = *gameScreenBitmap.getPixelPointer(x, y);
-						if (useTintColor)
+						for (int k = 0; k < pixels; ++k)
 						{
-							Color color = Color::fromABGR32(palette[colorIndex]);
-							color.r = saturate(sprite.mAddedColor.r + color.r * sprite.mTintColor.r);
-							color.g = saturate(sprite.mAddedColor.g + color.g * sprite.mTintColor.g);
-							color.b = saturate(sprite.mAddedColor.b + color.b * sprite.mTintColor.b);
-							color.a = saturate(sprite.mAddedColor.a + color.a * sprite.mTintColor.a);
+							// Depth test
+							if (depthValue < depth[k])
+								continue;
 
-							if (color.a < 1.0f)
+							const uint8 colorIndex = srcPatternPixels[k];
+							if (colorIndex & 0x0f)
 							{
-								color = color.blendOver(Color::fromABGR32(dst));
-								color.a = 1.0f;
+								Color color = Color::fromABGR32(paletteWithAtex[colorIndex]);
+								color.r = saturate(sprite.mAddedColor.r + color.r * sprite.mTintColor.r);
+								color.g = saturate(sprite.mAddedColor.g + color.g * sprite.mTintColor.g);
+								color.b = saturate(sprite.mAddedColor.b + color.b * sprite.mTintColor.b);
+								color.a = saturate(sprite.mAddedColor.a + color.a * sprite.mTintColor.a);
+
+								if (color.a < 1.0f)
+								{
+									color = color.blendOver(Color::fromABGR32(dstRGBA[k]));
+									color.a = 1.0f;
+								}
+
+								dstRGBA[k] = color.getABGR32();
 							}
-
-							dst = color.getABGR32();
-						}
-						else
-						{
-							dst = palette[colorIndex];
 						}
 					}
+					else
+					{
+						kernels.mWritePixelsDepthTested(dstRGBA, depth, depthValue, srcPatternPixels, paletteWithAtex, pixels);
+					}
+					x += pixels;
 				}
 			}
 			break;
@@ -710,7 +870,7 @@ void SoftwareRenderer::renderSprite(const SpriteGeometry& geometry)
 				blitterOptions.mBlendMode = spriteBase.mBlendMode;
 				blitterOptions.mTintColor = (tintColor != Color::WHITE) ? &tintColor : nullptr;
 				blitterOptions.mAddedColor = (addedColor != Color::TRANSPARENT) ? &addedColor : nullptr;
-				blitterOptions.mDepthBuffer = (mEmptyDepthBuffer && !spriteBase.mPriorityFlag) ? nullptr : &depthBufferView;
+				blitterOptions.mDepthBuffer = (band.mEmptyDepthBuffer && !spriteBase.mPriorityFlag) ? nullptr : &depthBufferView;
 				blitterOptions.mDepthTestValue = (spriteBase.mPriorityFlag) ? 0x80 : 0;
 			}
 
@@ -726,19 +886,22 @@ void SoftwareRenderer::renderSprite(const SpriteGeometry& geometry)
 
 				// Handle screen palette split
 				const int splitY = paletteManager.mSplitPositionY;
-				if (splitY < mGameResolution.y)
+				if (splitY < band.mMaxY)
 				{
 					const Blitter::PaletteWrapper paletteWrapper2(paletteManager.getPalette(1).getData() + spriteInfo.mAtex, paletteManager.getPalette(1).getSize() - spriteInfo.mAtex);
 
-					Recti targetRect = Recti::getIntersection(mCurrentViewport, Recti(0, 0, mGameResolution.x, splitY));
-					mBlitter.blitIndexed(Blitter::OutputWrapper(gameScreenBitmap, targetRect), spriteWrapper, paletteWrapper, spriteInfo.mInterpolatedPosition, blitterOptions);
+					if (splitY > band.mMinY)
+					{
+						const Recti targetRect = Recti::getIntersection(band.mCurrentViewport, Recti(0, 0, mGameResolution.x, splitY));
+						band.mBlitter.blitIndexed(Blitter::OutputWrapper(gameScreenBitmap, targetRect), spriteWrapper, paletteWrapper, spriteInfo.mInterpolatedPosition, blitterOptions);
+					}
 
-					targetRect = Recti::getIntersection(mCurrentViewport, Recti(0, splitY, mGameResolution.x, mGameResolution.y - splitY));
-					mBlitter.blitIndexed(Blitter::OutputWrapper(gameScreenBitmap, targetRect), spriteWrapper, paletteWrapper2, spriteInfo.mInterpolatedPosition, blitterOptions);
+					const Recti targetRect = Recti::getIntersection(band.mCurrentViewport, Recti(0, splitY, mGameResolution.x, mGameResolution.y - splitY));
+					band.mBlitter.blitIndexed(Blitter::OutputWrapper(gameScreenBitmap, targetRect), spriteWrapper, paletteWrapper2, spriteInfo.mInterpolatedPosition, blitterOptions);
 				}
 				else
 				{
-					mBlitter.blitIndexed(Blitter::OutputWrapper(gameScreenBitmap, mCurrentViewport), spriteWrapper, paletteWrapper, spriteInfo.mInterpolatedPosition, blitterOptions);
+					band.mBlitter.blitIndexed(Blitter::OutputWrapper(gameScreenBitmap, band.mCurrentViewport), spriteWrapper, paletteWrapper, spriteInfo.mInterpolatedPosition, blitterOptions);
 				}
 			}
 			else
@@ -749,11 +912,11 @@ void SoftwareRenderer::renderSprite(const SpriteGeometry& geometry)
 				const ComponentSprite& componentSprite = *static_cast<ComponentSprite*>(spriteInfo.mCacheItem->mSprite);
 				const Blitter::SpriteWrapper spriteWrapper(componentSprite.getBitmap(), -componentSprite.mOffset);
 
-				mBlitter.blitSprite(Blitter::OutputWrapper(gameScreenBitmap, mCurrentViewport), spriteWrapper, spriteInfo.mInterpolatedPosition, blitterOptions);
+				band.mBlitter.blitSprite(Blitter::OutputWrapper(gameScreenBitmap, band.mCurrentViewport), spriteWrapper, spriteInfo.mInterpolatedPosition, blitterOptions);
 			}
 
 			if (spriteBase.mPriorityFlag)
-				mEmptyDepthBuffer = false;
+				band.mEmptyDepthBuffer = false;
 			break;
 		}
 
@@ -768,8 +931,8 @@ void SoftwareRenderer::renderSprite(const SpriteGeometry& geometry)
 				const int bytes = (maxX - minX) * 4;
 				if (bytes > 0)
 				{
-					const int minY = clamp(mask.mInterpolatedPosition.y, 0, gameScreenBitmap.getHeight());
-					const int maxY = clamp(mask.mInterpolatedPosition.y + mask.mSize.y, 0, gameScreenBitmap.getHeight());
+					const int minY = clamp(mask.mInterpolatedPosition.y, band.mMinY, band.mMaxY);
+					const int maxY = clamp(mask.mInterpolatedPosition.y + mask.mSize.y, band.mMinY, band.mMaxY);
 
 					for (int line = minY; line < maxY; ++line)
 					{
@@ -11,7 +11,12 @@
 #include "oxygen/rendering/Renderer.h"
 #include "oxygen/drawing/software/Blitter.h"
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 class PlaneGeometry;
+class EffectBlurGeometry;
 class SpriteGeometry;
 namespace detail
 {
@@ -28,6 +33,7 @@ public:
 
 public:
 	SoftwareRenderer(RenderParts& renderParts, DrawerTexture& outputTexture);
+	~SoftwareRenderer();
 
 	virtual void initialize() override;
 	virtual void reset() override;
@@ -37,19 +43,27 @@ public:
 	virtual void renderDebugDraw(int debugDrawMode, const Recti& rect) override;
 
 private:
-	void renderGeometry(const Geometry& geometry);
-	void renderPlane(const PlaneGeometry& geometry);
-	void renderSprite(const SpriteGeometry& geometry);
+	struct RenderBand;
+
+	void setupRenderBands();
+	void startWorkerThreads();
+	void stopWorkerThreads();
+	void workerThreadFunc(int bandIndex);
+
+	void renderGeometriesInBands(const std::vector<Geometry*>& geometries, size_t firstIndex, size_t endIndex);
+	void renderGeometriesInBand(RenderBand& band, const std::vector<Geometry*>& geometries, size_t firstIndex, size_t endIndex);
+	void updateRenderQueue(RenderBand& band, uint16 renderQueue);
+	void renderGeometry(RenderBand& band, const Geometry& geometry);
+	void renderPlane(RenderBand& band, const PlaneGeometry& geometry);
+	void renderSprite(RenderBand& band, const SpriteGeometry& geometry);
+	void renderBlurEffect(const EffectBlurGeometry& geometry);
 
 private:
 	Vec2i mGameResolution;
 	Bitmap mGameScreenCopy;
+	bool mUsingSpriteMask = false;
 
 	uint8 mDepthBuffer[0x20000] = { 0 };	// 512x256 pixels
-	bool mEmptyDepthBuffer = true;			// Stays true until first non-zero depth value was written
-
-	Recti mCurrentViewport;
-	bool mFullViewport = true;
 
 	struct BufferedPlaneData
 	{
@@ -67,12 +81,39 @@ private:
 		int mScrollOffsets = 0;
 		Recti mActiveRect;
 
-		std::vector<uint8> mContent;
+		std::vector<uint8> mContent;	// Only covers the lines of the render band, starting at linear position "mContentOffset"
+		int mContentOffset = 0;
 		std::vector<PixelBlock> mPrioBlocks;
 		std::vector<PixelBlock> mNonPrioBlocks;
 	};
 	static const constexpr int MAX_BUFFER_PLANE_DATA = 8;
-	BufferedPlaneData mBufferedPlaneData[MAX_BUFFER_PLANE_DATA];
 
-	Blitter mBlitter;
+	// The game screen is split into horizontal bands of lines that get rendered in parallel
+	//  -> Each band only ever writes its own lines of the game screen and depth buffer, so they don't need any synchronization
+	struct RenderBand
+	{
+		int mMinY = 0;
+		int mMaxY = 0;
+		Recti mBandRect;
+		Recti mCurrentViewport;
+		bool mEmptyDepthBuffer = true;		// Stays true until first non-zero depth value was written
+		uint16 mLastRenderQueue = 0xffff;
+		BufferedPlaneData mBufferedPlaneData[MAX_BUFFER_PLANE_DATA];
+		Blitter mBlitter;
+	};
+	static const constexpr int MAX_RENDER_BANDS = 8;
+	RenderBand mRenderBands[MAX_RENDER_BANDS];
+	int mNumRenderBands = 1;
+
+	// Worker threads, one for each render band except the first, which gets rendered by the main thread itself
+	std::vector<std::thread> mWorkerThreads;
+	std::mutex mWorkerMutex;
+	std::condition_variable mWorkerStartCondition;
+	std::condition_variable mWorkerFinishedCondition;
+	uint32 mWorkerJobCounter = 0;
+	int mWorkersRunning = 0;
+	bool mStopWorkers = false;
+	const std::vector<Geometry*>* mJobGeometries = nullptr;
+	size_t mJobFirstIndex = 0;
+	size_t mJobEndIndex = 0;
 };
@@ -0,0 +1,389 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#include "oxygen/pch.h"
+#include "oxygen/rendering/software/SoftwareRendererKernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__)) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define KERNELS_X86
+	#include <immintrin.h>
+	#if defined(_MSC_VER) && !defined(__clang__)
+		#define TARGET_AVX2
+	#else
+		#define TARGET_AVX2 __attribute__((target("avx2")))
+	#endif
+#elif defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+	#define KERNELS_NEON
+	#include <arm_neon.h>
+#endif
+
+
+namespace
+{
+
+	// Scalar reference implementation
+
+	void writePixelsOpaque_Scalar(uint32* dstRGBA, const uint8* src, const uint32* palette, int numPixels)
+	{
+		for (int i = 0; i < numPixels; ++i)
+		{
+			dstRGBA[i] = palette[src[i]];
+		}
+	}
+
+	void writePixels_Scalar(uint32* dstRGBA, const uint8* src, const uint32* palette, int numPixels)
+	{
+		for (int i = 0; i < numPixels; ++i)
+		{
+			if (src[i] & 0x0f)
+			{
+				dstRGBA[i] = palette[src[i]];
+			}
+		}
+	}
+
+	void writePixelsWithDepth_Scalar(uint32* dstRGBA, uint8* dstDepth, const uint8* src, const uint32* palette, int numPixels)
+	{
+		for (int i = 0; i < numPixels; ++i)
+		{
+			if (src[i] & 0x0f)
+			{
+				dstRGBA[i] = palette[src[i]];
+				dstDepth[i] = 0x80;
+			}
+		}
+	}
+
+	void writePixelsDepthTested_Scalar(uint32* dstRGBA, const uint8* depth, uint8 depthValue, const uint8* src, const uint32* palette, int numPixels)
+	{
+		for (int i = 0; i < numPixels; ++i)
+		{
+			if ((src[i] & 0x0f) && depthValue >= depth[i])
+			{
+				dstRGBA[i] = palette[src[i]];
+			}
+		}
+	}
+
+
+#if defined(KERNELS_X86)
+
+	// SSE2 implementation
+	//  -> There's no gather instruction, so palette lookup is done per pixel, but transparency and depth are handled for 4 or 8 pixels at once
+
+	FORCE_INLINE __m128i loadIndices4_SSE2(const uint8* src)
+	{
+		int32 value;
+		memcpy(&value, src, 4);
+		const __m128i zero = _mm_setzero_si128();
+		return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(value), zero), zero);
+	}
+
+	FORCE_INLINE __m128i lookupPalette4_SSE2(const uint8* src, const uint32* palette)
+	{
+		return _mm_set_epi32((int)palette[src[3]], (int)palette[src[2]], (int)palette[src[1]], (int)palette[src[0]]);
+	}
+
+	FORCE_INLINE void blendStore4_SSE2(uint32* dstRGBA, __m128i colors, __m128i keepMask)
+	{
+		const __m128i oldColors = _mm_loadu_si128((const __m128i*)dstRGBA);
+		_mm_storeu_si128((__m128i*)dstRGBA, _mm_or_si128(_mm_and_si128(keepMask, oldColors), _mm_andnot_si128(keepMask, colors)));
+	}
+
+	void writePixels_SSE2(uint32* dstRGBA, const uint8* src, const uint32* palette, int numPixels)
+	{
+		const __m128i lowNibbleMask = _mm_set1_epi32(0x0f);
+		const __m128i zero = _mm_setzero_si128();
+		int i = 0;
+		for (; i + 4 <= numPixels; i += 4)
+		{
+			const __m128i isTransparent = _mm_cmpeq_epi32(_mm_and_si128(loadIndices4_SSE2(&src[i]), lowNibbleMask), zero);
+			if (_mm_movemask_epi8(isTransparent) == 0xffff)
+				continue;
+			blendStore4_SSE2(&dstRGBA[i], lookupPalette4_SSE2(&src[i], palette), isTransparent);
+		}
+		writePixels_Scalar(&dstRGBA[i], &src[i], palette, numPixels - i);
+	}
+
+	void writePixelsWithDepth_SSE2(uint32* dstRGBA, uint8* dstDepth, const uint8* src, const uint32* palette, int numPixels)
+	{
+		const __m128i lowNibbleMask8 = _mm_set1_epi8(0x0f);
+		const __m128i depthValue8 = _mm_set1_epi8((char)0x80);
+		const __m128i zero = _mm_setzero_si128();
+		int i = 0;
+		for (; i + 8 <= numPixels; i += 8)
+		{
+			// Handle 8 pixels' depth at once
+			const __m128i indices8 = _mm_loadl_epi64((const __m128i*)&src[i]);
+			const __m128i isTransparent8 = _mm_cmpeq_epi8(_mm_and_si128(indices8, lowNibbleMask8), zero);
+			if ((_mm_movemask_epi8(isTransparent8) & 0xff) == 0xff)
+				continue;
+
+			const __m128i oldDepth = _mm_loadl_epi64((const __m128i*)&dstDepth[i]);
+			_mm_storel_epi64((__m128i*)&dstDepth[i], _mm_or_si128(_mm_and_si128(isTransparent8, oldDepth), _mm_andnot_si128(isTransparent8, depthValue8)));
+
+			// Colors in two halves of 4 pixels each
+			const __m128i isTransparent16 = _mm_unpacklo_epi8(isTransparent8, isTransparent8);
+			blendStore4_SSE2(&dstRGBA[i], lookupPalette4_SSE2(&src[i], palette), _mm_unpacklo_epi16(isTransparent16, isTransparent16));
+			blendStore4_SSE2(&dstRGBA[i+4], lookupPalette4_SSE2(&src[i+4], palette), _mm_unpackhi_epi16(isTransparent16, isTransparent16));
+		}
+		writePixelsWithDepth_Scalar(&dstRGBA[i], &dstDepth[i], &src[i], palette, numPixels - i);
+	}
+
+	void writePixelsDepthTested_SSE2(uint32* dstRGBA, const uint8* depth, uint8 depthValue, const uint8* src, const uint32* palette, int numPixels)
+	{
+		const __m128i lowNibbleMask = _mm_set1_epi32(0x0f);
+		const __m128i depthValue32 = _mm_set1_epi32(depthValue);
+		const __m128i zero = _mm_setzero_si128();
+		int i = 0;
+		for (; i + 4 <= numPixels; i += 4)
+		{
+			const __m128i isTransparent = _mm_cmpeq_epi32(_mm_and_si128(loadIndices4_SSE2(&src[i]), lowNibbleMask), zero);
+			const __m128i isOccluded = _mm_cmpgt_epi32(loadIndices4_SSE2(&depth[i]), depthValue32);
+			const __m128i keepMask = _mm_or_si128(isTransparent, isOccluded);
+			if (_mm_movemask_epi8(keepMask) == 0xffff)
+				continue;
+			blendStore4_SSE2(&dstRGBA[i], lookupPalette4_SSE2(&src[i], palette), keepMask);
+		}
+		writePixelsDepthTested_Scalar(&dstRGBA[i], &depth[i], depthValue, &src[i], palette, numPixels - i);
+	}
+
+
+	// AVX2 implementation
+	//  -> Processes 8 pixels at once, using gather for the palette lookup and masked stores
+
+	TARGET_AVX2 void writePixelsOpaque_AVX2(uint32* dstRGBA, const uint8* src, const uint32* palette, int numPixels)
+	{
+		int i = 0;
+		for (; i + 8 <= numPixels; i += 8)
+		{
+			const __m256i indices = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)&src[i]));
+			_mm256_storeu_si256((__m256i*)&dstRGBA[i], _mm256_i32gather_epi32((const int*)palette, indices, 4));
+		}
+		writePixelsOpaque_Scalar(&dstRGBA[i], &src[i], palette, numPixels - i);
+	}
+
+	TARGET_AVX2 void writePixels_AVX2(uint32* dstRGBA, const uint8* src, const uint32* palette, int numPixels)
+	{
+		const __m256i lowNibbleMask = _mm256_set1_epi32(0x0f);
+		const __m256i zero = _mm256_setzero_si256();
+		int i = 0;
+		for (; i + 8 <= numPixels; i += 8)
+		{
+			const __m256i indices = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)&src[i]));
+			const __m256i isTransparent = _mm256_cmpeq_epi32(_mm256_and_si256(indices, lowNibbleMask), zero);
+			if (_mm256_movemask_epi8(isTransparent) == -1)
+				continue;
+			const __m256i colors = _mm256_i32gather_epi32((const int*)palette, indices, 4);
+			_mm256_maskstore_epi32((int*)&dstRGBA[i], _mm256_andnot_si256(isTransparent, _mm256_set1_epi32(-1)), colors);
+		}
+		writePixels_Scalar(&dstRGBA[i], &src[i], palette, numPixels - i);
+	}
+
+	TARGET_AVX2 void writePixelsWithDepth_AVX2(uint32* dstRGBA, uint8* dstDepth, const uint8* src, const uint32* palette, int numPixels)
+	{
+		const __m128i lowNibbleMask8 = _mm_set1_epi8(0x0f);
+		const __m128i depthValue8 = _mm_set1_epi8((char)0x80);
+		const __m128i zero = _mm_setzero_si128();
+		int i = 0;
+		for (; i + 8 <= numPixels; i += 8)
+		{
+			const __m128i indices8 = _mm_loadl_epi64((const __m128i*)&src[i]);
+			const __m128i isTransparent8 = _mm_cmpeq_epi8(_mm_and_si128(indices8, lowNibbleMask8), zero);
+			if ((_mm_movemask_epi8(isTransparent8) & 0xff) == 0xff)
+				continue;
+
+			const __m128i oldDepth = _mm_loadl_epi64((const __m128i*)&dstDepth[i]);
+			_mm_storel_epi64((__m128i*)&dstDepth[i], _mm_or_si128(_mm_and_si128(isTransparent8, oldDepth), _mm_andnot_si128(isTransparent8, depthValue8)));
+
+			const __m256i colors = _mm256_i32gather_epi32((const int*)palette, _mm256_cvtepu8_epi32(indices8), 4);
+			const __m256i isTransparent = _mm256_cvtepi8_epi32(isTransparent8);
+			_mm256_maskstore_epi32((int*)&dstRGBA[i], _mm256_andnot_si256(isTransparent, _mm256_set1_epi32(-1)), colors);
+		}
+		writePixelsWithDepth_Scalar(&dstRGBA[i], &dstDepth[i], &src[i], palette, numPixels - i);
+	}
+
+	TARGET_AVX2 void writePixelsDepthTested_AVX2(uint32* dstRGBA, const uint8* depth, uint8 depthValue, const uint8* src, const uint32* palette, int numPixels)
+	{
+		const __m256i lowNibbleMask = _mm256_set1_epi32(0x0f);
+		const __m256i depthValue32 = _mm256_set1_epi32(depthValue);
+		const __m256i zero = _mm256_setzero_si256();
+		int i = 0;
+		for (; i + 8 <= numPixels; i += 8)
+		{
+			const __m256i indices = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)&src[i]));
+			const __m256i isTransparent = _mm256_cmpeq_epi32(_mm256_and_si256(indices, lowNibbleMask), zero);
+			const __m256i isOccluded = _mm256_cmpgt_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)&depth[i])), depthValue32);
+			const __m256i keepMask = _mm256_or_si256(isTransparent, isOccluded);
+			if (_mm256_movemask_epi8(keepMask) == -1)
+				continue;
+			const __m256i colors = _mm256_i32gather_epi32((const int*)palette, indices, 4);
+			_mm256_maskstore_epi32((int*)&dstRGBA[i], _mm256_andnot_si256(keepMask, _mm256_set1_epi32(-1)), colors);
+		}
+		writePixelsDepthTested_Scalar(&dstRGBA[i], &depth[i], depthValue, &src[i], palette, numPixels - i);
+	}
+
+#endif
+
+
+#if defined(KERNELS_NEON)
+
+	// NEON implementation
+	//  -> Like SSE2, there's no gather, but transparency and depth are handled for 8 pixels at once
+
+	FORCE_INLINE void blendStore8_NEON(uint32* dstRGBA, const uint8* src, const uint32* palette, uint8x8_t writeMask8)
+	{
+		uint32 colors[8];
+		for (int k = 0; k < 8; ++k)
+		{
+			colors[k] = palette[src[k]];
+		}
+
+		const int16x8_t writeMask16 = vmovl_s8(vreinterpret_s8_u8(writeMask8));
+		const uint32x4_t writeMaskLow = vreinterpretq_u32_s32(vmovl_s16(vget_low_s16(writeMask16)));
+		const uint32x4_t writeMaskHigh = vreinterpretq_u32_s32(vmovl_s16(vget_high_s16(writeMask16)));
+		vst1q_u32(&dstRGBA[0], vbslq_u32(writeMaskLow, vld1q_u32(&colors[0]), vld1q_u32(&dstRGBA[0])));
+		vst1q_u32(&dstRGBA[4], vbslq_u32(writeMaskHigh, vld1q_u32(&colors[4]), vld1q_u32(&dstRGBA[4])));
+	}
+
+	void writePixels_NEON(uint32* dstRGBA, const uint8* src, const uint32* palette, int numPixels)
+	{
+		const uint8x8_t lowNibbleMask8 = vdup_n_u8(0x0f);
+		int i = 0;
+		for (; i + 8 <= numPixels; i += 8)
+		{
+			const uint8x8_t isOpaque8 = vtst_u8(vld1_u8(&src[i]), lowNibbleMask8);
+			if (vget_lane_u64(vreinterpret_u64_u8(isOpaque8), 0) == 0)
+				continue;
+			blendStore8_NEON(&dstRGBA[i], &src[i], palette, isOpaque8);
+		}
+		writePixels_Scalar(&dstRGBA[i], &src[i], palette, numPixels - i);
+	}
+
+	void writePixelsWithDepth_NEON(uint32* dstRGBA, uint8* dstDepth, const uint8* src, const uint32* palette, int numPixels)
+	{
+		const uint8x8_t lowNibbleMask8 = vdup_n_u8(0x0f);
+		const uint8x8_t depthValue8 = vdup_n_u8(0x80);
+		int i = 0;
+		for (; i + 8 <= numPixels; i += 8)
+		{
+			const uint8x8_t isOpaque8 = vtst_u8(vld1_u8(&src[i]), lowNibbleMask8);
+			if (vget_lane_u64(vreinterpret_u64_u8(isOpaque8), 0) == 0)
+				continue;
+			vst1_u8(&dstDepth[i], vbsl_u8(isOpaque8, depthValue8, vld1_u8(&dstDepth[i])));
+			blendStore8_NEON(&dstRGBA[i], &src[i], palette, isOpaque8);
+		}
+		writePixelsWithDepth_Scalar(&dstRGBA[i], &dstDepth[i], &src[i], palette, numPixels - i);
+	}
+
+	void writePixelsDepthTested_NEON(uint32* dstRGBA, const uint8* depth, uint8 depthValue, const uint8* src, const uint32* palette, int numPixels)
+	{
+		const uint8x8_t lowNibbleMask8 = vdup_n_u8(0x0f);
+		const uint8x8_t depthValue8 = vdup_n_u8(depthValue);
+		int i = 0;
+		for (; i + 8 <= numPixels; i += 8)
+		{
+			const uint8x8_t writeMask8 = vand_u8(vtst_u8(vld1_u8(&src[i]), lowNibbleMask8), vcle_u8(vld1_u8(&depth[i]), depthValue8));
+			if (vget_lane_u64(vreinterpret_u64_u8(writeMask8), 0) == 0)
+				continue;
+			blendStore8_NEON(&dstRGBA[i], &src[i], palette, writeMask8);
+		}
+		writePixelsDepthTested_Scalar(&dstRGBA[i], &depth[i], depthValue, &src[i], palette, numPixels - i);
+	}
+
+#endif
+
+
+	SoftwareRendererKernels::Functions buildScalarFunctions()
+	{
+		SoftwareRendererKernels::Functions functions;
+		functions.mWritePixelsOpaque = &writePixelsOpaque_Scalar;
+		functions.mWritePixels = &writePixels_Scalar;
+		functions.mWritePixelsWithDepth = &writePixelsWithDepth_Scalar;
+		functions.mWritePixelsDepthTested = &writePixelsDepthTested_Scalar;
+		return functions;
+	}
+
+	const SoftwareRendererKernels::Functions SCALAR_FUNCTIONS = buildScalarFunctions();
+}
+
+
+SoftwareRendererKernels::Variant SoftwareRendererKernels::mVariant = SoftwareRendererKernels::Variant::SCALAR;
+SoftwareRendererKernels::Functions SoftwareRendererKernels::mFunctions = buildScalarFunctions();
+
+
+void SoftwareRendererKernels::initialize()
+{
+	// Use the first supported variant, in order of preference
+	Variant variant = Variant::SCALAR;
+	Functions functions = SCALAR_FUNCTIONS;
+	for (Variant candidate : { Variant::AVX2, Variant::SSE2, Variant::NEON })
+	{
+		if (getVariantFunctions(candidate, functions))
+		{
+			variant = candidate;
+			break;
+		}
+	}
+
+	mVariant = variant;
+	mFunctions = functions;
+	RMX_LOG_INFO("Using " << getVariantName(variant) << " kernels for software rendering");
+}
+
+const char* SoftwareRendererKernels::getVariantName(Variant variant)
+{
+	switch (variant)
+	{
+		case Variant::SCALAR:  return "scalar";
+		case Variant::SSE2:	   return "SSE2";
+		case Variant::AVX2:	   return "AVX2";
+		case Variant::NEON:	   return "NEON";
+	}
+	return "";
+}
+
+bool SoftwareRendererKernels::getVariantFunctions(Variant variant, Functions& outFunctions)
+{
+	outFunctions = SCALAR_FUNCTIONS;
+	switch (variant)
+	{
+		case Variant::SCALAR:
+			return true;
+
+	#if defined(KERNELS_X86)
+		case Variant::SSE2:
+			if (!SDL_HasSSE2())
+				return false;
+
+			// Opaque writes stay scalar, as they're nothing but palette lookups
+			outFunctions.mWritePixels = &writePixels_SSE2;
+			outFunctions.mWritePixelsWithDepth = &writePixelsWithDepth_SSE2;
+			outFunctions.mWritePixelsDepthTested = &writePixelsDepthTested_SSE2;
+			return true;
+
+		case Variant::AVX2:
+			if (!SDL_HasAVX2())
+				return false;
+			outFunctions.mWritePixelsOpaque = &writePixelsOpaque_AVX2;
+			outFunctions.mWritePixels = &writePixels_AVX2;
+			outFunctions.mWritePixelsWithDepth = &writePixelsWithDepth_AVX2;
+			outFunctions.mWritePixelsDepthTested = &writePixelsDepthTested_AVX2;
+			return true;
+	#elif defined(KERNELS_NEON)
+		case Variant::NEON:
+			outFunctions.mWritePixels = &writePixels_NEON;
+			outFunctions.mWritePixelsWithDepth = &writePixelsWithDepth_NEON;
+			outFunctions.mWritePixelsDepthTested = &writePixelsDepthTested_NEON;
+			return true;
+	#endif
+
+		default:
+			return false;
+	}
+}
@@ -0,0 +1,57 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#pragma once
+
+#include <rmxbase.h>
+
+
+// Pixel kernels used by the software renderer for plane and VDP sprite output
+//  -> There's a scalar reference implementation, plus SIMD variants that get selected at runtime depending on the CPU features
+//  -> All kernels take palette indices as input, and a palette pointer that already includes the atex offset
+//  -> Pixels are considered transparent if their palette index has the lower 4 bits all zero
+class SoftwareRendererKernels
+{
+public:
+	enum class Variant
+	{
+		SCALAR,
+		SSE2,
+		AVX2,
+		NEON
+	};
+
+	struct Functions
+	{
+		// Write all pixels, without transparency check (used for the background plane)
+		void(*mWritePixelsOpaque)(uint32* dstRGBA, const uint8* src, const uint32* palette, int numPixels) = nullptr;
+
+		// Write only non-transparent pixels
+		void(*mWritePixels)(uint32* dstRGBA, const uint8* src, const uint32* palette, int numPixels) = nullptr;
+
+		// Write only non-transparent pixels, and set their depth value to 0x80
+		void(*mWritePixelsWithDepth)(uint32* dstRGBA, uint8* dstDepth, const uint8* src, const uint32* palette, int numPixels) = nullptr;
+
+		// Write only non-transparent pixels that pass the depth test, i.e. where the depth buffer value is not larger than the given depth value
+		void(*mWritePixelsDepthTested)(uint32* dstRGBA, const uint8* depth, uint8 depthValue, const uint8* src, const uint32* palette, int numPixels) = nullptr;
+	};
+
+public:
+	static void initialize();
+
+	inline static Variant getVariant()					{ return mVariant; }
+	inline static const Functions& getFunctions()		{ return mFunctions; }
+	static const char* getVariantName(Variant variant);
+
+	// Get the functions of a specific variant, e.g. for tests; returns false if the variant is not supported by the CPU or build
+	static bool getVariantFunctions(Variant variant, Functions& outFunctions);
+
+private:
+	static Variant mVariant;
+	static Functions mFunctions;
+};
@@ -148,6 +148,65 @@ namespace
 		return (ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'f') || (ch >= 'A' && ch <= 'F');
 	}
 
+	bool decodeSourceFile(PaletteBitmap& bitmap, const std::vector<uint8>& content, const std::wstring& filename)
+	{
+		return FileHelper::decodePaletteBitmap(bitmap, content, filename);
+	}
+
+	bool decodeSourceFile(Bitmap& bitmap, const std::vector<uint8>& content, const std::wstring& filename)
+	{
+		return FileHelper::decodeBitmap(bitmap, content, filename);
+	}
+
+
+	// Decoding cache files contain the raw pixel data of a decoded sprite source file
+	//  -> File names are built from a hash of the source file content, so a changed source file won't use an outdated entry
+	static const uint32 DECODING_CACHE_SIGNATURE = 0x43505358;	// "XSPC"
+	static const uint16 DECODING_CACHE_FORMAT_VERSION = 1;
+
+	template<typename BITMAP>
+	bool loadFromDecodingCache(BITMAP& bitmap, const std::wstring& cacheFilename)
+	{
+		std::vector<uint8> buffer;
+		if (!FTX::FileSystem->readFile(cacheFilename, buffer))
+			return false;
+
+		VectorBinarySerializer serializer(true, buffer);
+		const uint32 signature = serializer.read<uint32>();
+		const uint16 formatVersion = serializer.read<uint16>();
+		const uint8 bytesPerPixel = serializer.read<uint8>();
+		const uint32 width = serializer.read<uint32>();
+		const uint32 height = serializer.read<uint32>();
+		if (serializer.hasError() || signature != DECODING_CACHE_SIGNATURE || formatVersion != DECODING_CACHE_FORMAT_VERSION || bytesPerPixel != sizeof(*bitmap.getData()))
+			return false;
+
+		const size_t dataSize = (size_t)width * (size_t)height * bytesPerPixel;
+		if (width == 0 || height == 0 || serializer.getRemaining() != dataSize)
+			return false;
+
+		bitmap.create(width, height);
+		serializer.read(bitmap.getData(), dataSize);
+		return true;
+	}
+
+	template<typename BITMAP>
+	void saveToDecodingCache(const BITMAP& bitmap, const std::wstring& cacheFilename)
+	{
+		const uint8 bytesPerPixel = (uint8)sizeof(*bitmap.getData());
+		const size_t dataSize = (size_t)bitmap.getPixelCount() * bytesPerPixel;
+
+		std::vector<uint8> buffer;
+		buffer.reserve(dataSize + 0x20);
+		VectorBinarySerializer serializer(false, buffer);
+		serializer.write(DECODING_CACHE_SIGNATURE);
+		serializer.write(DECODING_CACHE_FORMAT_VERSION);
+		serializer.write(bytesPerPixel);
+		serializer.writeAs<uint32>(bitmap.getWidth());
+		serializer.writeAs<uint32>(bitmap.getHeight());
+		serializer.write(bitmap.getData(), dataSize);
+		FTX::FileSystem->saveFile(cacheFilename, buffer);
+	}
+
 }
 
 
@@ -175,12 +234,27 @@ void SpriteCache::clear()
 		delete pair.second.mSprite;
 	}
 	mCachedSprites.clear();
+	mSourceFiles.clear();
+	mPendingSprites.clear();
 	++mGlobalChangeCounter;
 }
 
 void SpriteCache::loadAllSpriteDefinitions()
 {
+	// Setup the decoding cache if enabled
+	const Configuration& config = Configuration::instance();
+	if (config.mUseSpriteDecodingCache && !config.mAppDataPath.empty())
+	{
+		mDecodingCachePath = config.mAppDataPath + L"spritecache/";
+		FTX::FileSystem->createDirectory(mDecodingCachePath);
+	}
+	else
+	{
+		mDecodingCachePath.clear();
+	}
+
 	// Load or reload from all mods
+	//  -> This only reads the sprite definitions, the actual sprite files get loaded on first use of any of their sprites
 	loadSpriteDefinitions(L"data/sprites");
 	for (const Mod* mod : ModManager::instance().getActiveMods())
 	{
@@ -203,6 +277,11 @@ const SpriteCache::CacheItem* SpriteCache::getSprite(uint64 key)
 		{
 			item = item->mRedirect;
 		}
+
+		if (item->mPendingLoad)
+		{
+			loadPendingSprite(*item);
+		}
 		return item;
 	}
 	else
@@ -230,6 +309,10 @@ SpriteCache::CacheItem& SpriteCache::getOrCreatePaletteSprite(uint64 key)
 	if (nullptr != item)
 	{
 		RMX_CHECK(!item->mUsesComponentSprite, "Sprite is not a palette sprite", );
+		if (item->mPendingLoad)
+		{
+			loadPendingSprite(*item);
+		}
 	}
 	else
 	{
@@ -246,6 +329,10 @@ SpriteCache::CacheItem& SpriteCache::getOrCreateComponentSprite(uint64 key)
 	if (nullptr != item)
 	{
 		RMX_CHECK(item->mUsesComponentSprite, "Sprite is not a component sprite", );
+		if (item->mPendingLoad)
+		{
+			loadPendingSprite(*item);
+		}
 	}
 	else
 	{
@@ -316,6 +403,11 @@ void SpriteCache::dumpSprite(uint64 key, std::string_view categoryKey, uint8 spr
 	CacheItem* item = mapFind(mCachedSprites, key);
 	if (nullptr != item && !item->mGotDumped)
 	{
+		if (item->mPendingLoad)
+		{
+			loadPendingSprite(*item);
+		}
+
 		if (!item->mUsesComponentSprite)
 		{
 			const PaletteSprite& paletteSprite = *static_cast<const PaletteSprite*>(item->mSprite);
@@ -336,17 +428,13 @@ SpriteCache::CacheItem& SpriteCache::createCacheItem(uint64 key)
 	item.mSprite = nullptr;
 	item.mUsesComponentSprite = false;
 	item.mChangeCounter = mGlobalChangeCounter;
+	item.mPendingLoad = false;
 	return item;
 }
 
 void SpriteCache::loadSpriteDefinitions(const std::wstring& path)
 {
-	struct SheetCache
-	{
-		std::map<std::wstring, PaletteBitmap> mPaletteSpriteSheets;
-		std::map<std::wstring, Bitmap> mComponentSpriteSheets;
-	};
-	SheetCache sheetCache;
+	std::map<std::wstring, size_t> sourceFileIndexByPath;
 
 	std::vector<rmx::FileIO::FileEntry> fileEntries;
 	fileEntries.reserve(8);
@@ -438,80 +526,131 @@ void SpriteCache::loadSpriteDefinitions(const std::wstring& path)
 
 				// Palette or RGBA?
 				item.mUsesComponentSprite = WString(filename).endsWith(L".png");
-
-				// Part of a sprite sheet?
-				const bool isPartOfSheet = (rect.width != 0);
-
-				bool success = false;
 				if (!item.mUsesComponentSprite)
 				{
-					// Load palette sprite (= 8-bit palette sprite)
-					PaletteSprite* sprite = new PaletteSprite();
-					item.mSprite = sprite;
-
-					if (isPartOfSheet)
-					{
-						PaletteBitmap* bitmap = nullptr;
-						const auto it = sheetCache.mPaletteSpriteSheets.find(fullpath);
-						if (it == sheetCache.mPaletteSpriteSheets.end())
-						{
-							bitmap = &sheetCache.mPaletteSpriteSheets[fullpath];
-							success = FileHelper::loadPaletteBitmap(*bitmap, fullpath);
-						}
-						else
-						{
-							bitmap = &it->second;
-							success = true;
-						}
+					// Palette sprite (= 8-bit palette sprite)
+					item.mSprite = new PaletteSprite();
+				}
+				else
+				{
+					// Component sprite (= 32-bit RGBA sprite)
+					item.mSprite = new ComponentSprite();
+				}
+				item.mSprite->mOffset = -center;
+				item.mPendingLoad = true;
 
-						if (success)
-						{
-							sprite->createFromBitmap(*bitmap, rect, -center);
-						}
-					}
-					else
-					{
-						PaletteBitmap bitmap;
-						success = FileHelper::loadPaletteBitmap(bitmap, fullpath);
-						if (success)
-						{
-							static_cast<PaletteSprite*>(item.mSprite)->createFromBitmap(std::move(bitmap), -center);
-						}
-					}
+				// Register the sprite at its source file, which gets loaded later on
+				size_t sourceFileIndex;
+				const auto it = sourceFileIndexByPath.find(fullpath);
+				if (it == sourceFileIndexByPath.end())
+				{
+					sourceFileIndex = mSourceFiles.size();
+					sourceFileIndexByPath.emplace(fullpath, sourceFileIndex);
+					SourceFile& sourceFile = vectorAdd(mSourceFiles);
+					sourceFile.mFullPath = fullpath;
+					sourceFile.mUsesComponentSprite = item.mUsesComponentSprite;
 				}
 				else
 				{
-					// Load component sprite (= 32-bit RGBA sprite)
-					ComponentSprite* sprite = new ComponentSprite();
-					item.mSprite = sprite;
+					sourceFileIndex = it->second;
+				}
+				mSourceFiles[sourceFileIndex].mPendingKeys.push_back(key);
 
-					if (isPartOfSheet)
-					{
-						Bitmap* bitmap = nullptr;
-						const auto it = sheetCache.mComponentSpriteSheets.find(fullpath);
-						if (it == sheetCache.mComponentSpriteSheets.end())
-						{
-							bitmap = &sheetCache.mComponentSpriteSheets[fullpath];
-							success = FileHelper::loadBitmap(*bitmap, fullpath);
-						}
-						else
-						{
-							bitmap = &it->second;
-							success = true;
-						}
+				PendingSprite& pendingSprite = mPendingSprites[key];
+				pendingSprite.mSourceFileIndex = sourceFileIndex;
+				pendingSprite.mRect = rect;
+			}
+		}
+	}
+}
 
-						if (success)
-						{
-							sprite->accessBitmap().copy(*bitmap, rect);
-						}
-					}
-					else
-					{
-						success = FileHelper::loadBitmap(static_cast<ComponentSprite*>(item.mSprite)->accessBitmap(), fullpath);
-					}
-					item.mSprite->mOffset = -center;
-				}
+void SpriteCache::loadPendingSprite(CacheItem& item)
+{
+	item.mPendingLoad = false;
+	const PendingSprite* pendingSprite = mapFind(mPendingSprites, item.mKey);
+	if (nullptr == pendingSprite)
+		return;
+
+	// Load the source file only once, and create all of its sprites that are still pending at the same time
+	//  -> Sprites from the same file are usually needed together anyways, e.g. all animation frames of an object
+	const size_t sourceFileIndex = pendingSprite->mSourceFileIndex;
+	SourceFile& sourceFile = mSourceFiles[sourceFileIndex];
+	std::vector<uint64> pendingKeys;
+	pendingKeys.swap(sourceFile.mPendingKeys);
+
+	PaletteBitmap paletteBitmap;
+	Bitmap componentBitmap;
+	const bool success = sourceFile.mUsesComponentSprite ? loadSourceFile(componentBitmap, sourceFile) : loadSourceFile(paletteBitmap, sourceFile);
+
+	for (uint64 key : pendingKeys)
+	{
+		// Skip sprites that got overloaded by another source file in the meantime
+		const auto it = mPendingSprites.find(key);
+		if (it == mPendingSprites.end() || it->second.mSourceFileIndex != sourceFileIndex)
+			continue;
+
+		const Recti rect = it->second.mRect;
+		mPendingSprites.erase(it);
+
+		CacheItem* pendingItem = mapFind(mCachedSprites, key);
+		if (nullptr == pendingItem)
+			continue;
+
+		pendingItem->mPendingLoad = false;
+		if (!success)
+			continue;
+
+		// Part of a sprite sheet?
+		const bool isPartOfSheet = (rect.width != 0);
+		if (!sourceFile.mUsesComponentSprite)
+		{
+			PaletteSprite& sprite = *static_cast<PaletteSprite*>(pendingItem->mSprite);
+			if (isPartOfSheet)
+			{
+				sprite.createFromBitmap(paletteBitmap, rect, sprite.mOffset);
+			}
+			else
+			{
+				sprite.createFromBitmap(paletteBitmap, sprite.mOffset);
+			}
+		}
+		else
+		{
+			ComponentSprite& sprite = *static_cast<ComponentSprite*>(pendingItem->mSprite);
+			if (isPartOfSheet)
+			{
+				sprite.accessBitmap().copy(componentBitmap, rect);
+			}
+			else
+			{
+				sprite.accessBitmap().copy(componentBitmap);
 			}
 		}
+		++pendingItem->mChangeCounter;
+	}
+}
+
+template<typename BITMAP>
+bool SpriteCache::loadSourceFile(BITMAP& bitmap, const SourceFile& sourceFile)
+{
+	std::vector<uint8> content;
+	if (!FTX::FileSystem->readFile(sourceFile.mFullPath, content))
+		RMX_ERROR("Failed to load image file '" << *WString(sourceFile.mFullPath).toString() << "': File not found", return false);
+
+	if (mDecodingCachePath.empty() || content.empty())
+	{
+		return decodeSourceFile(bitmap, content, sourceFile.mFullPath);
 	}
+
+	// Try to use the decoding cache first
+	const uint64 hash = rmx::getMurmur2_64(&content[0], content.size());
+	const std::wstring cacheFilename = mDecodingCachePath + *String(rmx::hexString(hash, 16, "")).toWString() + L".bin";
+	if (loadFromDecodingCache(bitmap, cacheFilename))
+		return true;
+
+	if (!decodeSourceFile(bitmap, content, sourceFile.mFullPath))
+		return false;
+
+	saveToDecodingCache(bitmap, cacheFilename);
+	return true;
 }
@@ -27,6 +27,7 @@ public:
 		uint32 mChangeCounter = 0;
 		CacheItem* mRedirect = nullptr;
 		bool mGotDumped = false;
+		bool mPendingLoad = false;		// Sprite is defined, but its pixel data was not decoded yet
 	};
 
 	enum ROMSpriteEncoding
@@ -59,12 +60,33 @@ public:
 	SpriteDump& getSpriteDump();
 	void dumpSprite(uint64 key, std::string_view categoryKey, uint8 spriteNumber, uint8 atex);
 
+private:
+	struct SourceFile
+	{
+		std::wstring mFullPath;
+		bool mUsesComponentSprite = false;
+		std::vector<uint64> mPendingKeys;	// Keys of all sprites using this file that were not loaded yet
+	};
+
+	struct PendingSprite
+	{
+		size_t mSourceFileIndex = 0;
+		Recti mRect;						// Part of the sprite sheet, or empty if the whole file is used
+	};
+
 private:
 	CacheItem& createCacheItem(uint64 key);
 	void loadSpriteDefinitions(const std::wstring& path);
+	void loadPendingSprite(CacheItem& item);
+
+	template<typename BITMAP>
+	bool loadSourceFile(BITMAP& bitmap, const SourceFile& sourceFile);
 
 private:
 	std::unordered_map<uint64, CacheItem> mCachedSprites;
+	std::vector<SourceFile> mSourceFiles;
+	std::unordered_map<uint64, PendingSprite> mPendingSprites;
+	std::wstring mDecodingCachePath;		// Empty if decoded sprite sheets don't get cached
 	SpriteDump* mSpriteDump = nullptr;
 	uint32 mGlobalChangeCounter = 0;
 };
@@ -483,6 +483,7 @@ bool CodeExec::performFrameUpdate()
 	if (beginningNewFrame)
 	{
 		mAccumulatedStepsOfCurrentFrame = 0;
+		mLemonScriptRuntime.onProfilingFrameStarted();
 
 		if (mIsDeveloperMode)
 		{
@@ -21,6 +21,11 @@ void GameRecorder::clear()
 	mPlaybackPosition = -1;
 	mRangeStart = 0;
 	mRangeEnd = 0;
+	mReferenceKeyframeNumber = -1;
+	mReferenceKeyframeData.clear();
+	mKeyframesSinceFullKeyframe = 0;
+	mDecodedKeyframeNumber = -1;
+	mDecodedKeyframeData.clear();
 }
 
 void GameRecorder::addFrame(const uint16* inputs)
@@ -31,9 +36,37 @@ void GameRecorder::addFrame(const uint16* inputs)
 
 void GameRecorder::addKeyFrame(const uint16* inputs, const std::vector<uint8>& data)
 {
-	Frame& frame = addFrameInternal(inputs, Frame::Type::KEYFRAME);
-	frame.mType = Frame::Type::KEYFRAME;
-	frame.mData = data;
+	// Differential keyframes can only be used if their full keyframe is still there, i.e. was not discarded in the meantime
+	const bool useDifferential = (mReferenceKeyframeNumber >= (int64)mRangeStart && mReferenceKeyframeNumber < (int64)mRangeEnd && mKeyframesSinceFullKeyframe + 1 < FULL_KEYFRAME_INTERVAL);
+	if (useDifferential)
+	{
+		Frame& frame = addFrameInternal(inputs, Frame::Type::DIFFERENTIAL);
+
+		// XOR with the full keyframe, which leaves mostly zeroes that compress very well
+		//  -> If the new data is larger, the additional bytes are stored as they are
+		mTempBuffer.resize(data.size());
+		const size_t commonSize = std::min(data.size(), mReferenceKeyframeData.size());
+		for (size_t k = 0; k < commonSize; ++k)
+		{
+			mTempBuffer[k] = data[k] ^ mReferenceKeyframeData[k];
+		}
+		if (data.size() > commonSize)
+		{
+			memcpy(&mTempBuffer[commonSize], &data[commonSize], data.size() - commonSize);
+		}
+
+		compressFrameData(frame, mTempBuffer);
+		++mKeyframesSinceFullKeyframe;
+	}
+	else
+	{
+		Frame& frame = addFrameInternal(inputs, Frame::Type::KEYFRAME);
+		compressFrameData(frame, data);
+
+		mReferenceKeyframeNumber = frame.mNumber;
+		mReferenceKeyframeData = data;
+		mKeyframesSinceFullKeyframe = 0;
+	}
 }
 
 void GameRecorder::discardOldFrames(uint32 minKeepNumber)
@@ -84,16 +117,23 @@ bool GameRecorder::updatePlayback(PlaybackResult& outResult)
 		return false;
 	}
 
-	Frame& frame = *mFrames[mPlaybackPosition];
+	const size_t index = (size_t)(mPlaybackPosition - (int32)mRangeStart);
+	Frame& frame = *mFrames[index];
 	outResult.mInputs[0] = frame.mInputs[0];
 	outResult.mInputs[1] = frame.mInputs[1];
 
-	if (frame.mType == Frame::Type::KEYFRAME)
+	if (frame.mType != Frame::Type::INPUT_ONLY)
 	{
 		if (!mIgnoreKeys || mPlaybackPosition == 0)
 		{
-			// TODO: Handle "frame.mCompressedData == true" (not needed for pure playback after loading from file)
-			outResult.mData = &frame.mData;
+			if (getFrameState(index, mPlaybackData))
+			{
+				outResult.mData = &mPlaybackData;
+			}
+			else
+			{
+				RMX_ERROR("Failed to restore game recorder keyframe at position " << mPlaybackPosition, );
+			}
 		}
 	}
 
@@ -111,13 +151,55 @@ bool GameRecorder::loadRecording(const std::wstring& filename)
 	if (!FTX::FileSystem->readFile(filename, dump))
 		return false;
 
+	std::string buildString;
+	std::vector<uint8> header;
+	if (!loadRecordingData(dump, buildString, header))
+		return false;
+
+	// Game-specific
+	if (!header.empty())
+	{
+		EngineMain::getDelegate().onGameRecordingHeaderLoaded(buildString, header);
+	}
+	return true;
+}
+
+bool GameRecorder::saveRecording(const std::wstring& filename) const
+{
+	// Create directory if needed
+	const size_t slashPosition = filename.find_last_of(L"/\\");
+	if (slashPosition != std::string::npos)
+	{
+		FTX::FileSystem->createDirectory(filename.substr(0, slashPosition));
+	}
+
+	// Game-specific
+	std::vector<uint8> header;
+	EngineMain::getDelegate().onGameRecordingHeaderSave(header);
+
+	std::vector<uint8> dump;
+	const EngineDelegateInterface::AppMetaData& appMetaData = EngineMain::getDelegate().getAppMetaData();
+	saveRecordingData(dump, appMetaData.mBuildVersionString, header);
+
+	return FTX::FileSystem->saveFile(filename, dump);
+}
+
+bool GameRecorder::loadRecordingData(const std::vector<uint8>& dump, std::string& outBuildString, std::vector<uint8>& outHeader)
+{
+	clear();
+	outHeader.clear();
+
 	VectorBinarySerializer serializer(true, dump);
 
 	// Signature
 	char signature[4];
 	serializer.read(signature, 4);
 	int formatVersion = 0;
-	if (memcmp(signature, "GRC1", 4) == 0)
+	if (memcmp(signature, "GRC2", 4) == 0)
+	{
+		formatVersion = 2;
+	}
+	else if (memcmp(signature, "GRC1", 4) == 0)
 	{
 		formatVersion = 1;
 	}
@@ -132,17 +214,16 @@ bool GameRecorder::loadRecording(const std::wstring& filename)
 
 	char buildString[11] = "..........";
 	serializer.read(buildString, 10);
+	outBuildString = buildString;
 
 	// Game-specific
-	if (std::string(buildString) >= "19.08.11.0")
+	if (outBuildString >= "19.08.11.0")
 	{
 		const uint32 bufferSize = serializer.read<uint32>();
 		if (bufferSize > 0)
 		{
-			std::vector<uint8> buffer;
-			buffer.resize((size_t)bufferSize);
-			serializer.read((char*)&buffer[0], bufferSize);
-			EngineMain::getDelegate().onGameRecordingHeaderLoaded(buildString, buffer);
+			outHeader.resize((size_t)bufferSize);
+			serializer.read((char*)&outHeader[0], bufferSize);
 		}
 	}
 
@@ -157,8 +238,11 @@ bool GameRecorder::loadRecording(const std::wstring& filename)
 		serializer.serialize(frame.mInputs[0]);
 		serializer.serialize(frame.mInputs[1]);
 
-		if (frameType == Frame::Type::KEYFRAME)
+		if (frameType == Frame::Type::KEYFRAME || frameType == Frame::Type::DIFFERENTIAL)
 		{
+			// Differential keyframes were added in format version 2
+			RMX_CHECK(frameType == Frame::Type::KEYFRAME || (formatVersion >= 2 && index > 0), "Invalid differential keyframe in game recording", clear(); return false);
+
 			frame.mCompressedData = false;
 			const uint32 dataSize = serializer.read<uint32>();
 			if (dataSize > 0)
@@ -166,8 +250,10 @@ bool GameRecorder::loadRecording(const std::wstring& filename)
 				if (formatVersion >= 1)
 				{
 					// Newer versions use zlib deflate, including the two zlib header bytes
-					ZlibDeflate::decode(frame.mData, serializer.peek(), dataSize);
-					serializer.skip(dataSize);
+					//  -> Data gets stored as it is, decompression is done only when needed during playback
+					frame.mData.resize(dataSize);
+					serializer.read((char*)&frame.mData[0], dataSize);
+					frame.mCompressedData = true;
 				}
 				else
 				{
@@ -192,37 +278,30 @@ bool GameRecorder::loadRecording(const std::wstring& filename)
 	return true;
 }
 
-bool GameRecorder::saveRecording(const std::wstring& filename) const
+void GameRecorder::saveRecordingData(std::vector<uint8>& dump, const std::string& buildString, const std::vector<uint8>& header) const
 {
-	// Create directory if needed
-	const size_t slashPosition = filename.find_last_of(L"/\\");
-	if (slashPosition != std::string::npos)
-	{
-		FTX::FileSystem->createDirectory(filename.substr(0, slashPosition));
-	}
-
-	std::vector<uint8> dump;
+	dump.clear();
 	VectorBinarySerializer serializer(false, dump);
 
 	// Signature
-	const EngineDelegateInterface::AppMetaData& appMetaData = EngineMain::getDelegate().getAppMetaData();
-	const char SIGNATURE[] = "GRC1";
+	const char SIGNATURE[] = "GRC2";
 	serializer.write(SIGNATURE, 4);
-	serializer.write(appMetaData.mBuildVersionString.c_str(), 10);
+	char buildStringBuffer[11] = "..........";
+	memcpy(buildStringBuffer, buildString.c_str(), std::min<size_t>(buildString.length(), 10));
+	serializer.write(buildStringBuffer, 10);
 
 	// Game-specific
-	std::vector<uint8> buffer;
 	{
-		EngineMain::getDelegate().onGameRecordingHeaderSave(buffer);
-		const uint32 bufferSize = (uint32)buffer.size();
+		const uint32 bufferSize = (uint32)header.size();
 		serializer.write(bufferSize);
 		if (bufferSize > 0)
 		{
-			serializer.write(&buffer[0], bufferSize);
+			serializer.write(&header[0], bufferSize);
 		}
 	}
 
 	// Save all frames
+	std::vector<uint8> buffer;
 	const uint32 frameCount = (uint32)mFrames.size();
 	serializer.write(frameCount);
 
@@ -232,9 +311,9 @@ bool GameRecorder::saveRecording(const std::wstring& filename) const
 		serializer.write(frame->mInputs[0]);
 		serializer.write(frame->mInputs[1]);
 
-		if (frame->mType == Frame::Type::KEYFRAME)
+		if (frame->mType == Frame::Type::KEYFRAME || frame->mType == Frame::Type::DIFFERENTIAL)
 		{
-			if (!frame->mCompressedData)
+			if (!frame->mCompressedData && !frame->mData.empty())
 			{
 				// Compress data
 				buffer.clear();
@@ -246,11 +325,12 @@ bool GameRecorder::saveRecording(const std::wstring& filename) const
 
 			const uint32 dataSize = (uint32)frame->mData.size();
 			serializer.write(dataSize);
-			serializer.write(&frame->mData[0], dataSize);
+			if (dataSize > 0)
+			{
+				serializer.write(&frame->mData[0], dataSize);
+			}
 		}
 	}
-
-	return FTX::FileSystem->saveFile(filename, dump);
 }
 
 GameRecorder::Frame& GameRecorder::createFrameInternal(Frame::Type frameType, uint32 number)
@@ -275,3 +355,75 @@ GameRecorder::Frame& GameRecorder::addFrameInternal(const uint16* inputs, Frame:
 	++mRangeEnd;
 	return frame;
 }
+
+bool GameRecorder::getFrameState(size_t index, std::vector<uint8>& outData)
+{
+	const Frame& frame = *mFrames[index];
+	switch (frame.mType)
+	{
+		case Frame::Type::KEYFRAME:
+		{
+			return decompressFrameData(frame, outData);
+		}
+
+		case Frame::Type::DIFFERENTIAL:
+		{
+			// Search for the full keyframe this one refers to
+			size_t keyframeIndex = index;
+			while (keyframeIndex > 0 && mFrames[keyframeIndex]->mType != Frame::Type::KEYFRAME)
+				--keyframeIndex;
+
+			const Frame& keyframe = *mFrames[keyframeIndex];
+			RMX_CHECK(keyframe.mType == Frame::Type::KEYFRAME, "No full keyframe found for differential keyframe " << frame.mNumber, return false);
+
+			// Decompress the full keyframe only if it's not the same as last time
+			if (mDecodedKeyframeNumber != (int64)keyframe.mNumber)
+			{
+				if (!decompressFrameData(keyframe, mDecodedKeyframeData))
+					return false;
+				mDecodedKeyframeNumber = keyframe.mNumber;
+			}
+
+			if (!decompressFrameData(frame, outData))
+				return false;
+
+			const size_t commonSize = std::min(outData.size(), mDecodedKeyframeData.size());
+			for (size_t k = 0; k < commonSize; ++k)
+			{
+				outData[k] ^= mDecodedKeyframeData[k];
+			}
+			return true;
+		}
+
+		default:
+			return false;
+	}
+}
+
+void GameRecorder::compressFrameData(Frame& frame, const std::vector<uint8>& data)
+{
+	frame.mData.clear();
+	frame.mCompressedData = false;
+	if (data.empty())
+		return;
+
+	// Use the fastest compression level, as this is done while the game is running
+	ZlibDeflate::encode(mCompressionBuffer, &data[0], data.size(), 1);
+
+	// Copy over to make sure the frame does not keep the (much larger) reserved memory of the compression buffer
+	frame.mData.assign(mCompressionBuffer.begin(), mCompressionBuffer.end());
+	frame.mData.shrink_to_fit();
+	frame.mCompressedData = true;
+}
+
+bool GameRecorder::decompressFrameData(const Frame& frame, std::vector<uint8>& outData) const
+{
+	if (!frame.mCompressedData || frame.mData.empty())
+	{
+		outData = frame.mData;
+		return true;
+	}
+	// Decoding appends to the output, so clear it first
+	outData.clear();
+	return ZlibDeflate::decode(outData, &frame.mData[0], frame.mData.size());
+}
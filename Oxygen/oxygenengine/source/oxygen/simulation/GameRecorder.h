@@ -23,7 +23,7 @@ public:
 public:
 	void clear();
 	void addFrame(const uint16* inputs);
-	void addKeyFrame(const uint16* inputs, const std::vector<uint8>& data);
+	void addKeyFrame(const uint16* inputs, const std::vector<uint8>& data);	// Gets stored as either full or differential keyframe
 
 	void discardOldFrames(uint32 minKeepNumber = 3600);
 
@@ -37,6 +37,10 @@ public:
 	bool loadRecording(const std::wstring& filename);
 	bool saveRecording(const std::wstring& filename) const;
 
+	// Same as above, but from / to memory, with the game-specific header data passed in and out instead of going through the engine delegate
+	bool loadRecordingData(const std::vector<uint8>& dump, std::string& outBuildString, std::vector<uint8>& outHeader);
+	void saveRecordingData(std::vector<uint8>& dump, const std::string& buildString, const std::vector<uint8>& header) const;
+
 	inline void setIgnoreKeys(bool ignoreKeys)  { mIgnoreKeys = ignoreKeys; }
 
 private:
@@ -46,21 +50,26 @@ private:
 		{
 			INPUT_ONLY,
 			KEYFRAME,
-			DIFFERENTIAL	// Difference to last keyframe; not implemented yet
+			DIFFERENTIAL	// XOR difference to the last full keyframe before this one
 		};
 
 		Type mType = Type::INPUT_ONLY;
 		uint32 mNumber = 0;
 		uint16 mInputs[2] = { 0 };
-		bool mCompressedData = false;
+		bool mCompressedData = false;	// Zlib compressed data, applies to both full and differential keyframes
 		std::vector<uint8> mData;
 	};
 
 private:
 	Frame& createFrameInternal(Frame::Type frameType, uint32 number);
 	Frame& addFrameInternal(const uint16* inputs, Frame::Type frameType);
+	bool getFrameState(size_t index, std::vector<uint8>& outData);
+	void compressFrameData(Frame& frame, const std::vector<uint8>& data);
+	bool decompressFrameData(const Frame& frame, std::vector<uint8>& outData) const;
 
 private:
+	static const constexpr uint32 FULL_KEYFRAME_INTERVAL = 10;	// Every n-th keyframe is a full keyframe, all others are differential
+
 	std::vector<Frame*> mFrames;
 	RentableObjectPool<Frame> mFrameNoDataPool;
 	RentableObjectPool<Frame> mFrameWithDataPool;
@@ -69,4 +78,17 @@ private:
 	uint32 mRangeStart = 0;			// Frame number of first frame stored in mFrames
 	uint32 mRangeEnd = 0;			// Frame number of last frame stored in mFrames plus one (!)
 	bool mIgnoreKeys = false;
+
+	// Uncompressed data of the full keyframe that new differential keyframes get compared to while recording
+	int64 mReferenceKeyframeNumber = -1;
+	std::vector<uint8> mReferenceKeyframeData;
+	uint32 mKeyframesSinceFullKeyframe = 0;
+
+	// Uncompressed data of the last full keyframe used for restoring a differential keyframe
+	int64 mDecodedKeyframeNumber = -1;
+	std::vector<uint8> mDecodedKeyframeData;
+
+	std::vector<uint8> mPlaybackData;
+	std::vector<uint8> mTempBuffer;
+	std::vector<uint8> mCompressionBuffer;
 };
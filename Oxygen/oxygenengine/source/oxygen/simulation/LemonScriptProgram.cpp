@@ -9,9 +9,11 @@
 #include "oxygen/pch.h"
 #include "oxygen/simulation/LemonScriptProgram.h"
 #include "oxygen/simulation/EmulatorInterface.h"
+#include "oxygen/simulation/NativizedModCache.h"
 #include "oxygen/application/modding/ModManager.h"
 #include "oxygen/helper/Utils.h"
 
+#include <lemon/compiler/CompilationCache.h>
 #include <lemon/compiler/Compiler.h>
 #include <lemon/compiler/TokenHelper.h>
 #include <lemon/compiler/TokenManager.h>
@@ -32,6 +34,9 @@ struct LemonScriptProgram::Internal
 	lemon::Program mProgram;
 	LemonScriptBindings	mLemonScriptBindings;
 	lemon::GlobalsLookup mGlobalsLookupCoreOnly;
+	NativizedModCache mNativizedModCache;
+	lemon::CompilationCache mCompilationCache;
+	std::wstring mCompilationCacheFilename;		// Empty if compilation cache is not used
 
 	Hook mPreUpdateHook;
 	Hook mPostUpdateHook;
@@ -83,6 +88,18 @@ LemonScriptProgram::LemonScriptProgram() :
 		mInternal.mLemonCoreModule.dumpDefinitionsToScriptFile(config.mDumpCppDefinitionsOutput);
 		mInternal.mOxygenCoreModule.dumpDefinitionsToScriptFile(config.mDumpCppDefinitionsOutput, true);
 	}
+
+	// Load the compilation cache, so that script files that did not change since the last run don't have to be compiled again
+	if (config.mUseScriptCompilationCache && !config.mAppDataPath.empty())
+	{
+		mInternal.mCompilationCacheFilename = config.mAppDataPath + L"scriptcache.bin";
+		std::vector<uint8> buffer;
+		if (FTX::FileSystem->readFile(mInternal.mCompilationCacheFilename, buffer))
+		{
+			VectorBinarySerializer serializer(true, buffer);
+			mInternal.mCompilationCache.serialize(serializer);
+		}
+	}
 }
 
 LemonScriptProgram::~LemonScriptProgram()
@@ -105,7 +122,7 @@ bool LemonScriptProgram::hasValidProgram() const
 	return !mInternal.mProgram.getModules().empty();
 }
 
-bool LemonScriptProgram::loadScriptModule(lemon::Module& module, lemon::GlobalsLookup& globalsLookup, const std::wstring& filename)
+bool LemonScriptProgram::loadScriptModule(lemon::Module& module, lemon::GlobalsLookup& globalsLookup, const std::wstring& filename, uint64 dependencyHash)
 {
 	try
 	{
@@ -113,6 +130,12 @@ bool LemonScriptProgram::loadScriptModule(lemon::Module& module, lemon::GlobalsL
 		lemon::CompileOptions options;
 		//options.mOutputCombinedSource = L"combined_source.lemon";	// Just for debugging preprocessor issues
 		//options.mOutputTranslatedSource = L"output.cpp";			// For testing translation
+		options.mNumThreads = Configuration::instance().mScriptCompilerThreads;
+		if (!mInternal.mCompilationCacheFilename.empty())
+		{
+			options.mCompilationCache = &mInternal.mCompilationCache;
+			options.mExternalDependencyHash = dependencyHash;
+		}
 		lemon::Compiler compiler(module, globalsLookup, options);
 
 		const bool compileSuccess = compiler.loadScript(filename);
@@ -186,6 +209,13 @@ LemonScriptProgram::LoadScriptsResult LemonScriptProgram::loadScripts(const std:
 	// Clear program here already - in case compilation fails, it would be broken otherwise
 	mInternal.mProgram.clear();
 
+	// Hash of all definitions visible to the next compiled module, only needed for the compilation cache
+	uint64 definitionsHash = 0;
+	if (!mInternal.mCompilationCacheFilename.empty())
+	{
+		definitionsHash = mInternal.mLemonCoreModule.buildDefinitionsHash(globalsLookup) + mInternal.mOxygenCoreModule.buildDefinitionsHash(globalsLookup) + loadOptions.mAppVersion;
+	}
+
 	// Load project's main script module, but only if a full reload is needed
 	if (mainScriptReloadNeeded)
 	{
@@ -217,7 +247,7 @@ LemonScriptProgram::LoadScriptsResult LemonScriptProgram::loadScripts(const std:
 				if (FTX::FileSystem->exists(filename))
 				{
 					// Compile module
-					scriptsLoaded = loadScriptModule(mInternal.mScriptModule, globalsLookup, *String(filename).toWString());
+					scriptsLoaded = loadScriptModule(mInternal.mScriptModule, globalsLookup, *String(filename).toWString(), definitionsHash);
 
 					// If there are no script functions at all, we consider that a failure
 					scriptsLoaded = scriptsLoaded && !mInternal.mScriptModule.getScriptFunctions().empty();
@@ -269,13 +299,15 @@ LemonScriptProgram::LoadScriptsResult LemonScriptProgram::loadScripts(const std:
 				if (nullptr != previousModule)
 				{
 					globalsLookup.addDefinitionsFromModule(*previousModule);
+					if (!mInternal.mCompilationCacheFilename.empty())
+						definitionsHash += previousModule->buildDefinitionsHash(globalsLookup);
 					previousModule = nullptr;
 				}
 
 				// Create and compile module
 				lemon::Module* module = new lemon::Module(mod->mUniqueID);
 				const std::wstring mainScriptFilename = mod->mFullPath + L"scripts/main.lemon";
-				const bool success = loadScriptModule(*module, globalsLookup, mainScriptFilename);
+				const bool success = loadScriptModule(*module, globalsLookup, mainScriptFilename, definitionsHash);
 				if (success)
 				{
 					mInternal.mModModules.push_back(module);
@@ -290,6 +322,17 @@ LemonScriptProgram::LoadScriptsResult LemonScriptProgram::loadScripts(const std:
 		}
 	}
 
+	// Write back the compilation cache if anything got compiled
+	if (mInternal.mCompilationCache.hasChanges())
+	{
+		std::vector<uint8> buffer;
+		VectorBinarySerializer serializer(false, buffer);
+		if (mInternal.mCompilationCache.serialize(serializer))
+		{
+			FTX::FileSystem->saveFile(mInternal.mCompilationCacheFilename, buffer);
+		}
+	}
+
 	// Build lemon script program from modules
 	mInternal.mProgram.addModule(mInternal.mLemonCoreModule);
 	mInternal.mProgram.addModule(mInternal.mOxygenCoreModule);
@@ -323,6 +366,9 @@ LemonScriptProgram::LoadScriptsResult LemonScriptProgram::loadScripts(const std:
 		config.mRunScriptNativization = 2;		// Mark as done
 	}
 
+	// Load nativized mod scripts, or prepare them for the next start
+	mInternal.mNativizedModCache.applyToProgram(mInternal.mProgram, mInternal.mModModules, EmulatorInterface::instance());
+
 	// Scan for function pragmas defining hooks
 	evaluateFunctionPragmas();
 
@@ -24,6 +24,7 @@
 #include <lemon/program/Program.h>
 #include <lemon/runtime/Runtime.h>
 #include <lemon/runtime/RuntimeFunction.h>
+#include <lemon/runtime/RuntimeProfiler.h>
 
 
 namespace
@@ -104,6 +105,7 @@ struct LemonScriptRuntime::Internal
 {
 	lemon::Runtime mRuntime;
 	RuntimeDetailHandler mRuntimeDetailHandler;
+	lemon::RuntimeProfiler mRuntimeProfiler;
 	LinearLookupTable<const lemon::RuntimeFunction*, 0x400000, 6, 1024> mAddressHookLookup;
 };
 
@@ -339,6 +341,42 @@ std::string LemonScriptRuntime::getOwnCurrentScriptLocationString() const
 	return buildScriptLocationString(mInternal.mRuntime.getSelectedControlFlow());
 }
 
+bool LemonScriptRuntime::isProfilingEnabled() const
+{
+	return (nullptr != mInternal.mRuntime.getRuntimeProfiler());
+}
+
+void LemonScriptRuntime::setProfilingEnabled(bool enable)
+{
+	if (enable == isProfilingEnabled())
+		return;
+
+	if (enable)
+	{
+		// Start over with a fresh profile
+		mInternal.mRuntimeProfiler.reset();
+		mInternal.mRuntime.setRuntimeProfiler(&mInternal.mRuntimeProfiler);
+	}
+	else
+	{
+		// Collected data stays available until profiling gets enabled again
+		mInternal.mRuntime.setRuntimeProfiler(nullptr);
+	}
+}
+
+const lemon::RuntimeProfiler& LemonScriptRuntime::getRuntimeProfiler() const
+{
+	return mInternal.mRuntimeProfiler;
+}
+
+void LemonScriptRuntime::onProfilingFrameStarted()
+{
+	if (isProfilingEnabled())
+	{
+		mInternal.mRuntimeProfiler.nextFrame();
+	}
+}
+
 std::string LemonScriptRuntime::buildScriptLocationString(const lemon::ControlFlow& controlFlow)
 {
 	lemon::ControlFlow::Location location;
@@ -22,6 +22,7 @@ namespace lemon
 	class GlobalsLookup;
 	class Runtime;
 	class RuntimeFunction;
+	class RuntimeProfiler;
 	class ScriptFunction;
 }
 
@@ -66,6 +67,11 @@ public:
 	void getLastStepLocation(const lemon::ScriptFunction*& outFunction, size_t& outProgramCounter) const;
 	std::string getOwnCurrentScriptLocationString() const;
 
+	bool isProfilingEnabled() const;
+	void setProfilingEnabled(bool enable);
+	const lemon::RuntimeProfiler& getRuntimeProfiler() const;
+	void onProfilingFrameStarted();
+
 private:
 	static std::string buildScriptLocationString(const lemon::ControlFlow& controlFlow);
 	static uint32 getLineNumberInFile(const lemon::ScriptFunction& function, size_t programCounter);
@@ -0,0 +1,217 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#include "oxygen/pch.h"
+#include "oxygen/simulation/NativizedModCache.h"
+
+#include <lemon/program/Function.h>
+#include <lemon/program/Module.h>
+#include <lemon/program/Program.h>
+
+#include <thread>
+
+
+namespace
+{
+#if defined(PLATFORM_WINDOWS) || defined(PLATFORM_MAC) || defined(PLATFORM_LINUX)
+	#define SUPPORT_NATIVIZED_MOD_LIBRARIES
+#endif
+
+#if defined(PLATFORM_WINDOWS)
+	const wchar_t* LIBRARY_EXTENSION = L"dll";
+#elif defined(PLATFORM_MAC)
+	const wchar_t* LIBRARY_EXTENSION = L"dylib";
+#else
+	const wchar_t* LIBRARY_EXTENSION = L"so";
+#endif
+
+	// Building marker files older than this are considered leftovers of an instance that got terminated during compilation
+	const time_t MAX_COMPILATION_TIME = 10 * 60;
+
+	typedef const lemon::Nativizer::LibraryData* (*GetLibraryDataFunc)();
+
+	void replaceAll(std::string& str, std::string_view pattern, std::string_view replacement)
+	{
+		for (size_t pos = str.find(pattern); pos != std::string::npos; pos = str.find(pattern, pos + replacement.length()))
+		{
+			str.replace(pos, pattern.length(), replacement);
+		}
+	}
+}
+
+
+void NativizedModCache::applyToProgram(lemon::Program& program, const std::vector<lemon::Module*>& modModules, lemon::MemoryAccessHandler& memoryAccessHandler)
+{
+#if defined(SUPPORT_NATIVIZED_MOD_LIBRARIES)
+	if (!mInitialized)
+	{
+		// Remember the game's own provider, which gets set once in the beginning
+		mGameProvider = program.mNativizedOpcodeProvider;
+		mInitialized = true;
+	}
+
+	lemon::NativizedOpcodeProvider& provider = (nullptr != mGameProvider) ? *mGameProvider : mOwnProvider;
+	provider.clearLibraryLookups();
+
+	const Configuration& config = Configuration::instance();
+	if (config.mModNativization.mEnabled && config.mScriptOptimizationLevel != 0)
+	{
+		const std::wstring cacheDirectory = config.mAppDataPath + L"nativized/";
+		bool createdDirectory = false;
+
+		for (const lemon::Module* module : modModules)
+		{
+			if (module->getScriptFunctions().empty())
+				continue;
+
+			const uint64 hash = getModuleHash(*module);
+			const std::wstring basename = cacheDirectory + String(rmx::hexString(hash, 16, "")).toStdWString();
+			const std::wstring libraryFilename = basename + L"." + LIBRARY_EXTENSION;
+			const std::wstring failedMarkerFilename = basename + L".failed";
+
+			// Don't try again if building or loading the library failed before
+			//  -> The hash includes the build version, so there's no point in rebuilding from the very same input; deleting the cache directory resets this
+			if (rmx::FileIO::exists(failedMarkerFilename))
+			{
+				RMX_LOG_INFO("Nativized library for mod module '" << module->getModuleName() << "' failed to build or load before and gets ignored");
+				continue;
+			}
+
+			// Load the library if it's in the cache already
+			void* library = nullptr;
+			const auto it = mLoadedLibraries.find(hash);
+			if (it != mLoadedLibraries.end())
+			{
+				library = it->second;
+			}
+			else if (rmx::FileIO::exists(libraryFilename))
+			{
+				library = loadLibrary(libraryFilename);
+				if (nullptr == library)
+				{
+					rmx::FileIO::saveFile(failedMarkerFilename, nullptr, 0);
+					continue;
+				}
+				mLoadedLibraries.emplace(hash, library);
+			}
+
+			if (nullptr != library)
+			{
+				const GetLibraryDataFunc func = (GetLibraryDataFunc)SDL_LoadFunction(library, "getNativizedLibraryData");
+				if (nullptr != func && provider.addLibraryLookup(*func()))
+					continue;
+
+				RMX_LOG_INFO("Nativized library for mod module '" << module->getModuleName() << "' is not compatible and gets ignored");
+				if (it == mLoadedLibraries.end())
+				{
+					// Not used yet, so it can be safely unloaded
+					SDL_UnloadObject(library);
+					mLoadedLibraries.erase(hash);
+					rmx::FileIO::saveFile(failedMarkerFilename, nullptr, 0);
+				}
+				continue;
+			}
+
+			// Write source and build the library for the next start, unless this or another instance is building it already
+			if (mStartedCompilations.count(hash) == 0 && !isCompilationRunning(basename + L".building"))
+			{
+				if (!createdDirectory)
+				{
+					rmx::FileIO::createDirectory(cacheDirectory);
+					createdDirectory = true;
+				}
+
+				program.runNativization(*module, basename + L".cpp", memoryAccessHandler, lemon::Nativizer::OutputType::SHARED_LIBRARY_SOURCE);
+				startCompilation(basename);
+				mStartedCompilations.insert(hash);
+			}
+		}
+	}
+
+	if (nullptr == mGameProvider)
+	{
+		program.mNativizedOpcodeProvider = mOwnProvider.isValid() ? &mOwnProvider : nullptr;
+	}
+#endif
+}
+
+uint64 NativizedModCache::getModuleHash(const lemon::Module& module) const
+{
+	// Include build version and library data version, as nativized code depends on the application's internals
+	uint64 hash = rmx::startFNV1a_64();
+	const uint32 versions[2] = { EngineMain::getDelegate().getAppMetaData().mBuildVersionNumber, lemon::Nativizer::LIBRARY_DATA_VERSION };
+	hash = rmx::addToFNV1a_64(hash, (const uint8*)versions, sizeof(versions));
+
+	for (const lemon::ScriptFunction* function : module.getScriptFunctions())
+	{
+		hash = function->addToCompiledHash(hash);
+	}
+	return hash;
+}
+
+void* NativizedModCache::loadLibrary(const std::wstring& filename)
+{
+	const std::string filenameUTF8 = WString(filename).toUTF8().toStdString();
+	void* library = SDL_LoadObject(filenameUTF8.c_str());
+	if (nullptr == library)
+	{
+		RMX_LOG_INFO("Failed to load nativized library '" << filenameUTF8 << "': " << SDL_GetError());
+	}
+	return library;
+}
+
+bool NativizedModCache::isCompilationRunning(const std::wstring& buildingMarkerFilename) const
+{
+	time_t markerTime;
+	if (!rmx::FileIO::getFileTime(buildingMarkerFilename, markerTime))
+		return false;
+	return (std::time(nullptr) - markerTime < MAX_COMPILATION_TIME);
+}
+
+void NativizedModCache::startCompilation(const std::wstring& basename)
+{
+	std::string command = Configuration::instance().mModNativization.mCompileCommand;
+	if (command.empty())
+		return;
+
+	// Compile into a temporary file first that gets renamed when complete, so no instance ever loads a partially written library
+	const uint64 uniqueId = (uint64)std::chrono::steady_clock::now().time_since_epoch().count();
+	const std::wstring sourceFilename = basename + L".cpp";
+	const std::wstring tempFilename = basename + L"_" + String(rmx::hexString(uniqueId, 16, "")).toStdWString() + L"." + LIBRARY_EXTENSION;
+	const std::wstring libraryFilename = basename + L"." + LIBRARY_EXTENSION;
+	const std::wstring buildingMarkerFilename = basename + L".building";
+	const std::wstring failedMarkerFilename = basename + L".failed";
+
+	replaceAll(command, "$(SOURCE)", "\"" + WString(sourceFilename).toUTF8().toStdString() + "\"");
+	replaceAll(command, "$(OUTPUT)", "\"" + WString(tempFilename).toUTF8().toStdString() + "\"");
+	RMX_LOG_INFO("Building nativized library: " << command);
+
+	rmx::FileIO::saveFile(buildingMarkerFilename, nullptr, 0);
+
+	// Run the compiler in the background, the result is only needed for the next start anyways
+	//  -> The thread gets detached, so quitting does not have to wait for the compiler; an interrupted build leaves only a building marker that expires, and a temp file that never gets loaded
+	//  -> As it may still run during shutdown, the thread only touches files and does no logging
+	std::thread([command, tempFilename, libraryFilename, buildingMarkerFilename, failedMarkerFilename]()
+	{
+		const int result = std::system(command.c_str());
+		if (result == 0 && rmx::FileIO::exists(tempFilename))
+		{
+			if (!rmx::FileIO::renameFile(tempFilename, libraryFilename))
+			{
+				// Most likely another instance has built and loaded the very same library in the meantime
+				rmx::FileIO::removeFile(tempFilename);
+			}
+		}
+		else
+		{
+			rmx::FileIO::removeFile(tempFilename);
+			rmx::FileIO::saveFile(failedMarkerFilename, nullptr, 0);
+		}
+		rmx::FileIO::removeFile(buildingMarkerFilename);
+	}).detach();
+}
@@ -0,0 +1,42 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#pragma once
+
+#include <lemon/runtime/provider/NativizedOpcodeProvider.h>
+
+namespace lemon
+{
+	class MemoryAccessHandler;
+	class Module;
+	class Program;
+}
+
+
+// Cache for nativized mod scripts, which get built as shared libraries using a compiler command from the configuration
+//  -> Cache entries are identified by a hash over the compiled opcodes of a mod's script module, so any change to the scripts leads to a new entry
+//  -> For mods without a cache entry, the nativized source gets written and optionally compiled in the background, to be picked up on the next start
+//  -> Marker files next to the cache entries tell other instances about running compilations, and prevent rebuilding entries that failed before
+class NativizedModCache
+{
+public:
+	void applyToProgram(lemon::Program& program, const std::vector<lemon::Module*>& modModules, lemon::MemoryAccessHandler& memoryAccessHandler);
+
+private:
+	uint64 getModuleHash(const lemon::Module& module) const;
+	void* loadLibrary(const std::wstring& filename);
+	bool isCompilationRunning(const std::wstring& buildingMarkerFilename) const;
+	void startCompilation(const std::wstring& basename);
+
+private:
+	bool mInitialized = false;
+	lemon::NativizedOpcodeProvider* mGameProvider = nullptr;	// Provider registered by the game itself, if there's any
+	lemon::NativizedOpcodeProvider mOwnProvider;				// Only used if the game does not register a provider of its own
+	std::map<uint64, void*> mLoadedLibraries;					// Using the module hash as key; libraries never get unloaded, as runtime opcodes may still refer to their code
+	std::set<uint64> mStartedCompilations;
+};
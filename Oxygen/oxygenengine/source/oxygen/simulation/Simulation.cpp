@@ -77,8 +77,15 @@ bool Simulation::startup()
 
 	if (config.mGameRecorder.mIsPlayback)
 	{
-		// Try the long and short name
-		if (mGameRecorder.loadRecording(L"gamerecording.bin"))
+		// Try an explicitly given file name, or the long and short default name
+		if (!config.mGameRecorder.mPlaybackFilename.empty())
+		{
+			if (mGameRecorder.loadRecording(config.mGameRecorder.mPlaybackFilename))
+			{
+				RMX_LOG_INFO("Playback of '" << WString(config.mGameRecorder.mPlaybackFilename).toStdString() << "'");
+			}
+		}
+		else if (mGameRecorder.loadRecording(L"gamerecording.bin"))
 		{
 			RMX_LOG_INFO("Playback of 'gamerecording.bin'");
 		}
@@ -198,16 +205,19 @@ bool Simulation::loadState(const std::wstring& filename, bool showError)
 	return true;
 }
 
-void Simulation::saveState(const std::wstring& filename)
+void Simulation::saveState(const std::wstring& filename, bool saveScreenshot)
 {
 	SaveStateSerializer serializer(mCodeExec, RenderParts::instance());
 	const bool success = serializer.saveState(filename);
 	RMX_CHECK(success, "Failed to save save state '" << WString(filename).toStdString() << "'", return);
 
 	// Also save a screenshot
-	Bitmap bmp;
-	VideoOut::instance().getScreenshot(bmp);
-	bmp.save(filename + L".bmp");
+	if (saveScreenshot)
+	{
+		Bitmap bmp;
+		VideoOut::instance().getScreenshot(bmp);
+		bmp.save(filename + L".bmp");
+	}
 
 	// Set as default for "reloadLastState"
 	mStateLoaded = filename;
@@ -478,6 +488,11 @@ void Simulation::refreshDebugging()
 	VideoOut::instance().postRefreshDebugging();
 }
 
+bool Simulation::isPlayingGameRecording() const
+{
+	return mGameRecorder.isPlaying();
+}
+
 uint32 Simulation::saveGameRecording(WString* outFilename)
 {
 	std::wstring filename = L"gamerecording.bin";
@@ -41,7 +41,7 @@ public:
 
 	void reloadLastState();
 	bool loadState(const std::wstring& filename, bool showError = true);
-	void saveState(const std::wstring& filename);
+	void saveState(const std::wstring& filename, bool saveScreenshot = true);
 
 	bool triggerFullScriptsReload();
 
@@ -63,6 +63,7 @@ public:
 
 	void refreshDebugging();
 
+	bool isPlayingGameRecording() const;
 	uint32 saveGameRecording(WString* outFilename = nullptr);
 
 private:
@@ -11,6 +11,7 @@
 #include "oxygen/simulation/sound/blip_buf.h"
 #include "oxygen/simulation/sound/sn76489.h"
 #include "oxygen/simulation/sound/ym2612.h"
+#include "oxygen/application/Configuration.h"
 #include "oxygen/helper/FileHelper.h"
 
 
@@ -42,6 +43,7 @@ bool SoundEmulation::init(int samplerate, double framerate)
 	// Initialize FM chip (YM2612)
 	mInternal.mYM2612.init();
 	mInternal.mYM2612.config(14);
+	mInternal.mYM2612.setBlockProcessing(Configuration::instance().mUseFMBlockProcessing);
 	fm_cycles_ratio = 144 * 7;		// Chip is running a VCLK / 144 = MCLK / 7 / 144
 
 	// Initialize PSG chip
@@ -142,6 +142,16 @@
 #include "oxygen/pch.h"
 #include "oxygen/simulation/sound/ym2612.h"
 
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__)) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define KERNELS_X86
+	#include <immintrin.h>
+	#if defined(_MSC_VER) && !defined(__clang__)
+		#define TARGET_AVX2
+	#else
+		#define TARGET_AVX2 __attribute__((target("avx2")))
+	#endif
+#endif
+
 
 namespace soundemulation
 {
@@ -1303,6 +1313,61 @@ namespace soundemulation
 		return tl_tab[p];
 	}
 
+	/* operator evaluation for a block of samples, used by block processing */
+	/* output of each sample is the same as in chan_calc (i.e. zero if EG output is quiet, op_calc otherwise), and gets added to the target */
+	typedef void(*op_calc_block_func)(int32 *target, const uint32 *phase, const uint32 *env, const int32 *pm, int length);
+
+	void op_calc_block_scalar(int32 *target, const uint32 *phase, const uint32 *env, const int32 *pm, int length)
+	{
+		for (int i = 0; i < length; ++i)
+		{
+			if (env[i] < ENV_QUIET)
+				target[i] += op_calc(phase[i], env[i], pm[i]);
+		}
+	}
+
+#if defined(KERNELS_X86)
+	TARGET_AVX2 void op_calc_block_avx2(int32 *target, const uint32 *phase, const uint32 *env, const int32 *pm, int length)
+	{
+		/* 8 samples at once, using gathers for the sin_tab and tl_tab lookups */
+		const __m256i sinMask = _mm256_set1_epi32(SIN_MASK);
+		const __m256i maxEnv = _mm256_set1_epi32(ENV_QUIET - 1);
+		const __m256i tlTabLen = _mm256_set1_epi32(TL_TAB_LEN);
+		int i = 0;
+		for (; i + 8 <= length; i += 8)
+		{
+			const __m256i phase8 = _mm256_loadu_si256((const __m256i*)&phase[i]);
+			const __m256i env8 = _mm256_loadu_si256((const __m256i*)&env[i]);
+			const __m256i pm8 = _mm256_loadu_si256((const __m256i*)&pm[i]);
+
+			const __m256i index = _mm256_and_si256(_mm256_add_epi32(_mm256_srli_epi32(phase8, SIN_BITS), _mm256_srli_epi32(pm8, 1)), sinMask);
+			const __m256i p = _mm256_add_epi32(_mm256_slli_epi32(env8, 3), _mm256_i32gather_epi32((const int*)sin_tab, index, 4));
+			const __m256i inRange = _mm256_and_si256(_mm256_cmpeq_epi32(_mm256_min_epu32(env8, maxEnv), env8), _mm256_cmpgt_epi32(tlTabLen, p));
+			const __m256i output = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), (const int*)tl_tab, _mm256_and_si256(p, inRange), inRange, 4);
+
+			_mm256_storeu_si256((__m256i*)&target[i], _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)&target[i]), output));
+		}
+		op_calc_block_scalar(&target[i], &phase[i], &env[i], &pm[i], length - i);
+	}
+#endif
+
+	/* select the fastest operator evaluation supported by the CPU; "EngineTests::testYM2612BlockProcessing" compares block against sample by sample processing */
+	op_calc_block_func select_op_calc_block()
+	{
+	#if defined(KERNELS_X86)
+		if (SDL_HasAVX2())
+			return &op_calc_block_avx2;
+	#endif
+		return &op_calc_block_scalar;
+	}
+
+	/* the selection is done only once and then shared by all YM2612 instances, which may be used on different threads */
+	op_calc_block_func get_op_calc_block()
+	{
+		static const op_calc_block_func func = select_op_calc_block();
+		return func;
+	}
+
 	void YM2612::chan_calc(FM_CH *channel, int num)
 	{
 		do
@@ -1355,33 +1420,284 @@ namespace soundemulation
 			channel->mem_value = mem;
 
 			/* update phase counters AFTER output calculations */
-			if (channel->pms)
+			advance_phase_channel(channel);
+
+			/* next channel */
+			channel++;
+		}
+		while (--num);
+	}
+
+	void YM2612::advance_phase_channel(FM_CH *channel)
+	{
+		if (channel->pms)
+		{
+			/* add support for 3 slot mode */
+			if ((OPN.ST.mode & 0xC0) && (channel == &channel[2]))
+			{
+				update_phase_lfo_slot(&channel->SLOT[SLOT1], channel->pms, OPN.SL3.block_fnum[1]);
+				update_phase_lfo_slot(&channel->SLOT[SLOT2], channel->pms, OPN.SL3.block_fnum[2]);
+				update_phase_lfo_slot(&channel->SLOT[SLOT3], channel->pms, OPN.SL3.block_fnum[0]);
+				update_phase_lfo_slot(&channel->SLOT[SLOT4], channel->pms, channel->block_fnum);
+			}
+			else
+			{
+				update_phase_lfo_channel(channel);
+			}
+		}
+		else  /* no LFO phase modulation */
+		{
+			channel->SLOT[SLOT1].phase += channel->SLOT[SLOT1].Incr;
+			channel->SLOT[SLOT2].phase += channel->SLOT[SLOT2].Incr;
+			channel->SLOT[SLOT3].phase += channel->SLOT[SLOT3].Incr;
+			channel->SLOT[SLOT4].phase += channel->SLOT[SLOT4].Incr;
+		}
+	}
+
+	/* Calculate the output of one channel for a whole block, from the recorded phases and EG outputs of its operators */
+	/* Instead of going through the operators sample by sample, each operator gets evaluated for all samples of the block, */
+	/* in an order that makes sure all of its inputs are known at that point: */
+	/*  - SLOT1 only depends on its own previous outputs (feedback), and its output gets used one sample later */
+	/*  - SLOT2 input (c1) only comes from SLOT1 */
+	/*  - MEM only gets written by SLOT1 and SLOT2, and its delayed value goes to m2 or c2 */
+	/*  - SLOT3 input (m2) only comes from MEM, and its output goes to c2 or the carrier */
+	/*  - SLOT4 input (c2) is complete after all of the above */
+	void YM2612::chan_calc_block(FM_CH *channel, const uint32 (*phase)[BLOCK_SIZE], const uint32 (*env)[BLOCK_SIZE], int32 *output, int length)
+	{
+		const op_calc_block_func op_calc_block = get_op_calc_block();
+		enum { NODE_M2, NODE_C1, NODE_C2, NODE_MEM, NODE_OUT, NUM_NODES };
+		const auto getNode = [&](const int32* connect)
+		{
+			return (connect == &m2) ? NODE_M2 : (connect == &c1) ? NODE_C1 : (connect == &c2) ? NODE_C2 : (connect == &mem) ? NODE_MEM : NODE_OUT;
+		};
+
+		int32 nodes[NUM_NODES][BLOCK_SIZE];
+		for (int k = 0; k < NUM_NODES; ++k)
+			memset(nodes[k], 0, length * sizeof(int32));
+
+		/* SLOT 1 */
+		int32 op1_prev[BLOCK_SIZE];
+		if (channel->FB)
+		{
+			for (int i = 0; i < length; ++i)
+			{
+				int32 out = channel->op1_out[0] + channel->op1_out[1];
+				channel->op1_out[0] = channel->op1_out[1];
+				op1_prev[i] = channel->op1_out[0];
+
+				channel->op1_out[1] = 0;
+				if (env[SLOT1][i] < ENV_QUIET)
+					channel->op1_out[1] = op_calc1(phase[SLOT1][i], env[SLOT1][i], (out << channel->FB));
+			}
+		}
+		else
+		{
+			/* without feedback, all samples are independent of each other */
+			static const int32 NO_MODULATION[BLOCK_SIZE] = { 0 };
+			int32 op1_out[BLOCK_SIZE];
+			memset(op1_out, 0, length * sizeof(int32));
+			op_calc_block(op1_out, phase[SLOT1], env[SLOT1], NO_MODULATION, length);
+
+			op1_prev[0] = channel->op1_out[1];
+			for (int i = 1; i < length; ++i)
+				op1_prev[i] = op1_out[i - 1];
+			channel->op1_out[0] = op1_prev[length - 1];
+			channel->op1_out[1] = op1_out[length - 1];
+		}
+
+		if (!channel->connect1)
+		{
+			/* algorithm 5  */
+			memcpy(nodes[NODE_MEM], op1_prev, length * sizeof(int32));
+			memcpy(nodes[NODE_C1], op1_prev, length * sizeof(int32));
+			memcpy(nodes[NODE_C2], op1_prev, length * sizeof(int32));
+		}
+		else
+		{
+			/* other algorithms */
+			int32* target = nodes[getNode(channel->connect1)];
+			for (int i = 0; i < length; ++i)
+				target[i] += op1_prev[i];
+		}
+
+		/* SLOT 2 */
+		op_calc_block(nodes[getNode(channel->connect2)], phase[SLOT2], env[SLOT2], nodes[NODE_C1], length);
+
+		/* delayed sample (MEM) to m2 or c2 */
+		const int memNode = getNode(channel->mem_connect);
+		if (memNode != NODE_MEM)	/* otherwise MEM is not used and keeps its value */
+		{
+			int32* target = nodes[memNode];
+			target[0] += channel->mem_value;
+			for (int i = 1; i < length; ++i)
+				target[i] += nodes[NODE_MEM][i - 1];
+			channel->mem_value = nodes[NODE_MEM][length - 1];
+		}
+
+		/* SLOT 3 */
+		op_calc_block(nodes[getNode(channel->connect3)], phase[SLOT3], env[SLOT3], nodes[NODE_M2], length);
+
+		/* SLOT 4 */
+		op_calc_block(nodes[NODE_OUT], phase[SLOT4], env[SLOT4], nodes[NODE_C2], length);
+
+		memcpy(output, nodes[NODE_OUT], length * sizeof(int32));
+	}
+
+	/* Generate a block of samples using block processing */
+	/* First run everything that does not depend on the operator outputs sample by sample, and record phases and EG outputs */
+	/* Then calculate the channel outputs for the whole block */
+	void YM2612::update_block(int *buffer, int length)
+	{
+		uint32 phase[6][4][BLOCK_SIZE];
+		uint32 env[6][4][BLOCK_SIZE];
+		bool audible[6] = { false };
+
+		const int numChannels = dacen ? 5 : 6;
+
+		/* check which channels have a linear phase progression during this block, i.e. no LFO phase modulation, no SSG-EG and no CSM */
+		/* their phase counters get calculated afterwards for the whole block at once */
+		/* also check for channels that stay silent for the whole block, as all their operators are off (this can only change with a key on) */
+		bool anySSG = false;
+		bool linearPhase[6];
+		bool silent[6];
+		for (int c = 0; c < 6; ++c)
+		{
+			const FM_CH* channel = &mChannels[c];
+			const bool ssg = ((channel->SLOT[0].ssg | channel->SLOT[1].ssg | channel->SLOT[2].ssg | channel->SLOT[3].ssg) & 0x08) != 0;
+			const bool csm = (c == 2 && (OPN.ST.mode & 0xC0));
+			anySSG |= ssg;
+			linearPhase[c] = !channel->pms && !ssg && !csm;
+			silent[c] = !csm;
+			for (int s = 0; s < 4; ++s)
+				silent[c] &= (channel->SLOT[s].state == EG_OFF && channel->SLOT[s].vol_out >= ENV_QUIET);
+		}
+
+		for (int i = 0; i < length; i++)
+		{
+			/* update SSG-EG output */
+			if (anySSG)
+				update_ssg_eg_channels(&mChannels[0]);
+
+			/* record operator state, then update phase counters like in chan_calc */
+			for (int c = 0; c < numChannels; ++c)
 			{
-				/* add support for 3 slot mode */
-				if ((OPN.ST.mode & 0xC0) && (channel == &channel[2]))
+				FM_CH* channel = &mChannels[c];
+				if (!silent[c])
 				{
-					update_phase_lfo_slot(&channel->SLOT[SLOT1], channel->pms, OPN.SL3.block_fnum[1]);
-					update_phase_lfo_slot(&channel->SLOT[SLOT2], channel->pms, OPN.SL3.block_fnum[2]);
-					update_phase_lfo_slot(&channel->SLOT[SLOT3], channel->pms, OPN.SL3.block_fnum[0]);
-					update_phase_lfo_slot(&channel->SLOT[SLOT4], channel->pms, channel->block_fnum);
+					const uint32 AM = OPN.LFO_AM >> channel->ams;
+					for (int s = 0; s < 4; ++s)
+					{
+						env[c][s][i] = volume_calc(&channel->SLOT[s]);
+						audible[c] |= (env[c][s][i] < ENV_QUIET);
+					}
 				}
-				else
+				if (!linearPhase[c])
 				{
-					update_phase_lfo_channel(channel);
+					for (int s = 0; s < 4; ++s)
+						phase[c][s][i] = channel->SLOT[s].phase;
+					advance_phase_channel(channel);
 				}
 			}
-			else  /* no LFO phase modulation */
+
+			/* advance LFO */
+			advance_lfo();
+
+			/* advance envelope generator */
+			OPN.eg_timer++;
+
+			/* EG is updated every 3 samples */
+			if (OPN.eg_timer >= 3)
 			{
-				channel->SLOT[SLOT1].phase += channel->SLOT[SLOT1].Incr;
-				channel->SLOT[SLOT2].phase += channel->SLOT[SLOT2].Incr;
-				channel->SLOT[SLOT3].phase += channel->SLOT[SLOT3].Incr;
-				channel->SLOT[SLOT4].phase += channel->SLOT[SLOT4].Incr;
+				OPN.eg_timer = 0;
+				OPN.eg_cnt++;
+				advance_eg_channels(&mChannels[0], OPN.eg_cnt);
 			}
 
-			/* next channel */
-			channel++;
+			/* CSM mode: if CSM Key ON has occured, CSM Key OFF need to be sent       */
+			/* only if Timer A does not overflow again (i.e CSM Key ON not set again) */
+			OPN.SL3.key_csm <<= 1;
+
+			/* timer A control */
+			INTERNAL_TIMER_A();
+
+			/* CSM Mode Key ON still disabled */
+			if (OPN.SL3.key_csm & 2)
+			{
+				/* CSM Mode Key OFF (verified by Nemesis on real hardware) */
+				FM_KEYOFF_CSM(&mChannels[2], SLOT1);
+				FM_KEYOFF_CSM(&mChannels[2], SLOT2);
+				FM_KEYOFF_CSM(&mChannels[2], SLOT3);
+				FM_KEYOFF_CSM(&mChannels[2], SLOT4);
+				OPN.SL3.key_csm = 0;
+			}
+		}
+
+		/* calculate FM */
+		int32 left[BLOCK_SIZE];
+		int32 right[BLOCK_SIZE];
+		int32 output[BLOCK_SIZE];
+		memset(left, 0, length * sizeof(int32));
+		memset(right, 0, length * sizeof(int32));
+		for (int c = 0; c < 6; ++c)
+		{
+			FM_CH* channel = &mChannels[c];
+			if (c >= numChannels)
+			{
+				/* DAC Mode */
+				for (int i = 0; i < length; i++)
+					output[i] = dacout;
+			}
+			else
+			{
+				/* output can only be non-zero if any operator is audible, or there's something left in the delayed samples */
+				const bool calculate = (audible[c] || channel->op1_out[0] || channel->op1_out[1] || channel->mem_value);
+
+				/* update linear phase counters */
+				if (linearPhase[c])
+				{
+					for (int s = 0; s < 4; ++s)
+					{
+						FM_SLOT* SLOT = &channel->SLOT[s];
+						if (calculate)
+						{
+							for (int i = 0; i < length; i++)
+								phase[c][s][i] = SLOT->phase + (uint32)SLOT->Incr * i;
+						}
+						SLOT->phase += (uint32)SLOT->Incr * length;
+					}
+				}
+
+				if (!calculate)
+					continue;
+
+				if (silent[c])
+				{
+					/* EG outputs were not recorded, but they're all quiet anyway */
+					for (int s = 0; s < 4; ++s)
+						for (int i = 0; i < length; i++)
+							env[c][s][i] = ENV_QUIET;
+				}
+
+				chan_calc_block(channel, phase[c], env[c], output, length);
+			}
+
+			/* 14-bit accumulator channels outputs (range is -8192;+8192), and stereo DAC channels outputs mixing */
+			const int32 panLeft = OPN.pan[c * 2];
+			const int32 panRight = OPN.pan[c * 2 + 1];
+			for (int i = 0; i < length; i++)
+			{
+				const int32 out = (output[i] > 8192) ? 8192 : (output[i] < -8192) ? -8192 : output[i];
+				left[i] += out & panLeft;
+				right[i] += out & panRight;
+			}
+		}
+
+		/* buffering */
+		for (int i = 0; i < length; i++)
+		{
+			*buffer++ = left[i];
+			*buffer++ = right[i];
 		}
-		while (--num);
 	}
 
 	/* write a OPN mode register 0x20-0x2f */
@@ -1890,6 +2206,18 @@ namespace soundemulation
 		refresh_fc_eg_chan(&mChannels[4]);
 		refresh_fc_eg_chan(&mChannels[5]);
 
+		if (mBlockProcessing)
+		{
+			for (int i = 0; i < length; i += BLOCK_SIZE)
+			{
+				update_block(&buffer[i * 2], std::min(length - i, BLOCK_SIZE));
+			}
+
+			/* timer B control */
+			INTERNAL_TIMER_B(length);
+			return;
+		}
+
 		/* buffering */
 		for (int i = 0; i < length; i++)
 		{
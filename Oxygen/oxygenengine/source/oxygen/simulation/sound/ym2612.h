@@ -39,7 +39,12 @@ namespace soundemulation
 		void update(int *buffer, int length);
 		void write(unsigned int a, unsigned int v);
 
+		/* block processing evaluates each operator for a whole block of samples at once, with the exact same output as sample by sample processing */
+		inline void setBlockProcessing(bool enable)  { mBlockProcessing = enable; }
+
 	private:
+		static const constexpr int BLOCK_SIZE = 64;	/* maximum number of samples per block in block processing */
+
 		struct FM_SLOT	/* struct describing a single operator (SLOT) */
 		{
 			int32   *DT;        /* detune          :dt_tab[DT]      */
@@ -168,9 +173,12 @@ namespace soundemulation
 		void update_ssg_eg_channels(FM_CH *CH);
 		void update_phase_lfo_slot(FM_SLOT *SLOT, int32 pms, uint32 block_fnum);
 		void update_phase_lfo_channel(FM_CH *CH);
+		void advance_phase_channel(FM_CH *CH);
 		void refresh_fc_eg_slot(FM_SLOT *SLOT, unsigned int fc, unsigned int kc);
 		void refresh_fc_eg_chan(FM_CH *CH);
 		void chan_calc(FM_CH *CH, int num);
+		void update_block(int *buffer, int length);
+		void chan_calc_block(FM_CH *CH, const uint32 (*phase)[BLOCK_SIZE], const uint32 (*env)[BLOCK_SIZE], int32 *output, int length);
 		void OPNWriteMode(int r, int v);
 		void OPNWriteReg(int r, int v);
 		static void reset_channels(FM_CH *CH, int num);
@@ -186,5 +194,7 @@ namespace soundemulation
 		int32  mem;        /* one sample delay memory */
 		int32  out_fm[8];  /* outputs of working channels */
 		uint32 bitmask;    /* working channels output bitmasking (DAC quantization) */
+
+		bool   mBlockProcessing;	/* use block processing instead of sample by sample processing */
 	};
 }
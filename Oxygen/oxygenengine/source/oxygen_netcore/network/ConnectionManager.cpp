@@ -19,13 +19,24 @@ ConnectionManager::ConnectionManager(UDPSocket* udpSocket, TCPSocket* tcpListenS
 	mListener(listener),
 	mHighLevelProtocolVersionRange(highLevelProtocolVersionRange)
 {
-	mActiveConnections.reserve(8);
 	mActiveConnectionsLookup.resize(8);
 	mBitmaskForActiveConnectionsLookup = (uint16)(mActiveConnectionsLookup.size() - 1);
 }
 
+ConnectionManager::~ConnectionManager()
+{
+	flushSendBatch();
+	stopReceiveThread();
+	stopSocketPoller();
+}
+
 void ConnectionManager::updateConnections(uint64 currentTimestamp)
 {
+	// Update all connections together at a fixed rate, instead of going through all of them whenever this gets called
+	if (currentTimestamp < mNextConnectionsUpdateTimestamp)
+		return;
+	mNextConnectionsUpdateTimestamp = currentTimestamp + CONNECTIONS_UPDATE_INTERVAL;
+
 	for (NetConnection* connection : mActiveConnectionsLookup)
 	{
 		if (nullptr != connection)
@@ -34,6 +45,9 @@ void ConnectionManager::updateConnections(uint64 currentTimestamp)
 			connection->updateConnection(currentTimestamp);
 		}
 	}
+
+	// Send out everything queued by the connection updates, in particular the resends
+	flushSendBatch();
 }
 
 bool ConnectionManager::updateReceivePackets()
@@ -41,27 +55,47 @@ bool ConnectionManager::updateReceivePackets()
 	bool anyActivity = !mReceivedPackets.mWorkerQueue.empty();
 
 	// Update UDP
-	if (nullptr != mUDPSocket)
+	if (mReceiveThread.mRunning)
 	{
-		for (int runs = 0; runs < 10; ++runs)
+		// Take over what the receive thread got so far
+		//  -> Limit the number of packets handled at once, so that a burst of packets does not delay connection updates too much
+		for (int runs = 0; runs < 0x100; ++runs)
 		{
-			// Receive next packet
-			static UDPSocket::ReceiveResult received;
-			const bool success = mUDPSocket->receiveNonBlocking(received);
-			if (!success)
-			{
-				// TODO: Handle error in socket
-				return false;
-			}
+			UDPSocket::ReceiveResult* datagram = nullptr;
+			if (!mReceiveThread.mReceivedQueue.tryPop(datagram))
+				break;
+
+			anyActivity = true;
+			receivedPacketInternal(datagram->mData, datagram->mLength, datagram->mSenderAddress, nullptr);
 
-			if (received.mBuffer.empty())
+			// Hand the buffer back to the receive thread
+			mReceiveThread.mFreeQueue.tryPush(datagram);
+		}
+	}
+	else if (nullptr != mUDPSocket)
+	{
+		if (mReceiveBatch.mDatagrams.empty())
+		{
+			mReceiveBatch.mDatagrams.resize(ReceiveBatch::NUM_DATAGRAMS);
+			mReceiveBatch.mPointers.resize(ReceiveBatch::NUM_DATAGRAMS);
+			for (size_t k = 0; k < ReceiveBatch::NUM_DATAGRAMS; ++k)
 			{
-				// Nothing to do at the moment
-				break;
+				mReceiveBatch.mPointers[k] = &mReceiveBatch.mDatagrams[k];
 			}
+		}
 
+		// Receive as many packets as are available, up to the batch size
+		size_t numReceived = 0;
+		if (!mUDPSocket->receiveBatchNonBlocking(&mReceiveBatch.mPointers[0], ReceiveBatch::NUM_DATAGRAMS, numReceived))
+		{
+			// TODO: Handle error in socket
+			return false;
+		}
+
+		for (size_t k = 0; k < numReceived; ++k)
+		{
 			anyActivity = true;
-			receivedPacketInternal(received.mBuffer, received.mSenderAddress, nullptr);
+			receivedPacketInternal(mReceiveBatch.mDatagrams[k].mData, mReceiveBatch.mDatagrams[k].mLength, mReceiveBatch.mDatagrams[k].mSenderAddress, nullptr);
 		}
 	}
 
@@ -83,49 +117,243 @@ bool ConnectionManager::updateReceivePackets()
 	}
 
 	// Update net connections' TCP sockets
+	if (mSocketPoller.isValid())
+	{
+		// Check for socket activity without waiting if there was no wait since the last update
+		//  -> "waitForActivity" usually does not get called while there's other activity, so constant UDP traffic would starve TCP connections otherwise
+		if (mSocketEvents.empty())
+		{
+			mSocketPoller.waitForEvents(mSocketEvents, 0);
+		}
+
+		// Only the connections with socket activity need to be looked at
+		for (const SocketPoller::Event& event : mSocketEvents)
+		{
+			if (event.mUserData == 0)	// UDP socket or TCP listen socket, these get checked above anyway
+				continue;
+
+			NetConnection* connection = findConnectionByLocalID((uint16)event.mUserData);
+			if (nullptr == connection || connection->mSocketType != NetConnection::SocketType::TCP_SOCKET)
+				continue;
+
+			bool success = true;
+			if (event.mReadable)
+			{
+				success = receiveTCPInternal(*connection, anyActivity);
+			}
+			if (!success || event.mClosed)
+			{
+				// The socket would get reported over and over again otherwise
+				anyActivity = true;
+				connection->disconnect(NetConnection::DisconnectReason::UNKNOWN);
+			}
+		}
+		mSocketEvents.clear();
+	}
+	else
+	{
+		for (NetConnection* connection : mTCPNetConnections)
+		{
+			if (!receiveTCPInternal(*connection, anyActivity))
+			{
+				// TODO: Handle error in socket
+				return false;
+			}
+		}
+	}
+
+	return anyActivity;
+}
+
+void ConnectionManager::startReceiveThread()
+{
+	if (mReceiveThread.mRunning || nullptr == mUDPSocket)
+		return;
+
+	// All buffers start in the free queue
+	mReceiveThread.mDatagrams.resize(ReceiveThread::NUM_DATAGRAMS);
+	for (UDPSocket::ReceiveResult& datagram : mReceiveThread.mDatagrams)
+	{
+		mReceiveThread.mFreeQueue.tryPush(&datagram);
+	}
+
+	// The UDP socket is the receive thread's business from now on
+	if (mSocketPoller.isValid())
+	{
+		mSocketPoller.removeSocket(*mUDPSocket);
+	}
+
+	mReceiveThread.mRunning = true;
+	mReceiveThread.mThread = std::thread([this] { runReceiveThread(); });
+}
+
+void ConnectionManager::stopReceiveThread()
+{
+	if (!mReceiveThread.mRunning)
+		return;
+
+	mReceiveThread.mRunning = false;
+	mReceiveThread.mThread.join();
+
+	// With the thread gone, both queues can simply be emptied from here
+	UDPSocket::ReceiveResult* datagram = nullptr;
+	while (mReceiveThread.mReceivedQueue.tryPop(datagram)) {}
+	while (mReceiveThread.mFreeQueue.tryPop(datagram)) {}
+	mReceiveThread.mDatagrams.clear();
+
+	if (mSocketPoller.isValid())
+	{
+		mSocketPoller.addSocket(*mUDPSocket, 0);
+	}
+}
+
+bool ConnectionManager::startSocketPoller()
+{
+	if (mSocketPoller.isValid())
+		return true;
+	if (!mSocketPoller.initialize())
+		return false;
+
+	// The UDP socket and the TCP listen socket are still checked in each update anyway, they're only watched here to end waits
+	if (nullptr != mUDPSocket && !mReceiveThread.mRunning)
+	{
+		mSocketPoller.addSocket(*mUDPSocket, 0);
+	}
+	if (nullptr != mTCPListenSocket)
+	{
+		mSocketPoller.addSocket(*mTCPListenSocket, 0);
+	}
+
+	// TCP connections use their local connection ID, so events can be matched to them later on
 	for (NetConnection* connection : mTCPNetConnections)
 	{
-		// Receive next packet
-		static TCPSocket::ReceiveResult received;
-		const bool success = connection->mTCPSocket.receiveNonBlocking(received);
-		if (!success)
+		mSocketPoller.addSocket(connection->mTCPSocket, connection->getLocalConnectionID());
+	}
+
+	mReceiveThread.mWakeUpSocketPoller = true;
+	return true;
+}
+
+void ConnectionManager::stopSocketPoller()
+{
+	if (!mSocketPoller.isValid())
+		return;
+
+	mReceiveThread.mWakeUpSocketPoller = false;
+	mSocketPoller.close();
+	mSocketEvents.clear();
+}
+
+void ConnectionManager::waitForActivity(uint64 currentTimestamp, uint32 maxMilliseconds)
+{
+	// Nothing queued for sending should be held back while waiting
+	flushSendBatch();
+
+	// Do not wait past the next connections update, as resending and timeouts depend on it
+	if (currentTimestamp >= mNextConnectionsUpdateTimestamp)
+		return;
+	const uint32 timeoutMilliseconds = (uint32)std::min<uint64>(maxMilliseconds, mNextConnectionsUpdateTimestamp - currentTimestamp);
+
+	if (mSocketPoller.isValid())
+	{
+		// Gets woken up right away by socket activity, or by the receive thread
+		if (!mReceiveThread.mWaitInterrupted.exchange(false))
 		{
-			// TODO: Handle error in socket
-			return false;
+			mSocketPoller.waitForEvents(mSocketEvents, timeoutMilliseconds);
 		}
+	}
+	else
+	{
+		// Gets woken up right away when the receive thread got new packets
+		//  -> Without receive thread, the UDP socket needs to be polled, so waits are kept short
+		std::unique_lock<std::mutex> lock(mReceiveThread.mWakeUpMutex);
+		mReceiveThread.mWakeUpCondition.wait_for(lock, std::chrono::milliseconds(std::min<uint32>(timeoutMilliseconds, 10)), [this] { return !mReceiveThread.mReceivedQueue.empty() || mReceiveThread.mWaitInterrupted.exchange(false); });
+	}
+}
 
-		if (!received.mBuffer.empty())
+void ConnectionManager::interruptWait()
+{
+	mReceiveThread.mWaitInterrupted = true;
+	if (mReceiveThread.mWakeUpSocketPoller)
+	{
+		mSocketPoller.wakeUp();
+	}
+	else
+	{
+		// See "runReceiveThread" on why the lock is taken
 		{
-			anyActivity = true;
-			if (connection->getState() == NetConnection::State::TCP_READY)
+			std::lock_guard<std::mutex> lock(mReceiveThread.mWakeUpMutex);
+		}
+		mReceiveThread.mWakeUpCondition.notify_one();
+	}
+}
+
+void ConnectionManager::runReceiveThread()
+{
+	// Free buffers taken over by this thread, but not filled yet
+	UDPSocket::ReceiveResult* datagrams[ReceiveThread::BATCH_SIZE];
+	size_t numDatagrams = 0;
+
+	while (mReceiveThread.mRunning)
+	{
+		// Wait for incoming data, but not too long, so that a stop gets noticed in time
+		if (!mUDPSocket->waitForData(50))
+			continue;
+
+		bool anyReceived = false;
+		while (true)
+		{
+			while (numDatagrams < ReceiveThread::BATCH_SIZE && mReceiveThread.mFreeQueue.tryPop(datagrams[numDatagrams]))
 			{
-				String webSocketKey;
-				if (WebSocketWrapper::handleWebSocketHttpHeader(received.mBuffer, webSocketKey))
-				{
-					String response;
-					WebSocketWrapper::getWebSocketHttpResponse(webSocketKey, response);
+				++numDatagrams;
+			}
+			if (numDatagrams == 0)
+			{
+				// All buffers are in use, the main thread needs to catch up first; until then, the data waits in the socket's own buffer
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				break;
+			}
 
-					connection->mIsWebSocketServer = true;
-					connection->mTCPSocket.sendData((const uint8*)response.getData(), response.length());
-					continue;
-				}
+			size_t numReceived = 0;
+			if (!mUDPSocket->receiveBatchNonBlocking(datagrams, numDatagrams, numReceived) || numReceived == 0)
+			{
+				// Nothing more to receive at the moment (keep the buffers for next time)
+				break;
 			}
 
-			if (connection->mIsWebSocketServer)
+			for (size_t k = 0; k < numReceived; ++k)
 			{
-				if (WebSocketWrapper::processReceivedClientPacket(received.mBuffer))
-				{
-					receivedPacketInternal(received.mBuffer, connection->getRemoteAddress(), connection);
-				}
+				mReceiveThread.mReceivedQueue.tryPush(datagrams[k]);	// Can't fail, as the queue can hold all buffers
 			}
-			else
+
+			// Move the remaining unused buffers to the front
+			for (size_t k = numReceived; k < numDatagrams; ++k)
 			{
-				receivedPacketInternal(received.mBuffer, connection->getRemoteAddress(), connection);
+				datagrams[k - numReceived] = datagrams[k];
+			}
+			numDatagrams -= numReceived;
+			anyReceived = true;
+		}
+
+		if (anyReceived)
+		{
+			// Taking the lock makes sure the main thread is either already waiting or will see the new packets before it starts to wait
+			{
+				std::lock_guard<std::mutex> lock(mReceiveThread.mWakeUpMutex);
+			}
+			mReceiveThread.mWakeUpCondition.notify_one();
+
+			if (mReceiveThread.mWakeUpSocketPoller)
+			{
+				mSocketPoller.wakeUp();
 			}
 		}
 	}
+}
 
-	return anyActivity;
+void ConnectionManager::injectReceivedDatagram(const uint8* data, size_t length, const SocketAddress& senderAddress)
+{
+	receivedPacketInternal(data, length, senderAddress, nullptr);
 }
 
 void ConnectionManager::syncPacketQueues()
@@ -135,11 +363,13 @@ void ConnectionManager::syncPacketQueues()
 
 	// First sync queues
 	{
-		while (!mReceivedPackets.mWorkerQueue.empty())
-		{
-			mReceivedPackets.mSyncedQueue.push_back(mReceivedPackets.mWorkerQueue.front());
-			mReceivedPackets.mWorkerQueue.pop_front();
-		}
+		// Remove packets already read
+		std::vector<ReceivedPacket*>& syncedQueue = mReceivedPackets.mSyncedQueue;
+		syncedQueue.erase(syncedQueue.begin(), syncedQueue.begin() + mReceivedPackets.mSyncedReadIndex);
+		mReceivedPackets.mSyncedReadIndex = 0;
+
+		syncedQueue.insert(syncedQueue.end(), mReceivedPackets.mWorkerQueue.begin(), mReceivedPackets.mWorkerQueue.end());
+		mReceivedPackets.mWorkerQueue.clear();
 	}
 
 	// Cleanup packets previously marked to be returned
@@ -156,11 +386,11 @@ void ConnectionManager::syncPacketQueues()
 
 ReceivedPacket* ConnectionManager::getNextReceivedPacket()
 {
-	if (mReceivedPackets.mSyncedQueue.empty())
+	if (!hasAnyPacket())
 		return nullptr;
 
-	ReceivedPacket* receivedPacket = mReceivedPackets.mSyncedQueue.front();
-	mReceivedPackets.mSyncedQueue.pop_front();
+	ReceivedPacket* receivedPacket = mReceivedPackets.mSyncedQueue[mReceivedPackets.mSyncedReadIndex];
+	++mReceivedPackets.mSyncedReadIndex;
 
 	// Packet initialization:
 	//  - Set the "dump" instance that packets get returned to when the reference counter reaches zero
@@ -181,9 +411,61 @@ bool ConnectionManager::sendUDPPacketData(const std::vector<uint8>& data, const
 #endif
 
 	RMX_ASSERT(nullptr != mUDPSocket, "No UDP socket set");
+	if (mSendBatch.mEnabled)
+	{
+		if (mSendBatch.mNumQueued >= mSendBatch.mDatagrams.size())
+		{
+			flushSendBatch();
+		}
+
+		// Copy the data, as the caller is free to reuse its buffer right away
+		SendBatch::Datagram& datagram = mSendBatch.mDatagrams[mSendBatch.mNumQueued];
+		datagram.mContent.assign(data.begin(), data.end());
+		datagram.mDestinationAddress.set(remoteAddress.getSockAddr());
+		++mSendBatch.mNumQueued;
+		return true;
+	}
 	return mUDPSocket->sendData(data, remoteAddress);
 }
 
+void ConnectionManager::setSendBatchingEnabled(bool enable)
+{
+	if (enable == mSendBatch.mEnabled)
+		return;
+
+	if (enable)
+	{
+		mSendBatch.mDatagrams.resize(SendBatch::NUM_DATAGRAMS);
+		mSendBatch.mSendItems.resize(SendBatch::NUM_DATAGRAMS);
+		for (SendBatch::Datagram& datagram : mSendBatch.mDatagrams)
+		{
+			datagram.mContent.reserve(0x800);
+		}
+	}
+	else
+	{
+		flushSendBatch();
+	}
+	mSendBatch.mEnabled = enable;
+}
+
+void ConnectionManager::flushSendBatch()
+{
+	if (mSendBatch.mNumQueued == 0)
+		return;
+
+	for (size_t k = 0; k < mSendBatch.mNumQueued; ++k)
+	{
+		const SendBatch::Datagram& datagram = mSendBatch.mDatagrams[k];
+		UDPSocket::SendItem& item = mSendBatch.mSendItems[k];
+		item.mData = datagram.mContent.data();
+		item.mLength = datagram.mContent.size();
+		item.mDestinationAddress = &datagram.mDestinationAddress;
+	}
+	mUDPSocket->sendDataBatch(&mSendBatch.mSendItems[0], mSendBatch.mNumQueued);
+	mSendBatch.mNumQueued = 0;
+}
+
 bool ConnectionManager::sendTCPPacketData(const std::vector<uint8>& data, TCPSocket& socket, bool isWebSocketServer)
 {
 #ifdef DEBUG
@@ -197,9 +479,8 @@ bool ConnectionManager::sendTCPPacketData(const std::vector<uint8>& data, TCPSoc
 
 	if (isWebSocketServer)
 	{
-		static std::vector<uint8> wrappedData;
-		WebSocketWrapper::wrapDataToSendToClient(data, wrappedData);
-		return socket.sendData(wrappedData);
+		WebSocketWrapper::wrapDataToSendToClient(data, mWebSocketSendBuffer);
+		return socket.sendData(mWebSocketSendBuffer);
 	}
 	else
 	{
@@ -210,7 +491,7 @@ bool ConnectionManager::sendTCPPacketData(const std::vector<uint8>& data, TCPSoc
 bool ConnectionManager::sendConnectionlessLowLevelPacket(lowlevel::PacketBase& lowLevelPacket, const SocketAddress& remoteAddress, uint16 localConnectionID, uint16 remoteConnectionID)
 {
 	// Write low-level packet header
-	static std::vector<uint8> sendBuffer;
+	std::vector<uint8>& sendBuffer = mConnectionlessSendBuffer;
 	sendBuffer.clear();
 
 	VectorBinarySerializer serializer(false, sendBuffer);
@@ -234,22 +515,30 @@ void ConnectionManager::addConnection(NetConnection& connection)
 	RMX_CHECK(localConnectionID != 0, "Error in connection management: Could not assign a valid connection ID", return);
 
 	connection.mLocalConnectionID = localConnectionID;
-	mActiveConnections[localConnectionID] = &connection;
 	mActiveConnectionsLookup[localConnectionID & mBitmaskForActiveConnectionsLookup] = &connection;
+	++mNumActiveConnections;
 	mConnectionsBySender[connection.getSenderKey()] = &connection;
 
 	if (connection.mSocketType == NetConnection::SocketType::TCP_SOCKET)
 	{
 		// Register as a TCP connection & socket to be polled regularly
 		mTCPNetConnections.push_back(&connection);
+		if (mSocketPoller.isValid())
+		{
+			mSocketPoller.addSocket(connection.mTCPSocket, localConnectionID);
+		}
 	}
 }
 
 void ConnectionManager::removeConnection(NetConnection& connection)
 {
 	// This method gets called from "NetConnection::clear", so it's safe to assume the connection gets cleaned up internally already
-	mActiveConnections.erase(connection.getLocalConnectionID());
-	mActiveConnectionsLookup[connection.getLocalConnectionID() & mBitmaskForActiveConnectionsLookup] = nullptr;
+	NetConnection*& lookupEntry = mActiveConnectionsLookup[connection.getLocalConnectionID() & mBitmaskForActiveConnectionsLookup];
+	if (lookupEntry == &connection)
+	{
+		lookupEntry = nullptr;
+		--mNumActiveConnections;
+	}
 	mConnectionsBySender.erase(connection.getSenderKey());
 
 	// TODO: Maybe reduce size of "mActiveConnectionsLookup" again if there's only few connections left - and if this does not produce any conflicts
@@ -257,6 +546,10 @@ void ConnectionManager::removeConnection(NetConnection& connection)
 	if (connection.mSocketType == NetConnection::SocketType::TCP_SOCKET)
 	{
 		// Unregister again
+		if (mSocketPoller.isValid())
+		{
+			mSocketPoller.removeSocket(connection.mTCPSocket);
+		}
 		for (size_t index = 0; index < mTCPNetConnections.size(); ++index)
 		{
 			if (&connection == mTCPNetConnections[index])
@@ -275,10 +568,10 @@ SentPacket& ConnectionManager::rentSentPacket()
 	return sentPacket;
 }
 
-void ConnectionManager::receivedPacketInternal(const std::vector<uint8>& buffer, const SocketAddress& senderAddress, NetConnection* connection)
+void ConnectionManager::receivedPacketInternal(const uint8* data, size_t length, const SocketAddress& senderAddress, NetConnection* connection)
 {
 	// Ignore too small packets
-	if (buffer.size() < 6)
+	if (length < 6)
 		return;
 
 #ifdef DEBUG
@@ -288,24 +581,18 @@ void ConnectionManager::receivedPacketInternal(const std::vector<uint8>& buffer,
 #endif
 
 	// Received a packet, check its signature
-	VectorBinarySerializer serializer(true, buffer);
-	const uint16 lowLevelSignature = serializer.read<uint16>();
+	const uint16 lowLevelSignature = rmx::readMemoryUnaligned<uint16>(&data[0]);
 	if (lowLevelSignature == lowlevel::StartConnectionPacket::SIGNATURE)
 	{
-		// Store for later evaluation
-		ReceivedPacket& receivedPacket = mReceivedPacketPool.rentObject();
-		receivedPacket.mContent = buffer;
-		receivedPacket.mLowLevelSignature = lowLevelSignature;
-		receivedPacket.mSenderAddress = senderAddress;
-		receivedPacket.mConnection = connection;
-		mReceivedPackets.mWorkerQueue.emplace_back(&receivedPacket);
+		// Store for later evaluation, including the sender address needed to accept the connection
+		queueReceivedPacket(data, length, lowLevelSignature, &senderAddress, connection);
 	}
 	else
 	{
 		// TODO: Explicitly check the known (= valid) signature types here?
 
-		const uint16 remoteConnectionID = serializer.read<uint16>();
-		const uint16 localConnectionID = serializer.read<uint16>();
+		const uint16 remoteConnectionID = rmx::readMemoryUnaligned<uint16>(&data[2]);
+		const uint16 localConnectionID = rmx::readMemoryUnaligned<uint16>(&data[4]);
 		if (localConnectionID == 0)
 		{
 			// Invalid connection
@@ -321,9 +608,7 @@ void ConnectionManager::receivedPacketInternal(const std::vector<uint8>& buffer,
 			if (nullptr == connection)
 			{
 				// Find the connection in our list of active connections
-				connection = mActiveConnectionsLookup[localConnectionID & mBitmaskForActiveConnectionsLookup];
-				if (nullptr != connection && connection->getLocalConnectionID() != localConnectionID)
-					connection = nullptr;
+				connection = findConnectionByLocalID(localConnectionID);
 			}
 
 			if (nullptr == connection)
@@ -348,6 +633,9 @@ void ConnectionManager::receivedPacketInternal(const std::vector<uint8>& buffer,
 					if (lowLevelSignature == lowlevel::ErrorPacket::SIGNATURE)
 					{
 						// Evaluate the error packet
+						const std::vector<uint8> content(data, data + length);
+						VectorBinarySerializer serializer(true, content);
+						serializer.skip(6);
 						lowlevel::ErrorPacket errorPacket;
 						errorPacket.serializePacket(serializer, lowlevel::PacketBase::LOWLEVEL_PROTOCOL_VERSIONS.mMinimum);
 						switch (errorPacket.mErrorCode)
@@ -372,23 +660,82 @@ void ConnectionManager::receivedPacketInternal(const std::vector<uint8>& buffer,
 				}
 				else
 				{
-					// Store for later evaluation
-					ReceivedPacket& receivedPacket = mReceivedPacketPool.rentObject();
-					receivedPacket.mContent = buffer;
-					receivedPacket.mLowLevelSignature = lowLevelSignature;
-					receivedPacket.mSenderAddress = senderAddress;
-					receivedPacket.mConnection = connection;
-					mReceivedPackets.mWorkerQueue.emplace_back(&receivedPacket);
+					// Store for later evaluation; the connection already knows its remote address
+					queueReceivedPacket(data, length, lowLevelSignature, nullptr, connection);
 				}
 			}
 		}
 	}
 }
 
+void ConnectionManager::queueReceivedPacket(const uint8* data, size_t length, uint16 lowLevelSignature, const SocketAddress* senderAddress, NetConnection* connection)
+{
+	// Pooled packet instances keep the capacity of their content, so copying the data usually does not need to allocate anything
+	ReceivedPacket& receivedPacket = mReceivedPacketPool.rentObject();
+	receivedPacket.mContent.assign(data, data + length);
+	receivedPacket.mLowLevelSignature = lowLevelSignature;
+	if (nullptr != senderAddress)
+	{
+		receivedPacket.mSenderAddress = *senderAddress;
+	}
+	else
+	{
+		receivedPacket.mSenderAddress.clear();
+	}
+	receivedPacket.mConnection = connection;
+	mReceivedPackets.mWorkerQueue.push_back(&receivedPacket);
+}
+
+bool ConnectionManager::receiveTCPInternal(NetConnection& connection, bool& outAnyActivity)
+{
+	// Receive next packet
+	TCPSocket::ReceiveResult& received = mTCPReceiveResult;
+	const bool success = connection.mTCPSocket.receiveNonBlocking(received);
+	if (!success)
+		return false;
+
+	if (received.mBuffer.empty())
+		return true;
+
+	outAnyActivity = true;
+	if (connection.getState() == NetConnection::State::TCP_READY)
+	{
+		String webSocketKey;
+		if (WebSocketWrapper::handleWebSocketHttpHeader(received.mBuffer, webSocketKey))
+		{
+			String response;
+			WebSocketWrapper::getWebSocketHttpResponse(webSocketKey, response);
+
+			connection.mIsWebSocketServer = true;
+			connection.mTCPSocket.sendData((const uint8*)response.getData(), response.length());
+			return true;
+		}
+	}
+
+	if (connection.mIsWebSocketServer)
+	{
+		if (WebSocketWrapper::processReceivedClientPacket(received.mBuffer))
+		{
+			receivedPacketInternal(received.mBuffer.data(), received.mBuffer.size(), connection.getRemoteAddress(), &connection);
+		}
+	}
+	else
+	{
+		receivedPacketInternal(received.mBuffer.data(), received.mBuffer.size(), connection.getRemoteAddress(), &connection);
+	}
+	return true;
+}
+
+NetConnection* ConnectionManager::findConnectionByLocalID(uint16 localConnectionID) const
+{
+	NetConnection* connection = mActiveConnectionsLookup[localConnectionID & mBitmaskForActiveConnectionsLookup];
+	return (nullptr != connection && connection->getLocalConnectionID() == localConnectionID) ? connection : nullptr;
+}
+
 uint16 ConnectionManager::getFreeLocalConnectionID()
 {
 	// Make sure the lookup is always large enough (not filled by more than 75%)
-	if (mActiveConnections.size() + 1 >= mActiveConnectionsLookup.size() * 3/4)
+	if (mNumActiveConnections + 1 >= mActiveConnectionsLookup.size() * 3/4)
 	{
 		const size_t oldSize = mActiveConnectionsLookup.size();
 		const size_t newSize = std::max<size_t>(mActiveConnectionsLookup.size() * 2, 32);
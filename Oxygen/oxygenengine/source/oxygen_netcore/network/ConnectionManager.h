@@ -10,8 +10,13 @@
 
 #include "oxygen_netcore/network/internal/SentPacketCache.h"
 #include "oxygen_netcore/network/internal/ReceivedPacket.h"
+#include "oxygen_netcore/network/internal/SPSCQueue.h"
 #include "oxygen_netcore/network/VersionRange.h"
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 namespace lowlevel
 {
 	struct PacketBase;
@@ -31,24 +36,60 @@ public:
 	};
 	DebugSettings mDebugSettings;
 
+	static const constexpr uint64 CONNECTIONS_UPDATE_INTERVAL = 100;	// In milliseconds, connections only need regular updates for resending and timeouts
+
 public:
 	ConnectionManager(UDPSocket* udpSocket, TCPSocket* tcpListenSocket, ConnectionListenerInterface& listener, VersionRange<uint8> highLevelProtocolVersionRange);
+	~ConnectionManager();
 
 	inline bool hasUDPSocket() const			  { return (nullptr != mUDPSocket); }
 	inline UDPSocket* getUDPSocket() const		  { return mUDPSocket; }
 	inline TCPSocket* getTCPListenSocket() const  { return mTCPListenSocket; }
 
 	inline ConnectionListenerInterface& getListener() const  { return mListener; }
-	inline size_t getNumActiveConnections() const			 { return mActiveConnections.size(); }
+	inline size_t getNumActiveConnections() const			 { return mNumActiveConnections; }
 
 	inline VersionRange<uint8> getHighLevelProtocolVersionRange() const  { return mHighLevelProtocolVersionRange; }
 
 	void updateConnections(uint64 currentTimestamp);
-	bool updateReceivePackets();	// TODO: This is meant to be executed by a thread later on
+	inline uint64 getNextConnectionsUpdateTimestamp() const  { return mNextConnectionsUpdateTimestamp; }
+	bool updateReceivePackets();
+
+	// Receiving from the UDP socket on a dedicated thread
+	//  -> While it is running, "updateReceivePackets" takes over the packets received by the thread instead of polling the UDP socket itself
+	//  -> Everything else, including sending, stays on the thread calling "updateReceivePackets"
+	void startReceiveThread();
+	void stopReceiveThread();
+	inline bool hasReceiveThread() const  { return mReceiveThread.mRunning; }
+
+	// Event-driven handling of the UDP socket (unless the receive thread takes care of it), the TCP listen socket and all TCP connections
+	//  -> While it is running, "updateReceivePackets" only looks at TCP connections the socket poller reported activity for, either in the last wait or in a non-blocking check of its own
+	//  -> Fails if the platform does not support it, see "SocketPoller::isSupported"
+	bool startSocketPoller();
+	void stopSocketPoller();
+	inline bool hasSocketPoller() const  { return mSocketPoller.isValid(); }
+
+	// Wait until there's something to do, i.e. new packets or socket activity, or the next connections update is due, but no longer than the given time
+	//  -> Without socket poller, TCP sockets still need to be polled, so waits are kept short in that case
+	void waitForActivity(uint64 currentTimestamp, uint32 maxMilliseconds);
+
+	// End the current or next wait in "waitForActivity" right away; unlike everything else here, this may be called from any thread
+	void interruptWait();
+
+	// Batched sending of UDP datagrams
+	//  -> While enabled, "sendUDPPacketData" only copies datagrams into a ring of preallocated buffers, which then get sent all together with as few system calls as possible
+	//  -> Queued datagrams get sent when the ring is full, at the end of "updateConnections" and before "waitForActivity" waits, or by an explicit call of "flushSendBatch"
+	void setSendBatchingEnabled(bool enable);
+	inline bool isSendBatchingEnabled() const  { return mSendBatch.mEnabled; }
+	void flushSendBatch();
+
+	// Handle a datagram as if it was received by the UDP socket, without any socket involved
+	//  -> Only meant for benchmarking and testing the receive path
+	void injectReceivedDatagram(const uint8* data, size_t length, const SocketAddress& senderAddress);
 
 	void syncPacketQueues();
 
-	inline bool hasAnyPacket() const  { return !mReceivedPackets.mSyncedQueue.empty(); }
+	inline bool hasAnyPacket() const  { return (mReceivedPackets.mSyncedReadIndex < mReceivedPackets.mSyncedQueue.size()); }
 	ReceivedPacket* getNextReceivedPacket();
 	std::list<TCPSocket>& getIncomingTCPConnections()  { return mIncomingTCPConnections; }
 
@@ -65,33 +106,93 @@ protected:
 	SentPacket& rentSentPacket();
 
 	// Internal
-	void receivedPacketInternal(const std::vector<uint8>& buffer, const SocketAddress& senderAddress, NetConnection* connection);
+	void receivedPacketInternal(const uint8* data, size_t length, const SocketAddress& senderAddress, NetConnection* connection);
+	void queueReceivedPacket(const uint8* data, size_t length, uint16 lowLevelSignature, const SocketAddress* senderAddress, NetConnection* connection);
+	bool receiveTCPInternal(NetConnection& connection, bool& outAnyActivity);
+	NetConnection* findConnectionByLocalID(uint16 localConnectionID) const;
 	uint16 getFreeLocalConnectionID();
+	void runReceiveThread();
 
 private:
 	struct SyncedPacketQueue
 	{
-		std::deque<ReceivedPacket*> mWorkerQueue;	// Used by the worker thread that adds packets
-		std::deque<ReceivedPacket*> mSyncedQueue;	// Used by the main thread that reads packets
+		// Using vectors instead of deques, so that they keep their memory and don't allocate anything after a while
+		std::vector<ReceivedPacket*> mWorkerQueue;	// Used by the worker thread that adds packets
+		std::vector<ReceivedPacket*> mSyncedQueue;	// Used by the main thread that reads packets, starting at "mSyncedReadIndex"
+		size_t mSyncedReadIndex = 0;
 		ReceivedPacket::Dump mToBeReturned;
 	};
 
+	struct ReceiveThread
+	{
+		static const constexpr size_t NUM_DATAGRAMS = 256;
+		static const constexpr size_t BATCH_SIZE = 32;		// Maximum number of datagrams received with a single system call
+		typedef SPSCQueue<UDPSocket::ReceiveResult*, NUM_DATAGRAMS> DatagramQueue;
+
+		std::thread mThread;
+		std::atomic<bool> mRunning = false;
+		std::vector<UDPSocket::ReceiveResult> mDatagrams;	// Pool of receive buffers, always owned by exactly one of the two queues or one of the threads
+		DatagramQueue mReceivedQueue;						// Filled by the receive thread, emptied by the main thread
+		DatagramQueue mFreeQueue;							// Filled by the main thread, emptied by the receive thread
+		std::mutex mWakeUpMutex;
+		std::condition_variable mWakeUpCondition;
+		std::atomic<bool> mWakeUpSocketPoller = false;		// Set while the socket poller is running, so that it gets woken up as well
+		std::atomic<bool> mWaitInterrupted = false;			// Set by "interruptWait", and reset by the wait that it ended
+	};
+
+	struct ReceiveBatch
+	{
+		static const constexpr size_t NUM_DATAGRAMS = 16;
+
+		std::vector<UDPSocket::ReceiveResult> mDatagrams;	// Receive buffers used when there's no receive thread
+		std::vector<UDPSocket::ReceiveResult*> mPointers;
+	};
+
+	struct SendBatch
+	{
+		static const constexpr size_t NUM_DATAGRAMS = 64;
+
+		struct Datagram
+		{
+			std::vector<uint8> mContent;
+			SocketAddress mDestinationAddress;
+		};
+
+		bool mEnabled = false;
+		std::vector<Datagram> mDatagrams;		// Preallocated send buffers, the first "mNumQueued" of them are waiting to be sent
+		std::vector<UDPSocket::SendItem> mSendItems;
+		size_t mNumQueued = 0;
+	};
+
 private:
 	UDPSocket* mUDPSocket = nullptr;		// Only set if UDP is used (or both UDP and TCP)
 	TCPSocket* mTCPListenSocket = nullptr;	// Only set if TCP is used (or both UDP and TCP)
 	ConnectionListenerInterface& mListener;
 	VersionRange<uint8> mHighLevelProtocolVersionRange = { 1, 1 };
 
-	std::unordered_map<uint16, NetConnection*> mActiveConnections;		// Using local connection ID as key
-	std::vector<NetConnection*> mActiveConnectionsLookup;				// Using the lowest n bits of the local connection ID as index
+	// Flat lookup of active connections, using the lowest n bits of the local connection ID as index
+	//  -> Local connection IDs are chosen so that they never collide in here, so a lookup is a single array access without any probing
+	std::vector<NetConnection*> mActiveConnectionsLookup;
 	uint16 mBitmaskForActiveConnectionsLookup = 0;
+	size_t mNumActiveConnections = 0;
 	std::unordered_map<uint64, NetConnection*> mConnectionsBySender;	// Using a sender key (= hash for the sender address + remote connection ID) as key
 
 	std::vector<NetConnection*> mTCPNetConnections;
+	uint64 mNextConnectionsUpdateTimestamp = 0;
 
 	SyncedPacketQueue mReceivedPackets;
+	ReceiveThread mReceiveThread;
+	ReceiveBatch mReceiveBatch;
+	SendBatch mSendBatch;
+	SocketPoller mSocketPoller;
+	std::vector<SocketPoller::Event> mSocketEvents;		// Events from the last wait, not yet handled in "updateReceivePackets"
 	std::list<TCPSocket> mIncomingTCPConnections;
 
+	// Buffers reused for sending and receiving, one set per connection manager, so that several of them can be used on different threads
+	std::vector<uint8> mWebSocketSendBuffer;
+	std::vector<uint8> mConnectionlessSendBuffer;
+	TCPSocket::ReceiveResult mTCPReceiveResult;
+
 	RentableObjectPool<SentPacket> mSentPacketPool;
 	RentableObjectPool<ReceivedPacket> mReceivedPacketPool;
 };
@@ -38,6 +38,61 @@ namespace highlevel
 	};
 
 
+	// Wrapper for sending the same packet to many connections, e.g. for broadcasts
+	//  -> The wrapped packet's content gets serialized only once per protocol version and then gets copied as-is, instead of getting serialized again for each connection
+	//  -> The low-level header still gets written by each connection, as it contains per-connection data
+	//  -> Only meant for sending, and the wrapped packet must not be changed while this wrapper is in use
+	struct PreSerializedPacket : public PacketBase
+	{
+	public:
+		inline explicit PreSerializedPacket(PacketBase& packet) : mPacket(packet) {}
+
+		virtual uint32 getPacketType() const override  { return mPacket.getPacketType(); }
+		virtual bool isReliablePacket() const override { return mPacket.isReliablePacket(); }
+
+	protected:
+		virtual void serializeContent(VectorBinarySerializer& serializer, uint8 protocolVersion) override
+		{
+			RMX_ASSERT(!serializer.isReading(), "Pre-serialized packets can't be read");
+			const SerializedContent* content = nullptr;
+			for (const SerializedContent& serializedContent : mSerializedContents)
+			{
+				if (serializedContent.mProtocolVersion == protocolVersion)
+				{
+					content = &serializedContent;
+					break;
+				}
+			}
+
+			if (nullptr == content)
+			{
+				// First use with this protocol version
+				SerializedContent& serializedContent = vectorAdd(mSerializedContents);
+				serializedContent.mProtocolVersion = protocolVersion;
+				VectorBinarySerializer contentSerializer(false, serializedContent.mContent);
+				serializedContent.mHasError = !mPacket.serializePacket(contentSerializer, protocolVersion);
+				content = &serializedContent;
+			}
+
+			if (content->mHasError)
+				serializer.setError();
+			else if (!content->mContent.empty())
+				serializer.write(&content->mContent[0], content->mContent.size());
+		}
+
+	private:
+		struct SerializedContent
+		{
+			uint8 mProtocolVersion = 0;
+			bool mHasError = false;
+			std::vector<uint8> mContent;
+		};
+
+		PacketBase& mPacket;
+		std::vector<SerializedContent> mSerializedContents;		// Usually only one, as most connections use the same protocol version
+	};
+
+
 	struct PacketTypeRegistration
 	{
 		inline PacketTypeRegistration(uint32 packetType, const std::string& packetName)
@@ -394,7 +394,7 @@ bool NetConnection::receivedWebSocketPacket(const std::vector<uint8>& content)
 	if (nullptr == mConnectionManager)
 		return false;
 
-	mConnectionManager->receivedPacketInternal(content, mRemoteAddress, this);
+	mConnectionManager->receivedPacketInternal(content.data(), content.size(), mRemoteAddress, this);
 	return true;
 }
 
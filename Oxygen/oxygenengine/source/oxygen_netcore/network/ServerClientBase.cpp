@@ -175,7 +175,7 @@ void ServerClientBase::handleConnectionStartPacket(ConnectionManager& connection
 		else
 		{
 			// Check if another connection would reach the limit of concurrent connections
-			if (connectionManager.getNumActiveConnections() + 1 >= 0x100)	// Not a hard limit, but should be good enough for now
+			if (connectionManager.getNumActiveConnections() + 1 >= mMaxConnections)
 			{
 				lowlevel::ErrorPacket errorPacket(lowlevel::ErrorPacket::ErrorCode::TOO_MANY_CONNECTIONS);
 				connectionManager.sendConnectionlessLowLevelPacket(errorPacket, receivedPacket.mSenderAddress, 0, remoteConnectionID);
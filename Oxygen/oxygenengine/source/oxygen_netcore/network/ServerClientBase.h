@@ -19,6 +19,10 @@ class ServerClientBase : public ConnectionListenerInterface
 public:
 	static uint64 getCurrentTimestamp();
 
+	// Limit for the number of concurrent connections, further connection start requests get rejected with an error
+	inline size_t getMaxConnections() const				  { return mMaxConnections; }
+	inline void setMaxConnections(size_t maxConnections)  { mMaxConnections = maxConnections; }
+
 protected:
 	bool updateReceivePackets(ConnectionManager& connectionManager);
 
@@ -28,4 +32,7 @@ protected:
 
 private:
 	void handleConnectionStartPacket(ConnectionManager& connectionManager, const ReceivedPacket& receivedPacket);
+
+private:
+	size_t mMaxConnections = 0x100;
 };
@@ -31,9 +31,32 @@
 	#define SOCKET int
 	#define INVALID_SOCKET -1
 
+	#if defined(__linux__) && !defined(__EMSCRIPTEN__)
+		#include <sys/epoll.h>
+		#include <sys/eventfd.h>
+		#define SUPPORT_EPOLL
+		#define SUPPORT_MMSG
+		#define SUPPORT_REUSEPORT
+	#endif
+
 #endif
 
 
+namespace
+{
+	void enablePortSharing(SOCKET socket)
+	{
+	#ifdef SUPPORT_REUSEPORT
+		const int enable = 1;
+		if (::setsockopt(socket, SOL_SOCKET, SO_REUSEPORT, (const char*)&enable, sizeof(enable)) != 0)
+		{
+			RMX_ERROR("setsockopt for SO_REUSEPORT failed with error: " << errno, );
+		}
+	#endif
+	}
+}
+
+
 void Sockets::startupSockets()
 {
 	if (mIsInitialized)
@@ -58,6 +81,15 @@ void Sockets::shutdownSockets()
 	mIsInitialized = false;
 }
 
+bool Sockets::isPortSharingSupported()
+{
+#ifdef SUPPORT_REUSEPORT
+	return true;
+#else
+	return false;
+#endif
+}
+
 bool Sockets::resolveToIP(const std::string& hostName, std::string& outIP)
 {
 #ifdef __EMSCRIPTEN__
@@ -254,7 +286,7 @@ void TCPSocket::swapWith(TCPSocket& other)
 	std::swap(mInternal, other.mInternal);
 }
 
-bool TCPSocket::setupServer(uint16 serverPort)
+bool TCPSocket::setupServer(uint16 serverPort, bool sharePort)
 {
 	if (nullptr == mInternal)
 	{
@@ -298,6 +330,11 @@ bool TCPSocket::setupServer(uint16 serverPort)
 		return false;
 	}
 
+	if (sharePort)
+	{
+		enablePortSharing(mInternal->mSocket);
+	}
+
 	// Bind socket
 	result = ::bind(mInternal->mSocket, addr->ai_addr, (int)addr->ai_addrlen);
 	if (result != 0)
@@ -339,7 +376,7 @@ bool TCPSocket::acceptConnection(TCPSocket& outSocket)
 	FD_ZERO(&socketSet);
 	FD_SET(mInternal->mSocket, &socketSet);
 	timeval timeout { 0, 0 };
-	const int result = ::select(0, &socketSet, nullptr, nullptr, &timeout);
+	const int result = ::select((int)mInternal->mSocket + 1, &socketSet, nullptr, nullptr, &timeout);	// First parameter gets ignored on Windows, but not on POSIX
 	if (result < 0)
 	{
 	#ifdef _WIN32
@@ -536,7 +573,14 @@ bool TCPSocket::receiveInternal(ReceiveResult& outReceiveResult)
 				return true;
 			RMX_ERROR("recv failed with error: " << errorCode, );
 		#else
-			RMX_ERROR("recv failed with error: " << result, );
+			const int errorCode = errno;
+			if (!mInternal->mIsBlockingSocket && (errorCode == EAGAIN || errorCode == EWOULDBLOCK))
+			{
+				// Nothing (more) to receive at the moment, this is not an error for non-blocking sockets
+				outReceiveResult.mBuffer.resize(bytesRead);
+				return true;
+			}
+			RMX_ERROR("recv failed with error: " << errorCode, );
 		#endif
 			return false;
 		}
@@ -551,6 +595,13 @@ struct UDPSocket::Internal
 #ifndef _WIN32
 	bool mIsBlockingSocket = true;
 #endif
+#ifdef SUPPORT_MMSG
+	// Separate for sending and receiving, as these may be used by different threads
+	std::vector<mmsghdr> mSendMessages;
+	std::vector<iovec> mSendBuffers;
+	std::vector<mmsghdr> mReceiveMessages;
+	std::vector<iovec> mReceiveBuffers;
+#endif
 };
 
 
@@ -591,7 +642,7 @@ void UDPSocket::close()
 	mInternal->mLocalPort = 0;
 }
 
-bool UDPSocket::bindToPort(uint16 port)
+bool UDPSocket::bindToPort(uint16 port, bool sharePort)
 {
 	if (nullptr == mInternal)
 	{
@@ -628,6 +679,11 @@ bool UDPSocket::bindToPort(uint16 port)
 	}
 	mInternal->mSocket = (SOCKET)result;
 
+	if (sharePort)
+	{
+		enablePortSharing(mInternal->mSocket);
+	}
+
 	// Setup the socket
 	result = ::bind(mInternal->mSocket, addressInfo->ai_addr, (int)addressInfo->ai_addrlen);
 	if (result < 0)
@@ -709,7 +765,7 @@ bool UDPSocket::sendData(const std::vector<uint8>& data, const SocketAddress& de
 
 bool UDPSocket::receiveBlocking(ReceiveResult& outReceiveResult)
 {
-	outReceiveResult.mBuffer.clear();
+	outReceiveResult.mLength = 0;
 	if (!isValid())
 		return false;
 
@@ -728,7 +784,7 @@ bool UDPSocket::receiveBlocking(ReceiveResult& outReceiveResult)
 
 bool UDPSocket::receiveNonBlocking(ReceiveResult& outReceiveResult)
 {
-	outReceiveResult.mBuffer.clear();
+	outReceiveResult.mLength = 0;
 	if (!isValid())
 		return false;
 
@@ -759,49 +815,389 @@ bool UDPSocket::receiveNonBlocking(ReceiveResult& outReceiveResult)
 	return true;
 }
 
+size_t UDPSocket::sendDataBatch(const SendItem* items, size_t count)
+{
+	if (!isValid())
+		return 0;
+
+#ifdef SUPPORT_MMSG
+	mInternal->mSendMessages.resize(std::max(mInternal->mSendMessages.size(), count));
+	mInternal->mSendBuffers.resize(std::max(mInternal->mSendBuffers.size(), count));
+	for (size_t k = 0; k < count; ++k)
+	{
+		iovec& buffer = mInternal->mSendBuffers[k];
+		buffer.iov_base = const_cast<uint8*>(items[k].mData);
+		buffer.iov_len = items[k].mLength;
+
+		mmsghdr& message = mInternal->mSendMessages[k];
+		message = {};
+		message.msg_hdr.msg_name = const_cast<uint8*>(items[k].mDestinationAddress->getSockAddr());
+		message.msg_hdr.msg_namelen = (socklen_t)sizeof(sockaddr);
+		message.msg_hdr.msg_iov = &buffer;
+		message.msg_hdr.msg_iovlen = 1;
+	}
+
+	size_t numSent = 0;
+	size_t index = 0;
+	while (index < count)
+	{
+		const int result = ::sendmmsg(mInternal->mSocket, &mInternal->mSendMessages[index], (unsigned int)(count - index), 0);
+		if (result > 0)
+		{
+			numSent += result;
+			index += result;
+		}
+		else
+		{
+			// Sending the datagram at "index" failed, skip it and go on with the rest
+			RMX_LOG_INFO("sendmmsg failed with error: " << errno);
+			++index;
+		}
+	}
+	return numSent;
+
+#else
+	size_t numSent = 0;
+	for (size_t k = 0; k < count; ++k)
+	{
+		if (sendData(items[k].mData, items[k].mLength, *items[k].mDestinationAddress))
+			++numSent;
+	}
+	return numSent;
+#endif
+}
+
+bool UDPSocket::receiveBatchNonBlocking(ReceiveResult** outReceiveResults, size_t count, size_t& outNumReceived)
+{
+	outNumReceived = 0;
+	if (!isValid())
+		return false;
+
+#ifdef SUPPORT_MMSG
+	mInternal->mReceiveMessages.resize(std::max(mInternal->mReceiveMessages.size(), count));
+	mInternal->mReceiveBuffers.resize(std::max(mInternal->mReceiveBuffers.size(), count));
+	for (size_t k = 0; k < count; ++k)
+	{
+		ReceiveResult& receiveResult = *outReceiveResults[k];
+
+		iovec& buffer = mInternal->mReceiveBuffers[k];
+		buffer.iov_base = receiveResult.mData;
+		buffer.iov_len = MAX_DATAGRAM_SIZE;
+
+		mmsghdr& message = mInternal->mReceiveMessages[k];
+		message = {};
+		message.msg_hdr.msg_name = receiveResult.mSenderAddress.accessSockAddr();
+		message.msg_hdr.msg_namelen = (socklen_t)sizeof(sockaddr_storage);
+		message.msg_hdr.msg_iov = &buffer;
+		message.msg_hdr.msg_iovlen = 1;
+	}
+
+	// Using MSG_DONTWAIT makes this non-blocking regardless of the socket setup
+	const int result = ::recvmmsg(mInternal->mSocket, &mInternal->mReceiveMessages[0], (unsigned int)count, MSG_DONTWAIT, nullptr);
+	if (result < 0)
+	{
+		for (size_t k = 0; k < count; ++k)
+			outReceiveResults[k]->mLength = 0;
+
+		const int errorCode = errno;
+		if (errorCode == EAGAIN || errorCode == EWOULDBLOCK)
+		{
+			// Nothing to receive at the moment
+			return true;
+		}
+		RMX_ERROR("recvmmsg failed with error: " << errorCode, );
+		return false;
+	}
+
+	for (size_t k = 0; k < count; ++k)
+	{
+		ReceiveResult& receiveResult = *outReceiveResults[k];
+		if (k < (size_t)result)
+		{
+			receiveResult.mLength = mInternal->mReceiveMessages[k].msg_len;
+			receiveResult.mSenderAddress.onSockAddrSet();
+		}
+		else
+		{
+			receiveResult.mLength = 0;
+		}
+	}
+	outNumReceived = (size_t)result;
+	return true;
+
+#else
+	for (size_t k = 0; k < count; ++k)
+	{
+		if (!receiveNonBlocking(*outReceiveResults[k]))
+			return false;
+		if (outReceiveResults[k]->mLength == 0)
+			break;
+		++outNumReceived;
+	}
+	return true;
+#endif
+}
+
+bool UDPSocket::waitForData(uint32 timeoutMilliseconds)
+{
+	if (!isValid())
+		return false;
+
+	fd_set socketSet;
+	FD_ZERO(&socketSet);
+	FD_SET(mInternal->mSocket, &socketSet);
+	timeval timeout { (long)(timeoutMilliseconds / 1000), (long)((timeoutMilliseconds % 1000) * 1000) };
+	const int result = ::select((int)mInternal->mSocket + 1, &socketSet, nullptr, nullptr, &timeout);
+	return (result > 0);
+}
+
 bool UDPSocket::receiveInternal(ReceiveResult& outReceiveResult)
 {
-	size_t bytesRead = 0;
-	while (true)
+	// Note that a datagram can't be read in multiple chunks (at least on Windows), so anything beyond the buffer size gets lost
+	sockaddr_storage& senderAddr = *reinterpret_cast<sockaddr_storage*>(outReceiveResult.mSenderAddress.accessSockAddr());
+	socklen_t senderAddrSize = sizeof(sockaddr);
+	const int result = ::recvfrom(mInternal->mSocket, (char*)outReceiveResult.mData, (int)MAX_DATAGRAM_SIZE, 0, (sockaddr*)&senderAddr, &senderAddrSize);
+	if (result < 0)
 	{
-		// TODO: Reading a datagram in multiple chunks does not work, at least on Windows, so this whole while-loop is kind of pointless...
-		const constexpr size_t CHUNK_SIZE = MAX_DATAGRAM_SIZE;
-		outReceiveResult.mBuffer.resize(bytesRead + CHUNK_SIZE);
+	#ifdef _WIN32
+		const int errorCode = WSAGetLastError();
+		if (errorCode == WSAECONNRESET)		// Ignore this error, see https://stackoverflow.com/questions/30749423/is-winsock-error-10054-wsaeconnreset-normal-with-udp-to-from-localhost
+			return true;
+		RMX_ERROR("recv failed with error: " << errorCode, );
+	#else
+		// This is only an error for blocking sockets
+		if (mInternal->mIsBlockingSocket)
+		{
+			RMX_ERROR("recv failed with error: " << result, );
+		}
+	#endif
+		outReceiveResult.mLength = 0;
+		return false;
+	}
 
-		sockaddr_storage& senderAddr = *reinterpret_cast<sockaddr_storage*>(outReceiveResult.mSenderAddress.accessSockAddr());
-		socklen_t senderAddrSize = sizeof(sockaddr);
-		const int result = ::recvfrom(mInternal->mSocket, (char*)&outReceiveResult.mBuffer[bytesRead], CHUNK_SIZE, 0, (sockaddr*)&senderAddr, &senderAddrSize);
-		if (result < 0)
+	outReceiveResult.mSenderAddress.onSockAddrSet();
+	outReceiveResult.mLength = (size_t)result;
+	return true;
+}
+
+
+struct SocketPoller::Internal
+{
+#ifdef SUPPORT_EPOLL
+	static const constexpr uint64 WAKE_UP_USER_DATA = 0xffffffffffffffffull;	// Reserved for the wake-up event
+
+	int mEpoll = -1;
+	int mWakeUpEvent = -1;
+	std::vector<epoll_event> mEpollEvents;
+#endif
+};
+
+
+namespace
+{
+#ifdef SUPPORT_EPOLL
+	bool addToEpoll(int epoll, SOCKET socket, uint32 events, uint64 userData)
+	{
+		epoll_event event = {};
+		event.events = events;
+		event.data.u64 = userData;
+		if (::epoll_ctl(epoll, EPOLL_CTL_ADD, socket, &event) != 0)
 		{
-		#ifdef _WIN32
-			const int errorCode = WSAGetLastError();
-			if (errorCode == WSAECONNRESET)		// Ignore this error, see https://stackoverflow.com/questions/30749423/is-winsock-error-10054-wsaeconnreset-normal-with-udp-to-from-localhost
-				return true;
-			RMX_ERROR("recv failed with error: " << errorCode, );
-		#else
-			// This is only an error for blocking sockets
-			if (mInternal->mIsBlockingSocket)
-			{
-				RMX_ERROR("recv failed with error: " << result, );
-			}
-		#endif
-			outReceiveResult.mBuffer.clear();
+			RMX_ERROR("epoll_ctl failed with error: " << errno, );
 			return false;
 		}
+		return true;
+	}
 
-		outReceiveResult.mSenderAddress.onSockAddrSet();
-		if (result > 0)
+	void removeFromEpoll(int epoll, SOCKET socket)
+	{
+		// Errors can be ignored here, closing the socket removes it from the epoll instance anyway
+		epoll_event event = {};
+		::epoll_ctl(epoll, EPOLL_CTL_DEL, socket, &event);
+	}
+#endif
+}
+
+
+bool SocketPoller::isSupported()
+{
+#ifdef SUPPORT_EPOLL
+	return true;
+#else
+	return false;
+#endif
+}
+
+SocketPoller::~SocketPoller()
+{
+	if (nullptr != mInternal)
+	{
+		close();
+		delete mInternal;
+	}
+}
+
+bool SocketPoller::isValid() const
+{
+#ifdef SUPPORT_EPOLL
+	return (nullptr != mInternal && mInternal->mEpoll >= 0);
+#else
+	return false;
+#endif
+}
+
+bool SocketPoller::initialize()
+{
+#ifdef SUPPORT_EPOLL
+	if (nullptr == mInternal)
+	{
+		mInternal = new Internal();
+	}
+	else
+	{
+		close();
+	}
+
+	mInternal->mEpoll = ::epoll_create1(EPOLL_CLOEXEC);
+	if (mInternal->mEpoll < 0)
+	{
+		RMX_ERROR("epoll_create1 failed with error: " << errno, );
+		return false;
+	}
+
+	// The wake-up event is part of the watched file descriptors as well, so that writing to it from another thread ends a wait
+	mInternal->mWakeUpEvent = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (mInternal->mWakeUpEvent < 0 || !addToEpoll(mInternal->mEpoll, mInternal->mWakeUpEvent, EPOLLIN, Internal::WAKE_UP_USER_DATA))
+	{
+		RMX_ERROR("Failed to setup wake-up event for epoll", );
+		close();
+		return false;
+	}
+
+	mInternal->mEpollEvents.resize(64);
+	return true;
+#else
+	return false;
+#endif
+}
+
+void SocketPoller::close()
+{
+#ifdef SUPPORT_EPOLL
+	if (nullptr == mInternal)
+		return;
+
+	if (mInternal->mWakeUpEvent >= 0)
+	{
+		::close(mInternal->mWakeUpEvent);
+		mInternal->mWakeUpEvent = -1;
+	}
+	if (mInternal->mEpoll >= 0)
+	{
+		::close(mInternal->mEpoll);
+		mInternal->mEpoll = -1;
+	}
+#endif
+}
+
+bool SocketPoller::addSocket(UDPSocket& socket, uint64 userData)
+{
+	if (!isValid() || !socket.isValid())
+		return false;
+
+#ifdef SUPPORT_EPOLL
+	return addToEpoll(mInternal->mEpoll, socket.mInternal->mSocket, EPOLLIN, userData);
+#else
+	return false;
+#endif
+}
+
+bool SocketPoller::addSocket(TCPSocket& socket, uint64 userData)
+{
+	if (!isValid() || !socket.isValid())
+		return false;
+
+#ifdef SUPPORT_EPOLL
+	return addToEpoll(mInternal->mEpoll, socket.mInternal->mSocket, EPOLLIN | EPOLLRDHUP, userData);
+#else
+	return false;
+#endif
+}
+
+void SocketPoller::removeSocket(UDPSocket& socket)
+{
+	if (!isValid() || !socket.isValid())
+		return;
+
+#ifdef SUPPORT_EPOLL
+	removeFromEpoll(mInternal->mEpoll, socket.mInternal->mSocket);
+#endif
+}
+
+void SocketPoller::removeSocket(TCPSocket& socket)
+{
+	if (!isValid() || !socket.isValid())
+		return;
+
+#ifdef SUPPORT_EPOLL
+	removeFromEpoll(mInternal->mEpoll, socket.mInternal->mSocket);
+#endif
+}
+
+bool SocketPoller::waitForEvents(std::vector<Event>& outEvents, uint32 timeoutMilliseconds)
+{
+	if (!isValid())
+		return false;
+
+#ifdef SUPPORT_EPOLL
+	const int numEvents = ::epoll_wait(mInternal->mEpoll, &mInternal->mEpollEvents[0], (int)mInternal->mEpollEvents.size(), (int)timeoutMilliseconds);
+	if (numEvents < 0)
+	{
+		// Getting interrupted by a signal is no real error
+		if (errno != EINTR)
 		{
-			bytesRead += result;
-			if (result >= CHUNK_SIZE)
-			{
-				// There's more to read
-				continue;
-			}
+			RMX_ERROR("epoll_wait failed with error: " << errno, );
 		}
+		return false;
+	}
 
-		// Done
-		outReceiveResult.mBuffer.resize(bytesRead);
-		return true;
+	for (int index = 0; index < numEvents; ++index)
+	{
+		const epoll_event& epollEvent = mInternal->mEpollEvents[index];
+		if (epollEvent.data.u64 == Internal::WAKE_UP_USER_DATA)
+		{
+			// Reset the wake-up event
+			uint64 counter = 0;
+			const ssize_t result = ::read(mInternal->mWakeUpEvent, &counter, sizeof(counter));
+			(void)result;
+			continue;
+		}
+
+		Event& event = vectorAdd(outEvents);
+		event.mUserData = epollEvent.data.u64;
+		event.mReadable = (epollEvent.events & EPOLLIN) != 0;
+		event.mClosed = (epollEvent.events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) != 0;
+	}
+
+	// If all event slots got used, there might be more events waiting, so use more next time
+	if ((size_t)numEvents == mInternal->mEpollEvents.size())
+	{
+		mInternal->mEpollEvents.resize(mInternal->mEpollEvents.size() * 2);
 	}
+	return (numEvents > 0);
+#else
+	return false;
+#endif
+}
+
+void SocketPoller::wakeUp()
+{
+	if (!isValid())
+		return;
+
+#ifdef SUPPORT_EPOLL
+	const uint64 value = 1;
+	const ssize_t result = ::write(mInternal->mWakeUpEvent, &value, sizeof(value));
+	(void)result;
+#endif
 }
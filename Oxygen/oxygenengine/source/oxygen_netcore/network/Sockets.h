@@ -19,6 +19,9 @@ public:
 
 	static bool resolveToIP(const std::string& hostName, std::string& outIP);
 
+	// Whether multiple sockets can be bound to the same port, with the system distributing incoming datagrams and connections among them (SO_REUSEPORT on Linux)
+	static bool isPortSharingSupported();
+
 public:
 	static inline rmx::ErrorHandling::LoggerInterface* mLogger = nullptr;
 
@@ -113,6 +116,8 @@ private:
 
 class TCPSocket
 {
+friend class SocketPoller;
+
 public:
 	struct ReceiveResult
 	{
@@ -129,7 +134,7 @@ public:
 	const SocketAddress& getRemoteAddress();
 	void swapWith(TCPSocket& other);
 
-	bool setupServer(uint16 serverPort);
+	bool setupServer(uint16 serverPort, bool sharePort = false);
 	bool acceptConnection(TCPSocket& outSocket);
 
 	bool connectTo(const std::string& serverAddress, uint16 serverPort);
@@ -151,22 +156,32 @@ private:
 
 class UDPSocket
 {
+friend class SocketPoller;
+
 public:
 	static const constexpr size_t MAX_DATAGRAM_SIZE = 0x8000;	// That's 32 KB (the actual limit is somewhat close to 64 KB, but let's play safe here)
 
 	struct ReceiveResult
 	{
-		std::vector<uint8> mBuffer;
+		uint8 mData[MAX_DATAGRAM_SIZE];		// Fixed size buffer, so receiving never needs to resize (and thus clear) anything; only the first "mLength" bytes are valid
+		size_t mLength = 0;
 		SocketAddress mSenderAddress;
 	};
 
+	struct SendItem
+	{
+		const uint8* mData = nullptr;
+		size_t mLength = 0;
+		const SocketAddress* mDestinationAddress = nullptr;
+	};
+
 public:
 	~UDPSocket();
 
 	bool isValid() const;
 	void close();
 
-	bool bindToPort(uint16 port);
+	bool bindToPort(uint16 port, bool sharePort = false);
 	bool bindToAnyPort();
 
 	bool sendData(const uint8* data, size_t length, const SocketAddress& destinationAddress);
@@ -175,6 +190,15 @@ public:
 	bool receiveBlocking(ReceiveResult& outReceiveResult);
 	bool receiveNonBlocking(ReceiveResult& outReceiveResult);
 
+	// Batched sending and receiving of multiple datagrams with a single system call each, where supported (using sendmmsg / recvmmsg on Linux)
+	//  -> Sending returns the number of datagrams that were sent successfully
+	//  -> Receiving fills the given results in order and never blocks; "outNumReceived" is zero if there was nothing to receive
+	size_t sendDataBatch(const SendItem* items, size_t count);
+	bool receiveBatchNonBlocking(ReceiveResult** outReceiveResults, size_t count, size_t& outNumReceived);
+
+	// Wait until there's data to receive, returns false on timeout or error
+	bool waitForData(uint32 timeoutMilliseconds);
+
 private:
 	bool receiveInternal(ReceiveResult& outReceiveResult);
 
@@ -182,3 +206,44 @@ private:
 	struct Internal;
 	Internal* mInternal = nullptr;
 };
+
+
+// Waits for activity on any number of sockets at once, instead of polling each socket on its own
+//  -> Uses epoll, and is therefore only supported on Linux; on other platforms, "initialize" fails and callers have to fall back to polling
+//  -> Sockets are watched level-triggered, i.e. a socket keeps getting reported as long as there's data left to receive
+class SocketPoller
+{
+public:
+	struct Event
+	{
+		uint64 mUserData = 0;		// As passed to "addSocket"
+		bool mReadable = false;		// There's data to receive, or an incoming connection for a TCP listen socket
+		bool mClosed = false;		// The remote side closed the connection, or there was an error on the socket
+	};
+
+public:
+	static bool isSupported();
+
+public:
+	~SocketPoller();
+
+	bool isValid() const;
+	bool initialize();
+	void close();
+
+	bool addSocket(UDPSocket& socket, uint64 userData);
+	bool addSocket(TCPSocket& socket, uint64 userData);
+	void removeSocket(UDPSocket& socket);
+	void removeSocket(TCPSocket& socket);
+
+	// Wait until there's activity on any of the sockets, "wakeUp" gets called, or the timeout is reached
+	//  -> Events get added to the output, returns false on timeout or error
+	bool waitForEvents(std::vector<Event>& outEvents, uint32 timeoutMilliseconds);
+
+	// Let a currently running or the next call to "waitForEvents" return right away; this can be called from any thread
+	void wakeUp();
+
+private:
+	struct Internal;
+	Internal* mInternal = nullptr;
+};
@@ -0,0 +1,54 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#pragma once
+
+#include <atomic>
+
+
+// Bounded lock-free queue for exactly one producer thread and one consumer thread
+//  -> Head and tail only ever increase, the buffer index is taken from their lowest bits
+template<typename T, size_t CAPACITY>
+class SPSCQueue
+{
+	static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "Capacity must be a power of two");
+
+public:
+	inline size_t getCapacity() const  { return CAPACITY; }
+
+	inline bool empty() const  { return mHead.load(std::memory_order_acquire) == mTail.load(std::memory_order_acquire); }
+
+	// Only to be called by the producer thread
+	inline bool tryPush(const T& value)
+	{
+		const size_t tail = mTail.load(std::memory_order_relaxed);
+		if (tail - mHead.load(std::memory_order_acquire) >= CAPACITY)
+			return false;
+
+		mBuffer[tail & (CAPACITY - 1)] = value;
+		mTail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Only to be called by the consumer thread
+	inline bool tryPop(T& outValue)
+	{
+		const size_t head = mHead.load(std::memory_order_relaxed);
+		if (head == mTail.load(std::memory_order_acquire))
+			return false;
+
+		outValue = mBuffer[head & (CAPACITY - 1)];
+		mHead.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	T mBuffer[CAPACITY];
+	alignas(64) std::atomic<size_t> mHead { 0 };	// Only written by the consumer
+	alignas(64) std::atomic<size_t> mTail { 0 };	// Only written by the producer
+};
@@ -161,11 +161,16 @@ namespace network
 
 		// All properties from "BroadcastChannelMessagePacket" are shared here
 		uint32 mSendingPlayerID = 0;
+		uint32 mReplicatedDataRevision = 0;		// Only for replicated data: revision of the sending player's state, always increasing, so older states can be ignored; 0 if unknown
 
 		virtual void serializeContent(VectorBinarySerializer& serializer, uint8 protocolVersion) override
 		{
 			BroadcastChannelMessagePacket::serializeContent(serializer, protocolVersion);
 			serializer.serialize(mSendingPlayerID);
+			if (protocolVersion >= 2 && mIsReplicatedData)
+			{
+				serializer.serialize(mReplicatedDataRevision);
+			}
 		}
 	};
 
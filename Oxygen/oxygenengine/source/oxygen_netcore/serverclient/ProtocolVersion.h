@@ -20,5 +20,8 @@ namespace network
 	//  - If a larger change is made that would break compatibility even with the extension of the packet serialization
 	//     as described above, the minimum version needs to be set to that new version number as well.
 
-	static const VersionRange<uint8> HIGHLEVEL_PROTOCOL_VERSION_RANGE { 1, 1 };
+	// Version history:
+	//  - 2: "ChannelMessagePacket" includes the revision of replicated data
+
+	static const VersionRange<uint8> HIGHLEVEL_PROTOCOL_VERSION_RANGE { 1, 2 };
 }
@@ -0,0 +1,134 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#define RMX_LIB
+
+#include "oxygen_netcore/network/ConnectionManager.h"
+#include "oxygen_netcore/network/ConnectionListener.h"
+#include "oxygen_netcore/network/LowLevelPackets.h"
+#include "oxygen_netcore/network/NetConnection.h"
+#include "oxygen_netcore/serverclient/ProtocolVersion.h"
+
+#include "ReceiveBenchmark.h"
+
+#include <atomic>
+#include <chrono>
+#include <new>
+
+
+// Count all heap allocations of the process, to check that the receive path does not allocate after warm-up
+//  -> This is only read by the receive benchmark, the load test itself does not care
+namespace
+{
+	std::atomic<size_t> gNumAllocations = 0;
+}
+
+void* operator new(size_t size)
+{
+	++gNumAllocations;
+	void* pointer = malloc(size);
+	if (nullptr == pointer)
+		throw std::bad_alloc();
+	return pointer;
+}
+
+void operator delete(void* pointer) noexcept
+{
+	free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+	free(pointer);
+}
+
+
+namespace
+{
+	static const uint32 PACKETS_PER_UPDATE = 64;	// Number of packets received between two syncs of the packet queues
+
+	struct BenchmarkListener : public ConnectionListenerInterface
+	{
+	};
+
+	void receivePackets(ConnectionManager& connectionManager, const std::vector<std::vector<uint8>>& datagrams, const SocketAddress& senderAddress, uint32 numPackets)
+	{
+		size_t datagramIndex = 0;
+		for (uint32 k = 0; k < numPackets; k += PACKETS_PER_UPDATE)
+		{
+			for (uint32 n = 0; n < PACKETS_PER_UPDATE; ++n)
+			{
+				const std::vector<uint8>& datagram = datagrams[datagramIndex];
+				connectionManager.injectReceivedDatagram(&datagram[0], datagram.size(), senderAddress);
+				datagramIndex = (datagramIndex + 1) % datagrams.size();
+			}
+
+			connectionManager.syncPacketQueues();
+			while (connectionManager.hasAnyPacket())
+			{
+				ReceivedPacket* receivedPacket = connectionManager.getNextReceivedPacket();
+				if (nullptr == receivedPacket)
+					break;
+				receivedPacket->decReferenceCounter();
+			}
+		}
+	}
+}
+
+
+void runReceiveBenchmark(uint32 numConnections, uint32 numPackets)
+{
+	// Connection setup logs a line for each connection, so logging is off until it's done
+	RMX_LOG_INFO("Setting up " << numConnections << " connections");
+	rmx::Logging::clear();
+
+	UDPSocket udpSocket;
+	if (!udpSocket.bindToAnyPort())
+		RMX_ERROR("Socket bind to any port failed", return);
+
+	BenchmarkListener listener;
+	ConnectionManager connectionManager(&udpSocket, nullptr, listener, network::HIGHLEVEL_PROTOCOL_VERSION_RANGE);
+
+	// Register connections, they only send a start connection packet into nowhere
+	SocketAddress remoteAddress;
+	remoteAddress.set("127.0.0.1", 9);
+	std::vector<std::unique_ptr<NetConnection>> connections;
+	for (uint32 k = 0; k < numConnections; ++k)
+	{
+		NetConnection& connection = *connections.emplace_back(std::make_unique<NetConnection>());
+		connection.startConnectTo(connectionManager, remoteAddress, 0);
+	}
+	rmx::Logging::addLogger(*new rmx::StdCoutLogger());
+
+	// Prepare datagrams addressed to these connections, with differing sizes
+	//  -> Remote connection ID is 0, as the connections never got accepted
+	std::vector<std::vector<uint8>> datagrams(numConnections);
+	for (uint32 k = 0; k < numConnections; ++k)
+	{
+		std::vector<uint8>& datagram = datagrams[k];
+		datagram.resize(80 + (k % 7) * 30);
+		uint16* header = (uint16*)&datagram[0];
+		header[0] = lowlevel::HighLevelPacket::SIGNATURE;
+		header[1] = 0;
+		header[2] = connections[k]->getLocalConnectionID();
+	}
+
+	// Warm-up, so that all pools and queues reach their working size
+	receivePackets(connectionManager, datagrams, remoteAddress, std::max(numConnections * 10, 100000u));
+
+	const size_t allocationsBefore = gNumAllocations;
+	const auto startTime = std::chrono::steady_clock::now();
+	receivePackets(connectionManager, datagrams, remoteAddress, numPackets);
+	const double nanoseconds = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+	const size_t allocations = gNumAllocations - allocationsBefore;
+
+	const double numPacketsDouble = (double)((numPackets + PACKETS_PER_UPDATE - 1) / PACKETS_PER_UPDATE * PACKETS_PER_UPDATE);
+	RMX_LOG_INFO("Received " << (uint64)numPacketsDouble << " packets for " << numConnections << " connections");
+	RMX_LOG_INFO("Time per packet: " << (int)(nanoseconds / numPacketsDouble * 10.0 + 0.5) / 10.0 << " ns");
+	RMX_LOG_INFO("Allocations per packet: " << (double)allocations / numPacketsDouble);
+}
@@ -0,0 +1,17 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#pragma once
+
+#include <rmxbase.h>
+
+
+// Measures the per-packet cost of the receive path in the connection manager, without any actual network traffic
+//  -> Datagrams for the given number of connections get fed in directly, then synced and taken out of the queue again like the server does
+//  -> Reports the time and heap allocations per packet
+void runReceiveBenchmark(uint32 numConnections, uint32 numPackets);
@@ -0,0 +1,629 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#define RMX_LIB
+
+#include "oxygen_netcore/network/ConnectionManager.h"
+#include "oxygen_netcore/network/RequestBase.h"
+#include "oxygen_netcore/network/NetConnection.h"
+#include "oxygen_netcore/network/ServerClientBase.h"
+#include "oxygen_netcore/serverclient/Packets.h"
+#include "oxygen_netcore/serverclient/ProtocolVersion.h"
+
+#include "ReceiveBenchmark.h"
+#include "Shared.h"
+
+#include <atomic>
+#include <thread>
+
+#if defined(__linux__)
+	#include <unistd.h>
+#endif
+
+
+// Load generator for the Oxygen server
+//  -> Simulates lots of clients that join channels and broadcast ghost sync-like messages to each other, optionally with app update checks on top
+//  -> Reports throughput, broadcast latency and update check round trip percentiles, and the server's CPU usage if its process ID is given (Linux only)
+namespace
+{
+	static const uint32 LOADTEST_MESSAGE_TYPE = 0x4c6f6164;	// "Load", so it can't be mistaken for actual ghost sync data
+	static const size_t MIN_MESSAGE_SIZE = 12;				// Send time in microseconds + sending client index
+
+	struct Settings
+	{
+		std::string mServerName = SERVER_NAME;
+		uint16 mUDPPort = UDP_SERVER_PORT;
+		uint16 mTCPPort = TCP_SERVER_PORT;
+		bool mUseTCP = false;
+		uint32 mNumClients = 100;
+		uint32 mNumThreads = 4;
+		uint32 mDurationSeconds = 30;
+		uint32 mNumChannels = 10;
+		float mMessagesPerSecond = 10.0f;		// Per client
+		uint32 mMessageSize = 100;				// In bytes
+		bool mReliableMessages = false;			// Ghost sync uses unreliable broadcasts
+		float mUpdateChecksPerSecond = 0.0f;	// Per client
+		uint32 mConnectionsPerSecond = 500;		// Ramp-up rate for starting connections, in total
+		uint32 mServerProcessID = 0;
+		bool mReceiveBenchmark = false;			// Run the local receive path benchmark instead of the load test
+	};
+
+	struct Statistics
+	{
+		std::atomic<uint32> mConnected = 0;
+		std::atomic<uint32> mJoinedChannel = 0;
+		std::atomic<uint32> mFailedConnections = 0;
+		std::atomic<uint64> mMessagesSent = 0;
+		std::atomic<uint64> mMessagesReceived = 0;
+		std::atomic<uint64> mExpectedDeliveries = 0;	// Sum of the number of other clients in the channel, over all sent messages
+		std::atomic<uint64> mUpdateChecksSent = 0;
+		std::atomic<uint64> mUpdateChecksAnswered = 0;
+		std::atomic<bool> mMeasuring = false;	// Latencies only get recorded after the ramp-up phase
+		std::unique_ptr<std::atomic<uint32>[]> mChannelMembers;	// Number of joined clients per channel
+	};
+
+	static const uint64 CONNECT_TIMEOUT = 10000000;		// In microseconds
+
+	uint64 getMicroseconds()
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	uint32 getPercentile(const std::vector<uint32>& sortedValues, float percentile)
+	{
+		if (sortedValues.empty())
+			return 0;
+		const size_t index = std::min((size_t)(percentile * (float)sortedValues.size()), sortedValues.size() - 1);
+		return sortedValues[index];
+	}
+
+	void printLatencies(const char* name, std::vector<uint32>& latencies)
+	{
+		std::sort(latencies.begin(), latencies.end());
+		RMX_LOG_INFO(name << ": " << latencies.size() << " samples, p50 = " << getPercentile(latencies, 0.5f) << " us, p90 = " << getPercentile(latencies, 0.9f) << " us, p99 = " << getPercentile(latencies, 0.99f)
+					 << " us, p99.9 = " << getPercentile(latencies, 0.999f) << " us, max = " << (latencies.empty() ? 0 : latencies.back()) << " us");
+	}
+
+	// Returns the CPU time used by the given process so far, in seconds, or a negative value if not available
+	double getProcessCPUTime(uint32 processID)
+	{
+	#if defined(__linux__)
+		if (processID == 0)
+			return -1.0;
+
+		FILE* file = fopen(("/proc/" + std::to_string(processID) + "/stat").c_str(), "r");
+		if (nullptr == file)
+			return -1.0;
+
+		char buffer[1024];
+		const size_t length = fread(buffer, 1, sizeof(buffer) - 1, file);
+		fclose(file);
+		buffer[length] = 0;
+
+		// The process name in parentheses may contain spaces, so start parsing after its closing bracket
+		const char* position = strrchr(buffer, ')');
+		if (nullptr == position)
+			return -1.0;
+
+		// Fields "utime" and "stime" are the 12th and 13th after the process name
+		unsigned long long utime = 0;
+		unsigned long long stime = 0;
+		if (sscanf(position + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &utime, &stime) != 2)
+			return -1.0;
+		return (double)(utime + stime) / (double)sysconf(_SC_CLK_TCK);
+	#else
+		return -1.0;
+	#endif
+	}
+}
+
+
+class LoadTestWorker : public ServerClientBase
+{
+public:
+	LoadTestWorker(const Settings& settings, Statistics& statistics, uint32 firstClientIndex, uint32 numClients);
+
+	void runWorker(const std::atomic<bool>& running);
+	void collectLatencies(std::vector<uint32>& broadcastLatencies, std::vector<uint32>& requestLatencies) const;
+
+protected:
+	virtual NetConnection* createNetConnection(ConnectionManager& connectionManager, const SocketAddress& senderAddress) override
+	{
+		// Do not allow incoming connections
+		return nullptr;
+	}
+
+	virtual void destroyNetConnection(NetConnection& connection) override
+	{
+		RMX_ASSERT(false, "This should never get called");
+	}
+
+	virtual bool onReceivedPacket(ReceivedPacketEvaluation& evaluation) override;
+
+private:
+	enum class State
+	{
+		NONE,
+		WAITING_FOR_CONNECTION,
+		JOIN_REQUEST_SENT,
+		RUNNING,
+		FAILED
+	};
+
+	struct SimulatedClient
+	{
+		uint32 mClientIndex = 0;
+		State mState = State::NONE;
+		NetConnection mConnection;
+		network::JoinChannelRequest mJoinChannelRequest;
+		network::AppUpdateCheckRequest mUpdateCheckRequest;
+		uint32 mChannelIndex = 0;
+		uint32 mChannelHash = 0;
+		uint64 mConnectStartTime = 0;		// In microseconds
+		uint64 mNextMessageTime = 0;		// In microseconds
+		uint64 mNextUpdateCheckTime = 0;	// In microseconds
+		uint64 mUpdateCheckSentTime = 0;	// In microseconds, zero if there's no open update check
+	};
+
+private:
+	void startNextConnections(ConnectionManager& connectionManager, const SocketAddress& serverAddress, uint64 currentMicroseconds);
+	void updateClient(SimulatedClient& client, uint64 currentMicroseconds);
+	void sendMessage(SimulatedClient& client, uint64 currentMicroseconds);
+
+private:
+	const Settings& mSettings;
+	Statistics& mStatistics;
+	std::vector<std::unique_ptr<SimulatedClient>> mClients;
+	size_t mNumStartedClients = 0;
+	uint64 mRampUpStartTime = 0;
+
+	std::vector<uint32> mBroadcastLatencies;
+	std::vector<uint32> mRequestLatencies;
+};
+
+
+LoadTestWorker::LoadTestWorker(const Settings& settings, Statistics& statistics, uint32 firstClientIndex, uint32 numClients) :
+	mSettings(settings),
+	mStatistics(statistics)
+{
+	mClients.reserve(numClients);
+	for (uint32 k = 0; k < numClients; ++k)
+	{
+		SimulatedClient& client = *mClients.emplace_back(std::make_unique<SimulatedClient>());
+		client.mClientIndex = firstClientIndex + k;
+
+		// Distribute clients evenly among the channels
+		client.mChannelIndex = client.mClientIndex % settings.mNumChannels;
+		client.mJoinChannelRequest.mQuery.mChannelName = "loadtest-" + std::to_string(client.mChannelIndex);
+		client.mJoinChannelRequest.mQuery.mChannelHash = (uint32)rmx::getMurmur2_64(client.mJoinChannelRequest.mQuery.mChannelName);
+		client.mChannelHash = client.mJoinChannelRequest.mQuery.mChannelHash;
+
+		client.mUpdateCheckRequest.mQuery.mAppName = "sonic3air";
+		client.mUpdateCheckRequest.mQuery.mPlatform = "linux";
+		client.mUpdateCheckRequest.mQuery.mReleaseChannel = "stable";
+		client.mUpdateCheckRequest.mQuery.mInstalledAppVersion = 0x22091000;
+	}
+}
+
+void LoadTestWorker::runWorker(const std::atomic<bool>& running)
+{
+	UDPSocket udpSocket;
+	if (!mSettings.mUseTCP && !udpSocket.bindToAnyPort())
+		RMX_ERROR("Socket bind to any port failed", return);
+
+	ConnectionManager connectionManager(mSettings.mUseTCP ? nullptr : &udpSocket, nullptr, *this, network::HIGHLEVEL_PROTOCOL_VERSION_RANGE);
+	if (mSettings.mUseTCP)
+	{
+		// Polling hundreds of TCP sockets in each update would distort the measurement
+		connectionManager.startSocketPoller();
+	}
+	connectionManager.setSendBatchingEnabled(true);
+
+	SocketAddress serverAddress;
+	{
+		std::string serverIP;
+		if (!Sockets::resolveToIP(mSettings.mServerName, serverIP))
+			RMX_ERROR("Unable to resolve server name " << mSettings.mServerName, return);
+		serverAddress.set(serverIP, mSettings.mUseTCP ? mSettings.mTCPPort : mSettings.mUDPPort);
+	}
+
+	mRampUpStartTime = getMicroseconds();
+	while (running)
+	{
+		const uint64 currentTimestamp = getCurrentTimestamp();
+		const uint64 currentMicroseconds = getMicroseconds();
+
+		startNextConnections(connectionManager, serverAddress, currentMicroseconds);
+
+		const bool anyActivity = updateReceivePackets(connectionManager);
+		connectionManager.updateConnections(currentTimestamp);
+
+		for (size_t k = 0; k < mNumStartedClients; ++k)
+		{
+			updateClient(*mClients[k], currentMicroseconds);
+		}
+		connectionManager.flushSendBatch();
+
+		if (!anyActivity)
+		{
+			connectionManager.waitForActivity(getCurrentTimestamp(), 1);
+		}
+	}
+
+	for (const auto& client : mClients)
+	{
+		if (client->mConnection.getState() == NetConnection::State::CONNECTED)
+			client->mConnection.disconnect();
+	}
+	connectionManager.flushSendBatch();
+}
+
+void LoadTestWorker::collectLatencies(std::vector<uint32>& broadcastLatencies, std::vector<uint32>& requestLatencies) const
+{
+	broadcastLatencies.insert(broadcastLatencies.end(), mBroadcastLatencies.begin(), mBroadcastLatencies.end());
+	requestLatencies.insert(requestLatencies.end(), mRequestLatencies.begin(), mRequestLatencies.end());
+}
+
+bool LoadTestWorker::onReceivedPacket(ReceivedPacketEvaluation& evaluation)
+{
+	if (evaluation.mPacketType != network::ChannelMessagePacket::PACKET_TYPE)
+		return false;
+
+	network::ChannelMessagePacket packet;
+	if (!evaluation.readPacket(packet))
+		return false;
+
+	if (packet.mMessageType != LOADTEST_MESSAGE_TYPE || packet.mMessage.size() < MIN_MESSAGE_SIZE)
+		return true;
+
+	++mStatistics.mMessagesReceived;
+	if (mStatistics.mMeasuring)
+	{
+		// All simulated clients run in this process, so the send time can be compared with the local clock
+		const uint64 sendTime = *reinterpret_cast<const uint64*>(&packet.mMessage[0]);
+		const uint64 currentMicroseconds = getMicroseconds();
+		if (currentMicroseconds >= sendTime)
+			mBroadcastLatencies.push_back((uint32)std::min<uint64>(currentMicroseconds - sendTime, 0xffffffff));
+	}
+	return true;
+}
+
+void LoadTestWorker::startNextConnections(ConnectionManager& connectionManager, const SocketAddress& serverAddress, uint64 currentMicroseconds)
+{
+	if (mNumStartedClients >= mClients.size())
+		return;
+
+	// Each worker gets its share of the total ramp-up rate
+	const double connectionsPerMicrosecond = (double)mSettings.mConnectionsPerSecond / (double)std::max<uint32>(mSettings.mNumThreads, 1) / 1000000.0;
+	const size_t targetCount = std::min(mClients.size(), (size_t)((double)(currentMicroseconds - mRampUpStartTime) * connectionsPerMicrosecond) + 1);
+	while (mNumStartedClients < targetCount)
+	{
+		SimulatedClient& client = *mClients[mNumStartedClients];
+		if (client.mConnection.startConnectTo(connectionManager, serverAddress, getCurrentTimestamp()))
+		{
+			client.mState = State::WAITING_FOR_CONNECTION;
+			client.mConnectStartTime = currentMicroseconds;
+		}
+		else
+		{
+			client.mState = State::FAILED;
+			++mStatistics.mFailedConnections;
+		}
+		++mNumStartedClients;
+	}
+}
+
+void LoadTestWorker::updateClient(SimulatedClient& client, uint64 currentMicroseconds)
+{
+	switch (client.mState)
+	{
+		case State::WAITING_FOR_CONNECTION:
+		{
+			if (client.mConnection.getState() == NetConnection::State::CONNECTED)
+			{
+				++mStatistics.mConnected;
+				client.mConnection.sendRequest(client.mJoinChannelRequest);
+				client.mState = State::JOIN_REQUEST_SENT;
+			}
+			else if (client.mConnection.getState() != NetConnection::State::REQUESTED_CONNECTION || currentMicroseconds > client.mConnectStartTime + CONNECT_TIMEOUT)
+			{
+				// Connection got rejected or timed out, e.g. because the server reached its connection limit
+				client.mConnection.disconnect();
+				++mStatistics.mFailedConnections;
+				client.mState = State::FAILED;
+			}
+			break;
+		}
+
+		case State::JOIN_REQUEST_SENT:
+		{
+			if (client.mJoinChannelRequest.hasResponse())
+			{
+				if (client.mJoinChannelRequest.hasSuccess() && client.mJoinChannelRequest.mResponse.mSuccessful)
+				{
+					++mStatistics.mJoinedChannel;
+					++mStatistics.mChannelMembers[client.mChannelIndex];
+
+					// Spread the first messages over one interval, so that clients don't send in lockstep
+					const uint64 messageInterval = (mSettings.mMessagesPerSecond > 0.0f) ? (uint64)(1000000.0f / mSettings.mMessagesPerSecond) : 0;
+					const uint64 updateCheckInterval = (mSettings.mUpdateChecksPerSecond > 0.0f) ? (uint64)(1000000.0f / mSettings.mUpdateChecksPerSecond) : 0;
+					client.mNextMessageTime = currentMicroseconds + ((messageInterval > 0) ? ((uint64)rand() % messageInterval) : 0);
+					client.mNextUpdateCheckTime = currentMicroseconds + ((updateCheckInterval > 0) ? ((uint64)rand() % updateCheckInterval) : 0);
+					client.mState = State::RUNNING;
+				}
+				else
+				{
+					++mStatistics.mFailedConnections;
+					client.mState = State::FAILED;
+				}
+			}
+			break;
+		}
+
+		case State::RUNNING:
+		{
+			if (client.mConnection.getState() != NetConnection::State::CONNECTED)
+			{
+				--mStatistics.mConnected;
+				--mStatistics.mJoinedChannel;
+				--mStatistics.mChannelMembers[client.mChannelIndex];
+				++mStatistics.mFailedConnections;
+				client.mState = State::FAILED;
+				break;
+			}
+
+			if (mSettings.mMessagesPerSecond > 0.0f && currentMicroseconds >= client.mNextMessageTime)
+			{
+				sendMessage(client, currentMicroseconds);
+				client.mNextMessageTime += (uint64)(1000000.0f / mSettings.mMessagesPerSecond);
+
+				// Don't try to catch up after a stall, as that would only produce a burst of messages
+				if (client.mNextMessageTime < currentMicroseconds)
+					client.mNextMessageTime = currentMicroseconds;
+			}
+
+			if (client.mUpdateCheckSentTime != 0 && client.mUpdateCheckRequest.hasResponse())
+			{
+				if (client.mUpdateCheckRequest.hasSuccess())
+				{
+					++mStatistics.mUpdateChecksAnswered;
+					if (mStatistics.mMeasuring)
+						mRequestLatencies.push_back((uint32)std::min<uint64>(currentMicroseconds - client.mUpdateCheckSentTime, 0xffffffff));
+				}
+				client.mUpdateCheckSentTime = 0;
+			}
+
+			if (mSettings.mUpdateChecksPerSecond > 0.0f && client.mUpdateCheckSentTime == 0 && currentMicroseconds >= client.mNextUpdateCheckTime)
+			{
+				client.mConnection.sendRequest(client.mUpdateCheckRequest);
+				client.mUpdateCheckSentTime = currentMicroseconds;
+				client.mNextUpdateCheckTime = currentMicroseconds + (uint64)(1000000.0f / mSettings.mUpdateChecksPerSecond);
+				++mStatistics.mUpdateChecksSent;
+			}
+			break;
+		}
+
+		default:
+			break;
+	}
+}
+
+void LoadTestWorker::sendMessage(SimulatedClient& client, uint64 currentMicroseconds)
+{
+	network::BroadcastChannelMessagePacket packet;
+	packet.mChannelHash = client.mChannelHash;
+	packet.mMessageType = LOADTEST_MESSAGE_TYPE;
+	packet.mMessageVersion = 1;
+	packet.mMessage.resize(std::max<size_t>(mSettings.mMessageSize, MIN_MESSAGE_SIZE));
+	*reinterpret_cast<uint64*>(&packet.mMessage[0]) = currentMicroseconds;
+	*reinterpret_cast<uint32*>(&packet.mMessage[8]) = client.mClientIndex;
+
+	if (client.mConnection.sendPacket(packet, mSettings.mReliableMessages ? NetConnection::SendFlags::NONE : NetConnection::SendFlags::UNRELIABLE))
+	{
+		++mStatistics.mMessagesSent;
+		mStatistics.mExpectedDeliveries += mStatistics.mChannelMembers[client.mChannelIndex] - 1;
+	}
+}
+
+
+void printUsage()
+{
+	RMX_LOG_INFO("Usage: loadtest [options]");
+	RMX_LOG_INFO("  -server <name>         Server name or IP (default: " << SERVER_NAME << ")");
+	RMX_LOG_INFO("  -port <port>           Server port, UDP or TCP depending on -tcp");
+	RMX_LOG_INFO("  -tcp                   Connect via TCP instead of UDP");
+	RMX_LOG_INFO("  -clients <n>           Number of simulated clients (default: 100)");
+	RMX_LOG_INFO("  -threads <n>           Number of worker threads, each with its own socket (default: 4)");
+	RMX_LOG_INFO("  -duration <seconds>    Measurement duration after ramp-up (default: 30)");
+	RMX_LOG_INFO("  -channels <n>          Number of channels the clients get distributed among (default: 10)");
+	RMX_LOG_INFO("  -rate <n>              Broadcast messages per second per client (default: 10)");
+	RMX_LOG_INFO("  -size <bytes>          Broadcast message size (default: 100)");
+	RMX_LOG_INFO("  -reliable              Send broadcast messages reliably");
+	RMX_LOG_INFO("  -updatechecks <n>      App update checks per second per client (default: 0)");
+	RMX_LOG_INFO("  -rampup <n>            Connections started per second (default: 500)");
+	RMX_LOG_INFO("  -pid <id>              Server process ID, for measuring its CPU usage (Linux only)");
+	RMX_LOG_INFO("  -receivebench          Instead of the load test, measure the per-packet cost of the receive path locally, using -clients as number of connections");
+}
+
+bool parseArguments(int argc, char** argv, Settings& settings)
+{
+	for (int k = 1; k < argc; ++k)
+	{
+		const std::string argument = argv[k];
+		const char* value = (k + 1 < argc) ? argv[k + 1] : nullptr;
+		const auto needsValue = [&]() { if (nullptr == value) { RMX_LOG_INFO("Missing value for " << argument); return false; } ++k; return true; };
+
+		if (argument == "-tcp")
+		{
+			settings.mUseTCP = true;
+		}
+		else if (argument == "-reliable")
+		{
+			settings.mReliableMessages = true;
+		}
+		else if (argument == "-receivebench")
+		{
+			settings.mReceiveBenchmark = true;
+		}
+		else if (argument == "-server" && needsValue())		{ settings.mServerName = value; }
+		else if (argument == "-port" && needsValue())		{ settings.mUDPPort = settings.mTCPPort = (uint16)atoi(value); }
+		else if (argument == "-clients" && needsValue())	{ settings.mNumClients = (uint32)std::max(atoi(value), 1); }
+		else if (argument == "-threads" && needsValue())	{ settings.mNumThreads = (uint32)std::max(atoi(value), 1); }
+		else if (argument == "-duration" && needsValue())	{ settings.mDurationSeconds = (uint32)std::max(atoi(value), 1); }
+		else if (argument == "-channels" && needsValue())	{ settings.mNumChannels = (uint32)std::max(atoi(value), 1); }
+		else if (argument == "-rate" && needsValue())		{ settings.mMessagesPerSecond = (float)atof(value); }
+		else if (argument == "-size" && needsValue())		{ settings.mMessageSize = (uint32)std::clamp(atoi(value), 0, 0x7000); }
+		else if (argument == "-updatechecks" && needsValue()) { settings.mUpdateChecksPerSecond = (float)atof(value); }
+		else if (argument == "-rampup" && needsValue())		{ settings.mConnectionsPerSecond = (uint32)std::max(atoi(value), 1); }
+		else if (argument == "-pid" && needsValue())		{ settings.mServerProcessID = (uint32)atoi(value); }
+		else
+		{
+			printUsage();
+			return false;
+		}
+	}
+
+	settings.mNumThreads = std::min(settings.mNumThreads, settings.mNumClients);
+	return true;
+}
+
+void runLoadTest(const Settings& settings)
+{
+	Statistics statistics;
+	statistics.mChannelMembers.reset(new std::atomic<uint32>[settings.mNumChannels]);
+	for (uint32 k = 0; k < settings.mNumChannels; ++k)
+		statistics.mChannelMembers[k] = 0;
+	std::atomic<bool> running = true;
+
+	// Distribute clients among the workers
+	std::vector<std::unique_ptr<LoadTestWorker>> workers;
+	std::vector<std::thread> threads;
+	uint32 firstClientIndex = 0;
+	for (uint32 k = 0; k < settings.mNumThreads; ++k)
+	{
+		const uint32 numClients = (settings.mNumClients * (k + 1)) / settings.mNumThreads - firstClientIndex;
+		workers.emplace_back(std::make_unique<LoadTestWorker>(settings, statistics, firstClientIndex, numClients));
+		firstClientIndex += numClients;
+	}
+	for (const auto& worker : workers)
+	{
+		LoadTestWorker* workerPtr = worker.get();
+		threads.emplace_back([workerPtr, &running] { workerPtr->runWorker(running); });
+	}
+
+	RMX_LOG_INFO("Starting " << settings.mNumClients << " clients on " << settings.mNumThreads << " threads, connecting to " << settings.mServerName << " via " << (settings.mUseTCP ? "TCP" : "UDP"));
+
+	// Ramp-up phase: wait until all clients joined their channel (or failed), but not forever
+	const uint64 rampUpStart = ServerClientBase::getCurrentTimestamp();
+	const uint64 rampUpTimeout = (uint64)settings.mNumClients * 1000 / settings.mConnectionsPerSecond + 10000;
+	while (statistics.mJoinedChannel + statistics.mFailedConnections < settings.mNumClients && ServerClientBase::getCurrentTimestamp() - rampUpStart < rampUpTimeout)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	}
+	RMX_LOG_INFO("Ramp-up done after " << (ServerClientBase::getCurrentTimestamp() - rampUpStart) << " ms: " << statistics.mJoinedChannel << " clients joined, " << statistics.mFailedConnections << " failed");
+
+	// Measurement phase
+	const uint64 messagesSentStart = statistics.mMessagesSent;
+	const uint64 messagesReceivedStart = statistics.mMessagesReceived;
+	const uint64 expectedDeliveriesStart = statistics.mExpectedDeliveries;
+	const uint64 updateChecksStart = statistics.mUpdateChecksAnswered;
+	const double cpuTimeStart = getProcessCPUTime(settings.mServerProcessID);
+	const uint64 measureStart = ServerClientBase::getCurrentTimestamp();
+	statistics.mMeasuring = true;
+
+	uint64 lastMessagesSent = messagesSentStart;
+	uint64 lastMessagesReceived = messagesReceivedStart;
+	uint64 lastUpdateChecks = updateChecksStart;
+	double lastCPUTime = cpuTimeStart;
+	for (uint32 second = 1; second <= settings.mDurationSeconds; ++second)
+	{
+		// Sleep until the next full second of the measurement
+		const uint64 targetTime = measureStart + second * 1000;
+		const uint64 now = ServerClientBase::getCurrentTimestamp();
+		if (targetTime > now)
+			std::this_thread::sleep_for(std::chrono::milliseconds(targetTime - now));
+
+		const uint64 messagesSent = statistics.mMessagesSent;
+		const uint64 messagesReceived = statistics.mMessagesReceived;
+		const uint64 updateChecks = statistics.mUpdateChecksAnswered;
+		const double cpuTime = getProcessCPUTime(settings.mServerProcessID);
+
+		std::string line = "[" + std::to_string(second) + " s] " + std::to_string(statistics.mJoinedChannel) + " clients, sent " + std::to_string(messagesSent - lastMessagesSent) + " msg/s, received " + std::to_string(messagesReceived - lastMessagesReceived) + " msg/s";
+		if (settings.mUpdateChecksPerSecond > 0.0f)
+			line += ", " + std::to_string(updateChecks - lastUpdateChecks) + " update checks/s";
+		if (cpuTime >= 0.0 && lastCPUTime >= 0.0)
+			line += ", server CPU " + std::to_string((int)((cpuTime - lastCPUTime) * 100.0 + 0.5)) + "%";
+		RMX_LOG_INFO(line);
+
+		lastMessagesSent = messagesSent;
+		lastMessagesReceived = messagesReceived;
+		lastUpdateChecks = updateChecks;
+		lastCPUTime = cpuTime;
+	}
+
+	statistics.mMeasuring = false;
+	const double seconds = (double)(ServerClientBase::getCurrentTimestamp() - measureStart) / 1000.0;
+	const double cpuTimeEnd = getProcessCPUTime(settings.mServerProcessID);
+
+	running = false;
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	// Summary
+	std::vector<uint32> broadcastLatencies;
+	std::vector<uint32> requestLatencies;
+	for (const auto& worker : workers)
+	{
+		worker->collectLatencies(broadcastLatencies, requestLatencies);
+	}
+
+	const double messagesSent = (double)(statistics.mMessagesSent - messagesSentStart);
+	const double messagesReceived = (double)(statistics.mMessagesReceived - messagesReceivedStart);
+	RMX_LOG_INFO("");
+	RMX_LOG_INFO("Summary over " << seconds << " seconds:");
+	RMX_LOG_INFO("Clients joined: " << statistics.mJoinedChannel << " of " << settings.mNumClients << ", failed: " << statistics.mFailedConnections);
+	RMX_LOG_INFO("Broadcast messages sent: " << (uint64)(messagesSent / seconds) << " per second");
+	RMX_LOG_INFO("Broadcast messages received: " << (uint64)(messagesReceived / seconds) << " per second");
+	{
+		// Each message is expected to reach all other clients in the same channel
+		const double expectedDeliveries = (double)(statistics.mExpectedDeliveries - expectedDeliveriesStart);
+		if (expectedDeliveries > 0.0)
+			RMX_LOG_INFO("Delivery ratio: " << (int)(messagesReceived / expectedDeliveries * 1000.0 + 0.5) / 10.0 << "%");
+	}
+	printLatencies("Broadcast latency", broadcastLatencies);
+	if (settings.mUpdateChecksPerSecond > 0.0f)
+	{
+		RMX_LOG_INFO("Update checks answered: " << (uint64)((double)(statistics.mUpdateChecksAnswered - updateChecksStart) / seconds) << " per second");
+		printLatencies("Update check round trip", requestLatencies);
+	}
+	if (cpuTimeStart >= 0.0 && cpuTimeEnd >= 0.0)
+	{
+		RMX_LOG_INFO("Server CPU usage: " << (int)((cpuTimeEnd - cpuTimeStart) / seconds * 1000.0 + 0.5) / 10.0 << "% of one core");
+	}
+}
+
+
+int main(int argc, char** argv)
+{
+	randomize();
+	rmx::Logging::addLogger(*new rmx::StdCoutLogger());
+
+	Settings settings;
+	if (!parseArguments(argc, argv, settings))
+		return 1;
+
+	Sockets::startupSockets();
+	if (settings.mReceiveBenchmark)
+		runReceiveBenchmark(settings.mNumClients, 10000000);
+	else
+		runLoadTest(settings);
+	Sockets::shutdownSockets();
+	return 0;
+}
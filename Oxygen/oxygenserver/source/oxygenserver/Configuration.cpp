@@ -25,5 +25,11 @@ bool Configuration::loadConfiguration(const std::wstring& filename)
 
 	rootHelper.tryReadAsInt("UDPPort", mUDPPort);
 	rootHelper.tryReadAsInt("TCPPort", mTCPPort);
+	rootHelper.tryReadBool("UseReceiveThread", mUseReceiveThread);
+	rootHelper.tryReadBool("UseSocketPoller", mUseSocketPoller);
+	rootHelper.tryReadBool("UseSendBatching", mUseSendBatching);
+	rootHelper.tryReadAsInt("MaxConnections", mMaxConnections);
+	rootHelper.tryReadAsInt("NumShards", mNumShards);
+	rootHelper.tryReadAsInt("FileTransferBytesPerSecond", mFileTransferBytesPerSecond);
 	return true;
 }
@@ -19,6 +19,9 @@ public:
 	inline static bool hasInstance()		 { return (nullptr != mSingleInstance); }
 	inline static Configuration& instance()  { return *mSingleInstance; }
 
+public:
+	static const constexpr uint32 DEFAULT_FILE_TRANSFER_BYTES_PER_SECOND = 0x200000;
+
 public:
 	Configuration();
 
@@ -28,6 +31,14 @@ public:
 	// Server setup
 	uint16 mUDPPort = 0;
 	uint16 mTCPPort = 0;
+	bool mUseReceiveThread = true;		// Receive UDP packets on a dedicated thread
+	bool mUseSocketPoller = true;		// Wait for socket activity with epoll instead of polling, where supported
+	bool mUseSendBatching = true;		// Send UDP packets in batches, using sendmmsg where supported
+	uint32 mMaxConnections = 0x100;		// Limit for the number of concurrent connections
+	uint32 mNumShards = 0;				// Number of server shards, each running on its own thread with its own sockets; 0 means one per CPU core
+
+	// File transfer
+	uint32 mFileTransferBytesPerSecond = DEFAULT_FILE_TRANSFER_BYTES_PER_SECOND;	// Maximum rate for sending file pieces, per connection
 
 private:
 	static inline Configuration* mSingleInstance = nullptr;
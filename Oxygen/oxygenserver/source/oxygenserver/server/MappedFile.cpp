@@ -0,0 +1,120 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#include "oxygenserver/pch.h"
+#include "oxygenserver/server/MappedFile.h"
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+	#undef ERROR
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const std::wstring& path)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE fileHandle = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!::GetFileSizeEx(fileHandle, &fileSize))
+	{
+		::CloseHandle(fileHandle);
+		return false;
+	}
+	mFileHandle = fileHandle;
+	mSize = (uint64)fileSize.QuadPart;
+	if (mSize == 0)
+	{
+		mIsEmptyFile = true;
+		return true;
+	}
+
+	mMappingHandle = ::CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (nullptr == mMappingHandle)
+	{
+		close();
+		return false;
+	}
+
+	mData = (const uint8*)::MapViewOfFile(mMappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (nullptr == mData)
+	{
+		close();
+		return false;
+	}
+	return true;
+
+#else
+	const int fileDescriptor = ::open(*WString(path).toUTF8(), O_RDONLY);
+	if (fileDescriptor < 0)
+		return false;
+
+	struct stat fileStats;
+	if (::fstat(fileDescriptor, &fileStats) != 0)
+	{
+		::close(fileDescriptor);
+		return false;
+	}
+
+	mSize = (uint64)fileStats.st_size;
+	if (mSize == 0)
+	{
+		::close(fileDescriptor);
+		mIsEmptyFile = true;
+		return true;
+	}
+
+	// The mapping stays valid after closing the file descriptor
+	void* data = ::mmap(nullptr, (size_t)mSize, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+	::close(fileDescriptor);
+	if (data == MAP_FAILED)
+	{
+		mSize = 0;
+		return false;
+	}
+
+	mData = (const uint8*)data;
+	return true;
+#endif
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (nullptr != mData)
+		::UnmapViewOfFile(mData);
+	if (nullptr != mMappingHandle)
+		::CloseHandle((HANDLE)mMappingHandle);
+	if (nullptr != mFileHandle)
+		::CloseHandle((HANDLE)mFileHandle);
+	mMappingHandle = nullptr;
+	mFileHandle = nullptr;
+#else
+	if (nullptr != mData)
+		::munmap(const_cast<uint8*>(mData), (size_t)mSize);
+#endif
+
+	mData = nullptr;
+	mSize = 0;
+	mIsEmptyFile = false;
+}
@@ -0,0 +1,40 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#pragma once
+
+#include <rmxbase.h>
+
+
+// Read-only memory-mapped file
+//  -> File contents get paged in by the OS only when accessed, and can be shared between all users without keeping a copy in memory
+class MappedFile
+{
+public:
+	MappedFile() {}
+	MappedFile(const MappedFile&) = delete;
+	~MappedFile();
+
+	inline bool isOpen() const			{ return (nullptr != mData || mIsEmptyFile); }
+	inline const uint8* getData() const	{ return mData; }
+	inline uint64 getSize() const		{ return mSize; }
+
+	bool open(const std::wstring& path);
+	void close();
+
+	MappedFile& operator=(const MappedFile&) = delete;
+
+private:
+	const uint8* mData = nullptr;
+	uint64 mSize = 0;
+	bool mIsEmptyFile = false;	// Empty files can't be mapped, but are still valid files
+#ifdef _WIN32
+	void* mFileHandle = nullptr;
+	void* mMappingHandle = nullptr;
+#endif
+};
@@ -8,43 +8,36 @@
 
 #pragma once
 
-#include "oxygen_netcore/network/ServerClientBase.h"
+#include "oxygen_netcore/network/NetConnection.h"
 #include "oxygen_netcore/serverclient/Packets.h"
 
-#include "oxygenserver/server/ServerNetConnection.h"
-#include "oxygenserver/subsystems/Channels.h"
-#include "oxygenserver/subsystems/UpdateCheck.h"
+#include "oxygenserver/subsystems/ReplicatedChannelState.h"
 #include "oxygenserver/subsystems/VirtualDirectory.h"
 
+#include <memory>
 
-class Server : public ServerClientBase
+class ServerShard;
+
+
+class Server
 {
 public:
-	void runServer();
+	Server();
+	~Server();
 
-protected:
-	// From ServerClientBase
-	virtual NetConnection* createNetConnection(ConnectionManager& connectionManager, const SocketAddress& senderAddress) override;
-	virtual void destroyNetConnection(NetConnection& connection) override;
+	void runServer();
 
-	// From ConnectionListenerInterface
-	virtual bool onReceivedPacket(ReceivedPacketEvaluation& evaluation) override;
-	virtual bool onReceivedRequestQuery(ReceivedQueryEvaluation& evaluation) override;
+	inline VirtualDirectory& getVirtualDirectory()  { return mVirtualDirectory; }
+	inline ReplicatedChannelState& getReplicatedChannelState()  { return mReplicatedChannelState; }
 
-private:
-	void performCleanup();
+	// Pass a channel broadcast on to all shards except for the source shard
+	void forwardChannelBroadcast(uint32 sourceShardIndex, const std::shared_ptr<const network::ChannelMessagePacket>& packet, NetConnection::SendFlags::Flags sendFlags);
 
 private:
-	// Connection management
-	std::unordered_map<uint32, ServerNetConnection*> mNetConnectionsByPlayerID;
-	ObjectPool<ServerNetConnection> mNetConnectionPool;
-	uint64 mLastCleanupTimestamp = 0;
-
-	// Sub-systems
-	Channels mChannels;
-	UpdateCheck mUpdateCheck;
+	// Shared between all shards, these are thread-safe
 	VirtualDirectory mVirtualDirectory;
+	ReplicatedChannelState mReplicatedChannelState;
 
-	// Cached data
-	network::GetServerFeaturesRequest mCachedServerFeaturesRequest;
+	// Each shard runs on its own thread, the first one on the main thread
+	std::vector<std::unique_ptr<ServerShard>> mShards;
 };
@@ -12,6 +12,5 @@
 
 void ServerNetConnection::unregisterPlayer()
 {
-	// TODO: Unregister this player where needed (e.g. in all channels the player is currently added)
-
+	// Nothing left to do here, as channel memberships and file transfers already get removed by "ServerShard::destroyNetConnection"
 }
@@ -13,6 +13,8 @@
 
 class ServerNetConnection : public NetConnection
 {
+friend class Channels;
+
 public:
 	inline explicit ServerNetConnection(uint32 playerID) :
 		mPlayerID(playerID),
@@ -21,10 +23,12 @@ public:
 
 	inline uint32 getPlayerID() const  { return mPlayerID; }
 	inline const std::string& getHexPlayerID() const  { return mHexPlayerID; }
+	inline const std::vector<uint32>& getJoinedChannels() const  { return mJoinedChannels; }
 
 	void unregisterPlayer();
 
 private:
 	uint32 mPlayerID = 0;
 	std::string mHexPlayerID;
+	std::vector<uint32> mJoinedChannels;	// IDs of all channels this player is in, managed by Channels
 };
@@ -0,0 +1,274 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#include "oxygenserver/pch.h"
+#include "oxygenserver/server/ServerShard.h"
+#include "oxygenserver/server/Server.h"
+#include "oxygenserver/Configuration.h"
+
+#include "oxygen_netcore/network/LagStopwatch.h"
+#include "oxygen_netcore/serverclient/ProtocolVersion.h"
+
+#include "Shared.h"
+
+
+ServerShard::ServerShard(Server& server, uint32 shardIndex, uint32 numShards) :
+	mServer(server),
+	mShardIndex(shardIndex),
+	mNumShards(numShards),
+	mChannels(*this, server.getReplicatedChannelState()),
+	mFileTransfer(server.getVirtualDirectory())
+{
+}
+
+ServerShard::~ServerShard()
+{
+	// Destroy the connection manager before the sockets it uses
+	mConnectionManager.reset();
+}
+
+bool ServerShard::setupShard(uint16 udpPort, uint16 tcpPort)
+{
+	Configuration& config = Configuration::instance();
+
+	// Setup sockets, all shards share the same ports if there's more than one
+	if (!mUDPSocket.bindToPort(udpPort, hasOtherShards()))
+		RMX_ERROR("UDP socket bind to port " << udpPort << " failed in shard " << mShardIndex, return false);
+
+	if (!mTCPListenSocket.setupServer(tcpPort, hasOtherShards()))
+		RMX_ERROR("TCP socket bind to port " << tcpPort << " failed in shard " << mShardIndex, return false);
+
+	// Setup connection manager
+	mConnectionManager.reset(new ConnectionManager(&mUDPSocket, &mTCPListenSocket, *this, network::HIGHLEVEL_PROTOCOL_VERSION_RANGE));
+#ifdef DEBUG
+	setupDebugSettings(mConnectionManager->mDebugSettings);
+#endif
+	if (config.mUseReceiveThread)
+	{
+		mConnectionManager->startReceiveThread();
+	}
+	if (config.mUseSendBatching)
+	{
+		mConnectionManager->setSendBatchingEnabled(true);
+	}
+	if (config.mUseSocketPoller)
+	{
+		mConnectionManager->startSocketPoller();
+	}
+
+	// The connection limit gets split between all shards
+	setMaxConnections(config.mMaxConnections / mNumShards + 1);
+
+	// Prepare cached data
+	{
+		// Fill in available features
+		mCachedServerFeaturesRequest.mResponse.mFeatures.emplace_back(network::GetServerFeaturesRequest::Response::Feature("app-update-check", 1, 1));
+		mCachedServerFeaturesRequest.mResponse.mFeatures.emplace_back(network::GetServerFeaturesRequest::Response::Feature("channel-broadcasting", 1, 1));
+		mCachedServerFeaturesRequest.mResponse.mFeatures.emplace_back(network::GetServerFeaturesRequest::Response::Feature("file-download", 1, 1));
+	}
+	return true;
+}
+
+void ServerShard::runShard()
+{
+	ConnectionManager& connectionManager = *mConnectionManager;
+
+	// Prepare timing
+	uint64 lastTimestamp = getCurrentTimestamp();
+	mLastCleanupTimestamp = lastTimestamp;
+
+	// Run the main loop
+	while (true)
+	{
+		const uint64 currentTimestamp = getCurrentTimestamp();
+		const uint64 millisecondsElapsed = currentTimestamp - lastTimestamp;
+		lastTimestamp = currentTimestamp;
+
+		// Check for new packets and messages from other shards
+		{
+			LAG_STOPWATCH("updateReceivePackets", 2000);
+			bool anyActivity = updateReceivePackets(connectionManager);
+			anyActivity |= handleShardMessages();
+			if (!anyActivity)
+			{
+				// Nothing to do at the moment, wait for new packets, but not past the next cleanup
+				//  -> Pending file transfers need regular updates as well
+				//  -> Other shards interrupt the wait when posting a message
+				const uint64 nextCleanupTimestamp = mLastCleanupTimestamp + 5000;
+				const uint64 timestamp = getCurrentTimestamp();
+				if (timestamp < nextCleanupTimestamp)
+				{
+					const uint32 maxMilliseconds = mFileTransfer.hasQueuedPieces() ? 5 : (uint32)(nextCleanupTimestamp - timestamp);
+					connectionManager.waitForActivity(timestamp, maxMilliseconds);
+				}
+			}
+		}
+
+		{
+			LAG_STOPWATCH("updateTransfers", 2000);
+			mFileTransfer.updateTransfers(getCurrentTimestamp());
+		}
+
+		{
+			LAG_STOPWATCH("updateConnections", 2000);
+			connectionManager.updateConnections(currentTimestamp);
+		}
+
+		{
+			// Send out all responses, broadcasts and file pieces queued in this iteration
+			LAG_STOPWATCH("flushSendBatch", 2000);
+			connectionManager.flushSendBatch();
+		}
+
+		// Perform cleanup regularly
+		if (currentTimestamp - mLastCleanupTimestamp > 5000)	// Every 5 seconds
+		{
+			LAG_STOPWATCH("performCleanup", 2000);
+			performCleanup();
+			mLastCleanupTimestamp = currentTimestamp;
+		}
+	}
+}
+
+void ServerShard::forwardChannelBroadcast(const network::ChannelMessagePacket& packet, NetConnection::SendFlags::Flags sendFlags)
+{
+	// Make a single copy that all other shards can share
+	const std::shared_ptr<const network::ChannelMessagePacket> sharedPacket = std::make_shared<network::ChannelMessagePacket>(packet);
+	mServer.forwardChannelBroadcast(mShardIndex, sharedPacket, sendFlags);
+}
+
+void ServerShard::postChannelBroadcast(const std::shared_ptr<const network::ChannelMessagePacket>& packet, NetConnection::SendFlags::Flags sendFlags)
+{
+	bool wasEmpty;
+	{
+		std::lock_guard<std::mutex> lock(mMessageQueueMutex);
+		wasEmpty = mMessageQueue.empty();
+		ShardMessage& message = vectorAdd(mMessageQueue);
+		message.mPacket = packet;
+		message.mSendFlags = sendFlags;
+	}
+
+	// Wake up the shard's thread, unless an earlier message already did that
+	if (wasEmpty)
+	{
+		mConnectionManager->interruptWait();
+	}
+}
+
+NetConnection* ServerShard::createNetConnection(ConnectionManager& connectionManager, const SocketAddress& senderAddress)
+{
+	while (true)
+	{
+		// Player IDs encode the shard index, so that they are unique across all shards
+		const uint32 randomID = (uint32)(rand() & 0xff) + ((uint32)(rand() % 0xff) << 8) + ((uint32)(rand() % 0xff) << 16) + ((uint32)(rand() % 0xff) << 24);
+		const uint64 shardedID = (uint64)(randomID - randomID % mNumShards) + mShardIndex;
+		if (shardedID > 0xffffffff)
+			continue;
+
+		const uint32 playerID = (uint32)shardedID;
+		if (mNetConnectionsByPlayerID.count(playerID) == 0)
+		{
+			ServerNetConnection& connection = mNetConnectionPool.createObject(playerID);
+			mNetConnectionsByPlayerID[playerID] = &connection;
+			RMX_LOG_INFO("Created new connection with player ID " << connection.getHexPlayerID() << " in shard " << mShardIndex << " (now " << mNetConnectionsByPlayerID.size() << " connections in this shard)");
+			return &connection;
+		}
+	}
+	return nullptr;
+}
+
+void ServerShard::destroyNetConnection(NetConnection& connection)
+{
+	ServerNetConnection& serverNetConnection = static_cast<ServerNetConnection&>(connection);
+	RMX_LOG_INFO("Removing connection with player ID " << serverNetConnection.getHexPlayerID() << " in shard " << mShardIndex << " (now " << (mNetConnectionsByPlayerID.size() - 1) << " connections in this shard)");
+
+	mChannels.removePlayerFromAllChannels(serverNetConnection);
+	mFileTransfer.removeTransfersOfConnection(serverNetConnection);
+	serverNetConnection.unregisterPlayer();
+	mNetConnectionsByPlayerID.erase(serverNetConnection.getPlayerID());
+	mNetConnectionPool.destroyObject(serverNetConnection);
+}
+
+bool ServerShard::onReceivedPacket(ReceivedPacketEvaluation& evaluation)
+{
+	// Go through sub-systems
+	if (mChannels.onReceivedPacket(evaluation))
+		return true;
+	if (mFileTransfer.onReceivedPacket(evaluation))
+		return true;
+
+	// Failed
+	return false;
+}
+
+bool ServerShard::onReceivedRequestQuery(ReceivedQueryEvaluation& evaluation)
+{
+	LAG_STOPWATCH("## ServerShard::onReceivedRequestQuery", 1000);
+
+	switch (evaluation.mPacketType)
+	{
+		case network::GetServerFeaturesRequest::Query::PACKET_TYPE:
+		{
+			// Re-use the already prepared request instance
+			network::GetServerFeaturesRequest& request = mCachedServerFeaturesRequest;
+			if (!evaluation.readQuery(request))
+				return false;
+
+			// Nothing more to change, the response is already filled in
+			return evaluation.respond(request);
+		}
+	}
+
+	// Go through sub-systems
+	if (mChannels.onReceivedRequestQuery(evaluation))
+		return true;
+	if (mUpdateCheck.onReceivedRequestQuery(evaluation))
+		return true;
+	if (mFileTransfer.onReceivedRequestQuery(evaluation))
+		return true;
+
+	// Failed
+	return false;
+}
+
+bool ServerShard::handleShardMessages()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMessageQueueMutex);
+		if (mMessageQueue.empty())
+			return false;
+		mMessagesToHandle.swap(mMessageQueue);
+	}
+
+	for (const ShardMessage& message : mMessagesToHandle)
+	{
+		mChannels.onForwardedBroadcast(*message.mPacket, message.mSendFlags);
+	}
+	mMessagesToHandle.clear();
+	return true;
+}
+
+void ServerShard::performCleanup()
+{
+	// Check for disconnected and empty connection instances
+	std::vector<NetConnection*> connectionsToRemove;
+	for (auto& pair : mNetConnectionsByPlayerID)
+	{
+		if (pair.second->getState() == NetConnection::State::DISCONNECTED || pair.second->getState() == NetConnection::State::EMPTY)
+		{
+			connectionsToRemove.push_back(pair.second);
+		}
+	}
+	for (NetConnection* connection : connectionsToRemove)
+	{
+		destroyNetConnection(*connection);
+	}
+
+	// Remove file transfers that are not used any more
+	mFileTransfer.removeInactiveTransfers(getCurrentTimestamp());
+}
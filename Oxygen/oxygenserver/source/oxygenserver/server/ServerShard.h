@@ -0,0 +1,96 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#pragma once
+
+#include "oxygen_netcore/network/ConnectionManager.h"
+#include "oxygen_netcore/network/NetConnection.h"
+#include "oxygen_netcore/network/ServerClientBase.h"
+#include "oxygen_netcore/serverclient/Packets.h"
+
+#include "oxygenserver/server/ServerNetConnection.h"
+#include "oxygenserver/subsystems/Channels.h"
+#include "oxygenserver/subsystems/FileTransfer.h"
+#include "oxygenserver/subsystems/UpdateCheck.h"
+
+#include <memory>
+#include <mutex>
+
+class Server;
+
+
+// A server shard handles a part of all connections on its own thread
+//  -> Each shard has its own sockets bound to the same ports, and the system distributes incoming datagrams and TCP connections among them
+//  -> Everything belonging to a connection, like resending, requests, channel membership and file transfers, stays inside its shard
+//  -> Shards only communicate via their message queue, e.g. for channel broadcasts to players in other shards
+class ServerShard : public ServerClientBase
+{
+public:
+	ServerShard(Server& server, uint32 shardIndex, uint32 numShards);
+	~ServerShard();
+
+	inline uint32 getShardIndex() const  { return mShardIndex; }
+	inline bool hasOtherShards() const	 { return (mNumShards > 1); }
+
+	bool setupShard(uint16 udpPort, uint16 tcpPort);
+	void runShard();
+
+	// Forward a channel broadcast to all other shards, only to be called from this shard's own thread
+	void forwardChannelBroadcast(const network::ChannelMessagePacket& packet, NetConnection::SendFlags::Flags sendFlags);
+
+	// Add a channel broadcast from another shard to the message queue; this may be called from any thread
+	void postChannelBroadcast(const std::shared_ptr<const network::ChannelMessagePacket>& packet, NetConnection::SendFlags::Flags sendFlags);
+
+protected:
+	// From ServerClientBase
+	virtual NetConnection* createNetConnection(ConnectionManager& connectionManager, const SocketAddress& senderAddress) override;
+	virtual void destroyNetConnection(NetConnection& connection) override;
+
+	// From ConnectionListenerInterface
+	virtual bool onReceivedPacket(ReceivedPacketEvaluation& evaluation) override;
+	virtual bool onReceivedRequestQuery(ReceivedQueryEvaluation& evaluation) override;
+
+private:
+	struct ShardMessage
+	{
+		std::shared_ptr<const network::ChannelMessagePacket> mPacket;	// Shared between all receiving shards, so it must not be modified
+		NetConnection::SendFlags::Flags mSendFlags = NetConnection::SendFlags::NONE;
+	};
+
+private:
+	bool handleShardMessages();
+	void performCleanup();
+
+private:
+	Server& mServer;
+	const uint32 mShardIndex = 0;
+	const uint32 mNumShards = 1;
+
+	// Networking
+	UDPSocket mUDPSocket;
+	TCPSocket mTCPListenSocket;
+	std::unique_ptr<ConnectionManager> mConnectionManager;
+
+	// Connection management
+	std::unordered_map<uint32, ServerNetConnection*> mNetConnectionsByPlayerID;
+	ObjectPool<ServerNetConnection> mNetConnectionPool;
+	uint64 mLastCleanupTimestamp = 0;
+
+	// Sub-systems
+	Channels mChannels;
+	UpdateCheck mUpdateCheck;
+	FileTransfer mFileTransfer;
+
+	// Messages from other shards
+	std::mutex mMessageQueueMutex;
+	std::vector<ShardMessage> mMessageQueue;		// Filled by other shards, protected by the mutex
+	std::vector<ShardMessage> mMessagesToHandle;	// Only used by this shard's thread
+
+	// Cached data
+	network::GetServerFeaturesRequest mCachedServerFeaturesRequest;
+};
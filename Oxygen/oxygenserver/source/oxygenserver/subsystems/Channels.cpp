@@ -9,11 +9,19 @@
 #include "oxygenserver/pch.h"
 #include "oxygenserver/subsystems/Channels.h"
 #include "oxygenserver/server/ServerNetConnection.h"
+#include "oxygenserver/server/ServerShard.h"
+#include "oxygenserver/subsystems/ReplicatedChannelState.h"
 
 #include "oxygen_netcore/network/LagStopwatch.h"
 #include "oxygen_netcore/serverclient/Packets.h"
 
 
+Channels::Channels(ServerShard& shard, ReplicatedChannelState& replicatedState) :
+	mShard(shard),
+	mReplicatedState(replicatedState)
+{
+}
+
 bool Channels::onReceivedPacket(ReceivedPacketEvaluation& evaluation)
 {
 	switch (evaluation.mPacketType)
@@ -27,8 +35,6 @@ bool Channels::onReceivedPacket(ReceivedPacketEvaluation& evaluation)
 
 			ServerNetConnection& connection = static_cast<ServerNetConnection&>(evaluation.mConnection);
 
-			// TODO: Handle "packet.mIsReplicatedData" by saving the data inside the player data
-
 			Channel* channel = findChannel(packet.mChannelHash);
 			if (nullptr == channel)
 			{
@@ -40,17 +46,7 @@ bool Channels::onReceivedPacket(ReceivedPacketEvaluation& evaluation)
 			}
 			else
 			{
-				bool playerIsInChannel = false;
-				for (const Channels::PlayerData& player : channel->mPlayers)
-				{
-					if (player.mServerNetConnection == &connection)
-					{
-						playerIsInChannel = true;
-						break;
-					}
-				}
-
-				if (!playerIsInChannel)
+				if (!channel->hasPlayer(connection.getPlayerID()))
 				{
 					// Send back an error
 					network::ChannelErrorPacket errorPacket;
@@ -58,23 +54,41 @@ bool Channels::onReceivedPacket(ReceivedPacketEvaluation& evaluation)
 					errorPacket.mParameter = packet.mChannelHash;
 					connection.sendPacket(errorPacket, NetConnection::SendFlags::UNRELIABLE);
 				}
-				else if (channel->mPlayers.size() >= 2)
+				else
 				{
+					// Broadcast unreliably if that's how the message got sent to the server
+					NetConnection::SendFlags::Flags sendFlags = (evaluation.mUniquePacketID == 0) ? NetConnection::SendFlags::UNRELIABLE : NetConnection::SendFlags::NONE;
+
+					uint32 replicatedDataRevision = 0;
+					if (packet.mIsReplicatedData)
+					{
+						// Store the player's state for players joining later
+						if (!mReplicatedState.updatePlayerState(channel->mID, connection.getPlayerID(), packet, replicatedDataRevision))
+						{
+							// Nothing changed, so all other players already got this
+							return true;
+						}
+
+						// Replicated data does not get sent again by the server, so it has to arrive
+						sendFlags = NetConnection::SendFlags::NONE;
+					}
+
+					if (channel->mPlayers.size() < 2 && !mShard.hasOtherShards())
+						return true;
+
 					// Prepare the packet to send
 					network::ChannelMessagePacket broadcastedPacket;
 					static_cast<network::BroadcastChannelMessagePacket&>(broadcastedPacket) = packet;	// Copy all the shared members
 					broadcastedPacket.mSendingPlayerID = connection.getPlayerID();
+					broadcastedPacket.mReplicatedDataRevision = replicatedDataRevision;
 
-					// Broadcast unreliably if that's how the message got sent to the server
-					const NetConnection::SendFlags::Flags sendFlags = (evaluation.mUniquePacketID == 0) ? NetConnection::SendFlags::UNRELIABLE : NetConnection::SendFlags::NONE;
+					// Send to the other players in this shard, ignoring the sending player
+					sendToChannelPlayers(*channel, broadcastedPacket, sendFlags, &connection);
 
-					for (const PlayerData& playerData : channel->mPlayers)
+					// Players in other shards are handled there
+					if (mShard.hasOtherShards())
 					{
-						// Ignore the sending player
-						if (playerData.mServerNetConnection != &connection)
-						{
-							playerData.mServerNetConnection->sendPacket(broadcastedPacket, sendFlags);
-						}
+						mShard.forwardChannelBroadcast(broadcastedPacket, sendFlags);
 					}
 				}
 			}
@@ -109,7 +123,16 @@ bool Channels::onReceivedRequestQuery(ReceivedQueryEvaluation& evaluation)
 
 			// Done
 			request.mResponse.mSuccessful = true;
-			return evaluation.respond(request);
+			if (!evaluation.respond(request))
+				return false;
+
+			// Send a snapshot of the replicated data of all other players in the channel
+			mReplicatedState.buildChannelSnapshot(baseChannel->mID, connection.getPlayerID(), mSnapshotPackets);
+			for (network::ChannelMessagePacket& snapshotPacket : mSnapshotPackets)
+			{
+				connection.sendPacket(snapshotPacket);
+			}
+			return true;
 		}
 
 		case network::LeaveChannelRequest::Query::PACKET_TYPE:
@@ -139,6 +162,16 @@ bool Channels::onReceivedRequestQuery(ReceivedQueryEvaluation& evaluation)
 	return false;
 }
 
+void Channels::onForwardedBroadcast(const network::ChannelMessagePacket& packet, NetConnection::SendFlags::Flags sendFlags)
+{
+	// The channel only exists in this shard if any of its players are here
+	Channel* channel = findChannel(packet.mChannelHash);
+	if (nullptr != channel)
+	{
+		sendToChannelPlayers(*channel, packet, sendFlags, nullptr);
+	}
+}
+
 Channels::Channel* Channels::findChannel(uint32 channelID)
 {
 	const auto it = mAllChannels.find(channelID);
@@ -164,31 +197,71 @@ void Channels::destroyChannel(Channel& channel)
 
 void Channels::addPlayerToChannel(Channel& channel, ServerNetConnection& playerConnection)
 {
-	// TODO: The check for uniqueness could be removed if we tracked which channels a player is added to (in a map) inside the ServerNetConnection instance
-	for (const PlayerData& playerData : channel.mPlayers)
-	{
-		if (playerData.mServerNetConnection == &playerConnection)
-			return;
-	}
+	const auto [it, inserted] = channel.mPlayerIndexByID.emplace(playerConnection.getPlayerID(), channel.mPlayers.size());
+	if (!inserted)
+		return;
 
 	PlayerData& playerData = vectorAdd(channel.mPlayers);
 	playerData.mServerNetConnection = &playerConnection;
+	playerConnection.mJoinedChannels.push_back(channel.mID);
 }
 
 void Channels::removePlayerFromSingleChannel(Channel& channel, ServerNetConnection& playerConnection)
 {
-	for (auto it = channel.mPlayers.begin(); it != channel.mPlayers.end(); ++it)
+	const auto it = channel.mPlayerIndexByID.find(playerConnection.getPlayerID());
+	if (it == channel.mPlayerIndexByID.end())
+		return;
+
+	// Fill the gap with the last player, so the index only needs to be updated for that one
+	const size_t index = it->second;
+	channel.mPlayerIndexByID.erase(it);
+	if (index + 1 < channel.mPlayers.size())
+	{
+		channel.mPlayers[index] = std::move(channel.mPlayers.back());
+		channel.mPlayerIndexByID[channel.mPlayers[index].mServerNetConnection->getPlayerID()] = index;
+	}
+	channel.mPlayers.pop_back();
+
+	mReplicatedState.removePlayerState(channel.mID, playerConnection.getPlayerID());
+
+	std::vector<uint32>& joinedChannels = playerConnection.mJoinedChannels;
+	const auto joinedIt = std::find(joinedChannels.begin(), joinedChannels.end(), channel.mID);
+	if (joinedIt != joinedChannels.end())
+		joinedChannels.erase(joinedIt);
+
+	// Is channel empty now?
+	if (channel.mPlayers.empty())
+	{
+		destroyChannel(channel);
+	}
+}
+
+void Channels::sendToChannelPlayers(Channel& channel, const network::ChannelMessagePacket& packet, NetConnection::SendFlags::Flags sendFlags, const ServerNetConnection* excludedConnection)
+{
+	if (channel.mPlayers.empty() || (channel.mPlayers.size() == 1 && channel.mPlayers[0].mServerNetConnection == excludedConnection))
+		return;
+
+	// Serialize the packet content only once for all receivers
+	highlevel::PreSerializedPacket preSerializedPacket(const_cast<network::ChannelMessagePacket&>(packet));
+	for (const PlayerData& playerData : channel.mPlayers)
 	{
-		if (it->mServerNetConnection == &playerConnection)
+		if (playerData.mServerNetConnection != excludedConnection)
 		{
-			channel.mPlayers.erase(it);
+			playerData.mServerNetConnection->sendPacket(preSerializedPacket, sendFlags);
+		}
+	}
+}
 
-			// Is channel empty now?
-			if (channel.mPlayers.empty())
-			{
-				destroyChannel(channel);
-			}
-			break;
+void Channels::removePlayerFromAllChannels(ServerNetConnection& playerConnection)
+{
+	while (!playerConnection.mJoinedChannels.empty())
+	{
+		Channel* channel = findChannel(playerConnection.mJoinedChannels.back());
+		if (nullptr == channel)
+		{
+			playerConnection.mJoinedChannels.pop_back();
+			continue;
 		}
+		removePlayerFromSingleChannel(*channel, playerConnection);
 	}
 }
@@ -9,8 +9,12 @@
 #pragma once
 
 #include "oxygen_netcore/network/ConnectionListener.h"
+#include "oxygen_netcore/network/NetConnection.h"
+#include "oxygen_netcore/serverclient/Packets.h"
 
+class ReplicatedChannelState;
 class ServerNetConnection;
+class ServerShard;
 
 
 class Channels
@@ -19,7 +23,6 @@ public:
 	struct PlayerData
 	{
 		ServerNetConnection* mServerNetConnection = nullptr;
-		std::vector<uint8> mReplicatedData;
 	};
 
 	struct Channel
@@ -27,20 +30,37 @@ public:
 		uint32 mID = 0;
 		std::string mName;
 		std::vector<PlayerData> mPlayers;
+		std::unordered_map<uint32, size_t> mPlayerIndexByID;	// Key is the player ID, value is the index in "mPlayers"
+
+		inline bool hasPlayer(uint32 playerID) const  { return (mPlayerIndexByID.count(playerID) != 0); }
 	};
 
 public:
+	// Channels only hold the players of their own server shard, broadcasts to players in other shards get forwarded there
+	//  -> Replicated data of the players is stored in the replicated channel state instead, which is shared between all shards
+	Channels(ServerShard& shard, ReplicatedChannelState& replicatedState);
+
 	bool onReceivedPacket(ReceivedPacketEvaluation& evaluation);
 	bool onReceivedRequestQuery(ReceivedQueryEvaluation& evaluation);
 
+	// Send a broadcast forwarded from another shard to the players of this shard
+	void onForwardedBroadcast(const network::ChannelMessagePacket& packet, NetConnection::SendFlags::Flags sendFlags);
+
 	Channel* findChannel(uint32 channelID);
 	Channel& createChannel(uint32 channelID, const std::string& channelName);
 	void destroyChannel(Channel& channel);
 
 	void addPlayerToChannel(Channel& channel, ServerNetConnection& playerConnection);
 	void removePlayerFromSingleChannel(Channel& channel, ServerNetConnection& playerConnection);
+	void removePlayerFromAllChannels(ServerNetConnection& playerConnection);
+
+private:
+	void sendToChannelPlayers(Channel& channel, const network::ChannelMessagePacket& packet, NetConnection::SendFlags::Flags sendFlags, const ServerNetConnection* excludedConnection);
 
 private:
+	ServerShard& mShard;
+	ReplicatedChannelState& mReplicatedState;
 	std::unordered_map<uint32, Channel*> mAllChannels;	// Key is the channel ID
 	ObjectPool<Channel> mChannelPool;
+	std::vector<network::ChannelMessagePacket> mSnapshotPackets;	// Only used temporarily, but kept to reduce allocations
 };
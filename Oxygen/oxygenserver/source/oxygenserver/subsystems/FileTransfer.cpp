@@ -0,0 +1,245 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#include "oxygenserver/pch.h"
+#include "oxygenserver/subsystems/FileTransfer.h"
+#include "oxygenserver/server/ServerNetConnection.h"
+#include "oxygenserver/Configuration.h"
+
+#include "oxygen_netcore/network/LagStopwatch.h"
+#include "oxygen_netcore/network/ServerClientBase.h"
+
+
+namespace
+{
+	const constexpr size_t MAX_QUEUED_PIECES_PER_TRANSFER = 0x400;		// That's up to about 32 MB of requested data
+	const constexpr size_t MAX_TRANSFERS_PER_CONNECTION = 4;
+	const constexpr uint64 TRANSFER_INACTIVITY_TIMEOUT = 60 * 1000;		// Remove transfers without any piece requests for one minute
+}
+
+
+FileTransfer::FileTransfer(VirtualDirectory& virtualDirectory) :
+	mVirtualDirectory(virtualDirectory)
+{
+}
+
+bool FileTransfer::onReceivedPacket(ReceivedPacketEvaluation& evaluation)
+{
+	switch (evaluation.mPacketType)
+	{
+		case network::FileTransferRequestPiecesPacket::PACKET_TYPE:
+		{
+			LAG_STOPWATCH("FileTransferRequestPiecesPacket", 500);
+			network::FileTransferRequestPiecesPacket packet;
+			if (!evaluation.readPacket(packet))
+				return false;
+
+			const auto it = mTransfers.find(packet.mTransferHandle);
+			if (it == mTransfers.end() || it->second->mConnection != &evaluation.mConnection)
+			{
+				// Unknown transfer, or one that belongs to someone else
+				return true;
+			}
+
+			Transfer& transfer = *it->second;
+			if (packet.mTransferComplete)
+			{
+				destroyTransfer(transfer);
+				return true;
+			}
+
+			transfer.mLastActivityTimestamp = ServerClientBase::getCurrentTimestamp();
+			for (const network::FileTransferRequestPiecesPacket::PieceInfo& pieceInfo : packet.mRequestedPieces)
+			{
+				enqueuePieces(transfer, pieceInfo.mChunkIndex, pieceInfo.mStartOffset, pieceInfo.mSize);
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+bool FileTransfer::onReceivedRequestQuery(ReceivedQueryEvaluation& evaluation)
+{
+	switch (evaluation.mPacketType)
+	{
+		case network::FileDownloadRequest::Query::PACKET_TYPE:
+		{
+			using Request = network::FileDownloadRequest;
+			Request request;
+			if (!evaluation.readQuery(request))
+				return false;
+
+			ServerNetConnection& connection = static_cast<ServerNetConnection&>(evaluation.mConnection);
+			RMX_LOG_INFO("FileDownloadRequest: '" << request.mQuery.mFilePath << "' (from " << connection.getHexPlayerID() << ")");
+
+			const VirtualDirectory::FileContent* fileContent = mVirtualDirectory.getFileContent(request.mQuery.mFilePath);
+			if (nullptr == fileContent || fileContent->mSize > 0xffffffff)
+			{
+				request.mResponse.mFileAvailable = false;
+				return evaluation.respond(request);
+			}
+
+			// Limit the number of transfers per connection, by replacing its least recently active transfer
+			const auto pacingIt = mConnectionPacings.find(&connection);
+			if (pacingIt != mConnectionPacings.end() && pacingIt->second.mNumTransfers >= MAX_TRANSFERS_PER_CONNECTION)
+			{
+				Transfer* oldestTransfer = nullptr;
+				for (const auto& [handle, transfer] : mTransfers)
+				{
+					if (transfer->mConnection == &connection && (nullptr == oldestTransfer || transfer->mLastActivityTimestamp < oldestTransfer->mLastActivityTimestamp))
+						oldestTransfer = transfer;
+				}
+				destroyTransfer(*oldestTransfer);
+			}
+
+			// Create a new transfer with a unique handle
+			uint32 handle = 0;
+			do
+			{
+				handle = (uint32)(rand() & 0xff) + ((uint32)(rand() & 0xff) << 8) + ((uint32)(rand() & 0xff) << 16) + ((uint32)(rand() & 0xff) << 24);
+			}
+			while (handle == 0 || mTransfers.count(handle) != 0);
+
+			const uint64 currentTimestamp = ServerClientBase::getCurrentTimestamp();
+			ConnectionPacing& pacing = mConnectionPacings[&connection];
+			if (pacing.mNumTransfers == 0)
+			{
+				pacing.mLastPacingTimestamp = currentTimestamp;
+				pacing.mByteBudget = 0;
+			}
+			++pacing.mNumTransfers;
+
+			Transfer& transfer = mTransferPool.createObject();
+			transfer.mHandle = handle;
+			transfer.mConnection = &connection;
+			transfer.mPacing = &pacing;
+			transfer.mFileContent = fileContent;
+			transfer.mQueuedPieces.clear();
+			transfer.mLastActivityTimestamp = currentTimestamp;
+			mTransfers[handle] = &transfer;
+
+			request.mResponse.mFileAvailable = true;
+			request.mResponse.mTransferHandle = handle;
+			request.mResponse.mFileSize = (uint32)fileContent->mSize;
+			request.mResponse.mFileHash = fileContent->mHash;
+			request.mResponse.mChunks.resize(fileContent->mChunks.size());
+			for (size_t k = 0; k < fileContent->mChunks.size(); ++k)
+			{
+				request.mResponse.mChunks[k].mChunkSize = (uint32)fileContent->mChunks[k].mSize;
+				request.mResponse.mChunks[k].mChunkHash = fileContent->mChunks[k].mHash;
+			}
+			return evaluation.respond(request);
+		}
+	}
+	return false;
+}
+
+void FileTransfer::updateTransfers(uint64 currentTimestamp)
+{
+	if (mNumQueuedPieces == 0)
+		return;
+
+	const uint64 bytesPerSecond = Configuration::hasInstance() ? Configuration::instance().mFileTransferBytesPerSecond : Configuration::DEFAULT_FILE_TRANSFER_BYTES_PER_SECOND;
+	const int64 maxByteBudget = (int64)std::max<uint64>(bytesPerSecond / 10, network::FileTransferPiecePacket::MAX_PIECE_SIZE);	// Allow for bursts of up to 100 ms
+
+	// Refill the byte budgets, which are per connection so that opening more transfers does not increase the rate
+	for (auto& [connection, pacing] : mConnectionPacings)
+	{
+		const uint64 elapsed = currentTimestamp - pacing.mLastPacingTimestamp;
+		pacing.mLastPacingTimestamp = currentTimestamp;
+		pacing.mByteBudget = std::min<int64>(pacing.mByteBudget + (int64)(elapsed * bytesPerSecond / 1000), maxByteBudget);
+	}
+
+	PieceWithDataPacket& packet = mPieceWithDataPacket;
+	for (auto& [handle, transfer] : mTransfers)
+	{
+		// Send as many pieces as the budget allows; the last one may overdraw it a bit
+		ConnectionPacing& pacing = *transfer->mPacing;
+		const VirtualDirectory::FileContent& fileContent = *transfer->mFileContent;
+		while (!transfer->mQueuedPieces.empty() && pacing.mByteBudget > 0)
+		{
+			const QueuedPiece& piece = transfer->mQueuedPieces.front();
+			packet.mTransferHandle = handle;
+			packet.mChunkIndex = piece.mChunkIndex;
+			packet.mStartOffset = piece.mStartOffset;
+			packet.mSize = piece.mSize;
+			packet.mData = fileContent.mMappedFile.getData() + fileContent.mChunks[piece.mChunkIndex].mStartOffset + piece.mStartOffset;
+			transfer->mConnection->sendPacket(packet, NetConnection::SendFlags::UNRELIABLE);
+
+			pacing.mByteBudget -= piece.mSize;
+			transfer->mQueuedPieces.pop_front();
+			--mNumQueuedPieces;
+		}
+	}
+}
+
+bool FileTransfer::hasQueuedPieces() const
+{
+	return (mNumQueuedPieces > 0);
+}
+
+void FileTransfer::removeTransfersOfConnection(ServerNetConnection& connection)
+{
+	std::vector<Transfer*> transfersToRemove;
+	for (const auto& [handle, transfer] : mTransfers)
+	{
+		if (transfer->mConnection == &connection)
+			transfersToRemove.push_back(transfer);
+	}
+	for (Transfer* transfer : transfersToRemove)
+	{
+		destroyTransfer(*transfer);
+	}
+}
+
+void FileTransfer::removeInactiveTransfers(uint64 currentTimestamp)
+{
+	std::vector<Transfer*> transfersToRemove;
+	for (const auto& [handle, transfer] : mTransfers)
+	{
+		if (transfer->mQueuedPieces.empty() && currentTimestamp > transfer->mLastActivityTimestamp + TRANSFER_INACTIVITY_TIMEOUT)
+			transfersToRemove.push_back(transfer);
+	}
+	for (Transfer* transfer : transfersToRemove)
+	{
+		destroyTransfer(*transfer);
+	}
+}
+
+void FileTransfer::enqueuePieces(Transfer& transfer, uint16 chunkIndex, uint32 startOffset, uint32 size)
+{
+	// Ignore invalid requests
+	const VirtualDirectory::FileContent& fileContent = *transfer.mFileContent;
+	if (chunkIndex >= fileContent.mChunks.size())
+		return;
+	const uint64 chunkSize = fileContent.mChunks[chunkIndex].mSize;
+	if ((uint64)startOffset + (uint64)size > chunkSize)
+		return;
+
+	// Split into pieces that fit into a single packet each
+	while (size > 0 && transfer.mQueuedPieces.size() < MAX_QUEUED_PIECES_PER_TRANSFER)
+	{
+		QueuedPiece& piece = transfer.mQueuedPieces.emplace_back();
+		piece.mChunkIndex = chunkIndex;
+		piece.mStartOffset = startOffset;
+		piece.mSize = (uint16)std::min<uint32>(size, network::FileTransferPiecePacket::MAX_PIECE_SIZE);
+		startOffset += piece.mSize;
+		size -= piece.mSize;
+		++mNumQueuedPieces;
+	}
+}
+
+void FileTransfer::destroyTransfer(Transfer& transfer)
+{
+	mNumQueuedPieces -= transfer.mQueuedPieces.size();
+	if (--transfer.mPacing->mNumTransfers == 0)
+		mConnectionPacings.erase(transfer.mConnection);
+	mTransfers.erase(transfer.mHandle);
+	mTransferPool.destroyObject(transfer);
+}
@@ -0,0 +1,86 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#pragma once
+
+#include "oxygen_netcore/network/ConnectionListener.h"
+#include "oxygen_netcore/serverclient/FileTransferPackets.h"
+
+#include "oxygenserver/subsystems/VirtualDirectory.h"
+
+class ServerNetConnection;
+
+
+// Serves file downloads from the virtual directory
+//  -> Clients start a download with a "FileDownloadRequest" and then request pieces of the file's chunks, possibly many at once
+//  -> Requested pieces get queued per transfer and sent out paced to a maximum number of bytes per second for each connection, shared by all of its transfers
+//  -> Pieces are sent unreliably, it's up to the client to request missing pieces again
+class FileTransfer
+{
+public:
+	explicit FileTransfer(VirtualDirectory& virtualDirectory);
+
+	bool onReceivedPacket(ReceivedPacketEvaluation& evaluation);
+	bool onReceivedRequestQuery(ReceivedQueryEvaluation& evaluation);
+
+	// Send out queued pieces, as far as the pacing allows
+	void updateTransfers(uint64 currentTimestamp);
+	bool hasQueuedPieces() const;
+
+	void removeTransfersOfConnection(ServerNetConnection& connection);
+	void removeInactiveTransfers(uint64 currentTimestamp);
+
+private:
+	struct QueuedPiece
+	{
+		uint16 mChunkIndex = 0;
+		uint32 mStartOffset = 0;	// Relative address inside chunk
+		uint16 mSize = 0;
+	};
+
+	struct ConnectionPacing
+	{
+		uint64 mLastPacingTimestamp = 0;
+		int64 mByteBudget = 0;		// Number of bytes that may be sent right now
+		size_t mNumTransfers = 0;
+	};
+
+	struct Transfer
+	{
+		uint32 mHandle = 0;
+		ServerNetConnection* mConnection = nullptr;
+		ConnectionPacing* mPacing = nullptr;
+		const VirtualDirectory::FileContent* mFileContent = nullptr;
+		std::deque<QueuedPiece> mQueuedPieces;
+		uint64 mLastActivityTimestamp = 0;
+	};
+
+	// Piece packet including the actual data, which gets read directly from the mapped file when serializing
+	struct PieceWithDataPacket : public network::FileTransferPiecePacket
+	{
+		const uint8* mData = nullptr;
+
+		virtual void serializeContent(VectorBinarySerializer& serializer, uint8 protocolVersion) override
+		{
+			network::FileTransferPiecePacket::serializeContent(serializer, protocolVersion);
+			serializer.write(mData, mSize);
+		}
+	};
+
+private:
+	void enqueuePieces(Transfer& transfer, uint16 chunkIndex, uint32 startOffset, uint32 size);
+	void destroyTransfer(Transfer& transfer);
+
+private:
+	VirtualDirectory& mVirtualDirectory;
+	std::unordered_map<uint32, Transfer*> mTransfers;	// Key is the transfer handle
+	std::unordered_map<ServerNetConnection*, ConnectionPacing> mConnectionPacings;	// Only for connections with at least one transfer
+	ObjectPool<Transfer> mTransferPool;
+	size_t mNumQueuedPieces = 0;
+	PieceWithDataPacket mPieceWithDataPacket;	// Reused for sending all pieces
+};
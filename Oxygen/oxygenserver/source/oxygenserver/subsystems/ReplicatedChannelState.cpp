@@ -0,0 +1,67 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#include "oxygenserver/pch.h"
+#include "oxygenserver/subsystems/ReplicatedChannelState.h"
+
+
+bool ReplicatedChannelState::updatePlayerState(uint32 channelID, uint32 playerID, const network::BroadcastChannelMessagePacket& packet, uint32& outRevision)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	const auto [it, inserted] = mStatesByChannel[channelID].try_emplace(playerID);
+	PlayerState& state = it->second;
+	if (!inserted && state.mMessageType == packet.mMessageType && state.mMessageVersion == packet.mMessageVersion && state.mData == packet.mMessage)
+		return false;
+
+	state.mMessageType = packet.mMessageType;
+	state.mMessageVersion = packet.mMessageVersion;
+	state.mData = packet.mMessage;
+	state.mRevision = ++mLastRevision;
+	outRevision = state.mRevision;
+	return true;
+}
+
+void ReplicatedChannelState::removePlayerState(uint32 channelID, uint32 playerID)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	const auto it = mStatesByChannel.find(channelID);
+	if (it == mStatesByChannel.end())
+		return;
+
+	it->second.erase(playerID);
+	if (it->second.empty())
+	{
+		mStatesByChannel.erase(it);
+	}
+}
+
+void ReplicatedChannelState::buildChannelSnapshot(uint32 channelID, uint32 excludedPlayerID, std::vector<network::ChannelMessagePacket>& outPackets) const
+{
+	outPackets.clear();
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	const auto it = mStatesByChannel.find(channelID);
+	if (it == mStatesByChannel.end())
+		return;
+
+	outPackets.reserve(it->second.size());
+	for (const auto& [playerID, state] : it->second)
+	{
+		if (playerID == excludedPlayerID)
+			continue;
+
+		network::ChannelMessagePacket& packet = vectorAdd(outPackets);
+		packet.mIsReplicatedData = true;
+		packet.mChannelHash = channelID;
+		packet.mMessageType = state.mMessageType;
+		packet.mMessageVersion = state.mMessageVersion;
+		packet.mMessage = state.mData;
+		packet.mSendingPlayerID = playerID;
+		packet.mReplicatedDataRevision = state.mRevision;
+	}
+}
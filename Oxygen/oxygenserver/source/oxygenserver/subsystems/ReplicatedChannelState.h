@@ -0,0 +1,44 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#pragma once
+
+#include "oxygen_netcore/serverclient/Packets.h"
+
+#include <mutex>
+
+
+// Stores the replicated data that players sent to their channels, i.e. the latest state of each player
+//  -> Players joining a channel get a snapshot of all other players' states, so nobody has to re-broadcast the full state for late joiners
+//  -> This is shared between all server shards, as the players of a channel may be spread over all of them; access is thread-safe
+class ReplicatedChannelState
+{
+public:
+	struct PlayerState
+	{
+		uint32 mMessageType = 0;
+		uint8 mMessageVersion = 0;		// Version of the message format, as sent by the player
+		uint32 mRevision = 0;			// Gets increased with each change, sent along so that clients can ignore outdated states
+		std::vector<uint8> mData;
+	};
+
+public:
+	// Store a player's replicated data and output its new revision; returns false if it did not change, so there's no need to broadcast it again
+	bool updatePlayerState(uint32 channelID, uint32 playerID, const network::BroadcastChannelMessagePacket& packet, uint32& outRevision);
+
+	// Remove a player's replicated data when leaving the channel
+	void removePlayerState(uint32 channelID, uint32 playerID);
+
+	// Build packets for all stored player states of a channel, except for the given player
+	void buildChannelSnapshot(uint32 channelID, uint32 excludedPlayerID, std::vector<network::ChannelMessagePacket>& outPackets) const;
+
+private:
+	mutable std::mutex mMutex;
+	uint32 mLastRevision = 0;	// Revisions are counted globally, so a player's revision keeps increasing even after leaving and re-joining a channel
+	std::unordered_map<uint32, std::unordered_map<uint32, PlayerState>> mStatesByChannel;	// Key of the outer map is the channel ID, key of the inner map is the player ID
+};
@@ -18,6 +18,55 @@ void VirtualDirectory::startup()
 	addFile(s3airDir, L"test.bin", 0x1234);
 }
 
+VirtualDirectory::FileContent* VirtualDirectory::getFileContent(const std::string& path)
+{
+	// Go through the directory structure
+	const std::wstring widePath = String(path).toStdWString();
+	const Directory* directory = &mRootDirectory;
+	size_t position = 0;
+	while (true)
+	{
+		const size_t slashPosition = widePath.find_first_of(L"/\\", position);
+		if (slashPosition == std::wstring::npos)
+			break;
+
+		const std::wstring_view directoryName = std::wstring_view(widePath).substr(position, slashPosition - position);
+		const Directory* subDirectory = nullptr;
+		for (const Directory& existingDir : directory->mSubDirectories)
+		{
+			if (existingDir.mName == directoryName)
+			{
+				subDirectory = &existingDir;
+				break;
+			}
+		}
+		if (nullptr == subDirectory)
+			return nullptr;
+
+		directory = subDirectory;
+		position = slashPosition + 1;
+	}
+
+	const std::wstring_view fileName = std::wstring_view(widePath).substr(position);
+	for (const FileEntry& file : directory->mFiles)
+	{
+		if (file.mName == fileName)
+		{
+			const auto it = mFileContents.find(file.mKey);
+			if (it == mFileContents.end())
+				return nullptr;
+
+			// File contents get mapped and set up on first use, which must not happen in multiple server shards at once
+			FileContent& content = it->second;
+			std::lock_guard<std::mutex> lock(mFileContentMutex);
+			if (!setupFileContentChunks(content))
+				return nullptr;
+			return &content;
+		}
+	}
+	return nullptr;
+}
+
 VirtualDirectory::FileContent& VirtualDirectory::addFileContent(uint64 key, uint64 size, const std::wstring& realPath)
 {
 	RMX_CHECK(mFileContents.count(key) == 0, "Duplicate file content insertion", return mFileContents[key]);
@@ -25,44 +74,48 @@ VirtualDirectory::FileContent& VirtualDirectory::addFileContent(uint64 key, uint
 	FileContent& content = mFileContents[key];
 	content.mSize = size;
 	content.mRealPath = realPath;
-	content.mCachedContent.clear();
+	content.mMappedFile.close();
 	content.mChunks.clear();
 	return content;
 }
 
-bool VirtualDirectory::loadCachedFileContent(FileContent& content)
+bool VirtualDirectory::mapFileContent(FileContent& content)
 {
-	if (!content.mCachedContent.empty())
+	if (content.mMappedFile.isOpen())
 		return true;
 
-	if (!FTX::FileSystem->readFile(content.mRealPath, content.mCachedContent))
+	if (!content.mMappedFile.open(content.mRealPath))
 		return false;
 
+	// The actual file is what counts
+	content.mSize = content.mMappedFile.getSize();
 	return true;
 }
 
 bool VirtualDirectory::setupFileContentChunks(FileContent& content)
 {
-	if (!content.mChunks.empty())
-		return true;
+	if (!mapFileContent(content))
+		return false;
 
-	if (content.mCachedContent.empty())
-	{
-		if (!loadCachedFileContent(content))
-			return false;
-		if (content.mCachedContent.empty())
-			return true;
-	}
+	if (!content.mChunks.empty() || content.mSize == 0)
+		return true;
 
-	const constexpr size_t MAX_CHUNK_SIZE = 0x100000;	// 1 MB
-	const size_t numChunks = (content.mCachedContent.size() + MAX_CHUNK_SIZE - 1) / MAX_CHUNK_SIZE;
+	const uint8* data = content.mMappedFile.getData();
+	const size_t numChunks = (size_t)((content.mSize + MAX_CHUNK_SIZE - 1) / MAX_CHUNK_SIZE);
 	content.mChunks.resize(numChunks);
 	for (size_t k = 0; k < numChunks; ++k)
 	{
 		FileContent::Chunk& chunk = content.mChunks[k];
 		chunk.mStartOffset = (uint64)(k * MAX_CHUNK_SIZE);
-		chunk.mSize = std::min<uint64>((uint64)MAX_CHUNK_SIZE, (uint64)content.mCachedContent.size() - chunk.mStartOffset);
-		chunk.mHash = rmx::getMurmur2_64(&content.mCachedContent[(size_t)chunk.mStartOffset], (size_t)chunk.mSize);
+		chunk.mSize = std::min<uint64>((uint64)MAX_CHUNK_SIZE, content.mSize - chunk.mStartOffset);
+		chunk.mHash = rmx::getMurmur2_64(&data[(size_t)chunk.mStartOffset], (size_t)chunk.mSize);
+	}
+
+	// Hash of the whole file, built from the chunk hashes
+	content.mHash = rmx::startFNV1a_64();
+	for (const FileContent::Chunk& chunk : content.mChunks)
+	{
+		content.mHash = rmx::addToFNV1a_64(content.mHash, (const uint8*)&chunk.mHash, sizeof(chunk.mHash));
 	}
 	return true;
 }
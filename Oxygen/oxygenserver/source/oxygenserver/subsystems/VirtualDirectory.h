@@ -8,15 +8,16 @@
 
 #pragma once
 
-#include <rmxbase.h>
+#include "oxygenserver/server/MappedFile.h"
+
+#include <mutex>
 
 
 class VirtualDirectory
 {
 public:
-	void startup();
+	static const constexpr size_t MAX_CHUNK_SIZE = 0x100000;	// 1 MB
 
-private:
 	struct FileContent
 	{
 		struct Chunk
@@ -29,10 +30,18 @@ private:
 		uint64 mHash = 0;
 		uint64 mSize = 0;
 		std::wstring mRealPath;
-		std::vector<uint8> mCachedContent;
+		MappedFile mMappedFile;		// File contents are memory-mapped instead of loaded, so that only the actually requested parts are paged in
 		std::vector<Chunk> mChunks;
 	};
 
+public:
+	void startup();
+
+	// Get the file content for a virtual path like "sonic3air/test.bin", with the file mapped and its chunks set up; returns a null pointer if not available
+	//  -> This is thread-safe, as long as "startup" is not called at the same time
+	FileContent* getFileContent(const std::string& path);
+
+private:
 	struct FileEntry
 	{
 		std::wstring mName;
@@ -48,7 +57,7 @@ private:
 
 private:
 	FileContent& addFileContent(uint64 key, uint64 size, const std::wstring& realPath);
-	bool loadCachedFileContent(FileContent& content);
+	bool mapFileContent(FileContent& content);
 	bool setupFileContentChunks(FileContent& content);
 
 	FileEntry& addFile(Directory& parentDirectory, const std::wstring& name, uint64 contentKey);
@@ -57,4 +66,5 @@ private:
 private:
 	std::unordered_map<uint64, FileContent> mFileContents;	// Key is the content hash
 	Directory mRootDirectory;
+	std::mutex mFileContentMutex;
 };
@@ -16,13 +16,54 @@
 #include "oxygen_netcore/network/ConnectionListener.h"
 #include "oxygen_netcore/network/NetConnection.h"
 
+#include "oxygen/helper/BitStream.h"
 #include "oxygen/simulation/EmulatorInterface.h"
 
 
 namespace
 {
 	static const constexpr uint32 GHOSTSYNC_BROADCAST_MESSAGE_TYPE = rmx::compileTimeFNV_32("S3AIR_GhostSync");
-	static const constexpr uint8 GHOSTSYNC_BROADCAST_MESSAGE_VERSION = 1;
+	static const constexpr uint8 GHOSTSYNC_BROADCAST_MESSAGE_VERSION = 2;		// Version 1 without delta encoding is still supported for receiving
+																				//  -> Versions above 1 are part of the channel name, so that older clients (which reject newer messages) end up in a different channel
+	static const constexpr int GHOSTSYNC_FULL_STATE_INTERVAL = 5;				// Send a full state in every n-th packet, so that receivers can (re-)sync
+
+	void writeSignedDelta(Bitstream& bitstream, int16 delta)
+	{
+		// Most changes between frames are small, like position changes
+		bitstream.write(delta != 0);
+		if (delta != 0)
+		{
+			const bool isSmall = (delta >= -32 && delta < 32);
+			bitstream.write(!isSmall);
+			bitstream.writeBits((uint16)delta, isSmall ? 6 : 16);
+		}
+	}
+
+	int16 readSignedDelta(Bitstream& bitstream)
+	{
+		if (!bitstream.read())
+			return 0;
+
+		if (bitstream.read())
+			return (int16)bitstream.readBits(16);
+
+		const uint32 value = bitstream.readBits(6);
+		return (value & 0x20) ? (int16)value - 0x40 : (int16)value;
+	}
+
+	template<typename T>
+	void writeChangedValue(Bitstream& bitstream, T value, T referenceValue, uint32 numBits)
+	{
+		bitstream.write(value != referenceValue);
+		if (value != referenceValue)
+			bitstream.writeBits(value, numBits);
+	}
+
+	template<typename T>
+	T readChangedValue(Bitstream& bitstream, T referenceValue, uint32 numBits)
+	{
+		return bitstream.read() ? (T)bitstream.readBits(numBits) : referenceValue;
+	}
 }
 
 
@@ -66,8 +107,8 @@ void GhostSync::performUpdate()
 			const char* subChannelName = getDesiredSubChannelName();
 			if (nullptr != subChannelName)
 			{
-				// Join channel
-				mJoinChannelRequest.mQuery.mChannelName = "sonic3air-ghostsync-" + ConfigurationImpl::instance().mGameServer.mGhostSync.mChannelName + "-" + subChannelName;
+				// Join channel, one separate channel per message version
+				mJoinChannelRequest.mQuery.mChannelName = "sonic3air-ghostsync-v" + std::to_string(GHOSTSYNC_BROADCAST_MESSAGE_VERSION) + "-" + ConfigurationImpl::instance().mGameServer.mGhostSync.mChannelName + "-" + subChannelName;
 				mJoinChannelRequest.mQuery.mChannelHash = (uint32)rmx::getMurmur2_64(mJoinChannelRequest.mQuery.mChannelName);
 				mGameClient.getServerConnection().sendRequest(mJoinChannelRequest);
 
@@ -86,6 +127,7 @@ void GhostSync::performUpdate()
 					mState = State::JOINED_CHANNEL;
 					mJoinedChannelHash = mJoinChannelRequest.mQuery.mChannelHash;
 					mGhostPlayers.clear();
+					mPacketsSinceFullState = 0;
 				}
 				else
 				{
@@ -191,7 +233,7 @@ bool GhostSync::onReceivedPacket(ReceivedPacketEvaluation& evaluation)
 				return false;
 
 			// Ignore messages of the wrong type or with an unsupported version
-			if (packet.mMessageType != GHOSTSYNC_BROADCAST_MESSAGE_TYPE || packet.mMessageVersion != GHOSTSYNC_BROADCAST_MESSAGE_VERSION)
+			if (packet.mMessageType != GHOSTSYNC_BROADCAST_MESSAGE_TYPE || packet.mMessageVersion < 1 || packet.mMessageVersion > GHOSTSYNC_BROADCAST_MESSAGE_VERSION)
 				return false;
 
 			PlayerData* playerData = nullptr;
@@ -211,19 +253,69 @@ bool GhostSync::onReceivedPacket(ReceivedPacketEvaluation& evaluation)
 				}
 			}
 
+			// Ignore replicated data that is not newer than what was already received, e.g. a snapshot arriving after a more recent update
+			if (packet.mIsReplicatedData && packet.mReplicatedDataRevision != 0)
+			{
+				if (packet.mReplicatedDataRevision <= playerData->mReplicatedDataRevision)
+					return true;
+				playerData->mReplicatedDataRevision = packet.mReplicatedDataRevision;
+			}
+
 			VectorBinarySerializer serializer(true, packet.mMessage);
 			const size_t count = (size_t)serializer.read<uint8>();
 			if (count > 12)
 				return true;
 
+			GhostData ghostData[12];
+			if (packet.mMessageVersion == 1)
+			{
+				// Each frame got serialized on its own
+				for (size_t k = 0; k < count; ++k)
+				{
+					serializeGhostData(serializer, ghostData[k]);
+				}
+				if (serializer.hasError())
+					return true;
+			}
+			else
+			{
+				// The first frame is either a full state, or delta encoded against the last full state; the other frames are delta encoded against their predecessor
+				const uint8 sequenceNumber = serializer.read<uint8>();
+				const uint8 baseSequenceNumber = serializer.read<uint8>();
+				if (serializer.hasError() || count == 0)
+					return true;
+
+				const bool isFullState = (sequenceNumber == baseSequenceNumber);
+				if (!isFullState && !(playerData->mLastFullState.mValid && playerData->mLastFullStateSequence == baseSequenceNumber))
+				{
+					// The full state this is based on got lost, wait for the next one
+					return true;
+				}
+
+				Bitstream bitstream(packet.mMessage, (uint32)serializer.getReadPosition());
+				for (size_t k = 0; k < count; ++k)
+				{
+					const GhostData* reference = (k > 0) ? &ghostData[k-1] : isFullState ? nullptr : &playerData->mLastFullState;
+					readGhostDataBits(bitstream, ghostData[k], reference);
+				}
+				if (bitstream.hasError())
+					return true;
+
+				if (isFullState)
+				{
+					playerData->mLastFullState = ghostData[0];
+					playerData->mLastFullState.mValid = true;
+					playerData->mLastFullStateSequence = sequenceNumber;
+				}
+			}
+
 			while (playerData->mGhostDataQueue.size() + count > 12)
 			{
 				playerData->mGhostDataQueue.pop_front();
 			}
 			for (size_t k = 0; k < count; ++k)
 			{
-				playerData->mGhostDataQueue.emplace_back();
-				serializeGhostData(serializer, playerData->mGhostDataQueue.back());
+				playerData->mGhostDataQueue.emplace_back(ghostData[k]);
 				playerData->mGhostDataQueue.back().mValid = true;
 			}
 
@@ -275,10 +367,26 @@ void GhostSync::updateSending()
 		packet.mMessage.clear();
 		VectorBinarySerializer serializer(false, packet.mMessage);
 
+		// Regularly send a full state, as messages are sent unreliably and other players may join at any time
+		++mOwnSequenceNumber;
+		const bool sendFullState = (mPacketsSinceFullState <= 0 || mPacketsSinceFullState >= GHOSTSYNC_FULL_STATE_INTERVAL);
+		if (sendFullState)
+		{
+			mOwnLastFullState = mOwnUnsentGhostData.front();
+			mOwnLastFullStateSequence = mOwnSequenceNumber;
+			mPacketsSinceFullState = 0;
+		}
+		++mPacketsSinceFullState;
+
 		serializer.writeAs<uint8>(mOwnUnsentGhostData.size());
-		for (GhostData& ghostData : mOwnUnsentGhostData)
+		serializer.write(mOwnSequenceNumber);
+		serializer.write(mOwnLastFullStateSequence);
+
+		Bitstream bitstream(packet.mMessage, (uint32)packet.mMessage.size());
+		for (size_t k = 0; k < mOwnUnsentGhostData.size(); ++k)
 		{
-			serializeGhostData(serializer, ghostData);
+			const GhostData* reference = (k > 0) ? &mOwnUnsentGhostData[k-1] : sendFullState ? nullptr : &mOwnLastFullState;
+			writeGhostDataBits(bitstream, mOwnUnsentGhostData[k], reference);
 		}
 
 		packet.mIsReplicatedData = false;
@@ -429,3 +537,82 @@ void GhostSync::serializeGhostData(VectorBinarySerializer& serializer, GhostData
 		serializer.serialize(ghostData.mFlags);
 	}
 }
+
+void GhostSync::writeGhostDataBits(Bitstream& bitstream, const GhostData& ghostData, const GhostData* reference)
+{
+	// Without a reference, or after a character or zone change, all data gets written
+	const bool writeFull = (nullptr == reference || ghostData.mCharacter != reference->mCharacter || ghostData.mZoneAndAct != reference->mZoneAndAct);
+	if (nullptr != reference)
+		bitstream.write(writeFull);
+
+	if (writeFull)
+	{
+		bitstream.writeBits(ghostData.mCharacter, 8);
+		bitstream.writeBits(ghostData.mZoneAndAct, 16);
+		if (ghostData.mZoneAndAct == 0xffff)
+			return;
+
+		bitstream.writeBits(ghostData.mFrameCounter, 16);
+		bitstream.writeBits((uint16)ghostData.mPosition.x, 16);
+		bitstream.writeBits((uint16)ghostData.mPosition.y, 16);
+		if (ghostData.mCharacter == 1)	// Only for Tails
+		{
+			bitstream.writeBits(ghostData.mMoveDirection, 8);
+		}
+		bitstream.writeBits(ghostData.mSprite, 16);
+		bitstream.writeBits(ghostData.mRotation, 8);
+		bitstream.writeBits(ghostData.mFlags, 8);
+	}
+	else
+	{
+		if (ghostData.mZoneAndAct == 0xffff)
+			return;
+
+		// The frame counter usually advances by one each frame
+		writeChangedValue<uint16>(bitstream, ghostData.mFrameCounter, reference->mFrameCounter + 1, 16);
+		writeSignedDelta(bitstream, (int16)(ghostData.mPosition.x - reference->mPosition.x));
+		writeSignedDelta(bitstream, (int16)(ghostData.mPosition.y - reference->mPosition.y));
+		if (ghostData.mCharacter == 1)	// Only for Tails
+		{
+			writeChangedValue(bitstream, ghostData.mMoveDirection, reference->mMoveDirection, 8);
+		}
+		writeChangedValue(bitstream, ghostData.mSprite, reference->mSprite, 16);
+		writeChangedValue(bitstream, ghostData.mRotation, reference->mRotation, 8);
+		writeChangedValue(bitstream, ghostData.mFlags, reference->mFlags, 8);
+	}
+}
+
+void GhostSync::readGhostDataBits(Bitstream& bitstream, GhostData& ghostData, const GhostData* reference)
+{
+	const bool readFull = (nullptr == reference) || bitstream.read();
+	if (readFull)
+	{
+		ghostData.mCharacter = (uint8)bitstream.readBits(8);
+		ghostData.mZoneAndAct = (uint16)bitstream.readBits(16);
+		if (ghostData.mZoneAndAct == 0xffff)
+			return;
+
+		ghostData.mFrameCounter = (uint16)bitstream.readBits(16);
+		ghostData.mPosition.x = (int16)bitstream.readBits(16);
+		ghostData.mPosition.y = (int16)bitstream.readBits(16);
+		ghostData.mMoveDirection = (ghostData.mCharacter == 1) ? (uint8)bitstream.readBits(8) : 0;
+		ghostData.mSprite = (uint16)bitstream.readBits(16);
+		ghostData.mRotation = (uint8)bitstream.readBits(8);
+		ghostData.mFlags = (uint8)bitstream.readBits(8);
+	}
+	else
+	{
+		ghostData.mCharacter = reference->mCharacter;
+		ghostData.mZoneAndAct = reference->mZoneAndAct;
+		if (ghostData.mZoneAndAct == 0xffff)
+			return;
+
+		ghostData.mFrameCounter = readChangedValue<uint16>(bitstream, reference->mFrameCounter + 1, 16);
+		ghostData.mPosition.x = (int16)(reference->mPosition.x + readSignedDelta(bitstream));
+		ghostData.mPosition.y = (int16)(reference->mPosition.y + readSignedDelta(bitstream));
+		ghostData.mMoveDirection = (ghostData.mCharacter == 1) ? readChangedValue(bitstream, reference->mMoveDirection, 8) : 0;
+		ghostData.mSprite = readChangedValue(bitstream, reference->mSprite, 16);
+		ghostData.mRotation = readChangedValue(bitstream, reference->mRotation, 8);
+		ghostData.mFlags = readChangedValue(bitstream, reference->mFlags, 8);
+	}
+}
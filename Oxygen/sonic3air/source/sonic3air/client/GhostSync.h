@@ -10,6 +10,7 @@
 
 #include "oxygen_netcore/serverclient/Packets.h"
 
+class Bitstream;
 class GameClient;
 struct ReceivedPacketEvaluation;
 
@@ -69,11 +70,16 @@ private:
 		std::deque<GhostData> mGhostDataQueue;
 		GhostData mShownGhostData;
 		int mTimeout = 0;
+		GhostData mLastFullState;			// Reference for delta encoded ghost data, not valid until the first full state got received
+		uint8 mLastFullStateSequence = 0;
+		uint32 mReplicatedDataRevision = 0;	// Revision of the last replicated data received from this player
 	};
 
 private:
 	const char* getDesiredSubChannelName() const;
 	void serializeGhostData(VectorBinarySerializer& serializer, GhostData& ghostData);
+	void writeGhostDataBits(Bitstream& bitstream, const GhostData& ghostData, const GhostData* reference);
+	void readGhostDataBits(Bitstream& bitstream, GhostData& ghostData, const GhostData* reference);
 
 private:
 	GameClient& mGameClient;
@@ -86,6 +92,10 @@ private:
 
 	GhostData mOwnGhostData;
 	std::deque<GhostData> mOwnUnsentGhostData;
+	GhostData mOwnLastFullState;
+	uint8 mOwnSequenceNumber = 0;
+	uint8 mOwnLastFullStateSequence = 0;
+	int mPacketsSinceFullState = 0;
 	network::BroadcastChannelMessagePacket mBroadcastChannelMessagePacket;
 
 	std::unordered_map<uint32, PlayerData> mGhostPlayers;
@@ -20,6 +20,7 @@ public:
 	bool mPack = false;
 	bool mNativize = false;
 	bool mDumpCppDefinitions = false;
+	bool mRunEngineTests = false;
 
 public:
 	void read(int argc, char** argv)
@@ -49,6 +50,10 @@ public:
 				{
 					mDumpCppDefinitions = true;
 				}
+				else if (parameter == "-enginetests")
+				{
+					mRunEngineTests = true;
+				}
 			}
 		}
 	}
@@ -11,6 +11,7 @@
 #include "sonic3air/helper/ArgumentsReader.h"
 #include "sonic3air/helper/PackageBuilder.h"
 
+#include "oxygen/helper/EngineTests.h"
 #include "oxygen/platform/PlatformFunctions.h"
 
 
@@ -51,6 +52,13 @@ int main(int argc, char** argv)
 	// Make sure we're in the correct working directory
 	PlatformFunctions::changeWorkingDirectory(arguments.mExecutableCallPath);
 
+	if (arguments.mRunEngineTests)
+	{
+		// Only run the tests, with output to the console
+		rmx::Logging::addLogger(*new rmx::StdCoutLogger());
+		return EngineTests::runAllTests() ? 0 : 1;
+	}
+
 #if defined(PLATFORM_WINDOWS)
 	// Check if the user has an old version of "audioremaster.bin", and remove it if that the case
 	//  -> As the newer installations don't include that file, it is most likely an out-dated one, and could cause problems (at least an assert) down the line
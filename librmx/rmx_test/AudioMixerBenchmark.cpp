@@ -0,0 +1,74 @@
+/*
+*	rmx Library
+*	Copyright (C) 2008-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#define RMX_LIB
+#include "../source/rmxmedia.h"
+#include "Tests.h"
+
+#include <chrono>
+
+
+namespace
+{
+	static const int NUM_SAMPLES = 1024;		// Output samples per call, about what the audio mixer uses per update
+	static const int NUM_INPUT_SAMPLES = NUM_SAMPLES * 2 + 8;
+	static const int NUM_ROUNDS = 20000;
+
+	double measureNanosecondsPerSample(const rmx::AudioMixerKernels::Functions& functions, int sourceIndexAdvance)
+	{
+		static short input[2][NUM_INPUT_SAMPLES];
+		static int32 output[NUM_SAMPLES];
+		for (int i = 0; i < NUM_INPUT_SAMPLES; ++i)
+		{
+			input[0][i] = (short)(i * 7919);
+			input[1][i] = (short)(i * 104729);
+		}
+		memset(output, 0, sizeof(output));
+
+		// Mix a mono source with constant volume and a stereo source with a volume ramp, like a typical sound and a fading music track
+		const auto startTime = std::chrono::steady_clock::now();
+		for (int round = 0; round < NUM_ROUNDS; ++round)
+		{
+			functions.mMixConstantVolume(output, input[0], NUM_SAMPLES, 0, sourceIndexAdvance, 0x80);
+			functions.mMixSumVolumeRamp(output, input[0], input[1], NUM_SAMPLES, 0, sourceIndexAdvance, 0x4000, 3);
+		}
+		const double nanoseconds = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+
+		// Use the output, so the compiler can't skip anything
+		int32 checksum = 0;
+		for (int i = 0; i < NUM_SAMPLES; ++i)
+			checksum ^= output[i];
+		if (checksum == 0x12345678)
+			RMX_LOG_INFO("");
+
+		return nanoseconds / ((double)NUM_ROUNDS * NUM_SAMPLES);
+	}
+}
+
+
+void runAudioMixerBenchmark()
+{
+	const rmx::AudioMixerKernels::Variant VARIANTS[] = { rmx::AudioMixerKernels::Variant::SCALAR, rmx::AudioMixerKernels::Variant::SSE2, rmx::AudioMixerKernels::Variant::AVX2, rmx::AudioMixerKernels::Variant::NEON };
+	const int SOURCE_INDEX_ADVANCES[] = { 0x10000, 0xe666, 0x1b9cc };	// Same rate, 44100 Hz -> 48000 Hz, 48000 Hz -> 22050 Hz
+
+	RMX_LOG_INFO("Audio mixer kernels, time per output sample for two mixed sources:");
+	for (rmx::AudioMixerKernels::Variant variant : VARIANTS)
+	{
+		rmx::AudioMixerKernels::Functions functions;
+		if (!rmx::AudioMixerKernels::getVariantFunctions(variant, functions))
+			continue;
+
+		std::string line = std::string("  ") + rmx::AudioMixerKernels::getVariantName(variant) + ":";
+		for (int sourceIndexAdvance : SOURCE_INDEX_ADVANCES)
+		{
+			const double nanoseconds = measureNanosecondsPerSample(functions, sourceIndexAdvance);
+			line += "  advance " + rmx::hexString(sourceIndexAdvance, 5) + " = " + std::to_string(nanoseconds) + " ns";
+		}
+		RMX_LOG_INFO(line);
+	}
+}
@@ -0,0 +1,101 @@
+/*
+*	rmx Library
+*	Copyright (C) 2008-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#define RMX_LIB
+#include "../source/rmxmedia.h"
+#include "Tests.h"
+
+#include <random>
+
+
+namespace
+{
+	bool testVariant(rmx::AudioMixerKernels::Variant variant, const rmx::AudioMixerKernels::Functions& reference, const rmx::AudioMixerKernels::Functions& functions)
+	{
+		// Compare outputs for pseudo-random input, for all sample counts up to a few SIMD blocks plus remainder, and for same-rate as well as resampled input
+		//  -> Volume ramps stay inside the range that the audio mixer uses, so that the scalar code can't overflow
+		constexpr int MAX_SAMPLES = 72;
+		constexpr int MAX_INPUT_SAMPLES = MAX_SAMPLES * 2 + 2;
+		const int SOURCE_INDEX_ADVANCES[] = { 0x10000, 0x8000, 0x9123, 0xe666, 0x18000, 0x1ffff };
+
+		std::mt19937 random(0x12345678);
+		short input[2][MAX_INPUT_SAMPLES];
+		int32 output[2][MAX_SAMPLES];
+
+		for (int numSamples = 0; numSamples <= MAX_SAMPLES; ++numSamples)
+		{
+			for (int sourceIndexAdvance : SOURCE_INDEX_ADVANCES)
+			{
+				for (int i = 0; i < MAX_INPUT_SAMPLES; ++i)
+				{
+					input[0][i] = (short)random();
+					input[1][i] = (random() % 8 == 0) ? (short)-0x8000 : (short)random();
+				}
+				for (int i = 0; i < MAX_SAMPLES; ++i)
+				{
+					output[0][i] = output[1][i] = (int32)(random() & 0xfffff) - 0x80000;
+				}
+
+				const int sourceIndexStart = (sourceIndexAdvance == 0x10000) ? 0 : (int)(random() & 0xffff);
+				const int volume = (int)(random() % 0x200);
+				const int rampVolume = 0x8000 + (int)(random() % 0x800) - 0x400;
+				const int volumeChange = (int)(random() % 0x600) - 0x300;
+
+				const char* mismatch = nullptr;
+				reference.mMixConstantVolume(output[0], input[0], numSamples, sourceIndexStart, sourceIndexAdvance, volume);
+				functions.mMixConstantVolume(output[1], input[0], numSamples, sourceIndexStart, sourceIndexAdvance, volume);
+				if (memcmp(output[0], output[1], sizeof(output[0])) != 0)
+					mismatch = "mixConstantVolume";
+
+				reference.mMixVolumeRamp(output[0], input[1], numSamples, sourceIndexStart, sourceIndexAdvance, rampVolume, volumeChange);
+				functions.mMixVolumeRamp(output[1], input[1], numSamples, sourceIndexStart, sourceIndexAdvance, rampVolume, volumeChange);
+				if (nullptr == mismatch && memcmp(output[0], output[1], sizeof(output[0])) != 0)
+					mismatch = "mixVolumeRamp";
+
+				reference.mMixSumConstantVolume(output[0], input[0], input[1], numSamples, sourceIndexStart, sourceIndexAdvance, volume);
+				functions.mMixSumConstantVolume(output[1], input[0], input[1], numSamples, sourceIndexStart, sourceIndexAdvance, volume);
+				if (nullptr == mismatch && memcmp(output[0], output[1], sizeof(output[0])) != 0)
+					mismatch = "mixSumConstantVolume";
+
+				reference.mMixSumVolumeRamp(output[0], input[0], input[1], numSamples, sourceIndexStart, sourceIndexAdvance, rampVolume / 2, volumeChange / 2);
+				functions.mMixSumVolumeRamp(output[1], input[0], input[1], numSamples, sourceIndexStart, sourceIndexAdvance, rampVolume / 2, volumeChange / 2);
+				if (nullptr == mismatch && memcmp(output[0], output[1], sizeof(output[0])) != 0)
+					mismatch = "mixSumVolumeRamp";
+
+				if (nullptr != mismatch)
+				{
+					RMX_LOG_INFO("Audio mixer kernel " << mismatch << " of variant " << rmx::AudioMixerKernels::getVariantName(variant) << " differs from scalar reference for "
+								 << numSamples << " samples with source index advance " << rmx::hexString(sourceIndexAdvance, 5));
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+}
+
+
+bool runAudioMixerTest()
+{
+	typedef rmx::AudioMixerKernels::Variant Variant;
+	rmx::AudioMixerKernels::Functions reference;
+	rmx::AudioMixerKernels::getVariantFunctions(Variant::SCALAR, reference);
+
+	bool success = true;
+	for (Variant variant : { Variant::SSE2, Variant::AVX2, Variant::NEON })
+	{
+		rmx::AudioMixerKernels::Functions functions;
+		if (!rmx::AudioMixerKernels::getVariantFunctions(variant, functions))
+			continue;
+
+		const bool passed = testVariant(variant, reference, functions);
+		RMX_LOG_INFO("Audio mixer kernels " << rmx::AudioMixerKernels::getVariantName(variant) << ": " << (passed ? "passed" : "FAILED"));
+		success &= passed;
+	}
+	return success;
+}
@@ -0,0 +1,163 @@
+/*
+*	rmx Library
+*	Copyright (C) 2008-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#define RMX_LIB
+#include "../source/rmxmedia.h"
+#include "Tests.h"
+
+#include <random>
+
+
+namespace
+{
+	static const int MAX_THREADS = 4;
+	static const int MAX_LONG_RUNNING_JOBS = MAX_THREADS - 1;	// See "JobManager::getMaxLongRunningJobs"
+
+	std::atomic<int> gNumViolations = 0;
+	std::atomic<int> gNumRunningLongJobs = 0;
+	std::atomic<int> gMaxRunningLongJobs = 0;
+
+	class StressTestJob : public rmx::JobBase
+	{
+	public:
+		std::atomic<int> mNumRunning = 0;
+		std::atomic<int> mNumCalls = 0;
+		std::atomic<int> mNumCallsAfterRemove = 0;
+		std::atomic<bool> mRemoved = false;
+		int mTargetCalls = 0;
+
+	public:
+		explicit StressTestJob(bool longRunning)
+		{
+			mJobType = longRunning ? "LongRunningStressTestJob" : "StressTestJob";
+			mJobIsLongRunning = longRunning;
+		}
+
+	protected:
+		bool jobFunc() override
+		{
+			// A job must never be executed by two threads at once, or after it got removed
+			if (mNumRunning++ != 0)
+				++gNumViolations;
+			if (mRemoved)
+				++mNumCallsAfterRemove;
+			++mNumCalls;
+
+			if (mJobIsLongRunning)
+			{
+				// Block the worker thread for a while, like a download does
+				const int running = ++gNumRunningLongJobs;
+				int maxRunning = gMaxRunningLongJobs;
+				while (running > maxRunning && !gMaxRunningLongJobs.compare_exchange_weak(maxRunning, running))
+				{
+				}
+				for (int i = 0; i < 5 && shouldJobBeRunning(); ++i)
+				{
+					SDL_Delay(1);
+				}
+				--gNumRunningLongJobs;
+			}
+			else
+			{
+				for (int i = 0; i < 200 && shouldJobBeRunning(); ++i)
+				{
+					volatile int x = i * i;
+					(void)x;
+				}
+			}
+
+			// Change delay and priority from inside the job function as well
+			if ((mNumCalls % 7) == 0)
+				setJobDelayUntilTicks(SDL_GetTicks() + 2);
+			setJobPriority((float)(mNumCalls % 5) - 0.5f);
+
+			--mNumRunning;
+			return (mNumCalls >= mTargetCalls);
+		}
+	};
+}
+
+
+bool runJobManagerStressTest()
+{
+	std::mt19937 randomGenerator(1);
+	rmx::JobManager jobManager;
+	jobManager.setMaxThreads(MAX_THREADS);
+
+	std::vector<StressTestJob*> jobs;
+	for (int i = 0; i < 64; ++i)
+	{
+		jobs.push_back(new StressTestJob(i % 8 == 0));
+	}
+
+	// Randomly insert, remove and change jobs while worker threads are executing them
+	for (int round = 0; round < 3000; ++round)
+	{
+		StressTestJob& job = *jobs[randomGenerator() % jobs.size()];
+		switch (randomGenerator() % 4)
+		{
+			case 0:
+			case 1:
+				if (!job.isJobRegistered())
+				{
+					job.mRemoved = false;
+					job.mTargetCalls = job.mNumCalls + 1 + randomGenerator() % 50;
+					jobManager.insertJob(job, (float)(randomGenerator() % 3));
+				}
+				break;
+
+			case 2:
+				jobManager.removeJob(job);
+				job.mRemoved = true;
+				if (job.isJobRunning())
+					++gNumViolations;
+				break;
+
+			case 3:
+				job.setJobPriority((float)(randomGenerator() % 3));
+				break;
+		}
+
+		if (round % 100 == 0)
+			SDL_Delay(1);
+	}
+
+	// Short jobs must still get processed while long-running jobs occupy as many threads as they may
+	StressTestJob shortJob(false);
+	shortJob.mTargetCalls = shortJob.mNumCalls + 1;
+	jobManager.insertJob(shortJob, 0.0f);
+	const uint32 startTicks = SDL_GetTicks();
+	while (!shortJob.isJobDone() && SDL_GetTicks() - startTicks < 5000)
+	{
+		SDL_Delay(1);
+	}
+	const bool shortJobDone = shortJob.isJobDone();
+
+	for (StressTestJob* job : jobs)
+	{
+		jobManager.removeJob(*job);
+		job->mRemoved = true;
+	}
+	jobManager.removeJob(shortJob);
+	SDL_Delay(50);
+
+	int numCallsAfterRemove = 0;
+	for (StressTestJob* job : jobs)
+	{
+		numCallsAfterRemove += job->mNumCallsAfterRemove;
+	}
+
+	RMX_LOG_INFO("Job manager stress test: " << jobManager.getThreadCount() << " threads, " << jobManager.getJobCount() << " jobs left, " << gNumViolations << " violations, "
+				 << numCallsAfterRemove << " calls after remove, at most " << gMaxRunningLongJobs << " long-running jobs at once, short job " << (shortJobDone ? "done" : "NOT done"));
+
+	for (StressTestJob* job : jobs)
+	{
+		delete job;
+	}
+	return (jobManager.getJobCount() == 0 && gNumViolations == 0 && numCallsAfterRemove == 0 && gMaxRunningLongJobs <= MAX_LONG_RUNNING_JOBS && shortJobDone);
+}
@@ -0,0 +1,21 @@
+/*
+*	rmx Library
+*	Copyright (C) 2008-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#pragma once
+
+
+// Command line tests and benchmarks, run instead of the test app when passing the respective argument
+
+// "-audiomixertest": Compares all audio mixer kernel variants supported here against the scalar code; returns false on any difference
+bool runAudioMixerTest();
+
+// "-audiomixerbenchmark": Time per sample of all audio mixer kernel variants supported here, for same-rate and resampled input
+void runAudioMixerBenchmark();
+
+// "-jobmanagerstresstest": Randomly inserts, removes and changes jobs of a job manager while they get executed, best run in a ThreadSanitizer build; returns false on failure
+bool runJobManagerStressTest();
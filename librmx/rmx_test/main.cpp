@@ -8,6 +8,7 @@
 
 #define RMX_LIB
 #include "../source/rmxmedia.h"
+#include "Tests.h"
 
 
 class App : public GuiBase
@@ -42,6 +43,28 @@ int main(int argc, char** argv)
 {
 	INIT_RMX;
 
+	// Command line tests and benchmarks
+	if (argc >= 2)
+	{
+		rmx::Logging::addLogger(*new rmx::StdCoutLogger());
+		const std::string argument = argv[1];
+		if (argument == "-audiomixertest")
+		{
+			return runAudioMixerTest() ? 0 : 1;
+		}
+		if (argument == "-audiomixerbenchmark")
+		{
+			runAudioMixerBenchmark();
+			return 0;
+		}
+		if (argument == "-jobmanagerstresstest")
+		{
+			return runJobManagerStressTest() ? 0 : 1;
+		}
+		RMX_LOG_INFO("Unknown argument " << argument);
+		return 1;
+	}
+
 	FTX::System->initialize();
 	FTX::Video->initialize(rmx::VideoConfig(false, 1200, 672, "rmx_test"));
 	FTX::Video->setPixelView();
@@ -18,6 +18,7 @@
 #include <chrono>
 #include <ctime>
 #include <iomanip>
+#include <mutex>
 #include <sstream>
 
 
@@ -142,6 +143,9 @@ namespace rmx
 
 	void Logging::log(LogLevel logLevel, const std::string& string)
 	{
+		// Logging may happen from multiple threads, and the loggers are not thread-safe themselves
+		static std::mutex mutex;
+		std::lock_guard<std::mutex> lock(mutex);
 		for (LoggerBase* logger : mLoggers)
 		{
 			logger->log(logLevel, string);
@@ -36,6 +36,7 @@
 #include "rmxmedia/audiovideo/VideoBuffer.h"
 #include "rmxmedia/audiovideo/AudioBuffer.h"
 #include "rmxmedia/audiovideo/AudioReference.h"
+#include "rmxmedia/audiovideo/AudioMixerKernels.h"
 #include "rmxmedia/audiovideo/AudioMixer.h"
 #include "rmxmedia/threads/JobManager.h"
 #include "rmxmedia/framework/GuiBase.h"
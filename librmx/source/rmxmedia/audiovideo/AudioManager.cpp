@@ -41,6 +41,9 @@ namespace rmx
 		// Initialize SDL2 audio subsystem
 		SDL_InitSubSystem(SDL_INIT_AUDIO);
 
+		// Select the sample mixing kernels for this CPU
+		AudioMixerKernels::initialize();
+
 		// Check input, we don't support everything
 		if ((sample_freq % 11025) != 0)
 		{
@@ -16,15 +16,11 @@ namespace rmx
 	{
 		void mixInSamples(int32* output, const short* input, int numSamples, int sourceIndexStart, int sourceIndexAdvance, int volume, int volumeChange)
 		{
-			int j = sourceIndexStart;
+			const AudioMixerKernels::Functions& kernels = AudioMixerKernels::getFunctions();
 			if (volumeChange == 0)
 			{
 				volume >>= 8;
-				for (int i = 0; i < numSamples; ++i)
-				{
-					output[i] += input[j >> 16] * volume;
-					j += sourceIndexAdvance;
-				}
+				kernels.mMixConstantVolume(output, input, numSamples, sourceIndexStart, sourceIndexAdvance, volume);
 			}
 			else
 			{
@@ -37,29 +33,19 @@ namespace rmx
 					numSamples = (0x10000 - volume) / volumeChange;
 				}
 
-				for (int i = 0; i < numSamples; ++i)
-				{
-					output[i] += (input[j >> 16] * volume) >> 8;
-					j += sourceIndexAdvance;
-					volume += volumeChange;
-				}
+				kernels.mMixVolumeRamp(output, input, numSamples, sourceIndexStart, sourceIndexAdvance, volume, volumeChange);
 			}
 		}
 
 		void mixInSampleAverages(int32* output, const short* input0, const short* input1, int numSamples, int sourceIndexStart, int sourceIndexAdvance, int volume, int volumeChange)
 		{
-			int j = sourceIndexStart;
+			const AudioMixerKernels::Functions& kernels = AudioMixerKernels::getFunctions();
 			volume /= 2;
 			volumeChange /= 2;
 			if (volumeChange == 0)
 			{
 				volume >>= 8;
-				for (int i = 0; i < numSamples; ++i)
-				{
-					const int k = j >> 16;
-					output[i] += (input0[k] + input1[k]) * volume;
-					j += sourceIndexAdvance;
-				}
+				kernels.mMixSumConstantVolume(output, input0, input1, numSamples, sourceIndexStart, sourceIndexAdvance, volume);
 			}
 			else
 			{
@@ -72,13 +58,7 @@ namespace rmx
 					numSamples = (0x10000 - volume) / volumeChange;
 				}
 
-				for (int i = 0; i < numSamples; ++i)
-				{
-					const int k = j >> 16;
-					output[i] += ((input0[k] + input1[k]) * volume) >> 8;
-					j += sourceIndexAdvance;
-					volume += volumeChange;
-				}
+				kernels.mMixSumVolumeRamp(output, input0, input1, numSamples, sourceIndexStart, sourceIndexAdvance, volume, volumeChange);
 			}
 		}
 	}
@@ -0,0 +1,336 @@
+/*
+*	rmx Library
+*	Copyright (C) 2008-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#include "rmxmedia.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__)) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define KERNELS_X86
+	#include <immintrin.h>
+	#if defined(_MSC_VER) && !defined(__clang__)
+		#define TARGET_AVX2
+	#else
+		#define TARGET_AVX2 __attribute__((target("avx2")))
+	#endif
+#elif defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+	#define KERNELS_NEON
+	#include <arm_neon.h>
+#endif
+
+
+namespace rmx
+{
+
+	namespace
+	{
+
+		// Scalar reference implementation
+		//  -> Template parameter "SUM" selects whether the sum of two input channels is used, "RAMP" whether the volume changes per sample
+
+		struct Kernels_Scalar
+		{
+			template<bool SUM, bool RAMP>
+			static void mix(int32* output, const short* input0, const short* input1, int numSamples, int j, int sourceIndexAdvance, int volume, int volumeChange)
+			{
+				for (int i = 0; i < numSamples; ++i)
+				{
+					const int k = j >> 16;
+					const int sample = SUM ? (input0[k] + input1[k]) : input0[k];
+					if constexpr (RAMP)
+					{
+						output[i] += (sample * volume) >> 8;
+						volume += volumeChange;
+					}
+					else
+					{
+						output[i] += sample * volume;
+					}
+					j += sourceIndexAdvance;
+				}
+			}
+		};
+
+
+	#if defined(KERNELS_X86)
+
+		// SSE2 implementation
+		//  -> Processes 4 samples at once
+
+		struct Kernels_SSE2
+		{
+			FORCE_INLINE static __m128i multiply(__m128i a, __m128i b)
+			{
+				// SSE2 has no 32-bit multiplication with 32-bit result, so use 32x32 -> 64 bit multiplications for the even and odd lanes instead
+				//  -> The lower 32 bits of the product are the same for signed and unsigned values
+				const __m128i even = _mm_mul_epu32(a, b);
+				const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+				return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+			}
+
+			FORCE_INLINE static __m128i loadSamples(const short* input)
+			{
+				// Sign-extend 4 consecutive 16-bit samples
+				const __m128i values = _mm_loadl_epi64((const __m128i*)input);
+				return _mm_srai_epi32(_mm_unpacklo_epi16(values, values), 16);
+			}
+
+			template<bool SUM, bool RAMP>
+			static void mixBlocks(int32* output, const short* input0, const short* input1, int numSamples, int j, int sourceIndexAdvance, int volume, int volumeChange)
+			{
+				__m128i volumes = RAMP ? _mm_setr_epi32(volume, volume + volumeChange, volume + volumeChange * 2, volume + volumeChange * 3) : _mm_set1_epi32(volume);
+				const __m128i volumeStep = _mm_set1_epi32(volumeChange * 4);
+
+				int i = 0;
+				for (; i + 4 <= numSamples; i += 4)
+				{
+					__m128i samples = loadSamples(&input0[j >> 16]);
+					if constexpr (SUM)
+					{
+						samples = _mm_add_epi32(samples, loadSamples(&input1[j >> 16]));
+					}
+
+					__m128i products = multiply(samples, volumes);
+					if constexpr (RAMP)
+					{
+						products = _mm_srai_epi32(products, 8);
+						volumes = _mm_add_epi32(volumes, volumeStep);
+					}
+
+					_mm_storeu_si128((__m128i*)&output[i], _mm_add_epi32(_mm_loadu_si128((const __m128i*)&output[i]), products));
+					j += sourceIndexAdvance * 4;
+				}
+
+				if constexpr (RAMP)
+				{
+					volume += volumeChange * i;
+				}
+				Kernels_Scalar::mix<SUM, RAMP>(&output[i], input0, input1, numSamples - i, j, sourceIndexAdvance, volume, volumeChange);
+			}
+
+			template<bool SUM, bool RAMP>
+			static void mix(int32* output, const short* input0, const short* input1, int numSamples, int j, int sourceIndexAdvance, int volume, int volumeChange)
+			{
+				// Resampled input can't be read with vector loads, and collecting it sample by sample does not pay off, so use the scalar code for that
+				if (sourceIndexAdvance == 0x10000)
+					mixBlocks<SUM, RAMP>(output, input0, input1, numSamples, j, sourceIndexAdvance, volume, volumeChange);
+				else
+					Kernels_Scalar::mix<SUM, RAMP>(output, input0, input1, numSamples, j, sourceIndexAdvance, volume, volumeChange);
+			}
+		};
+
+
+		// AVX2 implementation
+		//  -> Processes 8 samples at once
+
+		struct Kernels_AVX2
+		{
+			TARGET_AVX2 FORCE_INLINE static __m256i loadSamples(const short* input)
+			{
+				return _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)input));
+			}
+
+			template<bool SUM, bool RAMP>
+			TARGET_AVX2 static void mixBlocks(int32* output, const short* input0, const short* input1, int numSamples, int j, int sourceIndexAdvance, int volume, int volumeChange)
+			{
+				__m256i volumes = _mm256_set1_epi32(volume);
+				if constexpr (RAMP)
+				{
+					volumes = _mm256_add_epi32(volumes, _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(volumeChange)));
+				}
+				const __m256i volumeStep = _mm256_set1_epi32(volumeChange * 8);
+
+				int i = 0;
+				for (; i + 8 <= numSamples; i += 8)
+				{
+					__m256i samples = loadSamples(&input0[j >> 16]);
+					if constexpr (SUM)
+					{
+						samples = _mm256_add_epi32(samples, loadSamples(&input1[j >> 16]));
+					}
+
+					__m256i products = _mm256_mullo_epi32(samples, volumes);
+					if constexpr (RAMP)
+					{
+						products = _mm256_srai_epi32(products, 8);
+						volumes = _mm256_add_epi32(volumes, volumeStep);
+					}
+
+					_mm256_storeu_si256((__m256i*)&output[i], _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)&output[i]), products));
+					j += sourceIndexAdvance * 8;
+				}
+
+				if constexpr (RAMP)
+				{
+					volume += volumeChange * i;
+				}
+				Kernels_Scalar::mix<SUM, RAMP>(&output[i], input0, input1, numSamples - i, j, sourceIndexAdvance, volume, volumeChange);
+			}
+
+			template<bool SUM, bool RAMP>
+			static void mix(int32* output, const short* input0, const short* input1, int numSamples, int j, int sourceIndexAdvance, int volume, int volumeChange)
+			{
+				// Resampled input can't be read with vector loads, and collecting it sample by sample does not pay off, so use the scalar code for that
+				if (sourceIndexAdvance == 0x10000)
+					mixBlocks<SUM, RAMP>(output, input0, input1, numSamples, j, sourceIndexAdvance, volume, volumeChange);
+				else
+					Kernels_Scalar::mix<SUM, RAMP>(output, input0, input1, numSamples, j, sourceIndexAdvance, volume, volumeChange);
+			}
+		};
+
+	#elif defined(KERNELS_NEON)
+
+		// NEON implementation
+		//  -> Processes 4 samples at once
+
+		struct Kernels_NEON
+		{
+			FORCE_INLINE static int32x4_t loadSamples(const short* input)
+			{
+				return vmovl_s16(vld1_s16(input));
+			}
+
+			template<bool SUM, bool RAMP>
+			static void mixBlocks(int32* output, const short* input0, const short* input1, int numSamples, int j, int sourceIndexAdvance, int volume, int volumeChange)
+			{
+				const int32 initialVolumes[4] = { volume, volume + (RAMP ? volumeChange : 0), volume + (RAMP ? volumeChange * 2 : 0), volume + (RAMP ? volumeChange * 3 : 0) };
+				int32x4_t volumes = vld1q_s32(initialVolumes);
+				const int32x4_t volumeStep = vdupq_n_s32(volumeChange * 4);
+
+				int i = 0;
+				for (; i + 4 <= numSamples; i += 4)
+				{
+					int32x4_t samples = loadSamples(&input0[j >> 16]);
+					if constexpr (SUM)
+					{
+						samples = vaddq_s32(samples, loadSamples(&input1[j >> 16]));
+					}
+
+					int32x4_t products = vmulq_s32(samples, volumes);
+					if constexpr (RAMP)
+					{
+						products = vshrq_n_s32(products, 8);
+						volumes = vaddq_s32(volumes, volumeStep);
+					}
+
+					vst1q_s32(&output[i], vaddq_s32(vld1q_s32(&output[i]), products));
+					j += sourceIndexAdvance * 4;
+				}
+
+				if constexpr (RAMP)
+				{
+					volume += volumeChange * i;
+				}
+				Kernels_Scalar::mix<SUM, RAMP>(&output[i], input0, input1, numSamples - i, j, sourceIndexAdvance, volume, volumeChange);
+			}
+
+			template<bool SUM, bool RAMP>
+			static void mix(int32* output, const short* input0, const short* input1, int numSamples, int j, int sourceIndexAdvance, int volume, int volumeChange)
+			{
+				// Resampled input can't be read with vector loads, and collecting it sample by sample does not pay off, so use the scalar code for that
+				if (sourceIndexAdvance == 0x10000)
+					mixBlocks<SUM, RAMP>(output, input0, input1, numSamples, j, sourceIndexAdvance, volume, volumeChange);
+				else
+					Kernels_Scalar::mix<SUM, RAMP>(output, input0, input1, numSamples, j, sourceIndexAdvance, volume, volumeChange);
+			}
+		};
+
+	#endif
+
+
+		template<typename KERNELS>
+		AudioMixerKernels::Functions buildFunctions()
+		{
+			AudioMixerKernels::Functions functions;
+			functions.mMixConstantVolume = [](int32* output, const short* input, int numSamples, int sourceIndexStart, int sourceIndexAdvance, int volume)
+			{
+				KERNELS::template mix<false, false>(output, input, nullptr, numSamples, sourceIndexStart, sourceIndexAdvance, volume, 0);
+			};
+			functions.mMixVolumeRamp = [](int32* output, const short* input, int numSamples, int sourceIndexStart, int sourceIndexAdvance, int volume, int volumeChange)
+			{
+				KERNELS::template mix<false, true>(output, input, nullptr, numSamples, sourceIndexStart, sourceIndexAdvance, volume, volumeChange);
+			};
+			functions.mMixSumConstantVolume = [](int32* output, const short* input0, const short* input1, int numSamples, int sourceIndexStart, int sourceIndexAdvance, int volume)
+			{
+				KERNELS::template mix<true, false>(output, input0, input1, numSamples, sourceIndexStart, sourceIndexAdvance, volume, 0);
+			};
+			functions.mMixSumVolumeRamp = [](int32* output, const short* input0, const short* input1, int numSamples, int sourceIndexStart, int sourceIndexAdvance, int volume, int volumeChange)
+			{
+				KERNELS::template mix<true, true>(output, input0, input1, numSamples, sourceIndexStart, sourceIndexAdvance, volume, volumeChange);
+			};
+			return functions;
+		}
+
+		const AudioMixerKernels::Functions SCALAR_FUNCTIONS = buildFunctions<Kernels_Scalar>();
+	}
+
+
+	AudioMixerKernels::Variant AudioMixerKernels::mVariant = AudioMixerKernels::Variant::SCALAR;
+	AudioMixerKernels::Functions AudioMixerKernels::mFunctions = buildFunctions<Kernels_Scalar>();
+
+
+	void AudioMixerKernels::initialize()
+	{
+		// Use the first supported variant, in order of preference
+		Variant variant = Variant::SCALAR;
+		Functions functions = SCALAR_FUNCTIONS;
+		for (Variant candidate : { Variant::AVX2, Variant::SSE2, Variant::NEON })
+		{
+			if (getVariantFunctions(candidate, functions))
+			{
+				variant = candidate;
+				break;
+			}
+		}
+
+		mVariant = variant;
+		mFunctions = functions;
+	}
+
+	const char* AudioMixerKernels::getVariantName(Variant variant)
+	{
+		switch (variant)
+		{
+			case Variant::SCALAR:  return "scalar";
+			case Variant::SSE2:	   return "SSE2";
+			case Variant::AVX2:	   return "AVX2";
+			case Variant::NEON:	   return "NEON";
+		}
+		return "";
+	}
+
+	bool AudioMixerKernels::getVariantFunctions(Variant variant, Functions& outFunctions)
+	{
+		switch (variant)
+		{
+			case Variant::SCALAR:
+				outFunctions = SCALAR_FUNCTIONS;
+				return true;
+
+		#if defined(KERNELS_X86)
+			case Variant::SSE2:
+				if (!SDL_HasSSE2())
+					return false;
+				outFunctions = buildFunctions<Kernels_SSE2>();
+				return true;
+
+			case Variant::AVX2:
+				if (!SDL_HasAVX2())
+					return false;
+				outFunctions = buildFunctions<Kernels_AVX2>();
+				return true;
+		#elif defined(KERNELS_NEON)
+			case Variant::NEON:
+				outFunctions = buildFunctions<Kernels_NEON>();
+				return true;
+		#endif
+
+			default:
+				return false;
+		}
+	}
+
+}
@@ -0,0 +1,64 @@
+/*
+*	rmx Library
+*	Copyright (C) 2008-2023 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*
+*	AudioMixerKernels
+*		Inner loops for mixing audio samples into the output buffer.
+*/
+
+#pragma once
+
+
+namespace rmx
+{
+
+	// Sample mixing kernels used by the audio mixer
+	//  -> There's a scalar reference implementation, plus SIMD variants that get selected at runtime depending on the CPU features
+	//  -> Input positions are 16.16 fixed point, with the input index advancing by "sourceIndexAdvance" per output sample
+	//  -> Only same-rate input (an advance of exactly 0x10000) uses SIMD, with vector loads; resampled input always uses the scalar code
+	//  -> All variants produce exactly the same output as the scalar code, which gets checked by the "-audiomixertest" of rmx_test
+	class API_EXPORT AudioMixerKernels
+	{
+	public:
+		enum class Variant
+		{
+			SCALAR,
+			SSE2,
+			AVX2,
+			NEON
+		};
+
+		struct Functions
+		{
+			// Add input samples multiplied by a constant volume
+			void(*mMixConstantVolume)(int32* output, const short* input, int numSamples, int sourceIndexStart, int sourceIndexAdvance, int volume) = nullptr;
+
+			// Add input samples multiplied by a linearly changing volume, with the products shifted right by 8 bits
+			void(*mMixVolumeRamp)(int32* output, const short* input, int numSamples, int sourceIndexStart, int sourceIndexAdvance, int volume, int volumeChange) = nullptr;
+
+			// Add the sums of two input channels multiplied by a constant volume
+			void(*mMixSumConstantVolume)(int32* output, const short* input0, const short* input1, int numSamples, int sourceIndexStart, int sourceIndexAdvance, int volume) = nullptr;
+
+			// Add the sums of two input channels multiplied by a linearly changing volume, with the products shifted right by 8 bits
+			void(*mMixSumVolumeRamp)(int32* output, const short* input0, const short* input1, int numSamples, int sourceIndexStart, int sourceIndexAdvance, int volume, int volumeChange) = nullptr;
+		};
+
+	public:
+		static void initialize();
+
+		inline static Variant getVariant()					{ return mVariant; }
+		inline static const Functions& getFunctions()		{ return mFunctions; }
+		static const char* getVariantName(Variant variant);
+
+		// Get the functions of a specific variant, e.g. for tests and benchmarks; returns false if the variant is not supported by the CPU or build
+		static bool getVariantFunctions(Variant variant, Functions& outFunctions);
+
+	private:
+		static Variant mVariant;
+		static Functions mFunctions;
+	};
+
+}
@@ -14,65 +14,81 @@ namespace rmx
 
 	JobManager::JobManager()
 	{
-		mConditionVariable = SDL_CreateCond();
-		mConditionLock = SDL_CreateMutex();
+		mWakeUpCondition = SDL_CreateCond();
+		mWakeUpLock = SDL_CreateMutex();
+		mJobStoppedCondition = SDL_CreateCond();
+		mJobsLock = SDL_CreateMutex();
+		for (JobQueue& queue : mQueues)
+		{
+			queue.mMutex = SDL_CreateMutex();
+		}
+
+		// Use at least two worker threads, so that long-running jobs (like downloads) can't block all others, as they may occupy all but one thread
+		//  -> Note that additional threads only get started when there's actually enough work for them
+		mMaxThreads = clamp(SDL_GetCPUCount() - 1, 2, 4);
 	}
 
 	JobManager::~JobManager()
 	{
 		stopAllThreads();
-		SDL_DestroyCond(mConditionVariable);
-		SDL_DestroyMutex(mConditionLock);
+		for (JobQueue& queue : mQueues)
+		{
+			SDL_DestroyMutex(queue.mMutex);
+		}
+		SDL_DestroyCond(mWakeUpCondition);
+		SDL_DestroyMutex(mWakeUpLock);
+		SDL_DestroyCond(mJobStoppedCondition);
+		SDL_DestroyMutex(mJobsLock);
 	}
 
 	void JobManager::setMaxThreads(int count)
 	{
-		mMaxThreads = clamp(count, 0, 16);
+		mMaxThreads = clamp(count, 0, MAX_THREADS);
 	}
 
 	void JobManager::insertJob(JobBase& job)
 	{
+		SDL_LockMutex(mJobsLock);
 		if (nullptr != job.mRegisteredAtManager)
 		{
-			if (job.mRegisteredAtManager != this)
-				return;
-			if (job.mJobState != JobBase::JobState::INACTIVE && job.mJobState != JobBase::JobState::DONE)
+			if (job.mRegisteredAtManager != this || (job.mJobState != JobBase::JobState::INACTIVE && job.mJobState != JobBase::JobState::DONE))
+			{
+				SDL_UnlockMutex(mJobsLock);
 				return;
+			}
 
 			// Job is already registered here, but needs to have its state reset back to waiting
 		}
 		else
 		{
-			// Register job here
-			job.mRegisteredAtManager = this;
+			// Make sure there's a worker thread to take the job
+			tryStartWorkerThread();
 
-			// Make sure we have enough worker threads
-			//  -> TODO: Only create a new one if all existing threads are actually busy
-			const int index = (int)mThreads.size();
-			if (index < mMaxThreads)
+			if (mNumThreads == 0)
 			{
-				JobWorkerThread* thread = new JobWorkerThread(*this, index);
-				mThreads.push_back(thread);
-				thread->startThread();
+				// In case there are no worker threads, execute on the calling thread
+				SDL_UnlockMutex(mJobsLock);
+				job.mJobState = JobBase::JobState::WAITING;
+				job.executeOnCallingThread();
+				return;
 			}
+
+			// Register job here
+			job.mRegisteredAtManager = this;
+			mJobs.push_back(&job);
 		}
 
 		// Job is ready to be processed
+		//  -> Distribute new jobs evenly among the worker threads' queues, idle threads will steal them if needed anyways
+		JobQueue& queue = mQueues[mNextQueueIndex++ % (uint32)mNumThreads];
+		SDL_LockMutex(queue.mMutex);
 		job.mJobState = JobBase::JobState::WAITING;
+		queue.mJobs.push_back(&job);
+		SDL_UnlockMutex(queue.mMutex);
+		SDL_UnlockMutex(mJobsLock);
 
 		// Wake up a thread
-		if (!mThreads.empty())
-		{
-			SDL_LockMutex(mConditionLock);
-			mJobs.push_back(&job);
-			SDL_CondSignal(mConditionVariable);
-			SDL_UnlockMutex(mConditionLock);
-		}
-		else
-		{
-			// In case there are no worker threads, execute on the calling thread
-			job.executeOnCallingThread();
-		}
+		wakeUpThreads(false);
 	}
 
 	void JobManager::insertJob(JobBase& job, float priority)
@@ -83,11 +99,14 @@ namespace rmx
 
 	void JobManager::removeJob(JobBase& job)
 	{
+		// Unregister the job first, so that no worker thread will start or re-queue it any more
+		SDL_LockMutex(mJobsLock);
 		if (job.mRegisteredAtManager != this)
+		{
+			SDL_UnlockMutex(mJobsLock);
 			return;
-
-		bool wasRemoved = false;
-		SDL_LockMutex(mConditionLock);
+		}
+		job.mRegisteredAtManager = nullptr;
 		for (size_t i = 0; i < mJobs.size(); ++i)
 		{
 			if (mJobs[i] == &job)
@@ -98,141 +117,352 @@ namespace rmx
 					mJobs[i] = mJobs.back();
 				}
 				mJobs.pop_back();
-				wasRemoved = true;
+				break;
 			}
 		}
-		job.mRegisteredAtManager = nullptr;
-		SDL_UnlockMutex(mConditionLock);
+		SDL_UnlockMutex(mJobsLock);
 
-		if (wasRemoved)
+		// If the job is not waiting in any queue, it's either not started at all, or a worker thread is executing it right now
+		if (!removeFromQueues(job))
 		{
-			// Wait until job execution is done
-			job.mJobPriority = -1.0f;
+			// Signal the job function that it should abort, and wait until the worker thread reports back
+			//  -> Worker threads always change the state of an unregistered job under the lock, so no signal can get lost here
+			SDL_LockMutex(mJobsLock);
 			job.mJobShouldBeRunning = false;
 			while (job.mJobState == JobBase::JobState::RUNNING)
 			{
-				SDL_Delay(1);
+				SDL_CondWait(mJobStoppedCondition, mJobsLock);
 			}
+			SDL_UnlockMutex(mJobsLock);
 		}
+		job.mJobShouldBeRunning = false;
+	}
+
+	int JobManager::getJobCount()
+	{
+		SDL_LockMutex(mJobsLock);
+		const int count = (int)mJobs.size();
+		SDL_UnlockMutex(mJobsLock);
+		return count;
 	}
 
 	int JobManager::getFinishedCount()
 	{
 		int count = 0;
-		SDL_LockMutex(mConditionLock);
+		SDL_LockMutex(mJobsLock);
 		for (JobBase* job : mJobs)
 		{
 			if (job->isJobDone())
 				++count;
 		}
-		SDL_UnlockMutex(mConditionLock);
+		SDL_UnlockMutex(mJobsLock);
 		return count;
 	}
 
-	JobBase* JobManager::getNextJob()
+	void JobManager::getJobList(std::vector<JobBase*>& output)
 	{
-		SDL_LockMutex(mConditionLock);
-		JobBase* job = getNextJobInternal();
-		SDL_UnlockMutex(mConditionLock);
-		return job;
+		SDL_LockMutex(mJobsLock);
+		output = mJobs;
+		SDL_UnlockMutex(mJobsLock);
+	}
+
+	void JobManager::onJobChanged()
+	{
+		wakeUpThreads(false);
 	}
 
-	JobBase* JobManager::getNextJobBlocking()
+	JobBase* JobManager::getNextJob(int queueIndex, uint32& nextDelayedJobTicks)
 	{
-		// Wait until there's at leat one job available
-		SDL_LockMutex(mConditionLock);
-		JobBase* job = getNextJobInternal();
-		while (nullptr == job && mSearchforJobs)
+		nextDelayedJobTicks = 0xffffffff;	// This will get updated as well
+		const uint32 currentTicks = SDL_GetTicks();
+		const int numThreads = mNumThreads;
+
+		// Find the queue holding the ready job with the highest priority, starting with the thread's own queue, which wins on equal priority
+		//  -> Another thread may empty that queue before the job gets taken, in that case just search again
+		JobBase* job = nullptr;
+		int numReadyJobs = 0;
+		for (int attempt = 0; attempt < 3 && nullptr == job; ++attempt)
 		{
-			// Using a time-out for two reasons:
-			//  - to have a chance to check if "mShouldBeRunning" changed outside
-			//  - to react to a delayed job, if there's no other jobs at the moment
-			uint32 timeoutMilliseconds = 100;
-			if (mNextDelayedJobTicks != 0xffffffff)
+			int bestQueueIndex = -1;
+			float bestPriority = 0.0f;
+			numReadyJobs = 0;
+			for (int i = 0; i < numThreads; ++i)
 			{
-				const uint32 currentTicks = SDL_GetTicks();
-				if (mNextDelayedJobTicks > currentTicks)
-					timeoutMilliseconds = mNextDelayedJobTicks - currentTicks;
+				const int index = (queueIndex + i) % numThreads;
+				float priority;
+				if (peekBestJobInQueue(mQueues[index], currentTicks, nextDelayedJobTicks, priority, numReadyJobs) && (bestQueueIndex < 0 || priority > bestPriority))
+				{
+					bestQueueIndex = index;
+					bestPriority = priority;
+				}
 			}
-			SDL_CondWaitTimeout(mConditionVariable, mConditionLock, timeoutMilliseconds);
-			job = getNextJobInternal();
+			if (bestQueueIndex < 0)
+				break;
+
+			job = takeJobFromQueue(mQueues[bestQueueIndex], bestQueueIndex == queueIndex, currentTicks, nextDelayedJobTicks);
+		}
+
+		// If there's still work left for another thread, but all are busy, get some help
+		if (nullptr != job && numReadyJobs > 1 && mNumIdleThreads == 0 && numThreads < mMaxThreads)
+		{
+			SDL_LockMutex(mJobsLock);
+			tryStartWorkerThread();
+			SDL_UnlockMutex(mJobsLock);
 		}
-		SDL_UnlockMutex(mConditionLock);
 		return job;
 	}
 
-	void JobManager::getJobList(std::vector<JobBase*>& output)
+	JobBase* JobManager::getNextJobBlocking(int queueIndex)
 	{
-		SDL_LockMutex(mConditionLock);
-		output = mJobs;
-		SDL_UnlockMutex(mConditionLock);
+		// Read the wake-up counter before searching, so that any change during the search prevents going to sleep
+		const uint32 wakeUpCounter = mWakeUpCounter;
+		uint32 nextDelayedJobTicks;
+		JobBase* job = getNextJob(queueIndex, nextDelayedJobTicks);
+		if (nullptr != job)
+			return job;
+
+		// Using a time-out for two reasons:
+		//  - to have a chance to check if "mShouldBeRunning" changed outside
+		//  - to react to a delayed job, if there's no other jobs at the moment
+		uint32 timeoutMilliseconds = 100;
+		if (nextDelayedJobTicks != 0xffffffff)
+		{
+			const uint32 currentTicks = SDL_GetTicks();
+			timeoutMilliseconds = (nextDelayedJobTicks > currentTicks) ? std::min(nextDelayedJobTicks - currentTicks, timeoutMilliseconds) : 0;
+		}
+
+		// Wait until there's possibly a job available, the caller will then search again
+		++mNumIdleThreads;
+		SDL_LockMutex(mWakeUpLock);
+		if (wakeUpCounter == mWakeUpCounter && mSearchForJobs && timeoutMilliseconds > 0)
+		{
+			SDL_CondWaitTimeout(mWakeUpCondition, mWakeUpLock, timeoutMilliseconds);
+		}
+		SDL_UnlockMutex(mWakeUpLock);
+		--mNumIdleThreads;
+		return nullptr;
 	}
 
-	void JobManager::onJobChanged()
+	std::deque<JobBase*>::iterator JobManager::findBestJobInQueue(JobQueue& queue, bool isOwnQueue, bool allowLongRunningJobs, uint32 currentTicks, uint32& nextDelayedJobTicks, float& outPriority, int& outNumReadyJobs)
 	{
-		SDL_LockMutex(mConditionLock);
-		SDL_CondSignal(mConditionVariable);
-		SDL_UnlockMutex(mConditionLock);
+		// This must only be called while holding the queue's lock
+		//  -> Select waiting job with highest priority
+		//  -> On equal priority, the owning thread prefers the most recently queued job, while others steal the one that waited longest
+		auto bestIt = queue.mJobs.end();
+		float bestPriority = 0.0f;
+		for (auto it = queue.mJobs.begin(); it != queue.mJobs.end(); ++it)
+		{
+			JobBase& job = **it;
+			if (job.mRegisteredAtManager != this)
+				continue;
+
+			// Ignore priorities below 0.0f
+			const float priority = job.mJobPriority;
+			if (priority < 0.0f)
+				continue;
+
+			// Long-running jobs have to wait until one of them is done, if they already occupy as many threads as allowed
+			if (job.mJobIsLongRunning && !allowLongRunningJobs)
+				continue;
+
+			const uint32 delayUntilTicks = job.mJobDelayUntilTicks;
+			if (delayUntilTicks > currentTicks)
+			{
+				nextDelayedJobTicks = std::min(nextDelayedJobTicks, delayUntilTicks);
+				continue;
+			}
+
+			++outNumReadyJobs;
+			if (bestIt == queue.mJobs.end() || priority > bestPriority || (isOwnQueue && priority == bestPriority))
+			{
+				bestIt = it;
+				bestPriority = priority;
+			}
+		}
+
+		outPriority = bestPriority;
+		return bestIt;
 	}
 
-	JobBase* JobManager::getNextJobInternal()
+	bool JobManager::peekBestJobInQueue(JobQueue& queue, uint32 currentTicks, uint32& nextDelayedJobTicks, float& outPriority, int& outNumReadyJobs)
 	{
-		// Select waiting job with highest priority
-		mNextDelayedJobTicks = 0xffffffff;	// This will get updated as well
+		SDL_LockMutex(queue.mMutex);
+		const bool found = (findBestJobInQueue(queue, false, mNumRunningLongJobs < getMaxLongRunningJobs(), currentTicks, nextDelayedJobTicks, outPriority, outNumReadyJobs) != queue.mJobs.end());
+		SDL_UnlockMutex(queue.mMutex);
+		return found;
+	}
+
+	JobBase* JobManager::takeJobFromQueue(JobQueue& queue, bool isOwnQueue, uint32 currentTicks, uint32& nextDelayedJobTicks)
+	{
+		SDL_LockMutex(queue.mMutex);
+
+		float priority;
+		int numReadyJobs = 0;
+		auto bestIt = findBestJobInQueue(queue, isOwnQueue, mNumRunningLongJobs < getMaxLongRunningJobs(), currentTicks, nextDelayedJobTicks, priority, numReadyJobs);
+		bool holdsLongRunningJobSlot = false;
+		if (bestIt != queue.mJobs.end() && (*bestIt)->mJobIsLongRunning)
+		{
+			// Other threads may have started long-running jobs in the meantime, so the selection must get repeated without them if no slot is left
+			holdsLongRunningJobSlot = tryReserveLongRunningJobSlot();
+			if (!holdsLongRunningJobSlot)
+			{
+				bestIt = findBestJobInQueue(queue, isOwnQueue, false, currentTicks, nextDelayedJobTicks, priority, numReadyJobs);
+			}
+		}
+
 		JobBase* bestJob = nullptr;
-		const uint32 currentTicks = SDL_GetTicks();
-		for (JobBase* job : mJobs)
+		if (bestIt != queue.mJobs.end())
+		{
+			bestJob = *bestIt;
+			queue.mJobs.erase(bestIt);
+
+			// Changing the state while still holding the queue's lock ensures that "removeJob" either finds the job in the queue or sees it running
+			bestJob->mHoldsLongRunningJobSlot = holdsLongRunningJobSlot;
+			bestJob->mJobShouldBeRunning = true;
+			bestJob->mJobState = JobBase::JobState::RUNNING;
+		}
+
+		SDL_UnlockMutex(queue.mMutex);
+		return bestJob;
+	}
+
+	bool JobManager::tryReserveLongRunningJobSlot()
+	{
+		int count = mNumRunningLongJobs;
+		while (count < getMaxLongRunningJobs())
+		{
+			if (mNumRunningLongJobs.compare_exchange_weak(count, count + 1))
+				return true;
+		}
+		return false;
+	}
+
+	void JobManager::onJobFuncReturned(JobBase& job, int queueIndex, bool finished)
+	{
+		if (job.mHoldsLongRunningJobSlot)
 		{
-			if (job->mJobState == JobBase::JobState::WAITING)
+			// Another long-running job might be waiting for the slot to become free
+			job.mHoldsLongRunningJobSlot = false;
+			--mNumRunningLongJobs;
+			wakeUpThreads(false);
+		}
+
+		if (!finished)
+		{
+			// Set back to waiting state and put the job back into this thread's own queue
+			//  -> Note that the job's priority might have changed, or there's another job with higher priority now, so don't just continue with this job
+			//  -> Jobs with higher priority in other threads' queues get preferred as well, see "getNextJob"
+			JobQueue& queue = mQueues[queueIndex];
+			SDL_LockMutex(queue.mMutex);
+			const bool requeue = (job.mRegisteredAtManager == this);
+			if (requeue)
 			{
-				if (job->mJobDelayUntilTicks <= currentTicks)
-				{
-					if (nullptr == bestJob || job->mJobPriority > bestJob->mJobPriority)
-					{
-						bestJob = job;
-					}
-				}
-				else
+				job.mJobState = JobBase::JobState::WAITING;
+				queue.mJobs.push_back(&job);
+			}
+			SDL_UnlockMutex(queue.mMutex);
+
+			if (requeue)
+				return;
+		}
+
+		// The job is done or got removed in the meantime, in both cases it must not be touched by any worker thread any more
+		SDL_LockMutex(mJobsLock);
+		if (finished && job.mRegisteredAtManager == this)
+		{
+			job.mRegisteredAtManager = nullptr;
+			for (size_t i = 0; i < mJobs.size(); ++i)
+			{
+				if (mJobs[i] == &job)
 				{
-					if (job->mJobPriority >= 0.0f && job->mJobDelayUntilTicks < mNextDelayedJobTicks)
+					// Swap with last
+					if (i + 1 < mJobs.size())
 					{
-						mNextDelayedJobTicks = job->mJobDelayUntilTicks;
+						mJobs[i] = mJobs.back();
 					}
+					mJobs.pop_back();
+					break;
 				}
 			}
 		}
-		if (nullptr != bestJob)
+		job.mJobShouldBeRunning = false;
+		job.mJobState = finished ? JobBase::JobState::DONE : JobBase::JobState::WAITING;
+		SDL_CondBroadcast(mJobStoppedCondition);
+		SDL_UnlockMutex(mJobsLock);
+	}
+
+	bool JobManager::removeFromQueues(JobBase& job)
+	{
+		bool wasRemoved = false;
+		const int numThreads = mNumThreads;
+		for (int i = 0; i < numThreads && !wasRemoved; ++i)
 		{
-			// Ignore priorities below 0.0f
-			if (bestJob->mJobPriority >= 0.0f)
-			{
-				bestJob->mJobShouldBeRunning = true;
-				bestJob->mJobState = JobBase::JobState::RUNNING;
-			}
-			else
+			JobQueue& queue = mQueues[i];
+			SDL_LockMutex(queue.mMutex);
+			const auto it = std::find(queue.mJobs.begin(), queue.mJobs.end(), &job);
+			if (it != queue.mJobs.end())
 			{
-				bestJob = nullptr;
+				queue.mJobs.erase(it);
+				wasRemoved = true;
 			}
+			SDL_UnlockMutex(queue.mMutex);
 		}
-		return bestJob;
+		return wasRemoved;
+	}
+
+	void JobManager::wakeUpThreads(bool all)
+	{
+		++mWakeUpCounter;
+		SDL_LockMutex(mWakeUpLock);
+		if (all)
+			SDL_CondBroadcast(mWakeUpCondition);
+		else
+			SDL_CondSignal(mWakeUpCondition);
+		SDL_UnlockMutex(mWakeUpLock);
+	}
+
+	bool JobManager::tryStartWorkerThread()
+	{
+		// This must only be called while holding "mJobsLock"
+		//  -> Start a new thread only if all existing ones are busy
+		if (!mSearchForJobs || mNumIdleThreads > 0 || mNumThreads >= mMaxThreads)
+			return false;
+
+		const int index = mNumThreads;
+		JobWorkerThread* thread = new JobWorkerThread(*this, index);
+		mThreads[index] = thread;
+
+		// Make the new queue visible to other threads only after everything is set up
+		++mNumThreads;
+		thread->startThread();
+		return true;
 	}
 
 	void JobManager::stopAllThreads()
 	{
-		mSearchforJobs = false;
-		for (JobWorkerThread* thread : mThreads)
+		// Setting this under the lock makes sure no worker thread starts another one from now on
+		SDL_LockMutex(mJobsLock);
+		mSearchForJobs = false;
+		const int numThreads = mNumThreads;
+		SDL_UnlockMutex(mJobsLock);
+		if (numThreads == 0)
+			return;
+
+		wakeUpThreads(true);
+		for (int i = 0; i < numThreads; ++i)
 		{
-			thread->signalStopThread(false);
+			mThreads[i]->signalStopThread(false);
 		}
-		for (JobWorkerThread* thread : mThreads)
+		for (int i = 0; i < numThreads; ++i)
 		{
-			thread->joinThread();
+			mThreads[i]->joinThread();
 		}
-		for (JobWorkerThread* thread : mThreads)
+		for (int i = 0; i < numThreads; ++i)
 		{
-			delete thread;
+			delete mThreads[i];
+			mThreads[i] = nullptr;
 		}
-		mThreads.clear();
+		mNumThreads = 0;
 	}
 
 
@@ -244,9 +474,10 @@ namespace rmx
 		const bool wakeUpThread = (mJobPriority < 0.0f && priority >= 0.0f);
 		mJobPriority = priority;
 
-		if (wakeUpThread && nullptr != mRegisteredAtManager)
+		JobManager* jobManager = mRegisteredAtManager;
+		if (wakeUpThread && nullptr != jobManager)
 		{
-			mRegisteredAtManager->onJobChanged();
+			jobManager->onJobChanged();
 		}
 	}
 
@@ -256,9 +487,10 @@ namespace rmx
 		const bool wakeUpThread = (sdlTicks < mJobDelayUntilTicks);
 		mJobDelayUntilTicks = sdlTicks;
 
-		if (wakeUpThread && nullptr != mRegisteredAtManager)
+		JobManager* jobManager = mRegisteredAtManager;
+		if (wakeUpThread && nullptr != jobManager)
 		{
-			mRegisteredAtManager->onJobChanged();
+			jobManager->onJobChanged();
 		}
 	}
 
@@ -302,32 +534,22 @@ namespace rmx
 
 
 	JobWorkerThread::JobWorkerThread(JobManager& jobManager, int index) :
-		mJobManager(jobManager)
+		ThreadBase("rmx Job Worker " + std::to_string(index)),
+		mJobManager(jobManager),
+		mIndex(index)
 	{
-		// Index goes unused at the moment
 	}
 
 	void JobWorkerThread::threadFunc()
 	{
 		while (mShouldBeRunning)
 		{
-			JobBase* job = mJobManager.getNextJobBlocking();
+			JobBase* job = mJobManager.getNextJobBlocking(mIndex);
 			if (nullptr != job)
 			{
 				// Execute job
 				const bool result = job->jobFunc();
-				if (result)
-				{
-					// Job is done
-					job->mJobState = JobBase::JobState::DONE;
-					job->mRegisteredAtManager->removeJob(*job);
-				}
-				else
-				{
-					// Set back to waiting state
-					//  -> Note that the job's priority might have changed, or there's another job with higher priority now, so don't just continue with this job
-					job->mJobState = JobBase::JobState::WAITING;
-				}
+				mJobManager.onJobFuncReturned(*job, mIndex, result);
 			}
 		}
 	}
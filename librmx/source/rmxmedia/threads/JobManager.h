@@ -11,6 +11,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <deque>
+
 
 namespace rmx
 {
@@ -19,8 +22,17 @@ namespace rmx
 
 
 	// Job manager
+	//  -> Each worker thread owns a queue of waiting jobs, but takes the job with the highest priority among all queues, preferring its own queue on equal priority
+	//  -> Worker threads without anything to do in their own queue steal jobs from the queues of other worker threads
+	//  -> Worker threads get created on demand, i.e. only when there's more work to do while all existing ones are busy
+	//  -> Long-running jobs (like downloads) can only occupy a limited number of worker threads at once, so other jobs always get processed as well
 	class JobManager
 	{
+	friend class JobWorkerThread;
+
+	public:
+		static const constexpr int MAX_THREADS = 16;
+
 	public:
 		JobManager();
 		~JobManager();
@@ -31,34 +43,58 @@ namespace rmx
 		void insertJob(JobBase& job, float priority);
 		void removeJob(JobBase& job);
 
-		int getJobCount()  { return (int)mJobs.size(); }
+		int getJobCount();
 		int getFinishedCount();
-
-		JobBase* getNextJob();
-		JobBase* getNextJobBlocking();
+		inline int getThreadCount() const  { return mNumThreads; }
 
 		void getJobList(std::vector<JobBase*>& output);
 
 		void onJobChanged();
 
 	private:
-		JobBase* getNextJobInternal();
-		void stopAllThreads();
+		struct JobQueue
+		{
+			SDL_mutex* mMutex = nullptr;
+			std::deque<JobBase*> mJobs;		// Waiting jobs; the owning worker thread pushes at the back, other threads preferably steal from the front
+		};
 
 	private:
-		SDL_cond* mConditionVariable = nullptr;
-		SDL_mutex* mConditionLock = nullptr;
+		JobBase* getNextJob(int queueIndex, uint32& nextDelayedJobTicks);
+		JobBase* getNextJobBlocking(int queueIndex);
+		std::deque<JobBase*>::iterator findBestJobInQueue(JobQueue& queue, bool isOwnQueue, bool allowLongRunningJobs, uint32 currentTicks, uint32& nextDelayedJobTicks, float& outPriority, int& outNumReadyJobs);
+		bool peekBestJobInQueue(JobQueue& queue, uint32 currentTicks, uint32& nextDelayedJobTicks, float& outPriority, int& outNumReadyJobs);
+		JobBase* takeJobFromQueue(JobQueue& queue, bool isOwnQueue, uint32 currentTicks, uint32& nextDelayedJobTicks);
+		bool tryReserveLongRunningJobSlot();
+		inline int getMaxLongRunningJobs() const  { return std::max(mMaxThreads - 1, 1); }
+		void onJobFuncReturned(JobBase& job, int queueIndex, bool finished);
+		bool removeFromQueues(JobBase& job);
+		void wakeUpThreads(bool all);
+		bool tryStartWorkerThread();
+		void stopAllThreads();
 
-		// Worker threads
-		int mMaxThreads = 1;
-		std::vector<JobWorkerThread*> mThreads;
+	private:
+		// Worker threads, each with its own job queue
+		//  -> Threads only get added until "stopAllThreads" is called, so other threads can access the first "mNumThreads" queues without further locking
+		std::atomic<int> mMaxThreads = 1;
+		std::atomic<int> mNumThreads = 0;
+		std::atomic<int> mNumIdleThreads = 0;
+		std::atomic<int> mNumRunningLongJobs = 0;		// Number of worker threads currently occupied by long-running jobs, limited by "getMaxLongRunningJobs"
+		std::atomic<uint32> mNextQueueIndex = 0;
+		JobWorkerThread* mThreads[MAX_THREADS] = { nullptr };
+		JobQueue mQueues[MAX_THREADS];
+
+		// Waking up of idle worker threads
+		//  -> The counter gets increased whenever there might be something new to do, so a thread won't go to sleep after missing a signal
+		SDL_cond* mWakeUpCondition = nullptr;
+		SDL_mutex* mWakeUpLock = nullptr;
+		std::atomic<uint32> mWakeUpCounter = 0;
+		std::atomic<bool> mSearchForJobs = true;
 
 		// Registered jobs
-		//  -> Not using a data structure optimized for getting the next job (using priority);
-		//     but that's probably overkill anyways if the number of active jobs is not more than a few dozens
+		//  -> The lock also guards job state changes that "removeJob" needs to wait for, and the condition variable gets signalled on these
+		SDL_cond* mJobStoppedCondition = nullptr;
+		SDL_mutex* mJobsLock = nullptr;
 		std::vector<JobBase*> mJobs;
-		uint32 mNextDelayedJobTicks = 0;
-		bool mSearchforJobs = true;
 	};
 
 
@@ -97,6 +133,7 @@ namespace rmx
 
 	protected:
 		String mJobType;							// Type string for the job
+		bool mJobIsLongRunning = false;				// Set this for jobs that block their worker thread for a long time, e.g. waiting for network I/O; must not get changed while the job is registered
 
 	private:
 		enum class JobState
@@ -108,11 +145,12 @@ namespace rmx
 		};
 
 	private:
-		JobManager* mRegisteredAtManager = nullptr;	// Job manager instance this is registered at (should actually always be FTX::JobManager or nullptr)
-		JobState mJobState = JobState::INACTIVE;	// Current state
-		bool mJobShouldBeRunning = false;			// Can be set to false while running to signal the jobFunc that it should abort
-		float mJobPriority = 0.0f;					// Priority, higher values will be preferred; jobs with negative priorities won't get processed at all
-		uint32 mJobDelayUntilTicks = 0;				// SDL ticks value until when the job should get delayed; 0 if no delay active (which is the default)
+		std::atomic<JobManager*> mRegisteredAtManager = nullptr;	// Job manager instance this is registered at (should actually always be FTX::JobManager or nullptr)
+		std::atomic<JobState> mJobState = JobState::INACTIVE;		// Current state
+		std::atomic<bool> mJobShouldBeRunning = false;				// Gets set to false while running to signal the jobFunc that it should abort
+		std::atomic<float> mJobPriority = 0.0f;						// Priority, higher values will be preferred; jobs with negative priorities won't get processed at all
+		std::atomic<uint32> mJobDelayUntilTicks = 0;				// SDL ticks value until when the job should get delayed; 0 if no delay active (which is the default)
+		bool mHoldsLongRunningJobSlot = false;						// Only accessed by the worker thread executing the job
 	};
 
 
@@ -124,10 +162,8 @@ namespace rmx
 		JobWorkerThread(JobManager& jobManager, int index);
 		void threadFunc();
 
-	public:
-		float mInactivityDelay = 0.1f;
-
 	private:
 		JobManager& mJobManager;
+		int mIndex = 0;
 	};
 }
@@ -37,10 +37,7 @@ namespace rmx
 
 	ThreadBase::~ThreadBase()
 	{
-		if (mIsThreadRunning)
-		{
-			signalStopThread(true);
-		}
+		signalStopThread(true);
 		mManager->unregisterThread(*this);
 	}
 
@@ -56,8 +53,6 @@ namespace rmx
 
 	void ThreadBase::runThreadInternal()
 	{
-		mIsThreadRunning = true;
-		mShouldBeRunning = true;
 		threadFunc();
 		mShouldBeRunning = false;
 		mIsThreadRunning = false;
@@ -65,27 +60,34 @@ namespace rmx
 
 	void ThreadBase::startThread()
 	{
-		if (!mIsThreadRunning)
+		if (nullptr == mSDLThread)
 		{
+			// Set the flags already here, so that a stop signal right after this call can't get lost
+			mIsThreadRunning = true;
+			mShouldBeRunning = true;
 			mSDLThread = SDL_CreateThread(ThreadBase::runThreadStatic, mName.c_str(), this);
+			if (nullptr == mSDLThread)
+			{
+				mIsThreadRunning = false;
+				mShouldBeRunning = false;
+			}
 		}
 	}
 
 	void ThreadBase::signalStopThread(bool join)
 	{
-		if (mIsThreadRunning)
-		{
-			mShouldBeRunning = false;
-			if (join)
-				joinThread();
-		}
+		mShouldBeRunning = false;
+		if (join)
+			joinThread();
 	}
 
 	void ThreadBase::joinThread()
 	{
-		if (mIsThreadRunning && nullptr != mSDLThread)
+		// Always wait for the SDL thread, even if it already finished, as this releases its resources
+		if (nullptr != mSDLThread)
 		{
 			SDL_WaitThread(mSDLThread, nullptr);
+			mSDLThread = nullptr;
 		}
 	}
 
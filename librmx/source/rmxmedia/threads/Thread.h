@@ -11,6 +11,8 @@
 
 #pragma once
 
+#include <atomic>
+
 
 namespace rmx
 {
@@ -69,12 +71,12 @@ namespace rmx
 		void runThreadInternal();
 
 	protected:
-		bool mShouldBeRunning = false;		// If set to false, the thread should stop itself; this has to be implemented in the sub-class
+		std::atomic<bool> mShouldBeRunning = false;		// If set to false, the thread should stop itself; this has to be implemented in the sub-class
 
 	private:
 		SDL_Thread* mSDLThread = nullptr;
 		std::string mName;
-		bool mIsThreadRunning = false;		// Set as long as the actual thread is running
+		std::atomic<bool> mIsThreadRunning = false;		// Set from starting the thread until the actual thread function returned
 		SinglePtr<ThreadManager> mManager;
 	};
 